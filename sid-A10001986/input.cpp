@@ -53,6 +53,8 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include "sid_global.h"
+
 #include <Arduino.h>
 
 #include "input.h"
@@ -61,26 +63,154 @@
  * IRRemote class
  */
 
+// Capture mode:
+// If IR_CAPTURE_EDGE is defined, marks/spaces are measured by 
+// timestamping the edges in a GPIO change interrupt, with 1us 
+// resolution; end-of-transmission is detected lazily in loop().
+// Otherwise, a hardware timer polls the pin every 50us.
+// (IR_CAPTURE_TIMER selects the latter; the host tests in
+// tools/host build both for comparison.)
+#ifndef IR_CAPTURE_TIMER
+#define IR_CAPTURE_EDGE
+#endif
+
 #define TMR_TIME      0.00005    // 0.00005s = 50us
 #define TMR_PRESCALE  80
 #define TMR_TICKS     (uint64_t)(((double)TMR_TIME * 80000000.0) / (double)TMR_PRESCALE)
 #define TME_TIMEUS    (TMR_TIME * 1000000)
+#define TMR_TIMEUS    50         // Same, as integer
 
 #define GAP_DUR 5000  // Minimum gap between transmissions in us (microseconds)
+
+#define IR_REPEAT_WINDOW 200000   // Max us between end of frames of a held key
 #define GAP_TICKS     (GAP_DUR / TME_TIMEUS)
 
 // IR receiver pin polarity
 #define IR_LIGHT  0
 #define IR_DARK   1
 
-static void IRAM_ATTR IRTimer_ISR();
-
 static uint8_t _ir_pin;
 
-static volatile uint32_t _cnt = 0;
+// Ring of received frames, filled by the ISR, emptied by loop().
+// Single producer (ISR), single consumer (main loop): The ISR only
+// writes _irHead, loop() only writes _irTail. If the ring is full,
+// the ISR drops the new frame and counts it as an overflow instead
+// of waiting for the consumer.
+#define IR_NUMFRAMES 4      // Power of 2
+
+typedef struct {
+    uint32_t len;
+    uint32_t end;           // micros() at end of frame
+    uint32_t phase;         // micros() % 50 at first mark (edge capture)
+    uint32_t buf[IRBUFSIZE];
+} IRFrame;
+
+static IRFrame _irFrames[IR_NUMFRAMES];
+static volatile uint32_t _irHead = 0;
+static volatile uint32_t _irTail = 0;
+static volatile uint32_t _irOverflows = 0;
+static volatile uint32_t _irTruncated = 0;
+
 static volatile IRState  _irstate = IRSTATE_IDLE;
 static volatile uint32_t _irlen = 0;
-static volatile uint32_t _irbuf[IRBUFSIZE];
+
+#define _irbuf   _irFrames[_irHead].buf
+#define _irphase _irFrames[_irHead].phase
+
+// Hand recorded frame over to consumer
+static void IRAM_ATTR IRFrameDone()
+{
+    uint32_t next = (_irHead + 1) & (IR_NUMFRAMES - 1);
+
+    if(_irlen >= IRBUFSIZE) _irTruncated++;
+    
+    if(next != _irTail) {
+        _irFrames[_irHead].len = _irlen;
+        _irFrames[_irHead].end = micros();
+        __sync_synchronize();   // Frame data before index
+        _irHead = next;
+    } else {
+        // Ring full, drop this frame
+        _irOverflows++;
+    }
+    
+    _irlen = 0;
+}
+
+#ifdef IR_CAPTURE_EDGE
+
+static void IRAM_ATTR IREdge_ISR();
+
+static volatile uint32_t _lastEdge = 0;
+static portMUX_TYPE _irMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ISR
+// Called on every edge; record duration of marks/spaces 
+// (in us) through a simple state machine
+static void IRAM_ATTR IREdge_ISR()
+{
+    uint32_t now = micros();
+    uint8_t irpin = (uint8_t)digitalRead(_ir_pin);
+
+    portENTER_CRITICAL_ISR(&_irMux);
+    
+    uint32_t dur = now - _lastEdge;
+    _lastEdge = now;
+
+    switch(_irstate) {
+    case IRSTATE_IDLE:
+        if(irpin == IR_LIGHT && dur >= GAP_DUR) {
+            // Previous gap longer than minimum gap size,
+            // start recording. (See IRTimer_ISR)
+            _irstate = IRSTATE_LIGHT;
+            _irbuf[0] = dur;   // First is length of previous gap
+            _irphase = now % TMR_TIMEUS;
+            _irlen = 1;
+        }
+        break;
+    case IRSTATE_LIGHT:
+        if(irpin == IR_DARK) {
+            _irstate = IRSTATE_DARK;
+            _irbuf[_irlen++] = dur;
+            if(_irlen >= IRBUFSIZE) {
+                IRFrameDone();
+                _irstate = IRSTATE_IDLE;
+            }
+        }
+        break;
+    case IRSTATE_DARK:
+        if(irpin == IR_LIGHT) {
+            if(dur > GAP_DUR) {
+                // Gap longer than usual space, transmission finished
+                // (and loop() didn't notice yet). This edge starts
+                // the next transmission (eg a repeat code).
+                IRFrameDone();
+                _irbuf[0] = dur;
+                _irphase = now % TMR_TIMEUS;
+                _irlen = 1;
+                _irstate = IRSTATE_LIGHT;
+            } else {
+                _irstate = IRSTATE_LIGHT;
+                _irbuf[_irlen++] = dur;
+                if(_irlen >= IRBUFSIZE) {
+                    IRFrameDone();
+                    _irstate = IRSTATE_IDLE;
+                }
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    portEXIT_CRITICAL_ISR(&_irMux);
+}
+
+#else
+
+static void IRAM_ATTR IRTimer_ISR();
+
+static volatile uint32_t _cnt = 0;
 
 // ISR 
 // Record duration of marks/spaces through a simple state machine
@@ -111,7 +241,12 @@ static void IRAM_ATTR IRTimer_ISR()
             _irstate = IRSTATE_DARK;
             _irbuf[_irlen++] = _cnt;
             _cnt = 0;
-            if(_irlen >= IRBUFSIZE) _irstate = IRSTATE_STOP;
+            if(_irlen >= IRBUFSIZE) {
+                // In IDLE, cnt is reset whenever we see something, 
+                // so we won't start recording in mid-transmission
+                IRFrameDone();
+                _irstate = IRSTATE_IDLE;
+            }
         }
         break;
     case IRSTATE_DARK:
@@ -119,17 +254,22 @@ static void IRAM_ATTR IRTimer_ISR()
             _irstate = IRSTATE_LIGHT;
             _irbuf[_irlen++] = _cnt;
             _cnt = 0;
-            if(_irlen >= IRBUFSIZE) _irstate = IRSTATE_STOP;
+            if(_irlen >= IRBUFSIZE) {
+                IRFrameDone();
+                _irstate = IRSTATE_IDLE;
+            }
         } else if(_cnt > GAP_TICKS) {
             // Gap longer than usual space, transmission finished.
-            _irstate = IRSTATE_STOP;
+            IRFrameDone();
+            _irstate = IRSTATE_IDLE;
         }
         break;
-    case IRSTATE_STOP:
-        if(irpin == IR_LIGHT) _cnt = 0; // Reset cnt whenever we see something, even if we miss recording it
+    default:
         break;
     }
 }
+
+#endif
  
 // Store basic config data
 IRRemote::IRRemote(uint8_t timer_no, uint8_t ir_pin)
@@ -143,51 +283,241 @@ void IRRemote::begin()
     pinMode(_ir_pin, INPUT);
     _irstate = IRSTATE_IDLE;
     _irlen = 0;
+    _irHead = _irTail = 0;
 
+    #ifdef IR_CAPTURE_EDGE
+    // Install pin change interrupt
+    _lastEdge = micros();
+    attachInterrupt(digitalPinToInterrupt(_ir_pin), &IREdge_ISR, CHANGE);
+    #else
     // Install & enable interrupt
     _IRTimer = timerBegin(_timer_no, TMR_PRESCALE, true);
     timerAttachInterrupt(_IRTimer, &IRTimer_ISR, true);
     timerAlarmWrite(_IRTimer, TMR_TICKS, true);
     timerAlarmEnable(_IRTimer);
+    #endif
 }
 
 // Decode IR signal
 bool IRRemote::loop()
 {
-    // No new transmission, bail...
-    if(_irstate != IRSTATE_STOP)
-        return false;
+    #ifdef IR_CAPTURE_EDGE
+    // Detect end of transmission: Dark for longer than
+    // the minimum gap. There is no edge to tell us, so 
+    // we check here.
+    if(_irstate == IRSTATE_DARK) {
+        portENTER_CRITICAL(&_irMux);
+        if(_irstate == IRSTATE_DARK && (micros() - _lastEdge > GAP_DUR)) {
+            IRFrameDone();
+            _irstate = IRSTATE_IDLE;
+        }
+        portEXIT_CRITICAL(&_irMux);
+    }
+    #endif
+    
+    // No new transmission: Check held key
+    uint32_t tail = _irTail;
+    if(tail == _irHead)
+        return checkHold();
 
-    // Copy result to backup buffer
-    _buflen = _irlen;
-    for(int i = 0; i < _buflen; i++) {
-        _buf[i] = _irbuf[i];
+    __sync_synchronize();   // Index before frame data
+
+    // Copy result to backup buffer (in us)
+    IRFrame *frame = &_irFrames[tail];
+    _buflen = frame->len;
+    _bufEnd = frame->end;
+    _bufPhase = frame->phase;
+    for(uint32_t i = 0; i < _buflen; i++) {
+        #ifdef IR_CAPTURE_EDGE
+        _buf[i] = frame->buf[i];
+        #else
+        _buf[i] = frame->buf[i] * TME_TIMEUS;
+        #endif
     }
 
-    // Continue recording
-    resume();
+    // Release slot to ISR
+    __sync_synchronize();
+    _irTail = (tail + 1) & (IR_NUMFRAMES - 1);
     
-    // Calc hash on received "code"
-    if(calcHash()) {
-        //unsigned long now = millis();
-        // Repeat-key-avoidance hinders game play!
-        //if(_hvalue == _prevHash) {
-        //    if(now - _prevTime < 300) {
-        //        _prevTime = now;
-        //        return false;
-        //    }
-        //}
+    // Try protocol decoders first
+    bool gotCode = decode();
+    bool gotHash = false;
+
+    if(gotCode && _repeat) {
+        // Repeat frames might not carry the code 
+        // (NEC), so report the previous hash
+        _hvalue = _prevHash;
+        gotHash = true;
+    } else if(calcHash()) {
+        // Calc hash on received "code"
         _prevHash = _hvalue;
-        //_prevTime = now;
-        return true;
+        gotHash = true;
+    }
+
+    if(_trace) {
+        addTrace(gotCode, gotHash);
+    }
+
+    if(!gotCode && !gotHash)
+        return checkHold();
+
+    // Unknown protocol: Same hash again within the repeat 
+    // window means the key is held
+    if(!gotCode && _held && _hvalue == _heldHash && (_bufEnd - _lastFrameEnd <= IR_REPEAT_WINDOW)) {
+        _repeat = true;
+    }
+
+    _lastFrameEnd = _bufEnd;
+
+    if(_repeat) {
+        // Key still held; repeat events are 
+        // generated by checkHold(), at our pace
+        return checkHold();
     }
 
-    return false;
+    _held = true;
+    _heldHash = _hvalue;
+    _heldCode = _code;
+    _repInterval = _repStart;
+    _nextRepeat = millis() + _repDelay;
+    _event = IRKEY_PRESS;
+
+    return true;
 }
 
+/*
+ * Key hold tracking
+ * 
+ * While a key is held, IRKEY_REPEAT events are generated
+ * after an initial delay, with the interval getting shorter 
+ * with each repeat (down to a minimum). IRKEY_RELEASE is 
+ * reported when no (repeat) frame has been received for
+ * IR_REPEAT_WINDOW.
+ */
+
+void IRRemote::setRepeat(uint16_t delay, uint16_t interval, uint16_t minInterval, uint8_t accel)
+{
+    _repDelay = delay;
+    _repStart = interval;
+    _repMin = minInterval;
+    _repAccel = accel;
+}
+
+bool IRRemote::checkHold()
+{
+    if(!_held)
+        return false;
+
+    // Released? (Unless next frame is being recorded)
+    if(_irstate == IRSTATE_IDLE && _irTail == _irHead && 
+       (micros() - _lastFrameEnd > IR_REPEAT_WINDOW)) {
+        _held = false;
+        _event = IRKEY_RELEASE;
+    } else {
+        unsigned long now = millis();
+        if((long)(now - _nextRepeat) < 0)
+            return false;
+        _nextRepeat = now + _repInterval;
+        _repInterval = _repInterval * _repAccel / 100;
+        if(_repInterval < _repMin) _repInterval = _repMin;
+        _event = IRKEY_REPEAT;
+    }
+    
+    _hvalue = _heldHash;
+    _code = _heldCode;
+
+    return true;
+}
+
+// Discard all received frames, and the one 
+// currently being recorded
 void IRRemote::resume()
 {
+    #ifdef IR_CAPTURE_EDGE
+    portENTER_CRITICAL(&_irMux);
+    #else
+    if(_IRTimer) timerAlarmDisable(_IRTimer);
+    #endif
+    
     _irstate = IRSTATE_IDLE;
+    _irlen = 0;
+    _irTail = _irHead;
+    
+    #ifdef IR_CAPTURE_EDGE
+    portEXIT_CRITICAL(&_irMux);
+    #else
+    if(_IRTimer) timerAlarmEnable(_IRTimer);
+    #endif
+}
+
+/*
+ * Diagnostics: Raw timing trace
+ *
+ * While enabled, every received frame (including those
+ * which yield neither code nor hash) is recorded along
+ * with the results; the caller fetches the records
+ * through readTrace(). If the caller falls behind, the 
+ * oldest records are overwritten.
+ */
+
+bool IRRemote::setTrace(bool enable)
+{
+    if(enable && !_trace) {
+        if(!(_trace = (IRTraceRec *)malloc(IR_TRACE_RECS * sizeof(IRTraceRec)))) {
+            return false;
+        }
+        _traceHead = _traceTail = _traceLost = 0;
+    } else if(!enable && _trace) {
+        free(_trace);
+        _trace = NULL;
+    }
+
+    return true;
+}
+
+bool IRRemote::isTracing()
+{
+    return (_trace != NULL);
+}
+
+void IRRemote::addTrace(bool gotCode, bool gotHash)
+{
+    IRTraceRec *rec = &_trace[_traceHead];
+    
+    rec->stamp = millis();
+    rec->code = gotCode ? _code : 0;
+    rec->hash = gotHash ? _hvalue : 0;
+    rec->len = _buflen;
+    rec->flags = (gotCode ? IRTR_CODE : 0) | (gotHash ? IRTR_HASH : 0) | (_repeat ? IRTR_REPEAT : 0);
+    for(uint32_t i = 0; i < _buflen; i++) {
+        rec->dur[i] = (_buf[i] > 0xffff) ? 0xffff : _buf[i];
+    }
+
+    _traceHead = (_traceHead + 1) % IR_TRACE_RECS;
+    if(_traceHead == _traceTail) {
+        _traceTail = (_traceTail + 1) % IR_TRACE_RECS;
+        _traceLost++;
+    }
+}
+
+bool IRRemote::readTrace(IRTraceRec& rec, uint32_t& lost)
+{
+    if(!_trace || _traceHead == _traceTail)
+        return false;
+
+    rec = _trace[_traceTail];
+    _traceTail = (_traceTail + 1) % IR_TRACE_RECS;
+    lost = _traceLost;
+
+    return true;
+}
+
+// Number of frames dropped because the ring was full,
+// and frames cut off due to exceeding IRBUFSIZE
+void IRRemote::getStats(uint32_t& overflows, uint32_t& truncated)
+{
+    overflows = _irOverflows;
+    truncated = _irTruncated;
 }
 
 uint32_t IRRemote::readHash()
@@ -195,6 +525,23 @@ uint32_t IRRemote::readHash()
     return _hvalue;
 }
 
+// Decoded code, 0 if protocol unknown
+uint32_t IRRemote::readCode()
+{
+    return _code;
+}
+
+// Event type: IRKEY_PRESS, IRKEY_REPEAT, IRKEY_RELEASE
+uint8_t IRRemote::getEvent()
+{
+    return _event;
+}
+
+bool IRRemote::isRepeat()
+{
+    return (_event == IRKEY_REPEAT);
+}
+
 
 /* CalcHash: Calculate hash over an arbitrary IR code
  * 
@@ -220,13 +567,31 @@ uint32_t IRRemote::compare(uint32_t a, uint32_t b)
 
 bool IRRemote::calcHash()
 {
+    uint32_t *d = _buf;
+    
     if(_buflen < 6)
         return false;
+
+    #ifdef IR_CAPTURE_EDGE
+    // Hash the durations as the 50us timer capture measured them,
+    // so that hashes stay the same as with timer capture (which
+    // was used when the default codes and any learned keys were
+    // recorded): Count timer ticks, at multiples of 50us, between 
+    // the edges.
+    uint32_t q[IRBUFSIZE];
+    uint32_t pos = _bufPhase;
+    for(uint32_t i = 1; i < _buflen; i++) {
+        pos += _buf[i];
+        q[i] = (pos / TMR_TIMEUS) * TMR_TIMEUS;
+        pos %= TMR_TIMEUS;
+    }
+    d = q;
+    #endif
     
     uint32_t hash = FNV_BASIS_32;
     
-    for(int i = 1; i + 2 < _buflen; i++) {
-        hash = (hash * FNV_PRIME_32) ^ compare(_buf[i], _buf[i+2]);
+    for(uint32_t i = 1; i + 2 < _buflen; i++) {
+        hash = (hash * FNV_PRIME_32) ^ compare(d[i], d[i+2]);
     }
     
     _hvalue = hash;
@@ -234,6 +599,242 @@ bool IRRemote::calcHash()
     return true;
 }
 
+/*
+ * Protocol decoders
+ *
+ * Tried before the hash. If a frame matches one of the protocols
+ * in the table, the result is an exact code (see IRCODE), plus 
+ * a flag whether the frame is a repeat of the previous one; that 
+ * is a NEC repeat frame, or the same code (and toggle bit) again 
+ * within IR_REPEAT_WINDOW.
+ *
+ * Durations are in us; _buf[0] is the gap before the frame, odd 
+ * indices are marks, even ones spaces. The final space is not 
+ * recorded, it is part of the next gap.
+ */
+
+
+typedef enum {
+    IRC_PDIST,      // Pulse distance: Fixed mark, space determines bit value
+    IRC_PWIDTH,     // Pulse width: Mark determines bit value, fixed space
+    IRC_BIPHASE     // Manchester: Fixed half-bit, transition determines bit value
+} IRCoding;
+
+#define IRF_REPFRAME  0x01  // Frame has no data, repeats previous code
+#define IRF_TOGGLE    0x02  // Frame has toggle bit
+#define IRF_RESEND    0x04  // Frame is re-sent while key is held
+#define IRF_MARKFIRST 0x08  // Biphase: 1 is mark-space (else space-mark)
+
+#define IR_NODBL      0xff
+
+typedef struct {
+    uint8_t  proto;
+    uint8_t  coding;
+    uint8_t  minBits;
+    uint8_t  maxBits;
+    uint8_t  flags;
+    uint8_t  dblBit;        // Biphase: Index of double-length bit
+    uint16_t hdrMark;       // 0 = no header
+    uint16_t hdrSpace;
+    uint16_t unit;          // PDIST: mark; PWIDTH: space; BIPHASE: half-bit
+    uint16_t zero;          // PDIST: space; PWIDTH: mark
+    uint16_t one;
+} IRProtocol;
+
+// Tried in this order. RC6 goes before Sony: Both headers are
+// within each other's tolerance, and with receivers stretching 
+// marks (and thereby shortening spaces), RC6 frames fit Sony's 
+// pulse widths, too. The biphase decoder's checks are stricter.
+static const IRProtocol irProtocols[] = {
+    { IRPROTO_NEC,  IRC_PDIST,   32, 32, 0,                           IR_NODBL, 9000, 4500, 560, 560, 1690 },
+    { IRPROTO_NEC,  IRC_PDIST,    0,  0, IRF_REPFRAME,                IR_NODBL, 9000, 2250, 560,   0,    0 },
+    { IRPROTO_RC6,  IRC_BIPHASE, 21, 21, IRF_TOGGLE | IRF_MARKFIRST,  4,        2666,  889, 444,   0,    0 },
+    { IRPROTO_SONY, IRC_PWIDTH,  12, 20, IRF_RESEND,                  IR_NODBL, 2400,  600, 600, 600, 1200 },
+    { IRPROTO_RC5,  IRC_BIPHASE, 14, 14, IRF_TOGGLE,                  IR_NODBL,    0,    0, 889,   0,    0 }
+};
+
+// Match with 25% tolerance, plus some slack for
+// receivers stretching marks
+static bool irMatch(uint32_t meas, uint32_t expect)
+{
+    return (meas + 100 >= expect * 3 / 4) && (meas <= expect * 5 / 4 + 100);
+}
+
+static bool irDecodePulse(const IRProtocol *p, const uint32_t *buf, int len, uint32_t& data, int& nbits)
+{
+    int i = 3;
+
+    if(len < 4 || !irMatch(buf[1], p->hdrMark) || !irMatch(buf[2], p->hdrSpace))
+        return false;
+
+    // PDIST:  mark/space per bit, plus stop mark: 2 * bits + 1
+    // PWIDTH: mark/space per bit, last space in gap: 2 * bits - 1
+    if(!((len - i) & 1))
+        return false;
+    nbits = (p->coding == IRC_PDIST) ? (len - i - 1) / 2 : (len - i + 1) / 2;
+    if(nbits < p->minBits || nbits > p->maxBits)
+        return false;
+
+    uint32_t thresh = (p->zero + p->one) / 2;
+    data = 0;
+    for(int b = 0; b < nbits; b++, i += 2) {
+        uint32_t d;
+        if(p->coding == IRC_PDIST) {
+            if(!irMatch(buf[i], p->unit)) return false;
+            d = buf[i + 1];
+        } else {
+            if(i + 1 < len && !irMatch(buf[i + 1], p->unit)) return false;
+            d = buf[i];
+        }
+        if(d > thresh) data |= (1UL << b);    // LSB first
+    }
+
+    if(p->coding == IRC_PDIST && !irMatch(buf[i], p->unit))
+        return false;
+
+    return true;
+}
+
+static bool irDecodeBiphase(const IRProtocol *p, const uint32_t *buf, int len, uint32_t& data)
+{
+    uint8_t lvl[48];
+    int n = 0, i = 1;
+    int expect = p->minBits * 2 + ((p->dblBit != IR_NODBL) ? 2 : 0);
+
+    if(p->hdrMark) {
+        if(len < 4 || !irMatch(buf[1], p->hdrMark) || !irMatch(buf[2], p->hdrSpace))
+            return false;
+        i = 3;
+    } else {
+        // First half of start bit is part of the gap
+        lvl[n++] = 0;
+    }
+
+    // Expand to half-bits
+    for(; i < len; i++) {
+        uint32_t units = (buf[i] + p->unit / 2) / p->unit;
+        if(units < 1 || units > 4 || n + (int)units > expect) 
+            return false;
+        while(units--) lvl[n++] = (i & 1);
+    }
+
+    // Last half-bit might be a space, merged into the gap
+    if(n == expect - 1) lvl[n++] = 0;
+    if(n != expect)
+        return false;
+
+    data = 0;
+    for(int b = 0, pos = 0; b < p->minBits; b++) {
+        int w = (b == p->dblBit) ? 2 : 1;
+        uint8_t first = lvl[pos];
+        for(int k = 1; k < w; k++) {
+            if(lvl[pos + k] != first || lvl[pos + w + k] != lvl[pos + w]) 
+                return false;
+        }
+        if(lvl[pos + w] == first)
+            return false;
+        data <<= 1;                         // MSB first
+        if((first == 1) == !!(p->flags & IRF_MARKFIRST)) data |= 1;
+        pos += 2 * w;
+    }
+
+    return true;
+}
+
+#ifdef SID_BENCH
+// Load a frame for benchmarking; instance must not be begin()-ed
+void IRRemote::benchLoad(const uint16_t *dur, int len)
+{
+    if(len > IRBUFSIZE) len = IRBUFSIZE;
+    
+    for(int i = 0; i < len; i++) {
+        _buf[i] = dur[i];
+    }
+    _buflen = len;
+}
+#endif
+
+bool IRRemote::decode()
+{
+    const IRProtocol *p = irProtocols;
+    uint32_t data, code = 0;
+    bool toggle = false;
+    int nbits = 0;
+
+    _code = 0;
+    _repeat = false;
+
+    for(int t = 0; t < (int)(sizeof(irProtocols) / sizeof(irProtocols[0])); t++, p++) {
+        
+        if(p->coding == IRC_BIPHASE) {
+            if(!irDecodeBiphase(p, _buf, _buflen, data)) continue;
+        } else {
+            if(!irDecodePulse(p, _buf, _buflen, data, nbits)) continue;
+        }
+
+        switch(p->proto) {
+        case IRPROTO_NEC:
+            if(p->flags & IRF_REPFRAME) {
+                code = 1;
+                break;
+            }
+            // Command is followed by its complement; address might
+            // be complemented as well (NEC) or not (extended NEC)
+            if(((data >> 16) & 0xff) != (~(data >> 24) & 0xff))
+                continue;
+            if((data & 0xff) == (~(data >> 8) & 0xff)) {
+                code = IRCODE(IRPROTO_NEC, data & 0xff, (data >> 16) & 0xff);
+            } else {
+                code = IRCODE(IRPROTO_NEC, data & 0xffff, (data >> 16) & 0xff);
+            }
+            break;
+        case IRPROTO_SONY:
+            // 7 bits command, 5, 8 or 13 bits address
+            if(nbits != 12 && nbits != 15 && nbits != 20)
+                continue;
+            code = IRCODE(IRPROTO_SONY, data >> 7, data & 0x7f);
+            break;
+        case IRPROTO_RC5:
+            // S1, S2 (inverted bit 6 of command), toggle, 5 bits address, 6 bits command
+            if(!(data & 0x2000))
+                continue;
+            toggle = !!(data & 0x800);
+            code = IRCODE(IRPROTO_RC5, (data >> 6) & 0x1f, (data & 0x3f) | ((data & 0x1000) ? 0 : 0x40));
+            break;
+        case IRPROTO_RC6:
+            // Start, 3 bits mode (0), toggle, 8 bits address, 8 bits command
+            if((data & 0x1e0000) != 0x100000)
+                continue;
+            toggle = !!(data & 0x10000);
+            code = IRCODE(IRPROTO_RC6, (data >> 8) & 0xff, data & 0xff);
+            break;
+        }
+
+        if(code) break;
+    }
+
+    if(!code)
+        return false;
+
+    bool inWindow = (_prevCode && (_bufEnd - _prevEnd <= IR_REPEAT_WINDOW));
+
+    if(p->flags & IRF_REPFRAME) {
+        // Repeat frame without preceding code: Ignore
+        if(!inWindow || IRCODE_PROTO(_prevCode) != p->proto)
+            return false;
+        code = _prevCode;
+        _repeat = true;
+    } else if(p->flags & (IRF_TOGGLE|IRF_RESEND)) {
+        _repeat = inWindow && (code == _prevCode) && (toggle == _prevToggle);
+    }
+
+    _code = _prevCode = code;
+    _prevToggle = toggle;
+    _prevEnd = _bufEnd;
+
+    return true;
+}
+
 /*
  * SIDButton class
  * 
@@ -286,13 +887,94 @@ void SIDButton::attachLongPressStop(void (*newFunction)(void))
     _longPressStopFunc = newFunction;
 }
 
-// Check input of the pin and advance the state machine
+// Use pin change interrupt to record edges; the state
+// machine then runs on the exact edge times, instead
+// of the times scan() happens to be called.
+void SIDButton::begin(bool useISR)
+{
+    _edgeHead = _edgeTail = 0;
+    _useISR = useISR;
+    
+    if(useISR) {
+        attachInterruptArg(digitalPinToInterrupt(_pin), &SIDButton::edgeISR, this, CHANGE);
+    }
+}
+
+void IRAM_ATTR SIDButton::edgeISR(void *arg)
+{
+    SIDButton *b = (SIDButton *)arg;
+    unsigned long now = micros();
+    uint32_t next = (b->_edgeHead + 1) % SIDB_EDGES;
+
+    // If full, drop the edge; scan() samples the current 
+    // level after draining the ring anyway
+    if(next != b->_edgeTail) {
+        b->_edges[b->_edgeHead].t = now;
+        b->_edges[b->_edgeHead].active = (digitalRead(b->_pin) == b->_buttonPressed);
+        __sync_synchronize();
+        b->_edgeHead = next;
+    }
+}
+
+// Feed recorded edges and the current level to
+// the state machine, then report resulting events
 void SIDButton::scan(void)
 {
-    unsigned long now = millis();
-    unsigned long waitTime = now - _startTime;
+    // Time first, then level: Both are taken before the ring
+    // is drained, so that an edge coming in meanwhile can't 
+    // go to advance() with a time older than the one fed last.
+    unsigned long now = micros();
     bool active = (digitalRead(_pin) == _buttonPressed);
     
+    if(_useISR) {
+        uint32_t tail;
+        while((tail = _edgeTail) != _edgeHead) {
+            __sync_synchronize();
+            SIDBEdge e = _edges[tail];
+            // Newer than now: Leave it for the next scan
+            if((long)(e.t - now) > 0)
+                break;
+            _edgeTail = (tail + 1) % SIDB_EDGES;
+            advance(e.active, e.t);
+        }
+    }
+    
+    advance(active, now);
+
+    // Dispatch queued events
+    while(_evCount) {
+        SIDBEvent e = _evQueue[0];
+        for(int i = 1; i < _evCount; i++) {
+            _evQueue[i - 1] = _evQueue[i];
+        }
+        _evCount--;
+        _eventTime = e.t;
+        switch(e.ev) {
+        case SIDB_EV_PRESS:
+            if(_pressFunc) _pressFunc();
+            break;
+        case SIDB_EV_LONGSTART:
+            if(_longPressStartFunc) _longPressStartFunc();
+            break;
+        case SIDB_EV_LONGSTOP:
+            if(_longPressStopFunc) _longPressStopFunc();
+            break;
+        }
+    }
+}
+
+// Time (micros) of the event currently reported; for 
+// a press, this is when the press started
+unsigned long SIDButton::eventTime()
+{
+    return _eventTime;
+}
+
+// The state machine, fed with input level and time (micros)
+void SIDButton::advance(bool active, unsigned long now)
+{
+    unsigned long waitTime = now - _startTime;
+    
     switch(_state) {
     case TCBS_IDLE:
         if(active) {
@@ -302,46 +984,48 @@ void SIDButton::scan(void)
         break;
 
     case TCBS_PRESSED:
-        if((!active) && (waitTime < _debounceDur)) {  // de-bounce
+        if((!active) && (waitTime < _debounceDur * 1000)) {  // de-bounce
             transitionTo(_lastState);
         } else if(!active) {
             transitionTo(TCBS_RELEASED);
-            _startTime = now;
+            _pressEnd = now;
         } else {
             if(!_longPressStartFunc) {
-                if(waitTime > _pressDur) {
-                    if(_pressFunc) _pressFunc();
+                if(!_pressNotified && waitTime > _pressDur * 1000) {
+                    queueEvent(SIDB_EV_PRESS, _startTime);
                     _pressNotified = true;
                 }      
-            } else if(waitTime > _longPressDur) {
-                if(_longPressStartFunc) _longPressStartFunc(); 
+            } else if(waitTime > _longPressDur * 1000) {
+                queueEvent(SIDB_EV_LONGSTART, now);
                 transitionTo(TCBS_LONGPRESS);
             }
         }
         break;
 
     case TCBS_RELEASED:
-        if((active) && (waitTime < _debounceDur)) {  // de-bounce
+        waitTime = now - _pressEnd;
+        if((active) && (waitTime < _debounceDur * 1000)) {  // de-bounce
             transitionTo(_lastState);
-        } else if((!active) && (waitTime > _pressDur)) {
-            if(!_pressNotified && _pressFunc) _pressFunc();
-            reset();
+        } else if((!active) && (waitTime > _pressDur * 1000)) {
+            if(!_pressNotified) queueEvent(SIDB_EV_PRESS, _startTime);
+            resetState();
         }
         break;
   
     case TCBS_LONGPRESS:
         if(!active) {
             transitionTo(TCBS_LONGPRESSEND);
-            _startTime = now;
+            _pressEnd = now;
         }
         break;
 
     case TCBS_LONGPRESSEND:
-        if((active) && (waitTime < _debounceDur)) { // de-bounce
+        waitTime = now - _pressEnd;
+        if((active) && (waitTime < _debounceDur * 1000)) { // de-bounce
             transitionTo(_lastState);
-        } else if(waitTime >= _debounceDur) {
-            if(_longPressStopFunc) _longPressStopFunc();
-            reset();
+        } else if(waitTime >= _debounceDur * 1000) {
+            queueEvent(SIDB_EV_LONGSTOP, now);
+            resetState();
         }
         break;
 
@@ -355,7 +1039,15 @@ void SIDButton::scan(void)
  * Private
  */
 
+// Reset state machine, forget pending events and edges
 void SIDButton::reset(void)
+{
+    resetState();
+    _evCount = 0;
+    _edgeTail = _edgeHead;
+}
+
+void SIDButton::resetState(void)
 {
     _state = TCBS_IDLE;
     _lastState = TCBS_IDLE;
@@ -363,6 +1055,15 @@ void SIDButton::reset(void)
     _pressNotified = false;
 }
 
+void SIDButton::queueEvent(uint8_t ev, unsigned long t)
+{
+    if(_evCount < SIDB_EVENTS) {
+        _evQueue[_evCount].ev = ev;
+        _evQueue[_evCount].t = t;
+        _evCount++;
+    }
+}
+
 // Advance to new state
 void SIDButton::transitionTo(ButtonState nextState)
 {
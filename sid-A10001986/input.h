@@ -61,11 +61,43 @@
 
 #define IRBUFSIZE 100
 
+// Protocols recognized by the decoders; codes are
+// built as (protocol << 24) | (address << 8) | command
+#define IRPROTO_NONE  0
+#define IRPROTO_NEC   1
+#define IRPROTO_SONY  2
+#define IRPROTO_RC5   3
+#define IRPROTO_RC6   4
+
+// Raw timing trace record. Written to SD as-is, up to 
+// and including dur[len - 1]; all values little endian.
+#define IR_TRACE_RECS 8
+
+#define IRTR_CODE     0x01
+#define IRTR_HASH     0x02
+#define IRTR_REPEAT   0x04
+
+typedef struct __attribute__((packed)) {
+    uint32_t stamp;             // millis() when processed
+    uint32_t code;              // Decoded code (if IRTR_CODE)
+    uint32_t hash;              // Hash (if IRTR_HASH)
+    uint8_t  len;               // Number of durations
+    uint8_t  flags;             // IRTR_xxx
+    uint16_t dur[IRBUFSIZE];    // Gap, mark, space, mark, ... in us, max 65535
+} IRTraceRec;
+
+// Key events
+#define IRKEY_PRESS   1
+#define IRKEY_REPEAT  2
+#define IRKEY_RELEASE 3
+
+#define IRCODE(p, a, c)   (((uint32_t)(p) << 24) | ((uint32_t)(a) << 8) | (uint32_t)(c))
+#define IRCODE_PROTO(c)   ((c) >> 24)
+
 typedef enum {
     IRSTATE_IDLE,
     IRSTATE_LIGHT,
-    IRSTATE_DARK,
-    IRSTATE_STOP  
+    IRSTATE_DARK
 } IRState;
 
 class IRRemote {
@@ -76,21 +108,64 @@ class IRRemote {
 
         bool loop();
         uint32_t readHash();
+        uint32_t readCode();
+        uint8_t  getEvent();
+        bool     isRepeat();
+
+        void setRepeat(uint16_t delay, uint16_t interval, uint16_t minInterval, uint8_t accel);
         void resume();
+
+        void getStats(uint32_t& overflows, uint32_t& truncated);
+
+        bool setTrace(bool enable);
+        bool isTracing();
+        bool readTrace(IRTraceRec& rec, uint32_t& lost);
+
+        #ifdef SID_BENCH
+        void benchLoad(const uint16_t *dur, int len);
+        bool benchHash()   { return calcHash(); }
+        bool benchDecode() { return decode(); }
+        #endif
         
     private:
         uint32_t compare(unsigned int oldval, unsigned int newval);
         bool     calcHash();
+        bool     decode();
+        void     addTrace(bool gotCode, bool gotHash);
+        bool     checkHold();
 
         uint8_t _timer_no = 0;
         hw_timer_t *_IRTimer = NULL;
 
         uint32_t _buflen;
         uint32_t _buf[IRBUFSIZE];
+        uint32_t _bufEnd;
+        uint32_t _bufPhase;
         uint32_t _hvalue;
+        uint32_t _code = 0;
+        bool     _repeat = false;
+
+        uint32_t _prevHash = 0;
+        uint32_t _prevCode = 0;
+        bool     _prevToggle = false;
+        uint32_t _prevEnd = 0;
 
-        unsigned long _prevTime;
-        uint32_t      _prevHash;
+        uint8_t       _event = 0;
+        bool          _held = false;
+        uint32_t      _heldHash = 0;
+        uint32_t      _heldCode = 0;
+        uint32_t      _lastFrameEnd = 0;
+        unsigned long _nextRepeat = 0;
+        uint16_t      _repInterval = 0;
+        uint16_t      _repDelay = 400;
+        uint16_t      _repStart = 150;
+        uint16_t      _repMin = 50;
+        uint8_t       _repAccel = 85;
+
+        IRTraceRec *_trace = NULL;
+        int         _traceHead = 0;
+        int         _traceTail = 0;
+        uint32_t    _traceLost = 0;
 };
 
 
@@ -106,6 +181,23 @@ typedef enum {
     TCBS_LONGPRESSEND
 } ButtonState;
 
+#define SIDB_EDGES  16
+#define SIDB_EVENTS 4
+
+#define SIDB_EV_PRESS     1
+#define SIDB_EV_LONGSTART 2
+#define SIDB_EV_LONGSTOP  3
+
+typedef struct {
+    unsigned long t;
+    bool          active;
+} SIDBEdge;
+
+typedef struct {
+    unsigned long t;
+    uint8_t       ev;
+} SIDBEvent;
+
 class SIDButton {
   
     public:
@@ -117,11 +209,20 @@ class SIDButton {
         void attachLongPressStart(void (*newFunction)(void));
         void attachLongPressStop(void (*newFunction)(void));
 
+        void begin(bool useISR = true);
+
         void scan(void);
         void reset(void);
 
+        unsigned long eventTime();
+
     private:
 
+        static void IRAM_ATTR edgeISR(void *arg);
+
+        void advance(bool active, unsigned long now);
+        void queueEvent(uint8_t ev, unsigned long t);
+        void resetState(void);
         void transitionTo(ButtonState nextState);
 
         void (*_pressFunc)(void) = NULL;
@@ -140,8 +241,18 @@ class SIDButton {
         ButtonState _lastState = TCBS_IDLE;
       
         unsigned long _startTime;
+        unsigned long _pressEnd;
 
         bool _pressNotified = false;
+
+        bool              _useISR = false;
+        SIDBEdge          _edges[SIDB_EDGES];
+        volatile uint32_t _edgeHead = 0;
+        volatile uint32_t _edgeTail = 0;
+
+        SIDBEvent     _evQueue[SIDB_EVENTS];
+        int           _evCount = 0;
+        unsigned long _eventTime = 0;
 };
 
 #endif
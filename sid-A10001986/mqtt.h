@@ -156,6 +156,10 @@ class PubSubClient {
         bool pollPing();
         void cancelPing();
         int  pstate() { return this->_pstate; }
+
+        #ifdef SID_BENCH
+        uint32_t benchReadPacket() { uint8_t ll; return readPacket(&ll); }
+        #endif
     
     private:
 
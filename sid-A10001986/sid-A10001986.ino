@@ -107,6 +107,109 @@
 
 /*  Changelog
  *  
+ *  2026/10/19 (A10001986)
+ *    - Spectrum Analyzer: Add multirate front-end; the lowest three bands 
+ *      (80-250Hz) are now taken from a second, low-rate FFT fed by a CIC
+ *      decimator, resulting in four times the frequency resolution there.
+ *      SID_BENCH reports its cost per frame against the frame budget, for
+ *      every FFT size.
+ *    - Spectrum Analyzer: Allocate analysis buffers only while active, and convert
+ *      samples in place. This frees about 18KB of RAM while the SA is off.
+ *    - Spectrum Analyzer: Add "waterfall" display mode, selectable in Config Portal,
+ *      toggled by *65 or MQTT command SA_WATERFALL.
+ *    - Spectrum Analyzer: Add "VU meter" display mode, which skips the FFT. Selectable
+ *      in Config Portal, toggled by *66 or MQTT command SA_VU. SID_BENCH
+ *      reports its cycles per frame next to those of the FFT path.
+ *    - Spectrum Analyzer: FFT size (256-2048) now selectable in Config Portal. The
+ *      CP also shows the measured processing time per frame.
+ *    - IR: Measure marks/spaces by timestamping edges in a pin change interrupt
+ *      instead of polling the receiver every 50us. Better timing resolution,
+ *      and no more 20.000 timer interrupts per second. Hashes (used for
+ *      remotes of unknown protocol) are calculated on the durations in
+ *      50us steps, as before, so default and learned keys stay valid.
+ *    - IR: Buffer up to three received frames, so key presses are no longer lost
+ *      while the main loop is busy (eg during text display or in games).
+ *    - IR: Add decoders for NEC, Sony, RC5 and RC6 remotes. Keys of such remotes
+ *      are now learned by their exact code (hash as fallback for others).
+ *      Previously learned keys remain valid.
+ *    - IR: Up to four remotes can be learned; learning a new remote no longer
+ *      replaces the previous one. *654321 forgets all learned remotes.
+ *    - IR: Track held keys. Holding arrow up/down changes brightness continuously
+ *      (accelerating), holding left/right/down in Siddly repeats the move.
+ *    - IR: Add timing trace for diagnostics (*993 starts, *992 stops). Raw
+ *      timings are printed to serial and appended to /sidirtrace.bin on SD.
+ *    - Time Travel button/TCD trigger: Record edges in a pin change interrupt
+ *      and debounce on their exact times, so detection no longer depends on
+ *      how busy the main loop is.
+ *    - TCD-triggered (wired) time travel: Time the sequence from the trigger's
+ *      edge instead of from when the main loop noticed it. Latency statistics
+ *      are printed to serial with SID_DBG, or queried through the injector.
+ *    - Run main loop parts through a simple cooperative scheduler with per-task
+ *      runtime accounting; timeouts and delayed saves are now checked four 
+ *      times per second instead of on every loop pass. Time travel, SA/games
+ *      and idle pattern are tasks of their own; the time travel task wakes up
+ *      for the sequence's next keyframe, the SA for its next audio frame, and
+ *      the CPU idles in between.
+ *    - Add optional loop profiler (SID_PROFILE in sid_global.h): Per-subsystem
+ *      time histograms and worst cases, available through serial ('p'), Config 
+ *      Portal and MQTT (command PROFILE, published to bttf/sid/profile).
+ *      Times come from the us timer (independent of CPU clock, no wrap);
+ *      the cost of one measurement is measured at boot and reported.
+ *    - Network and display side now exchange typed messages through lock-free
+ *      queues instead of sharing flags; time travel messages have reserved
+ *      room in the queue. WiFi, MQTT and BTTFN now run in a separate task on
+ *      core 0 (SID_NETTASK in sid_global.h), so Config Portal page builds or
+ *      MQTT reconnects no longer stall Spectrum Analyzer and time travel
+ *      animations.
+ *    - Remote commands (BTTFN, MQTT) go through a lock-free multi-producer queue
+ *      carrying source and timestamp; commands are handled in batches, stale
+ *      ones dropped. MQTT input is held back while the queue is full.
+ *    - Time travel sequence is now driven by a table of phases (sid_ttseq),
+ *      shared by stand-alone and TCD-triggered time travels. Acceleration
+ *      keyframes are scheduled on absolute times instead of accumulating loop
+ *      delays. The re-entry phase is part of the table, too, and lasts at
+ *      most 3 seconds.
+ *    - Add optional serial event injector (SID_INJECT in sid_global.h) for
+ *      scripted tests: IR keys, TT button, remote commands and network events
+ *      can be injected, and a status line queried.
+ *    - Add host build (tools/host) on a virtual clock: Tests for the 
+ *      hardware-free parts (scheduler, message queues, TT sequencer, 
+ *      pattern interpreter, power states, IR capture and decoders), and
+ *      sidsim, which runs the whole firmware (setup, scheduler tasks, 
+ *      network task) against a simulated TCD, display, microphone and 
+ *      flash/SD: 6 minutes idle with screen saver, 21 time travels and 
+ *      remote commands, in well under a second. irreplay replays IR 
+ *      timing traces from SD through the decoders, with jitter and noise,
+ *      for miss and collision rates.
+ *    - Add optional micro-benchmarks (SID_BENCH in sid_global.h), run at boot:
+ *      Display rendering, FFT and SA stages, IR decoding, BTTFN and MQTT 
+ *      packet parsing, settings parsing. Results are printed as JSON lines.
+ *    - Add optional golden-frame regression (SID_GOLDEN in sid_global.h), run
+ *      at boot: Idle modes 0-5 (strict and non-strict), GPS speed baselines
+ *      and both TT sequences are played on a virtual clock with a fixed
+ *      random seed; hashes of all frames are compared against golden files
+ *      on SD (recorded if missing). Each scenario reports its virtual fps
+ *      and the real time it took, as a real rendering rate.
+ *    - Idle patterns and TT sequence use a fast seeded PRNG (xoshiro128**)
+ *      instead of the hardware RNG, with unbiased range helpers. Seeded at
+ *      boot from the hardware RNG, or with a fixed value (SID_PRNG_SEED in
+ *      sid_global.h) for identical pattern sequences across props.
+ *    - Idle patterns are now bytecode programs run by a small interpreter
+ *      (sid_patvm); the built-in patterns are compiled from text sources
+ *      (tools/patterns) by tools/sidpatc.py into sid_patprog.h. A user
+ *      pattern can be loaded from SD (/sidpat.bin), selected by *16.
+ *    - Power saving while the screen saver is active or fake power is off:
+ *      CPU clock drops to 80MHz, frequent tasks are throttled, and the
+ *      scheduler sleeps between deadlines; light sleep (woken by timer or
+ *      IR) if WiFi is off, or automatically if the IDF supports it.
+ *    - Fake power: Resume instantly where we left off when the TCD's fake
+ *      power comes back on, instead of playing the startup sequence and
+ *      starting over. The display contents, idle pattern state and
+ *      brightness are kept, SA history is kept across a suspended SA,
+ *      and games come back paused. Startup sequence can be played first
+ *      by defining SID_FPO_STARTUP. Latency from the TCD's status packet
+ *      to display off/first frame is measured (printed with SID_DBG, or
+ *      queried through the injector).
  *  2026/07/17 (A10001986) [1.74]
  *    *********************************************************************************
  *    ** If updating from below 1.70, please see boxed note at version 1.71 below    **
@@ -546,6 +649,26 @@
 #include "sid_settings.h"
 #include "sid_wifi.h"
 #include "sid_main.h"
+#include "sid_sched.h"
+#ifdef SID_BENCH
+#include "sid_bench.h"
+#endif
+
+#ifdef SID_NETTASK
+#define NET_CORE       0    // loop() runs on core 1
+#define NET_STACK_SIZE 8192
+
+// Network side: Talks to main side only through
+// the message queues and main_state() (sid_msg.h)
+static void netTask(void *parm)
+{
+    for(;;) {
+        wifi_loop();
+        bttfn_loop();
+        vTaskDelay(1);
+    }
+}
+#endif
 
 void setup()
 {
@@ -560,14 +683,23 @@ void setup()
     settings_setup();
     wifi_setup();
     main_setup();
+    #ifdef SID_BENCH
+    bench_all();
+    #endif
+    #ifdef SID_GOLDEN
+    golden_run();
+    #endif
     bttfn_loop();
+
+    main_sched_setup();
+    #ifdef SID_NETTASK
+    xTaskCreatePinnedToCore(netTask, "net", NET_STACK_SIZE, NULL, 1, NULL, NET_CORE);
+    #endif
 }
 
 void loop()
 {    
-    main_loop();
-    wifi_loop();
-    bttfn_loop();
+    sched_run();
 }
 
 #if defined(SID_DBG) || defined(SID_DBG_NET)
@@ -0,0 +1,252 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Micro-benchmarks
+ *
+ * Benchmarks for the hot paths: Rendering, FFT and SA stages, IR 
+ * decoding, BTTFN packet parsing, MQTT packet reading and settings
+ * parsing. Run once at boot if SID_BENCH is defined; results are 
+ * printed to serial as one JSON object per line:
+ *
+ * {"bench":"<name>","ver":"<fw>","mhz":<cpu>,"iter":<n>,"cyc_avg":<c>,"cyc_min":<c>,"ns_avg":<ns>}
+ *
+ * Cycle counts include the call overhead and are per call.
+ *
+ * The SA benchmarks run for every FFT size, and add a line per size
+ * comparing the cost of a frame to its budget (see sa_bench()).
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sid_global.h"
+
+#ifdef SID_BENCH
+
+#include <Arduino.h>
+
+#include "sid_bench.h"
+#include "sid_main.h"
+#include "sid_sa.h"
+#include "sid_settings.h"
+#include "input.h"
+#include "mqtt.h"
+
+static uint32_t cpuMHz = 240;
+
+/*
+ * Run func iter times (after one warm-up call) and print
+ * average and minimum cycles per call. Returns the average.
+ */
+uint32_t bench_run(const char *name, void (*func)(void), uint32_t iter)
+{
+    uint64_t total = 0;
+    uint32_t minc = 0xffffffff, c;
+
+    func();
+
+    for(uint32_t i = 0; i < iter; i++) {
+        c = ESP.getCycleCount();
+        func();
+        c = ESP.getCycleCount() - c;
+        total += c;
+        if(c < minc) minc = c;
+        // Let idle task run, keeps the watchdog happy
+        if(!(i & 63)) vTaskDelay(1);
+    }
+
+    c = iter ? total / iter : 0;
+    
+    Serial.printf("{\"bench\":\"%s\",\"ver\":\"%s\",\"mhz\":%u,\"iter\":%u,\"cyc_avg\":%u,\"cyc_min\":%u,\"ns_avg\":%u}\n",
+        name, SID_VERSION, cpuMHz, iter, c, minc, (uint32_t)((uint64_t)c * 1000 / cpuMHz));
+
+    return c;
+}
+
+// Display
+
+static int benchCnt = 0;
+
+static void bench_drawBars()
+{
+    for(int i = 0; i < 10; i++) {
+        sid.drawBarWithHeight(i, (benchCnt + i * 3) % 21);
+    }
+    benchCnt++;
+}
+
+static void bench_drawField()
+{
+    static uint8_t field[20*10];
+
+    field[benchCnt++ % (20*10)] ^= 1;
+    sid.drawFieldAndShow(field);
+}
+
+static void bench_drawLetter()
+{
+    sid.drawLetterAndShow('A' + (benchCnt++ % 26));
+}
+
+static void bench_show()
+{
+    sid.show();
+}
+
+// IR: NEC frame, 32 bits
+
+static IRRemote benchIR(0, IRREMOTE_PIN);
+
+static void bench_irHash()
+{
+    benchIR.benchHash();
+}
+
+static void bench_irDecode()
+{
+    benchIR.benchDecode();
+}
+
+static void bench_ir()
+{
+    uint16_t dur[IRBUFSIZE];
+    uint32_t code = 0x10ef20df;
+    int len = 0;
+
+    dur[len++] = 40000;     // Gap
+    dur[len++] = 9000;
+    dur[len++] = 4500;
+    for(int i = 0; i < 32; i++) {
+        dur[len++] = 560;
+        dur[len++] = (code & (1 << i)) ? 1690 : 560;
+    }
+    dur[len++] = 560;
+
+    benchIR.benchLoad(dur, len);
+    
+    bench_run("ir_hash", bench_irHash, 1000);
+    bench_run("ir_decode", bench_irDecode, 1000);
+}
+
+// MQTT: Read a PUBLISH packet from memory
+
+class benchClient : public WiFiClient {
+    public:
+        void load(const uint8_t *data, int len) { _data = data; _len = len; _pos = 0; }
+        void rewind() { _pos = 0; }
+        int  available() override { return _len - _pos; }
+        int  read() override { return (_pos < _len) ? _data[_pos++] : -1; }
+        
+    private:
+        const uint8_t *_data = NULL;
+        int _len = 0;
+        int _pos = 0;
+};
+
+static benchClient  *benchMQTTClient = NULL;
+static PubSubClient *benchMQTT = NULL;
+
+static void bench_mqttRead()
+{
+    benchMQTTClient->rewind();
+    benchMQTT->benchReadPacket();
+}
+
+static void bench_mqtt()
+{
+    static const char topic[] = "bttf/sid/cmd";
+    static const char payload[] = "TIMETRAVEL";
+    uint8_t pkt[64];
+    int len = 0;
+
+    pkt[len++] = 0x30;      // PUBLISH, QoS 0
+    pkt[len++] = 2 + sizeof(topic) - 1 + sizeof(payload) - 1;
+    pkt[len++] = 0;
+    pkt[len++] = sizeof(topic) - 1;
+    memcpy(&pkt[len], topic, sizeof(topic) - 1);
+    len += sizeof(topic) - 1;
+    memcpy(&pkt[len], payload, sizeof(payload) - 1);
+    len += sizeof(payload) - 1;
+
+    benchMQTTClient = new benchClient();
+    benchMQTT = new PubSubClient(*benchMQTTClient);
+    if(benchMQTT->setBufferSize(256)) {
+        benchMQTTClient->load(pkt, len);
+        bench_run("mqtt_readpacket", bench_mqttRead, 1000);
+    }
+    delete benchMQTT;
+    delete benchMQTTClient;
+}
+
+void bench_all()
+{
+    cpuMHz = getCpuFrequencyMhz();
+    if(!cpuMHz) cpuMHz = 240;
+
+    Serial.println("Running benchmarks");
+
+    bench_run("draw_bars", bench_drawBars, 1000);
+    bench_run("draw_field_show", bench_drawField, 200);
+    bench_run("draw_letter_show", bench_drawLetter, 200);
+    bench_run("show", bench_show, 200);
+    sid.clearDisplayDirect();
+
+    sa_bench();
+
+    bench_ir();
+
+    main_bench();
+
+    bench_mqtt();
+
+    settings_bench();
+
+    Serial.println("Benchmarks done");
+}
+
+#endif
@@ -25,6 +25,21 @@
 // Uncomment for HomeAssistant MQTT protocol support
 #define SID_HAVEMQTT
 
+// Run WiFi, MQTT and BTTFN in a task of their own on core 0, so
+// that network activity does not stall display updates. Comment out
+// to run them in the main loop on core 1, as before.
+#define SID_NETTASK
+
+// Uncomment to seed the pattern random generator with a fixed value
+// instead of the hardware RNG. Props using the same seed play the
+// same idle pattern sequence.
+//#define SID_PRNG_SEED 0x19551105
+
+// Uncomment to play the startup sequence when the TCD's fake power
+// comes back on. Without it, the display instantly resumes where it
+// left off when the power went off.
+//#define SID_FPO_STARTUP
+
 // External time travel lead time, as defined by TCD firmware
 // If SID is connected to TCD by wire, and the option "Signal Time Travel
 // without 5s lead" is set on the TCD, the SID option "TCD signals without
@@ -37,6 +52,10 @@
 
 //#define SID_DBG               // Generic except below
 //#define SID_DBG_NET           // Prop network related
+//#define SID_PROFILE           // Loop profiler (serial, CP, MQTT)
+//#define SID_INJECT            // Serial event injector for scripted tests
+//#define SID_BENCH             // Micro-benchmarks at boot (serial)
+//#define SID_GOLDEN            // Golden-frame regression at boot (serial, SD)
 
 /*************************************************************************
  ***                  esp32-arduino version detection                  ***
@@ -56,6 +56,8 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include <esp_sleep.h>
+#include <driver/rtc_io.h>
 #include "input.h"
 
 #include "sid_main.h"
@@ -64,6 +66,26 @@
 #include "sid_sa.h"
 #include "sid_siddly.h"
 #include "sid_snake.h"
+#include "sid_prof.h"
+#include "sid_msg.h"
+#include "sid_ttseq.h"
+#include "sid_prng.h"
+#include "sid_patvm.h"
+#include "sid_patprog.h"
+#include "sid_power.h"
+#include "sid_sched.h"
+
+// If the IDF is built with power management and tickless idle,
+// light sleep is automatic, and WiFi stays associated (modem 
+// sleep). Otherwise, we sleep explicitly, which cuts WiFi.
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#define SID_AUTO_LIGHTSLEEP
+#include <esp_pm.h>
+#endif
+#ifdef SID_BENCH
+#include "sid_bench.h"
+#include "sid_patref.h"
+#endif
 
 unsigned long powerupMillis = 0;
 
@@ -90,32 +112,44 @@ static SIDButton TTKey = SIDButton(TT_IN_PIN,
 static bool isTTKeyPressed = false;
 static bool isTTKeyHeld = false;
 
-bool networkTimeTravel = false;
-bool networkTCDTT      = false;
-bool networkReentry    = false;
-bool networkAbort      = false;
-bool networkAlarm      = false;
-uint16_t networkLead   = ETTO_LEAD;
-uint16_t networkP1     = 6600;
+// Set from network messages, see handleNetMsgs()
+static bool     networkTimeTravel = false;
+static bool     networkTCDTT      = false;
+static bool     networkReentry    = false;
+static bool     networkAbort      = false;
+bool            networkAlarm      = false;
+static uint16_t networkLead       = ETTO_LEAD;
+static uint16_t networkP1         = 6600;
+static bool     mqttDisp          = false;
+static char     mqttMsg[10]       = { 0 };
 
 static bool tcdIsBusy  = false;
 bool        sidBusy    = false;
 
-#define SID_IDLE_0    0
-#define SID_IDLE_1    1
-#define SID_IDLE_2    2
-#define SID_IDLE_3    3
-#define SID_IDLE_BL   4   // "backlot mode"
-#define SID_IDLE_IDC  5   // text / "identity crisis"
-
-#define SBLF_REPEAT   1
-#define SBLF_ISTT     2
-#define SBLF_LM       4
-#define SBLF_SKIPSHOW 8
-#define SBLF_LMTT     16
-#define SBLF_NOBL     32
-#define SBLF_ANIM     64
-#define SBLF_STRICT   128
+// Pattern randomness and time. Randomness comes from a seeded
+// PRNG; in golden-frame runs (SID_GOLDEN), time is virtual.
+static sidPRNG patRNG;
+static void patSeed()
+{
+    #ifdef SID_PRNG_SEED
+    patRNG.seed(SID_PRNG_SEED);
+    #else
+    patRNG.seed(esp_random());
+    #endif
+}
+static uint32_t patBelow(uint32_t n)
+{
+    return patRNG.below(n);
+}
+
+#ifdef SID_GOLDEN
+static bool          goldenRun = false;
+static unsigned long goldenNow = 0;
+#define PAT_MILLIS() (goldenRun ? goldenNow : millis())
+#else
+#define PAT_MILLIS() millis()
+#endif
+
 uint16_t              idleMode = 0;
 bool                  strictMode = true;
 static int            sidBaseLine = 0;
@@ -134,23 +168,42 @@ static unsigned long  idleDelay2 = 800;
 static char           LM[] = { 0xa8,0xa8,0xca,0xc9,0xcb,0xc3,0xa8,0xdc,0xc7,0xa8,0xdc,0xc0,0xcd,0xa8,0xce,0xdd,0xdc,0xdd,0xda,0xcd,0xa8,0 }; // Space at beginning for letting pattern grow first
 static const char     LMTT[] = { 36, 37, 38, 39, 0 };
 
-#define ID5_STEPS 14
 static int id5idx = 0;
-static const uint8_t idle5[ID5_STEPS][10] = {
-    {  6,  8,  6,  5,  8, 11, 11, 11, 12, 12 }, // 1
-    { 10, 10, 10, 11, 11, 11, 11, 11, 12, 12 }, // 2
-    { 14, 14, 15, 13, 13, 11, 11, 11, 12, 12 }, // 3
-    { 14, 14, 15, 13, 13, 13, 13, 15, 14, 14 }, // 4
-    { 14, 14, 15, 13, 13, 15, 16, 19, 16, 17 }, // 5
-    { 16, 18, 17, 15, 17, 15, 16, 19, 16, 17 }, // 6
-    { 16, 18, 17, 15, 17, 20, 18, 20, 20, 20 }, // 7
-    { 19, 20, 20, 17, 19, 20, 18, 20, 20, 20 }, // 8
-    { 16, 18, 17, 15, 17, 20, 18, 20, 20, 20 }, // 9
-    { 16, 18, 17, 15, 17, 15, 16, 19, 16, 17 }, // 10
-    { 14, 14, 15, 13, 13, 15, 16, 19, 16, 17 }, // 11
-    { 14, 14, 15, 13, 13, 13, 13, 15, 14, 14 }, // 12
-    { 14, 14, 15, 13, 13, 11, 11, 11, 12, 12 }, // 13
-    { 10, 10, 10, 11, 11, 11, 11, 11, 12, 12 }  // 14
+
+// Idle pattern programs (sid_patvm)
+static void patBars(const uint8_t *heights);
+static const uint8_t *patBuiltin[SID_IDLE_IDC + 1] = {
+    pat_idle0, pat_idle1, pat_idle2, pat_idle3, pat_idle4, pat_idle5
+};
+static uint8_t *patUser = NULL;
+static patCtx  patState = { { 0 }, 0, 0, 0, &patRNG, patBars };
+
+// Bar height modifiers (percent) around baseline
+static const uint8_t blMods[21][10] = {
+    { 130, 90, 10,  80,  10, 110, 100,  15, 120,  90 }, // g 0
+    { 130, 90, 10,  80,  10, 110, 100,  15, 100,  90 }, // g 1
+    { 130, 90, 20,  80,  15, 110, 100,  15, 120, 100 }, // g 2
+    { 110,100, 70,  80,  30,  50, 100,  15, 100, 110 }, // g 3
+    { 110,110, 40,  90,  30,  50, 100,  15,  80, 100 }, // g 4
+    { 110,110, 30, 120,  30,  50, 110,  15,  50, 100 }, // g 5
+    { 100,100, 20, 120,  10,  50, 110,  20,  40, 110 }, // g 6
+    { 110,120, 15, 110,  20,  40, 110,  18,  40, 100 }, // g 7
+    { 100,100, 15, 110,  20,  50, 100,  15,  50,  90 }, // g 8
+    {  90,110,  0, 100,  20,  50, 100,  15,  60, 100 }, // g 9
+    {  90,100, 10, 100,  10,  60,  90,  15,  40, 100 }, // g 10
+    {  90,100, 10, 100,  10,  90,  90,  15, 110, 100 }, // g 11
+    {  90, 90, 20,  90,  15, 100, 100,  50, 100,  90 }, // g 12
+    {  90, 90, 20,  90,  15, 100, 100,  50, 100,  90 }, // y 13
+    {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 14
+    {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 15
+    {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 16
+    {  90, 70, 20,  70,  15,  70,  70,  40, 100,  70 }, // y 17
+    {  90, 70, 20,  70,  15,  70,  70,  40,  90,  70 }, // y 18
+    {  90, 60, 25,  60,  15,  80,  60,  40,  90,  60 }, // r 19
+    {  90, 90, 70, 100,  90, 110,  90,  60,  95,  80 }  // extra for TT
+};
+static const uint8_t maxTTHeight[10] = {
+    19, 19, 12, 19, 19, 18, 19,  9, 19, 16
 };
 
 static bool useGPSS     = false;
@@ -169,24 +222,19 @@ static int  FPOSAMode = -1;
 static bool bttfnTT = true;
 static bool oldSidNM = false;
 
-bool doPrepareTT = false;
-bool doWakeup = false;
+static bool doPrepareTT = false;
+static bool doWakeup = false;
 
 static bool skipTTAnim = false;
 
+// Scheduler handles of tasks that set their own deadlines
+static int           schedTT = -1;
+static int           schedSA = -1;
+
 // Time travel status flags etc.
 bool                 TTrunning = false;  // TT sequence is running
 static bool          extTT = false;      // TT was triggered by TCD
-static unsigned long TTstart = 0;
-static unsigned long P0duration = ETTO_LEAD;
-static unsigned long P1_maxtimeout = 10000;
-static bool          TTP0 = false;
-static bool          TTP1 = false;
-static bool          TTP2 = false;
-static unsigned long TTFInt = 0;
-static unsigned long TTFDelay = 0;
-static unsigned long TTfUpdNow = 0;
-static int           TTcnt = 0;
+static ttSequencer   ttSeq(patBelow);
 static int           TTClrBar = 0;
 static int           TTClrBarInc = 1;
 static int           TTBarCnt = 0;
@@ -197,6 +245,39 @@ static int           TTLMIdx = 0;
 static bool          TTLMTrigger = false;
 static int           TTsidBaseLineIdx = 0;
 
+// TT_IN edge timing: micros() of edge (0 = TT not triggered
+// by wire), and latency statistics (us) from edge to TT start
+// and from edge to first displayed step
+static unsigned long TTtrigUs = 0;
+typedef struct {
+    uint32_t cnt;
+    uint32_t min;
+    uint32_t max;
+    uint32_t sum;
+} ttLatStat;
+static ttLatStat     ttLatStart = { 0, 0xffffffff, 0, 0 };
+static ttLatStat     ttLatFrame = { 0, 0xffffffff, 0, 0 };
+
+// Fake power: Snapshot of what was displayed when the TCD's
+// fake power went off, to resume from it when it comes back.
+// FPO latency: micros() of evaluating the status packet that
+// changed FPO (0 = n/a), and statistics (us) from there to
+// display off, and to the first frame after power on.
+#define FPOS_NONE   0     // No snapshot: Cold start
+#define FPOS_IDLE   1
+#define FPOS_SA     2
+#define FPOS_SI     3
+#define FPOS_SN     4
+static struct {
+    uint8_t  mode;
+    uint8_t  bri;
+    uint8_t  idleHeight[10];
+    uint16_t buf[SD_BUF_SIZE];
+} fpoSnap = { FPOS_NONE };
+static unsigned long fpoTrigUs = 0;
+static ttLatStat     fpoLatOff = { 0, 0xffffffff, 0, 0 };
+static ttLatStat     fpoLatOn  = { 0, 0xffffffff, 0, 0 };
+
 #define TT_SQF_LN 51
 static const uint8_t ttledseqfull[TT_SQF_LN][10] = {
     {  1,  0,  0,  4,  0,  0,  0,  0,  0,  0 },
@@ -297,12 +378,6 @@ static const int TTampFacts[TT_AMP_STEPS] = {
     500, 800, 1000, 1500, 2000, 2000
 };
 
-// Durations of tt phases for internal tt
-#define P0_DUR          5000    // acceleration phase
-#define P1_DUR_TCD      6600    // time tunnel phase (synced; overruled by TCD network commands)
-#define P1_DUR          5000    // time tunnel phase (stand-alone)
-#define P2_DUR          3000    // re-entry phase
-
 bool         TCDconnected = false;
 static bool  noETTOLead = false;
 
@@ -315,6 +390,8 @@ static unsigned long ssLastActivity = 0;
 static unsigned long ssDelay = 0;
 static unsigned long ssOrigDelay = 0;
 static bool          ssActive = false;
+
+static pwrState      pwr;
 static bool          ssClock = false;
 static bool          ssIsClock = false;
 static int           ssClkPos = 0;
@@ -328,30 +405,40 @@ bool                 FPBUnitIsOn = true;
 bool                 blockScan = false;
 
 /*
- * Leave first two columns at 0 here, those will be filled
- * by a user-provided ir_keys.txt file on the SD card, and 
- * learned keys respectively.
+ * Codes of the supplied remote. Learned remotes (read 
+ * from Flash/SD) are kept in learned_codes; all codes
+ * are entered in an index (irIndexCode) for lookup.
  */
-static uint32_t remote_codes[NUM_IR_KEYS][NUM_REM_TYPES] = {
-//    L  Default     (L = Learned)
-    { 0, 0x97483bfb },    // 0:  0
-    { 0, 0xe318261b },    // 1:  1
-    { 0, 0x00511dbb },    // 2:  2
-    { 0, 0xee886d7f },    // 3:  3
-    { 0, 0x52a3d41f },    // 4:  4
-    { 0, 0xd7e84b1b },    // 5:  5
-    { 0, 0x20fe4dbb },    // 6:  6
-    { 0, 0xf076c13b },    // 7:  7
-    { 0, 0xa3c8eddb },    // 8:  8
-    { 0, 0xe5cfbd7f },    // 9:  9
-    { 0, 0xc101e57b },    // 10: *
-    { 0, 0xf0c41643 },    // 11: #
-    { 0, 0x3d9ae3f7 },    // 12: arrow up
-    { 0, 0x1bc0157b },    // 13: arrow down
-    { 0, 0x8c22657b },    // 14: arrow left
-    { 0, 0x0449e79f },    // 15: arrow right
-    { 0, 0x488f3cbb }     // 16: OK/Enter
+static const uint32_t default_codes[NUM_IR_KEYS] = {
+    0x97483bfb,    // 0:  0
+    0xe318261b,    // 1:  1
+    0x00511dbb,    // 2:  2
+    0xee886d7f,    // 3:  3
+    0x52a3d41f,    // 4:  4
+    0xd7e84b1b,    // 5:  5
+    0x20fe4dbb,    // 6:  6
+    0xf076c13b,    // 7:  7
+    0xa3c8eddb,    // 8:  8
+    0xe5cfbd7f,    // 9:  9
+    0xc101e57b,    // 10: *
+    0xf0c41643,    // 11: #
+    0x3d9ae3f7,    // 12: arrow up
+    0x1bc0157b,    // 13: arrow down
+    0x8c22657b,    // 14: arrow left
+    0x0449e79f,    // 15: arrow right
+    0x488f3cbb     // 16: OK/Enter
 };
+static uint32_t learned_codes[NUM_IR_REMOTES][NUM_IR_KEYS] = { 0 };
+
+// Open-addressed index code -> (remote, key). At most
+// (NUM_IR_REMOTES + 1) * NUM_IR_KEYS = 85 codes, so at most 2/3 full.
+// Codes and remote/key kept apart to avoid padding (640 bytes).
+#define IR_INDEX_BITS 7     // 128 entries
+#define IR_INDEX_SIZE (1 << IR_INDEX_BITS)
+#define IR_REM_DEFAULT NUM_IR_REMOTES
+static uint32_t      irIndexCode[IR_INDEX_SIZE];    // 0 = empty
+static uint8_t       irIndexRK[IR_INDEX_SIZE];      // remote * NUM_IR_KEYS + key
+static bool          useDefaultIR = true;
 
 #define INPUTLEN_MAX 6
 static char          inputBuffer[INPUTLEN_MAX + 2];
@@ -359,9 +446,12 @@ static char          inputBackup[INPUTLEN_MAX + 2];
 static int           inputIndex = 0;
 static bool          inputRecord = false;
 static unsigned long lastKeyPressed = 0;
-static int           maxIRctrls = NUM_REM_TYPES;
 
 #define IR_FEEDBACK_DUR 300
+#define IR_REP_DELAY    400     // Held key: ms until first repeat
+#define IR_REP_INTERVAL 150     // Held key: ms between first repeats
+#define IR_REP_MIN       50     // Held key: Minimum ms between repeats
+#define IR_REP_ACCEL     85     // Held key: Interval shrinks to 85% with each repeat
 static bool          irFeedBack = false;
 static unsigned long irFeedBackNow = 0;
 static unsigned long irFeedBackDur = IR_FEEDBACK_DUR;
@@ -375,6 +465,7 @@ bool                 irLocked = false;
 
 bool                 IRLearning = false;
 static uint32_t      backupIRcodes[NUM_IR_KEYS];
+static int           IRLearnRemote = 0;
 static int           IRLearnIndex = 0;
 static unsigned long IRLearnNow;
 static unsigned long IRFBLearnNow;
@@ -468,6 +559,20 @@ static uint32_t      bttfnSessionID = 0;
 int                  bttfnHaveTCDSSID = 0;
 char                 TCDSSID[8] = { 0 };
 uint8_t              TCDpwMarker = 0;
+static bool          bttfnLinkUp = false;       // Last NM_TCDLINK sent
+
+// Main side copies of network state
+static bool          tcdLinkUp = false;
+static unsigned long sidPollInt = BTTFN_POLL_INT;
+static unsigned long sidPollIntSent = BTTFN_POLL_INT;
+static unsigned long sidPollFastNow = 0;
+
+// Message queues between network and main side (sid_msg.h)
+static msgQueue<netMsg, 32> toMain;
+static msgQueue<netMsg, 16> toNet;
+static uint32_t      toMainTTLost = 0;  // NM_TT/REENTRY/ABORT dropped
+static volatile bool mainHaltReq = false;
+static volatile bool mainHalted = false;
 static uint8_t       bttfnReqStatus = 0x53; // Request capabilities, status, speed, date/time
 static bool          TCDSupportsRemKP = false;
 static bool          TCDSupportsNOTData = false;
@@ -483,9 +588,11 @@ enum {
     BTTFN_KP_KS_HOLD,
 };
 
-static int      iCmdIdx = 0;
-static int      oCmdIdx = 0;
-static uint32_t commandQueue[16] = { 0 };
+#define CMD_QUEUE_SIZE  16
+#define CMD_BATCH        4      // Max commands handled per pass
+#define CMD_MAX_AGE  30000      // Commands older than this (ms) are dropped
+static mpscQueue<sidCmd, CMD_QUEUE_SIZE> cmdQueue;
+static uint32_t cmdDropped[CMDSRC_NUM] = { 0 };
 
 static uint8_t  bttfnDateBuf[8] = { 0xff };
 static unsigned long bttfnDateNow = 0;
@@ -503,11 +610,11 @@ static unsigned long bttfnDateNow = 0;
 #define GET32(a,b)    *((uint32_t *)((a) + (b)))
 #define SET32(a,b,c)  *((uint32_t *)((a) + (b))) = c
 #else
-#define GET32(a,b)          \
-    (((a)[b])            |  \
-    (((a)[(b)+1]) << 8)  |  \
-    (((a)[(b)+2]) << 16) |  \
-    (((a)[(b)+3]) << 24))   
+#define GET32(a,b)                    \
+    (((uint32_t)(a)[b])            |  \
+    (((uint32_t)(a)[(b)+1]) << 8)  |  \
+    (((uint32_t)(a)[(b)+2]) << 16) |  \
+    (((uint32_t)(a)[(b)+3]) << 24))   
 #define SET32(a,b,c)                        \
     (a)[b]       = ((uint32_t)(c)) & 0xff;  \
     ((a)[(b)+1]) = ((uint32_t)(c)) >> 8;    \
@@ -518,10 +625,13 @@ static unsigned long bttfnDateNow = 0;
 // Forward declarations ------
 
 static void startIRLearn();
+static void rebuildIRIndex();
+static void flushIRTrace();
 static void endIRLearn(bool restore);
 static void handleIRinput();
-static void handleIRKey(int command);
+static void handleIRKey(int command, bool isRepeat = false);
 static void handleRemoteCommand();
+static void execRemoteCommand(const sidCmd& cmd);
 static void clearInpBuf();
 static int  execute(bool isIR, bool injected);
 static void startIRfeedback();
@@ -530,7 +640,14 @@ static void endIRfeedback();
 static void showBaseLine(int variation = 20, uint16_t flags = 0);
 static bool showIdle(bool freezeBaseLine = false);
 static void play_startup();
-static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur = 0);
+static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur = 0, unsigned long trigUs = 0);
+static void ttLatFirstFrame();
+static void ttLatAdd(ttLatStat& st, uint32_t lat);
+static void fpoLatAdd(ttLatStat& st, const char *what);
+static void fpoSuspend(bool warm);
+static bool fpoResume();
+static void ttFeedEvents();
+static void ttLoop(unsigned long now);
 
 static void showChar(const char text);
 static void fadeOutChar();
@@ -556,11 +673,24 @@ static void ssUpdateClock();
 
 static void setTTOUT(uint8_t stat);
 
+static void main_power();
+static void pwrSleep(unsigned long ms);
+
+static void handleNetMsgs();
+#ifdef SID_INJECT
+static void inj_serial();
+#endif
+static void handleMainMsgs();
+static void cpUpdate(uint8_t what);
+
 static bool bttfn_connected();
 static bool bttfn_trigger_tt();
+static bool bttfn_queue_command(uint8_t cmd, uint8_t p1, uint8_t p2);
 static bool bttfn_send_command(uint8_t cmd, uint8_t p1, uint8_t p2);
 static void bttfn_setup();
+#ifndef SID_NETTASK
 static void bttfn_loop_quick();
+#endif
 
 void main_boot()
 {
@@ -570,25 +700,35 @@ void main_boot()
     // Reset TT-OUT
     pinMode(TT_OUT_PIN, OUTPUT);
     digitalWrite(TT_OUT_PIN, LOW);
+
+    patSeed();
 }
 
 void main_setup()
 {
     char *s = LM;
+    int patLen;
     
     Serial.println("Status Indicator Display version " SID_VERSION " " SID_VERSION_EXTRA);
 
     // Load settings
     loadBrightness();
     loadIdlePat();                    // load idle pattern
+    if((patUser = loadUserPattern(patLen))) {
+        if(!patVerify(patUser, patLen)) {
+            Serial.println("User idle pattern invalid, ignored");
+            free(patUser);
+            patUser = NULL;
+        }
+    }
     loadStrict();                     // load strictMode
-    updateConfigPortalStrictValue();  // Update current CP value
+    updateConfigPortalStrictValue(strictMode);  // Update current CP value
     loadIRLock();
     loadSASettings();
-    updateConfigPortalSAValues();
+    updateConfigPortalSAValues(saMode, doPeaks, doMirror);
     loadPosIRFB();
     loadIRCFB();
-    updateConfigPortalIRFBValues();
+    updateConfigPortalIRFBValues(irShowPosFBDisplay, irShowCmdFBDisplay);
 
     // Other options
     bootMode = loadBootMode();
@@ -602,8 +742,10 @@ void main_setup()
 
     skipTTAnim = evalBool(settings.skipTTAnim);
 
-    if(evalBool(settings.disDIR))
-        maxIRctrls--;
+    sa_setFFTSize(atoi(settings.SAfftSz));
+
+    useDefaultIR = !evalBool(settings.disDIR);
+    rebuildIRIndex();
     
     // [formerly started CP here]
 
@@ -621,6 +763,7 @@ void main_setup()
     digitalWrite(IRFeedBackPin, LOW);
 
     // Set up TT button / TCD trigger
+    TTKey.begin();
     TTKey.attachPress(TTKeyPressed);
     if(!TCDconnected) {
         // If we are in fact a physical button, we need
@@ -650,6 +793,11 @@ void main_setup()
     Serial.println("Booting IR Receiver");
     #endif
     ir_remote.begin();
+    ir_remote.setRepeat(IR_REP_DELAY, IR_REP_INTERVAL, IR_REP_MIN, IR_REP_ACCEL);
+
+    #ifdef SID_PROFILE
+    prof_begin();
+    #endif
 
     memset(bttfnDateBuf, 0xff, sizeof(bttfnDateBuf));
 
@@ -658,7 +806,7 @@ void main_setup()
     bttfn_loop();
 
     // Other inits
-    idleDelay2 = 800 + ((int)(esp_random() % 200) - 100);
+    idleDelay2 = patRNG.range(700, 899);
 
     for( ; *s; ++s) *s ^= (SBLF_SKIPSHOW + SBLF_STRICT);
 
@@ -702,25 +850,64 @@ void main_setup()
     Serial.println("main_setup() done");
     #endif
 
+    // Scheduler waits through power management
+    sched_setSleep(pwrSleep);
+
     // Delete previous IR input, start fresh
     ir_remote.resume();  
 }
 
+/*
+ * Register the tasks with the scheduler. With SID_NETTASK,
+ * the network side runs as a task of its own, started by
+ * the caller.
+ */
+void main_sched_setup()
+{
+    sched_add("IR",      main_ir_loop,      IR_TASK_INT,   SCHED_PRIO_HIGH);
+    schedTT = 
+    sched_add("TT",      main_tt_loop,      TT_TASK_INT,   SCHED_PRIO_HIGH);
+    sched_add("Main",    main_loop,         MAIN_TASK_INT, SCHED_PRIO_NORMAL);
+    schedSA = 
+    sched_add("SA",      main_sa_loop,      SA_TASK_INT,   SCHED_PRIO_NORMAL);
+    sched_add("Idle",    main_idle_loop,    IDLE_TASK_INT, SCHED_PRIO_NORMAL);
+    #ifndef SID_NETTASK
+    sched_add("WiFi",    wifi_loop,         NET_TASK_INT,  SCHED_PRIO_NORMAL);
+    sched_add("BTTFN",   bttfn_loop,        NET_TASK_INT,  SCHED_PRIO_NORMAL);
+    #endif
+    sched_add("Housekp", main_housekeeping, HK_TASK_INT,   SCHED_PRIO_LOW);
+}
+
 void main_loop()
 {
     unsigned long now = millis();
 
-    // Reset polling interval; will be overruled in showIdle if applicable
-    bttfnSIDPollInt = BTTFN_POLL_INT;
+    PROF_SCOPE(PROF_MAIN);
+
+    handleNetMsgs();
+
+    // Tell network side about poll interval: Fast while showIdle 
+    // recently followed the speed (idle and TT run as other tasks)
+    sidPollInt = (sidPollFastNow && (now - sidPollFastNow < 1000)) ? 
+                      BTTFN_POLL_INT_FAST : BTTFN_POLL_INT;
+    if(sidPollInt != sidPollIntSent) {
+        if(postToNet(NC_POLLINT, sidPollInt)) {
+            sidPollIntSent = sidPollInt;
+        }
+    }
 
     // Follow TCD fake power
     if(useFPO && (tcdFPO != fpoOld)) {
         if((fpoOld = tcdFPO)) {
             // Power off:
             FPBUnitIsOn = false;
+
+            // Resume later only from a steady display
+            bool warm = !TTrunning && !IRLearning && !ssActive;
             
             if(TTrunning) {
                 TTrunning = false;
+                ttSeq.stop();
                 // Reset to idle
                 sa_setAmpFact(100);
                 sid.setBrightness(255);
@@ -740,11 +927,15 @@ void main_loop()
             
             // Display OFF
             sid.off();
+            fpoLatAdd(fpoLatOff, "off");
 
             // Backup last mode (idle or sa)
             FPOSAMode = saActive ? 1 : 0;
 
-            // Specials off
+            // Take snapshot, suspend specials
+            fpoSuspend(warm);
+
+            // Specials off (unless suspended)
             span_stop();
             siddly_stop();
             snake_stop();
@@ -759,44 +950,43 @@ void main_loop()
         } else {
             // Power on: 
             FPBUnitIsOn = true;
-            
-            // Display ON, idle
-            sid.clearDisplayDirect();
-            lastChange = 0;
-            sid.setBrightness(255);
-            sid.on();
 
             TTKey.reset();
             isTTKeyHeld = isTTKeyPressed = false;
             networkTimeTravel = false;
+            
+            // Resume from snapshot, or start over
+            if(!fpoResume()) {
+
+                // Display ON, idle
+                sid.clearDisplayDirect();
+                lastChange = 0;
+                sid.setBrightness(255);
+                sid.on();
+
+                // Play startup sequence
+                play_startup();
 
-            // Play startup sequence
-            play_startup();
+                sidBaseLine = strictBaseLine = 0;
+                LMState = LMIdx = id5idx = 0;
+
+                // Restore sa mode if active before FPO
+                if(bootMode == BOOTM_SA || (FPOSAMode > 0)) {
+                    span_start();
+                    bootMode = BOOTM_IGNORE;
+                }
+            }
 
             ssRestartTimer();
             ssActive = ssIsClock = false;
 
-            sidBaseLine = strictBaseLine = 0;
-            LMState = LMIdx = id5idx = 0;
-
-            ir_remote.loop();
+            ir_remote.resume();
 
             // anything else?
-
-            // Restore sa mode if active before FPO
-            if(bootMode == BOOTM_SA || (FPOSAMode > 0)) {
-                span_start();
-                bootMode = BOOTM_IGNORE;
-            }
  
         }
     }
 
-    // Discard (incomplete) input from IR after 30 seconds of inactivity
-    if(now - lastKeyPressed >= 30*1000) {
-        clearInpBuf();
-    }
-
     // Eval flags set in handle_tcd_notification
     if(doPrepareTT) {
         if(FPBUnitIsOn && !IRLearning && !TTrunning) {
@@ -843,26 +1033,6 @@ void main_loop()
         }
     }
 
-    // IR Remote loop
-    if(FPBUnitIsOn) {
-        if(ir_remote.loop()) {
-            handleIRinput();
-        }
-        if(!IRLearning) {
-            handleRemoteCommand();
-        }
-    }
-
-    // Spectrum analyzer / Siddly / Snake loops
-    if(FPBUnitIsOn && !TTrunning) {
-        //unsigned long now2 = millis();
-        sa_loop();
-        //now2 = millis() - now2;
-        //if(now2 > 0) Serial.printf("%d\n", now2);
-        si_loop();
-        sn_loop();
-    }
-    
     // IR learning triggered by IR?
     if(triggerIRLN && (now - triggerIRLNNow > 1000)) {
         triggerIRLN = false;
@@ -900,8 +1070,11 @@ void main_loop()
                 if(TCDconnected) {
                     ssEnd();
                 }
-                if(TCDconnected || !bttfnTT || !bttfn_trigger_tt()) {
-                    timeTravel(TCDconnected, (TCDconnected && noETTOLead) ? 0 : ETTO_LEAD);
+                if(TCDconnected) {
+                    // Sync to the edge, not to when we noticed it
+                    timeTravel(true, noETTOLead ? 0 : ETTO_LEAD, 0, TTKey.eventTime());
+                } else if(!bttfnTT || !bttfn_trigger_tt()) {
+                    timeTravel(false, ETTO_LEAD);
                 }
             }
         }
@@ -919,324 +1092,75 @@ void main_loop()
         TTKey.reset();
     }
 
-    now = millis();
-    
-    if(TTrunning) {
-
-        if(extTT) {
-
-            // ***********************************************************************************
-            // TT triggered by TCD (BTTFN, GPIO or MQTT) *****************************************
-            // ***********************************************************************************
-
-            if(TTP0) {   // Acceleration - runs for ETTO_LEAD ms by default
-
-                if(!networkAbort && (now - TTstart < P0duration)) {
-
-                    if(!TTFDelay || (now - TTfUpdNow >= TTFDelay)) {
-
-                        if(TTFDelay) {
-                            TTFDelay = 0;
-                            TTfUpdNow = now;
-                        } else if(TTFInt && (now - TTfUpdNow >= TTFInt)) {                          
-                            if(saActive) {
-                                if(TTcnt > 0) {
-                                    TTcnt--;
-                                    sa_setAmpFact(TTampFacts[TT_AMP_STEPS - 1 - TTcnt]);
-                                }
-                            } else {
-                                if(TTcnt > 0) {
-                                    TTcnt--;
-                                    if(TTsbFlags & SBLF_STRICT) {
-                                        TTsidBaseLineIdx = TT_SQF_LN - 1 - TTcnt;
-                                        for(int i = 0; i < 10; i++) {
-                                            sid.drawBarWithHeight(i, ttledseqfull[TT_SQF_LN - 1 - TTcnt][i]);
-                                        }
-                                    } else {
-                                        TTsidBaseLineIdx = TT_SQ_LN - 1 - TTcnt;
-                                        for(int i = 0; i < 10; i++) {
-                                            sid.drawBarWithHeight(i, ttledseq[TT_SQ_LN - 1 - TTcnt][i]);
-                                        }
-                                    }
-                                    sid.show();
-                                }
-                            }
-                            TTfUpdNow = now;
-                        }
-
-                        if(saActive) {
-                            sa_loop();
-                        }
-
-                    } else {
-
-                        if(saActive) {
-                            sa_loop();                            
-                        } else {
-                            showIdle(true);
-                        }
-
-                    }
-
-                } else {
-
-                    if(!networkAbort) {
-
-                        setTTOUT(HIGH);
-                      
-                        if(TTstart == TTfUpdNow) {
-                            // If we have missed P0, set last step of sequence at least
-                            // Do this also in sa mode and if strict (pattern is same)
-                            for(int i = 0; i < 10; i++) {
-                                sid.drawBarWithHeight(i, ttledseq[TT_SQ_LN - 1][i]);
-                            }
-                            sid.show();
-                        }
-    
-                        if(saActive) {
-                            //span_stop(true);
-                            sa_deactivate();
-                            TTSAStopped = true;
-                        }
-
-                        strictBaseLine = TT_SQF_LN - 1;
-                        sidBaseLine = 19;
-
-                    } else {
-
-                        // determine baseline at time of abort
-                        if(TTsbFlags & SBLF_STRICT) {
-                            strictBaseLine = TTsidBaseLineIdx;
-                        } else {
-                            sidBaseLine = TTsidBaseLineIdx;
-                        }
-
-                    }
-
-                    TTP0 = false;
-                    TTP1 = true;
-                    
-                    TTstart = TTfUpdNow = now;
-                    TTFInt = 1000 + ((int)(esp_random() % 200) - 100);
-
-                    TTClrBar = TTBarCnt = 0;
-                    TTClrBarInc = 1;
-                    TTBri = false;
-
-                    TTLMIdx = 0;
-                    TTLMTrigger = false;
-
-                }
-            }
-            if(TTP1) {   // Peak/"time tunnel" - ends with pin going LOW or MQTT "REENTRY" (or a long timeout)
-
-                if(((networkTCDTT && (!networkReentry && !networkAbort)) || 
-                  (!networkTCDTT && digitalRead(TT_IN_PIN)))               &&
-                  (millis() - TTstart <  P1_maxtimeout) ) {
-
-                    if(TTFInt && (now - TTfUpdNow >= TTFInt)) {
-                        if(TTLMTrigger) {
-                            TTLMIdx++;
-                            if(!LMTT[TTLMIdx]) TTLMIdx = 0;
-                        }
-                        showBaseLine(80, TTsbFlags | SBLF_ISTT);
-                        TTfUpdNow = now;
-                        if(TTsbFlags & SBLF_LMTT) {
-                            TTLMTrigger = true;
-                            TTFInt = 130;
-                        } else {
-                            TTFInt = 100 + ((int)(esp_random() % 100) - 50);
-                        }
-                    }
-                    
-                } else {
-
-                    TTP1 = false;
-                    TTP2 = true;
-
-                    setTTOUT(LOW);
-
-                    sid.setBrightness(255);
-
-                    TTFInt = 50;
-                    TTfUpdNow = now;
-                    
-                }
-            }
-            if(TTP2) {   // Reentry - up to us
-
-                // Idle mode: Let showIdle take care of calming us down
-                // SA mode: reduce ampFactor gradually
-
-                if(TTSAStopped) {
-                    sa_activate(false, 500);
-                    TTSAStopped = false;
-                }
-                if(saActive && sa_setAmpFact(-1) > 100) {
-                    if(now - TTfUpdNow >= TTFInt) {
-                        TTcnt++;
-                        if(TTcnt <= TT_AMP_STEPS) {
-                            sa_setAmpFact(TTampFacts[TT_AMP_STEPS - 1 - TTcnt]);
-                        }
-                        TTfUpdNow = now;
-                        TTFInt = 400 + ((int)(esp_random() % 100) - 50);
-                    }
-                    sa_loop();
-                } else {
-                    TTP2 = false;
-                    TTrunning = false;
-                    isTTKeyHeld = isTTKeyPressed = false;
-                    ssRestartTimer();
-                    sa_setAmpFact(100);
-                    LMState = LMIdx = id5idx = 0;
-                }
-
-            }
-          
+    // Follow TCD night mode
+    if(useNM && (tcdNM != nmOld)) {
+        if(tcdNM) {
+            // NM on: Set Screen Saver timeout to 10 seconds
+            ssDelay = 10 * 1000;
+            sidNM = true;
         } else {
+            // NM off: End Screen Saver; reset timeout to old value
+            ssEnd();  // Doesn't do anything if fake power is off
+            ssDelay = ssOrigDelay;
+            sidNM = false;
+        }
+        nmOld = tcdNM;
+    }
 
-            // ****************************************************************************
-            // TT triggered by button (if TCD not connected), MQTT or IR ******************
-            // ****************************************************************************
-          
-            if(TTP0) {   // Acceleration - runs for P0_DUR ms
-
-                if(now - TTstart < P0_DUR) {
-
-                    if(!TTFDelay || (now - TTfUpdNow >= TTFDelay)) {
-
-                        TTFDelay = 0;
-                        if(TTFInt && (now - TTfUpdNow >= TTFInt)) {
-                            if(saActive) {
-                                if(TTcnt > 0) {
-                                    TTcnt--;
-                                    sa_setAmpFact(TTampFacts[TT_AMP_STEPS - 1 - TTcnt]);
-                                }
-                            } else {
-                                if(TTcnt > 0) {
-                                    TTcnt--;
-                                    if(TTsbFlags & SBLF_STRICT) {
-                                        for(int i = 0; i < 10; i++) {
-                                            sid.drawBarWithHeight(i, ttledseqfull[TT_SQF_LN - 1 - TTcnt][i]);
-                                        }
-                                    } else {
-                                        for(int i = 0; i < 10; i++) {
-                                            sid.drawBarWithHeight(i, ttledseq[TT_SQ_LN - 1 - TTcnt][i]);
-                                        }
-                                    }
-                                    sid.show();
-                                }
-                            }
-                            TTfUpdNow = now;
-                        }
-                        
-                        if(saActive) {
-                            sa_loop();
-                        }
-
-                    } else {
-                        
-                        if(saActive) {
-                            sa_loop();
-                        } else {
-                            showIdle(true);
-                        }
-
-                    }
-
-                } else {
-
-                    if(saActive) {
-                        sa_deactivate();
-                        TTSAStopped = true;
-                    }
-
-                    setTTOUT(HIGH);
-
-                    TTP0 = false;
-                    TTP1 = true;
-                    sidBaseLine = 19;
-                    strictBaseLine = TT_SQF_LN - 1;
-                    TTstart = TTfUpdNow = now;
-                    TTFInt = 1000 + ((int)(esp_random() % 200) - 100);
-
-                    TTClrBar = TTBarCnt = 0;
-                    TTClrBarInc = 1;
-                    TTBri = false;
-
-                    TTLMIdx = 0;
-                    TTLMTrigger = false;
-                    
-                }
-            }
-            
-            if(TTP1) {   // Peak/"time tunnel" - runs for P1_DUR ms
-
-                if(now - TTstart < P1_DUR) {
-                    
-                    if(TTFInt && (now - TTfUpdNow >= TTFInt)) {
-                        if(TTLMTrigger) {
-                            TTLMIdx++;
-                            if(!LMTT[TTLMIdx]) TTLMIdx = 0;
-                        }
-                        showBaseLine(80, TTsbFlags | SBLF_ISTT);
-                        TTfUpdNow = now;
-                        if(TTsbFlags & SBLF_LMTT) {
-                            TTLMTrigger = true;
-                            TTFInt = 130;
-                        } else {
-                            TTFInt = 100 + ((int)(esp_random() % 100) - 50);
-                        }
-                    }
-                    
-                } else {
-
-                    TTP1 = false;
-                    TTP2 = true;
-
-                    setTTOUT(LOW);
+    main_power();
+}
 
-                    sid.setBrightness(255);
+// Time travel sequence; a scheduler task of its own. While
+// a TT runs, it wakes up for the sequencer's next keyframe
+// or tick (but at least every TT_TASK_INT ms for events and
+// animations); otherwise it sleeps until timeTravel() kicks it.
+void main_tt_loop()
+{
+    unsigned long now = millis();
+    
+    if(TTrunning) {
+        PROF_SCOPE(PROF_MAIN);
+        ttFeedEvents();
+        ttLoop(now);
+    }
 
-                    TTFInt = 50;
-                    TTfUpdNow = now;
-                    
-                }
-            }
-            
-            if(TTP2) {   // Reentry - up to us
+    if(TTrunning) {
+        sched_runAt(schedTT, now + min(ttSeq.due(now), (uint32_t)TT_TASK_INT));
+    } else {
+        sched_runAt(schedTT, now + TT_IDLE_INT);
+    }
+}
 
-                // Idle mode: Let showIdle take care of calming us down
-                // SA mode: reduce ampFactor gradually
+// Spectrum analyzer / Siddly / Snake; a scheduler task of its
+// own. The SA wakes it up when its next frame is due.
+void main_sa_loop()
+{
+    uint32_t wait = SA_TASK_INT;
+    
+    if(FPBUnitIsOn && !TTrunning) {
+        sa_loop();
+        si_loop();
+        sn_loop();
+        if(saActive) {
+            wait = sa_due();
+        }
+    }
 
-                if(TTSAStopped) {
-                    sa_activate(false, 500);
-                    TTSAStopped = false;
-                }
-                if(saActive && sa_setAmpFact(-1) > 100) {
-                    if(now - TTfUpdNow >= TTFInt) {
-                        TTcnt++;
-                        if(TTcnt <= TT_AMP_STEPS) {
-                            sa_setAmpFact(TTampFacts[TT_AMP_STEPS - 1 - TTcnt]);
-                        }
-                        TTfUpdNow = now;
-                        TTFInt = 400 + ((int)(esp_random() % 100) - 50);
-                    }
-                    sa_loop();
-                } else {
-                    TTP2 = false;
-                    TTrunning = false;
-                    isTTKeyHeld = isTTKeyPressed = false;
-                    ssRestartTimer();
-                    sa_setAmpFact(100);
-                    LMState = LMIdx = id5idx = 0;
-                }
+    sched_runAt(schedSA, millis() + wait);
+}
 
-            }
+// Idle pattern, screen saver, alarm/text display; a scheduler
+// task of its own
+void main_idle_loop()
+{
+    unsigned long now;
 
-        }
+    if(TTrunning)
+        return;
 
-    } else if(!siActive && !snActive && !saActive) {    // No TT currently
+    PROF_SCOPE(PROF_MAIN);
+    
+    if(!siActive && !snActive && !saActive) {
 
         if(!IRLearning) {
 
@@ -1254,7 +1178,7 @@ void main_loop()
                     networkAlarm = false;
                 } else {
                     showWordSequence(mqttMsg, 4);
-                    mqttDisp = 0;
+                    mqttDisp = false;
                 }
                 
                 if(!FPBUnitIsOn) {
@@ -1306,36 +1230,39 @@ void main_loop()
             oldSidNM = sidNM;
         }
     }
+}
 
-    // Follow TCD night mode
-    if(useNM && (tcdNM != nmOld)) {
-        if(tcdNM) {
-            // NM on: Set Screen Saver timeout to 10 seconds
-            ssDelay = 10 * 1000;
-            sidNM = true;
-        } else {
-            // NM off: End Screen Saver; reset timeout to old value
-            ssEnd();  // Doesn't do anything if fake power is off
-            ssDelay = ssOrigDelay;
-            sidNM = false;
+// IR input; a scheduler task of its own
+void main_ir_loop()
+{
+    if(FPBUnitIsOn) {
+        if(ir_remote.loop()) {
+            handleIRinput();
+        }
+        if(ir_remote.isTracing()) {
+            flushIRTrace();
+        }
+        if(!IRLearning) {
+            handleRemoteCommand();
         }
-        nmOld = tcdNM;
     }
+}
 
-    now = millis();
+// Timeouts and delayed saves; a scheduler task which 
+// runs every few hundred ms
+void main_housekeeping()
+{
+    unsigned long now = millis();
 
-    // If network is interrupted, return to stand-alone
-    if(useBTTFN) {
-        if( !bttfnDataNotEnabled &&
-            ((lastBTTFNpacket && (now - lastBTTFNpacket > 30*1000)) ||
-             (!BTTFNBootTO && !lastBTTFNpacket && (now - powerupMillis > 60*1000))) ) {
-            tcdNM = false;
-            tcdFPO = false;
-            remoteAllowed = remMode = remHoldKey = false;
-            gpsSpeed = -1;
-            lastBTTFNpacket = 0;
-            BTTFNBootTO = true;
-        }
+    #if defined(SID_INJECT)
+    inj_serial();
+    #elif defined(SID_PROFILE)
+    prof_serial();
+    #endif
+
+    // Discard (incomplete) input from IR after 30 seconds of inactivity
+    if(now - lastKeyPressed >= 30*1000) {
+        clearInpBuf();
     }
 
     if(!TTrunning) {
@@ -1384,33 +1311,6 @@ void flushDelayedSave()
 
 static void showBaseLine(int variation, uint16_t flags)
 {
-    const int mods[21][10] = {
-        { 130, 90, 10,  80,  10, 110, 100,  15, 120,  90 }, // g 0
-        { 130, 90, 10,  80,  10, 110, 100,  15, 100,  90 }, // g 1
-        { 130, 90, 20,  80,  15, 110, 100,  15, 120, 100 }, // g 2
-        { 110,100, 70,  80,  30,  50, 100,  15, 100, 110 }, // g 3
-        { 110,110, 40,  90,  30,  50, 100,  15,  80, 100 }, // g 4
-        { 110,110, 30, 120,  30,  50, 110,  15,  50, 100 }, // g 5
-        { 100,100, 20, 120,  10,  50, 110,  20,  40, 110 }, // g 6
-        { 110,120, 15, 110,  20,  40, 110,  18,  40, 100 }, // g 7
-        { 100,100, 15, 110,  20,  50, 100,  15,  50,  90 }, // g 8
-        {  90,110,  0, 100,  20,  50, 100,  15,  60, 100 }, // g 9
-        {  90,100, 10, 100,  10,  60,  90,  15,  40, 100 }, // g 10
-        {  90,100, 10, 100,  10,  90,  90,  15, 110, 100 }, // g 11
-        {  90, 90, 20,  90,  15, 100, 100,  50, 100,  90 }, // g 12
-        {  90, 90, 20,  90,  15, 100, 100,  50, 100,  90 }, // y 13
-        {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 14
-        {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 15
-        {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 16
-        {  90, 70, 20,  70,  15,  70,  70,  40, 100,  70 }, // y 17
-        {  90, 70, 20,  70,  15,  70,  70,  40,  90,  70 }, // y 18
-        {  90, 60, 25,  60,  15,  80,  60,  40,  90,  60 }, // r 19
-        {  90, 90, 70, 100,  90, 110,  90,  60,  95,  80 }  // extra for TT
-    };
-    const uint8_t maxTTHeight[10] = {
-        19, 19, 12, 19, 19, 18, 19,  9, 19, 16
-    };
-
     int bh, a = sidBaseLine, b;
     int vc = (flags & SBLF_ISTT) ? 0 : variation / 2;
 
@@ -1429,11 +1329,11 @@ static void showBaseLine(int variation, uint16_t flags)
         } else {
             if(!(flags & SBLF_STRICT)) {
                 for(int i = 0; i < 10; i++) {
-                    bh = a * (mods[b][i] + ((int)(esp_random() % variation)-vc)) / 100;
+                    bh = a * (blMods[b][i] + ((int)patRNG.below(variation)-vc)) / 100;
                     if(bh < 0) bh = 0;
                     if(bh > 19) bh = 19;
                     if((flags & SBLF_LM) && bh < 9) {
-                        bh = 9 + (int)(esp_random() % 4);
+                        bh = 9 + (int)patRNG.below(4);
                     }
                     if(!(flags & SBLF_ISTT) && abs(bh - oldIdleHeight[i]) > 5) {
                         bh = (oldIdleHeight[i] + bh) / 2;
@@ -1478,7 +1378,7 @@ static void showBaseLine(int variation, uint16_t flags)
                 int temp1 = sid.getBrightness(), temp2 = 3;
                 if(temp1 >= 4) temp1 -= 2;
                 else { temp1 = 2; temp2 = 0; }
-                sid.setBrightnessDirect((esp_random() % temp1) + temp2); //       13) + 3);
+                sid.setBrightnessDirect(patRNG.below(temp1) + temp2); //       13) + 3);
             }
             if(flags & SBLF_LMTT) {
                 if(LMTT[TTLMIdx]) {
@@ -1498,23 +1398,80 @@ static void showBaseLine(int variation, uint16_t flags)
     #endif
 }
 
-static bool showIdle(bool freezeBaseLine)
+static void patBars(const uint8_t *heights)
 {
-    unsigned long now = millis();
-    int oldBaseLine = sidBaseLine;
-    int oldSBaseLine = strictBaseLine;
-    int variation = 20;
-    uint16_t sblFlags = 0;
-
-    idleDelay2 = 800 + ((int)(esp_random() % 200) - 100);
-
-    if(useGPSS && gpsSpeed >= 0) {
+    for(int i = 0; i < 10; i++) {
+        sid.drawBarWithHeight(i, heights[i]);
+    }
+}
 
-        if(!bttfnTCDSeqCnt) {
-            bttfnSIDPollInt = BTTFN_POLL_INT_FAST;
-        }
+/*
+ * Idle pattern step (not speed-driven): Run the pattern
+ * program on our state
+ */
+static void patStep(bool freezeBaseLine, unsigned long now, int& variation, uint16_t& sblFlags)
+{
+    const uint8_t *prog = patBuiltin[SID_IDLE_0];
+    int32_t *r = patState.r;
 
-        usingGPSS = true;
+    if(idleMode == SID_IDLE_USER) {
+        if(patUser) prog = patUser;
+    } else if(idleMode <= SID_IDLE_IDC) {
+        prog = patBuiltin[idleMode];
+    }
+    
+    r[PVR_BL] = sidBaseLine;
+    r[PVR_SBL] = strictBaseLine;
+    r[PVR_WAY] = blWayup;
+    r[PVR_VAR] = variation;
+    r[PVR_FLG] = sblFlags;
+    r[PVR_DLY] = idleDelay;
+    r[PVR_IDX] = id5idx;
+    r[PVR_GPS] = usingGPSS;
+    r[PVR_STRICT] = strictMode;
+    r[PVR_FRZ] = freezeBaseLine;
+    r[PVR_SPD] = gpsSpeed;
+    patState.now = now;
+    patState.mark = lastChange2;
+    patState.hold = idleDelay2;
+
+    if(!patRun(prog, patState) && prog == patUser) {
+        // Runaway user pattern: Drop it
+        free(patUser);
+        patUser = NULL;
+        #ifdef SID_DBG
+        Serial.println("patStep: User pattern exceeded step limit, removed");
+        #endif
+    }
+
+    sidBaseLine = r[PVR_BL];
+    strictBaseLine = r[PVR_SBL];
+    blWayup = !!r[PVR_WAY];
+    variation = r[PVR_VAR];
+    sblFlags = r[PVR_FLG];
+    idleDelay = (r[PVR_DLY] > 0) ? r[PVR_DLY] : 0;
+    id5idx = r[PVR_IDX];
+    usingGPSS = !!r[PVR_GPS];
+    lastChange2 = patState.mark;
+    idleDelay2 = patState.hold;
+}
+
+static bool showIdle(bool freezeBaseLine)
+{
+    unsigned long now = PAT_MILLIS();
+    int oldBaseLine = sidBaseLine;
+    int oldSBaseLine = strictBaseLine;
+    int variation = 20;
+    uint16_t sblFlags = 0;
+
+    idleDelay2 = patRNG.range(700, 899);
+
+    if(useGPSS && gpsSpeed >= 0) {
+
+        // Network side ignores this if speed comes by notification
+        sidPollFastNow = millisNonZero();
+
+        usingGPSS = true;
        
         if(!strictMode) {
             if(now - lastChange < 500)
@@ -1537,11 +1494,11 @@ static bool showIdle(bool freezeBaseLine)
                 strictBaseLine = gpsSpeed * 100 / (88 * 100 / (TT_SQF_LN - 1));
                 if(gpsSpeed == prevGPSSpeed) {
                     if(strictBaseLine < 5) {
-                        strictBaseLine += (esp_random() % 5);
+                        strictBaseLine += patRNG.below(5);
                     } else if(strictBaseLine > TT_SQF_LN - 4) {
                         // no modify
                     } else {
-                        strictBaseLine += (((esp_random() % 5)) - 2);
+                        strictBaseLine += (patRNG.below(5) - 2);
                     }
                     if(strictBaseLine < 0) strictBaseLine = 0;
                     if(strictBaseLine > TT_SQF_LN-2) strictBaseLine = TT_SQF_LN-2;
@@ -1558,205 +1515,14 @@ static bool showIdle(bool freezeBaseLine)
         lastChange = now;
         prevGPSSpeed = gpsSpeed;
 
-    } else if(idleMode == SID_IDLE_BL) {     // "backlot mode"
-
-        if(now - lastChange < idleDelay)
-            return false;
-          
-        lastChange = now;
-
-        idleDelay = 90;
-
-        for(int i = 0; i < 10; i++) {
-            sid.drawBarWithHeight(i, idle5[id5idx][i]);
-        }
-        id5idx++;
-        if(id5idx >= ID5_STEPS) id5idx = 0;
-        
-        sidBaseLine = strictBaseLine = 0;
-        sblFlags |= SBLF_NOBL;
-
     } else {
-        
+
         if(now - lastChange < idleDelay)
             return false;
           
         lastChange = now;
 
-        if(strictMode) {
-            if(idleMode != SID_IDLE_IDC) {
-                sblFlags |= SBLF_STRICT;
-            }
-        }
-
-        switch(idleMode) {
-        case SID_IDLE_1:     // higher peaks, tempo as 0
-            idleDelay = 800 + ((int)(esp_random() % 200) - 100);
-            if(!strictMode) {
-                if(!freezeBaseLine) {
-                    if(sidBaseLine > 16) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine > 12) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
-                    } else {
-                        sidBaseLine += (((esp_random() % 5)) - 1);
-                    }
-                    variation = 40;
-                }
-            } else {
-                if(!freezeBaseLine) {
-                    if(strictBaseLine > 40) {
-                        strictBaseLine -= (((esp_random() % 5)) + 1);
-                        blWayup = false;
-                    } else if(strictBaseLine < 10) {
-                        strictBaseLine += (((esp_random() % 5)) + 2);
-                        blWayup = true;
-                    } else {
-                        strictBaseLine += (((esp_random() % 7)) - (blWayup ? 2 : 4));
-                    }
-                } else {
-                    if((esp_random() % 5) >= 2) {
-                        strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
-                    }
-                }
-            }
-            break;
-        case SID_IDLE_2:       // Same as 0, but faster
-            idleDelay = 300 + ((int)(esp_random() % 200) - 100);
-            if(!strictMode) {
-                if(!freezeBaseLine) {
-                    if(sidBaseLine > 14) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine > 8) {
-                        sidBaseLine -= (((esp_random() % 5)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
-                    } else {
-                        sidBaseLine += (((esp_random() % 4)) - 1);
-                    }
-                }
-            } else {
-                if(!freezeBaseLine) {
-                    if(strictBaseLine > 30) {
-                        strictBaseLine -= (((esp_random() % 3)) + 1);
-                        blWayup = false;
-                    } else if(strictBaseLine < 10) {
-                        strictBaseLine += (((esp_random() % 3)) + 2);
-                        blWayup = true;
-                    } else {
-                        strictBaseLine += (((esp_random() % 7)) - (blWayup ? 2 : 4));
-                    }
-                } else {
-                    if((esp_random() % 5) >= 2) {
-                        strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
-                    }
-                }
-            }
-            break;
-        case SID_IDLE_3:     // higher peaks, faster
-            idleDelay = 300 + ((int)(esp_random() % 200) - 100);
-            if(!strictMode) {
-                if(!freezeBaseLine) {
-                    if(sidBaseLine > 16) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine > 12) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
-                    } else {
-                        sidBaseLine += (((esp_random() % 5)) - 1);
-                    }
-                    variation = 40;
-                }
-            } else {
-                if(!freezeBaseLine) {
-                    if(strictBaseLine > 40) {
-                        strictBaseLine -= (((esp_random() % 5)) + 1);
-                        blWayup = false;
-                    } else if(strictBaseLine < 10) {
-                        strictBaseLine += (((esp_random() % 5)) + 2);
-                        blWayup = true;
-                    } else {
-                        strictBaseLine += (((esp_random() % 7)) - (blWayup ? 2 : 4));
-                    }
-                } else {
-                    if((esp_random() % 5) >= 2) {
-                        strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
-                    }
-                }
-            }
-            break;
-        case SID_IDLE_IDC:   // with masked text & "identity crisis" tt seq
-            idleDelay = 80;
-            sblFlags |= (SBLF_LM|SBLF_SKIPSHOW);
-            if(now - lastChange2 < idleDelay2) {
-                sblFlags |= SBLF_REPEAT;
-            } else {
-                if(!freezeBaseLine) {
-                    if(sidBaseLine > 18) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
-                    } else {
-                        sidBaseLine += (((esp_random() % 5)) - 1);
-                    }
-                    variation = 40;
-                }
-                lastChange2 = now;
-                idleDelay2 = 800 + ((int)(esp_random() % 200) - 100);
-            }
-            break;
-        default:
-            idleDelay = 800 + ((int)(esp_random() % 200) - 100);
-            if(!strictMode) {
-                if(!freezeBaseLine) {
-                    if(sidBaseLine > 14) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine > 8) {
-                        sidBaseLine -= (((esp_random() % 5)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
-                    } else {
-                        sidBaseLine += (((esp_random() % 4)) - 1);
-                    }
-                }
-            } else {
-                if(!freezeBaseLine) {
-                    if(strictBaseLine > 30) {
-                        strictBaseLine -= (((esp_random() % 3)) + 1);
-                        blWayup = false;
-                    } else if(strictBaseLine < 10) {
-                        strictBaseLine += (((esp_random() % 3)) + 2);
-                        blWayup = true;
-                    } else {
-                        strictBaseLine += (((esp_random() % 7)) - (blWayup ? 2 : 4));
-                    }
-                } else {
-                    if((esp_random() % 5) >= 2) {
-                        strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
-                    }
-                }
-            }
-            break;
-        }
-        
-        if(!freezeBaseLine) {
-            if(usingGPSS) {
-                // Smoothen
-                if(!(sblFlags & SBLF_STRICT)) {
-                    if(abs(oldBaseLine - sidBaseLine) > 3) {
-                        sidBaseLine = (sidBaseLine + oldBaseLine) / 2;
-                    }
-                } else {
-                    if(abs(oldSBaseLine - strictBaseLine) > 7) {
-                        strictBaseLine = (strictBaseLine + oldSBaseLine) / 2;
-                    }
-                }
-                usingGPSS = false;
-            }
-        }
+        patStep(freezeBaseLine, now, variation, sblFlags);
     }
 
     if(sidBaseLine < 0) sidBaseLine = 0;
@@ -1770,7 +1536,7 @@ static bool showIdle(bool freezeBaseLine)
         switch(LMState) {
         case 0:
             if(!LM[LMIdx]) LMIdx = 0;
-            LMAdvNow = millis();
+            LMAdvNow = PAT_MILLIS();
             LMDelay = (LM[LMIdx] == '.') ? 400 : 1000;
             LMState++;
             LMY = 11;
@@ -1778,8 +1544,8 @@ static bool showIdle(bool freezeBaseLine)
         case 1:
         case 2:
             sid.drawLetterMask(LM[LMIdx], 1, LMY);
-            if(millis() - LMAdvNow > LMDelay) {
-                LMAdvNow = millis();
+            if(PAT_MILLIS() - LMAdvNow > LMDelay) {
+                LMAdvNow = PAT_MILLIS();
                 if(LMState == 1) {
                     LMState++;
                     LMDelay = 50;
@@ -1807,8 +1573,208 @@ static bool showIdle(bool freezeBaseLine)
  * 
  */
 
-static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur)
+static void ttLatAdd(ttLatStat& st, uint32_t lat)
+{
+    st.cnt++;
+    st.sum += lat;
+    if(lat < st.min) st.min = lat;
+    if(lat > st.max) st.max = lat;
+}
+
+// Called when the first step of the TT sequence is shown
+static void ttLatFirstFrame()
+{
+    if(!TTtrigUs)
+        return;
+
+    ttLatAdd(ttLatFrame, micros() - TTtrigUs);
+    TTtrigUs = 0;
+
+    #ifdef SID_DBG
+    Serial.printf("TT latency (us): start %u/%u/%u, first frame %u/%u/%u (min/avg/max, %u TTs)\n",
+        ttLatStart.min, ttLatStart.sum / ttLatStart.cnt, ttLatStart.max,
+        ttLatFrame.min, ttLatFrame.sum / ttLatFrame.cnt, ttLatFrame.max,
+        ttLatFrame.cnt);
+    #endif
+}
+
+/*
+ * Time travel sequence: The sequencer (sid_ttseq) does the timing,
+ * we do the drawing.
+ */
+static void ttDrawSeq(int row)
+{
+    if(TTsbFlags & SBLF_STRICT) {
+        TTsidBaseLineIdx = TT_SQF_LN - 1 - row;
+        for(int i = 0; i < 10; i++) {
+            sid.drawBarWithHeight(i, ttledseqfull[TT_SQF_LN - 1 - row][i]);
+        }
+    } else {
+        TTsidBaseLineIdx = TT_SQ_LN - 1 - row;
+        for(int i = 0; i < 10; i++) {
+            sid.drawBarWithHeight(i, ttledseq[TT_SQ_LN - 1 - row][i]);
+        }
+    }
+    sid.show();
+}
+
+static void ttEndP0()
+{
+    if(!ttSeq.aborted()) {
+
+        setTTOUT(HIGH);
+
+        if(!ttSeq.keys()) {
+            // If we have missed P0, set last step of sequence at least
+            // Do this also in sa mode and if strict (pattern is same)
+            for(int i = 0; i < 10; i++) {
+                sid.drawBarWithHeight(i, ttledseq[TT_SQ_LN - 1][i]);
+            }
+            sid.show();
+        }
+        ttLatFirstFrame();
+
+        if(saActive) {
+            sa_deactivate();
+            TTSAStopped = true;
+        }
+
+        strictBaseLine = TT_SQF_LN - 1;
+        sidBaseLine = 19;
+
+    } else {
+
+        // determine baseline at time of abort
+        if(TTsbFlags & SBLF_STRICT) {
+            strictBaseLine = TTsidBaseLineIdx;
+        } else {
+            sidBaseLine = TTsidBaseLineIdx;
+        }
+
+    }
+
+    TTClrBar = TTBarCnt = 0;
+    TTClrBarInc = 1;
+    TTBri = false;
+
+    TTLMIdx = 0;
+    TTLMTrigger = false;
+}
+
+// Feed external phase events: Abort/reentry from 
+// BTTFN/MQTT, or TT_IN going LOW if wired
+static void ttFeedEvents()
+{
+    if(!extTT)
+        return;
+        
+    if(networkAbort) {
+        ttSeq.event(TTE_ABORT);
+    } else if(networkTCDTT ? networkReentry : !digitalRead(TT_IN_PIN)) {
+        ttSeq.event(TTE_REENTRY);
+    }
+}
+
+static void ttLoop(unsigned long now)
+{
+    uint8_t ev;
+    int     cnt;
+    bool    again;
+
+    do {
+    
+        ev = ttSeq.run(now);
+        again = false;
+        cnt = ttSeq.count();
+
+        switch(ttSeq.phase()) {
+        
+        case TTPH_ACCEL:    // Acceleration
+        
+            if(ev & TTEV_END) {
+                ttEndP0();
+            } else if(ttSeq.inRamp(now)) {
+                if(ev & TTEV_STEP) {
+                    if(saActive) {
+                        sa_setAmpFact(TTampFacts[TT_AMP_STEPS - 1 - cnt]);
+                    } else {
+                        ttDrawSeq(cnt);
+                    }
+                    ttLatFirstFrame();
+                }
+                if(saActive) {
+                    sa_loop();
+                }
+            } else if(saActive) {
+                sa_loop();
+            } else {
+                showIdle(true);
+            }
+            break;
+
+        case TTPH_TUNNEL:   // Peak/"time tunnel"
+        
+            if(ev & TTEV_END) {
+                setTTOUT(LOW);
+                sid.setBrightness(255);
+            } else if(ev & TTEV_STEP) {
+                if(TTLMTrigger) {
+                    TTLMIdx++;
+                    if(!LMTT[TTLMIdx]) TTLMIdx = 0;
+                }
+                showBaseLine(80, TTsbFlags | SBLF_ISTT);
+                if(TTsbFlags & SBLF_LMTT) {
+                    TTLMTrigger = true;
+                }
+            }
+            break;
+
+        case TTPH_REENTRY:  // Reentry - ends after P2_DUR at most
+        
+            if(ev & TTEV_END) {
+                TTrunning = false;
+                isTTKeyHeld = isTTKeyPressed = false;
+                ssRestartTimer();
+                sa_setAmpFact(100);
+                LMState = LMIdx = id5idx = 0;
+                break;
+            }
+            
+            // Idle mode: Let showIdle take care of calming us down
+            // SA mode: reduce ampFactor gradually on ticks
+            if(TTSAStopped) {
+                sa_activate(false, 500);
+                TTSAStopped = false;
+            }
+            if(saActive && sa_setAmpFact(-1) > 100) {
+                if((ev & TTEV_STEP) && cnt < TT_AMP_STEPS) {
+                    sa_setAmpFact(TTampFacts[TT_AMP_STEPS - 1 - cnt]);
+                }
+                sa_loop();
+            } else {
+                // Calmed down: End phase in this pass
+                ttSeq.finish();
+                again = true;
+            }
+            break;
+        }
+
+        if(ev & TTEV_END) {
+            ttSeq.next(now);
+        }
+
+    } while((ev & TTEV_END) || again);
+}
+
+/*
+ * trigUs: micros() of the TT_IN edge, if triggered by wire. The
+ * sequence is then timed from this, not from when we noticed it.
+ */
+static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur, unsigned long trigUs)
 {
+    unsigned long TTstart;
+    int TTcnt;
+    
     if(TTrunning || IRLearning)
         return;
 
@@ -1827,19 +1793,21 @@ static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur)
     }
         
     TTrunning = true;
-    TTstart = TTfUpdNow = millis();
-    TTP0 = true;   // phase 0
-    TTP1 = TTP2 = false;
+    TTstart = PAT_MILLIS();
+    if((TTtrigUs = trigUs)) {
+        unsigned long lat = micros() - trigUs;
+        ttLatAdd(ttLatStart, lat);
+        TTstart -= (lat / 1000);
+    }
     TTSAStopped = false;
     TTsbFlags = skipTTAnim ? 0 : SBLF_ANIM;
     TTLMIdx = 0;
 
     // P1Dur, even if coming from TCD, is not used for timing, 
-    // but only to calculate steps and for a max timeout
+    // but only for a max timeout
     if(!P1Dur) {
         P1Dur = TCDtriggered ? P1_DUR_TCD : P1_DUR;
     }
-    P1_maxtimeout = P1Dur + 3000;
     
     #ifdef SID_DBG
     Serial.printf("TT: baseLine %d, entry %d\n", sidBaseLine, seqEntry[sidBaseLine]);
@@ -1867,48 +1835,19 @@ static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur)
         }
     }
     TTsidBaseLineIdx = sidBaseLine;
-    
-    if(TCDtriggered) {    // TCD-triggered TT (GPIO, BTTFN or MQTT) (synced with TCD)
-        extTT = true;
-        P0duration = P0Dur;
-        #ifdef SID_DBG
-        Serial.printf("P0 duration is %d\n", P0duration);
-        #endif
-        if(TTcnt > 0) {
-            if(P0duration > 2500) {
-                TTFDelay = P0duration - 2500;
-            } else {
-                TTFDelay = 0;
-            }
-            TTFInt = (P0duration - TTFDelay) / (TTcnt + 1);
-            if(TTFInt > 0 && TTFInt < 65) {
-                if((TTcnt + 1) * 65 <= P0duration) {
-                    TTFInt = 65;
-                    TTFDelay = P0duration - (TTFInt * (TTcnt + 1));
-                }
-            }
-        } else {
-            TTFInt = 0;
-            TTFDelay = 0;
-        }
-    } else {              // button/IR-triggered TT (stand-alone)
-        extTT = false;
-        TTFDelay = 2500;
-        if(TTcnt > 0) {
-            TTFInt = (P0_DUR - TTFDelay) / (TTcnt + 1);
-            if(TTFInt > 0 && TTFInt < 65) {
-                if((TTcnt + 1) * 65 <= P0_DUR) {
-                    TTFInt = 65;
-                    TTFDelay = P0_DUR - (TTFInt * (TTcnt + 1));
-                }
-            }
-        } else {
-            TTFInt = 0;
-        }
-    }
-    
+
+    // TCD-triggered TT (GPIO, BTTFN or MQTT) is synced with TCD,
+    // button/IR-triggered TT (stand-alone) runs on fixed times
+    extTT = TCDtriggered;
+    ttSeq.begin(extTT ? ttTimelineTCD : ttTimelineInt, TTstart, 
+                P0Dur, P1Dur + P1_GRACE, TTcnt, !!(TTsbFlags & SBLF_LMTT));
+
+    // Have the TT task run right away
+    sched_runAt(schedTT, millis());
+
     #ifdef SID_DBG
-    Serial.printf("TTFDelay %d  TTFInt %d  TTcnt %d\n", TTFDelay, TTFInt, TTcnt);
+    Serial.printf("TT: %s, P0 duration %d, TTcnt %d\n", extTT ? "synced" : "stand-alone", 
+                  extTT ? P0Dur : P0_DUR, TTcnt);
     #endif
 }
 
@@ -1939,6 +1878,7 @@ static void play_startup()
         sid.drawDot(4 - i, 10);
         sid.drawDot(5 + i, 10);
         sid.show();
+        if(!i) fpoLatAdd(fpoLatOn, "on");
         if(oldBri >= (i + 1) * 2) sid.setBrightnessDirect((i + 1) * 2);
         mydelay(20 - (i*2), false);
     }
@@ -1982,6 +1922,93 @@ static void play_startup()
     blockScan = false;
 }
 
+/*
+ * Fake power fast resume
+ */
+
+static void fpoLatAdd(ttLatStat& st, const char *what)
+{
+    if(!fpoTrigUs)
+        return;
+
+    ttLatAdd(st, micros() - fpoTrigUs);
+    fpoTrigUs = 0;
+
+    #ifdef SID_DBG
+    Serial.printf("FPO %s latency (us): %u/%u/%u (min/avg/max, %u)\n", what,
+        st.min, st.sum / st.cnt, st.max, st.cnt);
+    #endif
+}
+
+// Power off: Keep display contents, idle pattern state
+// and brightness; suspend SA and games instead of ending
+// them. Not warm: Cold start on power on.
+static void fpoSuspend(bool warm)
+{
+    fpoSnap.mode = FPOS_NONE;
+
+    if(!warm)
+        return;
+
+    sid.getRawBuf(fpoSnap.buf);
+    fpoSnap.bri = sid.getBrightness();
+    memcpy(fpoSnap.idleHeight, oldIdleHeight, sizeof(oldIdleHeight));
+
+    if(saActive) {
+        sa_suspend();
+        fpoSnap.mode = FPOS_SA;
+    } else if(siActive) {
+        si_end();
+        fpoSnap.mode = FPOS_SI;
+    } else if(snActive) {
+        sn_end();
+        fpoSnap.mode = FPOS_SN;
+    } else {
+        fpoSnap.mode = FPOS_IDLE;
+    }
+}
+
+// Power on: Show snapshot and continue from there.
+// Returns false if there is nothing to resume from.
+static bool fpoResume()
+{
+    uint8_t mode = fpoSnap.mode;
+
+    if(mode == FPOS_NONE)
+        return false;
+
+    fpoSnap.mode = FPOS_NONE;
+
+    #ifdef SID_FPO_STARTUP
+    sid.clearDisplayDirect();
+    sid.setBrightness(255);
+    sid.on();
+    play_startup();
+    #endif
+
+    sid.setBrightness(fpoSnap.bri);
+    sid.drawRawAndShow(fpoSnap.buf);
+    sid.on();
+    fpoLatAdd(fpoLatOn, "on");
+
+    memcpy(oldIdleHeight, fpoSnap.idleHeight, sizeof(oldIdleHeight));
+    lastChange = PAT_MILLIS();
+
+    switch(mode) {
+    case FPOS_SA:
+        sa_wake();
+        break;
+    case FPOS_SI:
+        si_resume();
+        break;
+    case FPOS_SN:
+        sn_resume();
+        break;
+    }
+
+    return true;
+}
+
 void setIdleMode(int idleNo)
 {
     uint16_t temp = idleMode;
@@ -2002,7 +2029,7 @@ static void toggleStrictMode()
 {
     strictMode = !strictMode;
     saveStrict();
-    updateConfigPortalStrictValue();
+    cpUpdate(NCU_STRICT);
 }
 
 static void changeBootMode(uint8_t bM)
@@ -2039,28 +2066,96 @@ static void startIRErrFeedback()
 static void backupIR()
 {
     for(int i = 0; i < NUM_IR_KEYS; i++) {
-        backupIRcodes[i] = remote_codes[i][REM_KEYS_LEARNED];
+        backupIRcodes[i] = learned_codes[IRLearnRemote][i];
     }
 }
 
 static void restoreIRbackup()
 {
     for(int i = 0; i < NUM_IR_KEYS; i++) {
-        remote_codes[i][REM_KEYS_LEARNED] = backupIRcodes[i];
+        learned_codes[IRLearnRemote][i] = backupIRcodes[i];
     }
+    rebuildIRIndex();
 }
 
-static void startIRLearn()
+/*
+ * IR code index
+ */
+
+static uint32_t irIndexSlot(uint32_t code)
 {
-    // Play LEARN START sequence
-    showWordSequence("GO", 4);
+    // Fibonacci hashing; hashes from calcHash and decoded 
+    // codes are not evenly distributed in the lower bits
+    return (uint32_t)(code * 2654435761U) >> (32 - IR_INDEX_BITS);
+}
+
+static void irIndexAdd(uint32_t code, int remote, int key)
+{
+    uint32_t s = irIndexSlot(code);
+
+    if(!code) return;
+
+    while(irIndexCode[s]) {
+        // Same code in several remotes: First one wins
+        if(irIndexCode[s] == code) return;
+        s = (s + 1) & (IR_INDEX_SIZE - 1);
+    }
+
+    irIndexCode[s] = code;
+    irIndexRK[s] = remote * NUM_IR_KEYS + key;
+}
+
+// Returns key, or -1 if code is unknown
+static int irIndexFind(uint32_t code, int *remote = NULL)
+{
+    uint32_t s = irIndexSlot(code);
+
+    if(!code) return -1;
+
+    while(irIndexCode[s]) {
+        if(irIndexCode[s] == code) {
+            if(remote) *remote = irIndexRK[s] / NUM_IR_KEYS;
+            return irIndexRK[s] % NUM_IR_KEYS;
+        }
+        s = (s + 1) & (IR_INDEX_SIZE - 1);
+    }
+
+    return -1;
+}
+
+static void rebuildIRIndex()
+{
+    memset(irIndexCode, 0, sizeof(irIndexCode));
+    
+    for(int i = 0; i < NUM_IR_REMOTES; i++) {
+        for(int j = 0; j < NUM_IR_KEYS; j++) {
+            irIndexAdd(learned_codes[i][j], i, j);
+        }
+    }
+    
+    if(useDefaultIR) {
+        for(int j = 0; j < NUM_IR_KEYS; j++) {
+            irIndexAdd(default_codes[j], IR_REM_DEFAULT, j);
+        }
+    }
+}
+
+static void startIRLearn()
+{
+    // Play LEARN START sequence
+    showWordSequence("GO", 4);
     IRLearning = true;
     IRLearnIndex = 0;
+    // Learn into first free slot; if all are taken,
+    // replace the last one
+    for(IRLearnRemote = 0; IRLearnRemote < NUM_IR_REMOTES - 1; IRLearnRemote++) {
+        if(!learned_codes[IRLearnRemote][0]) break;
+    }
     IRLearnNow = IRFBLearnNow = millis();
     IRLearnBlink = false;
     backupIR();
     showChar(IRLearnKeys[IRLearnIndex]);
-    ir_remote.loop();     // Ignore IR received in the meantime
+    ir_remote.resume();   // Ignore IR received in the meantime
 }
 
 static void endIRLearn(bool restore)
@@ -2071,25 +2166,53 @@ static void endIRLearn(bool restore)
     if(restore) {
         restoreIRbackup();
     }
-    ir_remote.loop();     // Ignore IR received in the meantime
+    ir_remote.resume();   // Ignore IR received in the meantime
 }
 
 static void handleIRinput()
 {
     uint32_t myHash = ir_remote.readHash();
-    uint16_t i, j;
-    bool done = false;
-    
-    Serial.printf("handleIRinput: Received IR code 0x%x\n", myHash);
+    uint32_t myCode = ir_remote.readCode();
+    uint8_t  event = ir_remote.getEvent();
+    int i;
+
+    if(event != IRKEY_PRESS) {
+        #ifdef SID_DBG
+        Serial.printf("handleIRinput: IR 0x%x %s\n", myCode ? myCode : myHash, (event == IRKEY_REPEAT) ? "repeat" : "released");
+        #endif
+        if(event == IRKEY_RELEASE || IRLearning) return;
+    } else if(myCode) {
+        Serial.printf("handleIRinput: Received IR code 0x%x (hash 0x%x)\n", myCode, myHash);
+    } else {
+        Serial.printf("handleIRinput: Received IR code 0x%x\n", myHash);
+    }
+    #ifdef SID_DBG
+    {
+        uint32_t ovf, trunc;
+        ir_remote.getStats(ovf, trunc);
+        if(ovf || trunc) Serial.printf("handleIRinput: IR frames dropped %d, truncated %d\n", ovf, trunc);
+    }
+    #endif
 
     if(IRLearning) {
         endIRfeedback();
-        remote_codes[IRLearnIndex++][REM_KEYS_LEARNED] = myHash;
+        // Store decoded code if protocol is known, hash otherwise
+        uint32_t code = myCode ? myCode : myHash;
+        if(!IRLearnIndex) {
+            // If this is a remote learned before, learn it anew
+            int remote;
+            if(irIndexFind(code, &remote) == 0 && remote != IR_REM_DEFAULT && remote != IRLearnRemote) {
+                IRLearnRemote = remote;
+                backupIR();
+            }
+        }
+        learned_codes[IRLearnRemote][IRLearnIndex++] = code;
         if(IRLearnIndex == NUM_IR_KEYS) {
             // Play LEARN DONE sequence
             fadeOutChar();
             showWordSequence("DONE", 2);
             IRLearning = false;
+            rebuildIRIndex();
             saveIRKeys();
             #ifdef SID_DBG
             Serial.println("handleIRinput: All IR keys learned, and saved");
@@ -2110,18 +2233,33 @@ static void handleIRinput()
         return;
     }
 
-    for(i = 0; i < NUM_IR_KEYS; i++) {
-        for(j = 0; j < maxIRctrls; j++) {
-            if(remote_codes[i][j] == myHash) {
-                #ifdef SID_DBG
-                Serial.printf("handleIRinput: key %d\n", i);
-                #endif
-                handleIRKey(i);
-                done = true;
-                break;
-            }
+    if((i = irIndexFind(myCode)) < 0) {
+        i = irIndexFind(myHash);
+    }
+    if(i >= 0) {
+        #ifdef SID_DBG
+        Serial.printf("handleIRinput: key %d\n", i);
+        #endif
+        handleIRKey(i, (event == IRKEY_REPEAT));
+    }
+}
+
+/*
+ * IR timing trace: Print records and
+ * append them to trace file on SD
+ */
+static void flushIRTrace()
+{
+    IRTraceRec rec;
+    uint32_t lost;
+
+    while(ir_remote.readTrace(rec, lost)) {
+        Serial.printf("IR trace %u: len %d, code 0x%x, hash 0x%x, flags 0x%x, lost %u\n",
+              rec.stamp, rec.len, rec.code, rec.hash, rec.flags, lost);
+        for(int i = 0; i < rec.len; i++) {
+            Serial.printf("%u%c", rec.dur[i], (i == rec.len - 1 || (i & 15) == 15) ? '\n' : ' ');
         }
-        if(done) break;
+        appendIRTrace((const uint8_t *)&rec, sizeof(rec) - sizeof(rec.dur) + rec.len * sizeof(rec.dur[0]));
     }
 }
 
@@ -2170,13 +2308,33 @@ static void doKey9()
 }
 */
 
-static void handleIRKey(int key)
+static void handleIRKey(int key, bool isRepeat)
 {
     int doInpReaction = 0;
     bool tempIRShowPosFBDisplay = irShowPosFBDisplay;
     bool tempIRShowCmdFBDisplay = irShowCmdFBDisplay;
     unsigned long now = millisNonZero();
 
+    // Held key: Only brightness and Siddly 
+    // moves (incl soft drop) auto-repeat
+    if(isRepeat) {
+        if(irLocked || remMode || ssActive) return;
+        switch(key) {
+        case 12:
+            if(siActive || snActive || saActive) return;
+            break;
+        case 13:
+            if(snActive || saActive) return;
+            break;
+        case 14:
+        case 15:
+            if(!siActive) return;
+            break;
+        default:
+            return;
+        }
+    }
+
     if(ssActive) {
         if(!irLocked || key == 11) {
             ssEnd();
@@ -2209,7 +2367,7 @@ static void handleIRKey(int key)
         if(key == 11) {   // # quits
             remMode = remHoldKey = false;
             clearInpBuf();    // Relevant if initiated by TCD (6096)
-            bttfn_send_command(BTTFN_REMCMD_KP_BYE, 0, 0);
+            bttfn_queue_command(BTTFN_REMCMD_KP_BYE, 0, 0);
             sid.specialSig(SID_SS_REMEND);
             irFeedBackDur = 1000;
         } else if(key == 10) {   // * means the following key is "held" on TCD keypad
@@ -2217,7 +2375,7 @@ static void handleIRKey(int key)
         } else {
             uint8_t rkey = (key >= 0 && key <= 9) ? key + '0' : ((key == 16) ? 'E' : 0);
             if(rkey) {
-                bttfn_send_command(BTTFN_REMCMD_KP_KEY, rkey, remHoldKey ? BTTFN_KP_KS_HOLD : BTTFN_KP_KS_PRESSED);
+                bttfn_queue_command(BTTFN_REMCMD_KP_KEY, rkey, remHoldKey ? BTTFN_KP_KS_HOLD : BTTFN_KP_KS_PRESSED);
             }
             remHoldKey = false;
         }
@@ -2382,22 +2540,31 @@ static void handleIRKey(int key)
     }
 }
 
+// Drain the command queue in batches: A burst of commands is
+// handled quickly, but does not stall the loop.
 static void handleRemoteCommand()
 {
-    uint32_t command = commandQueue[oCmdIdx];
-    int      doInpReaction = 0;
-    bool     injected = false;
+    sidCmd cmd;
+    int    n = CMD_BATCH;
 
-    if(!command)
-        return;
+    while(n-- && !IRLearning && cmdQueue.get(cmd)) {
+        if(millis() - cmd.stamp > CMD_MAX_AGE) {
+            #ifdef SID_DBG
+            Serial.printf("Dropping stale command %d (src %d)\n", cmd.code, cmd.src);
+            #endif
+            continue;
+        }
+        execRemoteCommand(cmd);
+    }
+}
 
-    commandQueue[oCmdIdx] = 0;
-    oCmdIdx++;
-    oCmdIdx &= 0x0f;
+static void execRemoteCommand(const sidCmd& cmd)
+{
+    uint32_t command = cmd.code;
+    int      doInpReaction = 0;
+    bool     injected = !!(cmd.flags & CMDF_INJECT);
 
-    if(command & 0x80000000) {
-        injected = true;
-        command &= ~0x80000000;
+    if(injected) {
         // Allow user to use IR sequence or TCD code
         if(command >= 6000 && command <= 6999) {
             command -= 6000;
@@ -2519,7 +2686,7 @@ static int execute(bool isIR, bool injected)
         temp = atoi(inputBuffer);
         if(temp >= 10 && temp <= 19) {            // *10-*15 idle pattern
             if(!isIRLocked) {
-                if(temp <= (10 + SID_MAX_IDLE_MODE)) {
+                if(temp <= (10 + SID_MAX_IDLE_MODE) && (temp != (10 + SID_IDLE_USER) || patUser)) {
                     setIdleMode(temp - 10);
                     inputReaction = 1;
                 } else {
@@ -2585,7 +2752,7 @@ static int execute(bool isIR, bool injected)
                     if(!TTrunning) {
                         doPeaks = !doPeaks;
                         saveSASettings();
-                        updateConfigPortalSAValues();
+                        cpUpdate(NCU_SA);
                         inputReaction = 1;
                     } else inputReaction = -1;
                 }
@@ -2595,7 +2762,7 @@ static int execute(bool isIR, bool injected)
                     if(!TTrunning) {
                         irShowPosFBDisplay = !irShowPosFBDisplay;
                         savePosIRFB();
-                        updateConfigPortalIRFBValues();
+                        cpUpdate(NCU_IRFB);
                         inputReaction = 1;
                     } else inputReaction = -1;
                 }
@@ -2605,7 +2772,7 @@ static int execute(bool isIR, bool injected)
                     if(!TTrunning) {
                         irShowCmdFBDisplay = !irShowCmdFBDisplay;
                         saveIRCFB();
-                        updateConfigPortalIRFBValues();
+                        cpUpdate(NCU_IRFB);
                         inputReaction = 1;
                     } else inputReaction = -1;
                 }
@@ -2615,7 +2782,27 @@ static int execute(bool isIR, bool injected)
                     if(!TTrunning) {
                         doMirror = !doMirror;
                         saveSASettings();
-                        updateConfigPortalSAValues();
+                        cpUpdate(NCU_SA);
+                        inputReaction = 1;
+                    } else inputReaction = -1;
+                }
+                break;
+            case 65:                              // *65  enable/disable "waterfall mode" in Spectrum Analyzer
+                if(!isIRLocked) {
+                    if(!TTrunning) {
+                        saMode = (saMode == SA_MODE_WATERFALL) ? SA_MODE_BARS : SA_MODE_WATERFALL;
+                        saveSASettings();
+                        cpUpdate(NCU_SA);
+                        inputReaction = 1;
+                    } else inputReaction = -1;
+                }
+                break;
+            case 66:                              // *66  enable/disable "VU meter mode" in Spectrum Analyzer
+                if(!isIRLocked) {
+                    if(!TTrunning) {
+                        saMode = (saMode == SA_MODE_VU) ? SA_MODE_BARS : SA_MODE_VU;
+                        saveSASettings();
+                        cpUpdate(NCU_SA);
                         inputReaction = 1;
                     } else inputReaction = -1;
                 }
@@ -2628,7 +2815,7 @@ static int execute(bool isIR, bool injected)
                     // Need to quit remote mode before locking ir
                     // (Use case: Enter 6071 on TCD keypad during remMode)
                     remMode = remHoldKey = false;                    
-                    bttfn_send_command(BTTFN_REMCMD_KP_BYE, 0, 0);
+                    bttfn_queue_command(BTTFN_REMCMD_KP_BYE, 0, 0);
                 }
                 irLocked = !irLocked;
                 irlchgnow = now;
@@ -2643,15 +2830,13 @@ static int execute(bool isIR, bool injected)
                 break;
             case 77:                              // *77 Restart WiFi after entering Power Save
                 if(isIR && !isIRLocked && !TTrunning && !injected) {
-                    bool blocked = false;
                     if(wifiOnWillBlock()) {
                         flushDelayedSave();
-                        blocked = true;
                     }
                     // Enable WiFi / even if in AP mode / with CP
-                    wifiOn(0, true, false);
-                    if(!blocked) inputReaction = 1;
-                    else ir_remote.loop(); // Flush IR afterwards
+                    // Done by network side; blocks only there.
+                    postToNet(NC_WIFION);
+                    inputReaction = 1;
                 } else {
                     inputReaction = -1;
                 }
@@ -2668,14 +2853,14 @@ static int execute(bool isIR, bool injected)
                         snake_stop();
                         flushDelayedSave();
                         showWordSequence(ipbuf, 5);
-                        ir_remote.loop(); // Flush IR afterwards
+                        ir_remote.resume(); // Flush IR afterwards
                     } else inputReaction = -1;
                 }
                 break;
             case 96:                              // *96  enter TCD keypad remote control mode
                 if(!irLocked) {                   //      yes, 'irLocked', not 'isIRLocked' - must not be entered while IR is locked
                     if(!TTrunning) {
-                        if(bttfn_connected() && remoteAllowed && !tcdIsBusy) {
+                        if(tcdLinkUp && remoteAllowed && !tcdIsBusy) {
                             siddly_stop();
                             snake_stop();
                             remMode = true;
@@ -2691,7 +2876,7 @@ static int execute(bool isIR, bool injected)
                 if(!isIR) {                       //      command not possible through IR, naturally
                     if(remMode) {
                         remMode = remHoldKey = false;                    
-                        bttfn_send_command(BTTFN_REMCMD_KP_BYE, 0, 0);
+                        bttfn_queue_command(BTTFN_REMCMD_KP_BYE, 0, 0);
                         sid.specialSig(SID_SS_REMEND);
                     }
                 } else inputReaction = -1;
@@ -2720,22 +2905,24 @@ static int execute(bool isIR, bool injected)
                 case 991:
                     if(!injected) {
                         if(!TTrunning) {
-                            bool ocm = carMode;          
-                            if(temp == 991) {
-                                if(*settings.cm_ssid) carMode = true;
-                            } else {
-                                carMode = false;
-                            }
-                            if(ocm != carMode) {
-                                saveCarMode();
-                                prepareReboot();
-                                delay(1000);
-                                esp_restart();
-                            }
+                            // Network side saves and reboots if changed
+                            postToNet(NC_SETCM, (temp == 991));
                             inputReaction = 1;
                         } else inputReaction = -1;
                     }
                     break;
+                case 992:                         // 992/993: Stop/start IR timing trace
+                case 993:
+                    if(temp == 993) {
+                        if(ir_remote.setTrace(true)) {
+                            inputReaction = 1;
+                        } else inputReaction = -1;
+                    } else {
+                        flushIRTrace();
+                        ir_remote.setTrace(false);
+                        inputReaction = 1;
+                    }
+                    break;
                 default:
                     inputReaction = -1;
                 }
@@ -2796,10 +2983,9 @@ static int execute(bool isIR, bool injected)
                     }
                     inputReaction = 1;
                 } else if(!strcmp(inputBuffer, "654321") && !injected) {
-                    deleteIRKeys();                   // *654321OK deletes learned IR remote
-                    for(int i = 0; i < NUM_IR_KEYS; i++) {
-                        remote_codes[i][REM_KEYS_LEARNED] = 0;
-                    }
+                    deleteIRKeys();                   // *654321OK deletes learned IR remotes
+                    memset(learned_codes, 0, sizeof(learned_codes));
+                    rebuildIRIndex();
                     inputReaction = 1;
                 } else if(!strcmp(inputBuffer, "987654") && !injected) {
                     triggerIRLN = true;               // *987654OK initates IR learning
@@ -2932,7 +3118,7 @@ void showWordSequence(const char *text, int speed)
     blockScan = sidBusy = true;
     
     sid.clearDisplayDirect();
-    for(int i = 0; i < strlen(text); i++) {
+    for(int i = 0; i < (int)strlen(text); i++) {
         sid.drawLetterAndShow(text[i], 0, 8);
         sid.setBrightness(255);
         mydelay(speedDelay[speed], false);
@@ -2945,7 +3131,7 @@ void showWordSequence(const char *text, int speed)
     
     blockScan = sidBusy = false;
     
-    ir_remote.loop();     // Ignore IR received in the meantime
+    ir_remote.resume();   // Ignore IR received in the meantime
 }
 
 static void showChar(const char text)
@@ -2962,20 +3148,21 @@ static void fadeOutChar()
     sid.clearDisplayDirect();
     sid.setBrightness(255);
     LMState = LMIdx = id5idx = 0;
-    ir_remote.loop();     // Ignore IR received in the meantime
+    ir_remote.resume();   // Ignore IR received in the meantime
 }
 
 void populateIRarray(uint32_t *irkeys, int index)
 {
     for(int i = 0; i < NUM_IR_KEYS; i++) {
-        remote_codes[i][index] = irkeys[i]; 
+        learned_codes[index][i] = irkeys[i]; 
     }
+    rebuildIRIndex();
 }
 
 void copyIRarray(uint32_t *irkeys, int index)
 {
     for(int i = 0; i < NUM_IR_KEYS; i++) {
-        irkeys[i] = remote_codes[i][index];
+        irkeys[i] = learned_codes[index][i];
     }
 }
 
@@ -3093,6 +3280,79 @@ static void ssUpdateClock()
     }
 }
 
+/*
+ * Power management: Reduce CPU clock and loop rate while the
+ * screen saver is active or fake power is off; sleep between
+ * scheduled wakeups.
+ */
+static void pwrApply()
+{
+    const pwrParams& p = pwr.params();
+
+    #ifdef SID_AUTO_LIGHTSLEEP
+    #if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t pm;
+    #else
+    esp_pm_config_esp32_t pm;
+    #endif
+    pm.max_freq_mhz = p.cpuMHz;
+    pm.min_freq_mhz = p.cpuMHz;
+    pm.light_sleep_enable = p.lightSleep;
+    esp_pm_configure(&pm);
+    #else
+    setCpuFrequencyMhz(p.cpuMHz);
+    #endif
+
+    #ifdef SID_PROFILE
+    prof_setCpuMHz(p.cpuMHz);
+    #endif
+
+    sched_setMinInterval(p.loopInt);
+}
+
+// Scheduler's idle wait
+static void pwrSleep(unsigned long ms)
+{
+    #ifndef SID_AUTO_LIGHTSLEEP
+    // Explicit light sleep cuts WiFi, so only when WiFi is off.
+    // Wake up on timer or IR (which probably costs the first
+    // frame). The TT button is held long enough to be seen after
+    // the timer wakeup.
+    if(pwr.params().lightSleep && ms > 1 && 
+       wifiIsOff && (!wifiInAPMode || wifiAPIsOff) &&
+       digitalRead(IRREMOTE_PIN)) {
+        esp_sleep_enable_timer_wakeup(ms * 1000);
+        esp_sleep_enable_ext0_wakeup((gpio_num_t)IRREMOTE_PIN, 0);
+        esp_light_sleep_start();
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+        // ext0 switched pin to RTC IO; give it back
+        rtc_gpio_deinit((gpio_num_t)IRREMOTE_PIN);
+        return;
+    }
+    #endif
+    
+    delay(ms);
+}
+
+// Called at end of every main_loop pass
+static void main_power()
+{
+    unsigned long now = millis();
+    bool busy = TTrunning || IRLearning || saActive || siActive || snActive ||
+                irFeedBack || irErrFeedBack;
+
+    pwr.countLoop(now);
+
+    if(pwr.update(now, !FPBUnitIsOn, ssActive, busy)) {
+        pwrApply();
+        #ifdef SID_DBG
+        Serial.printf("Power: %s (%dMHz); loops/s: active %u, quiet %u, off %u\n",
+            pwr.params().name, pwr.params().cpuMHz, pwr.loopRate(PWR_ACTIVE),
+            pwr.loopRate(PWR_QUIET), pwr.loopRate(PWR_OFF));
+        #endif
+    }
+}
+
 // Prepare TT: Stop games, disable s-s
 void prepareTT()
 {
@@ -3117,6 +3377,12 @@ void wakeup()
 
 static void setTTOUT(uint8_t stat)
 {
+    #ifdef SID_GOLDEN
+    // Don't trigger props during regression runs
+    if(goldenRun)
+        return;
+    #endif
+    
     digitalWrite(TT_OUT_PIN, stat);
     #ifdef SID_DBG
     Serial.printf("Setting TT_OUT %d\n", stat);
@@ -3132,8 +3398,11 @@ static void setTTOUT(uint8_t stat)
  */
 static void myloop(bool withIR)
 {
+    #ifndef SID_NETTASK
     wifi_loop();
     bttfn_loop_quick();
+    #endif
+    handleNetMsgs();
     if(withIR) ir_remote.loop();
 }
 
@@ -3176,17 +3445,49 @@ static bool check_packet(uint8_t *buf)
     return (buf[BTTF_PACKET_SIZE - 1] == a);
 }
 
-void addCmdQueue(uint32_t command)
+/*
+ * Queue remote command; called by network side (any task).
+ * Returns false if the queue is full and the command was
+ * dropped. Senders that can wait should check cmdQueueFull()
+ * before accepting more input.
+ */
+bool addCmdQueue(uint32_t command, uint8_t src, uint8_t flags)
 {    
-    if(!command) return;
+    sidCmd c;
+    
+    if(!command) return true;
+
+    c.code = command;
+    c.stamp = millis();
+    c.src = src;
+    c.flags = flags;
+
+    if(!cmdQueue.put(c)) {
+        __atomic_fetch_add(&cmdDropped[src], 1, __ATOMIC_RELAXED);
+        #ifdef SID_DBG
+        Serial.printf("Command queue full, dropped %d (src %d, %d dropped total)\n", 
+                    command, src, cmdQueue.lost());
+        #endif
+        return false;
+    }
+
+    return true;
+}
 
-    commandQueue[iCmdIdx] = command;
-    iCmdIdx++;
-    iCmdIdx &= 0x0f;
+bool cmdQueueFull()
+{
+    return (cmdQueue.count() >= CMD_QUEUE_SIZE);
+}
+
+uint32_t cmdQueueDropped(uint8_t src)
+{
+    return (src < CMDSRC_NUM) ? cmdDropped[src] : 0;
 }
 
 static void bttfn_eval_response(uint8_t *buf, bool checkCaps)
 {
+    netMsg m;
+
     if(checkCaps && (buf[5] & 0x40)) {
         bttfnReqStatus &= ~0x40;     // Do no longer poll capabilities
         if(buf[31] & 0x01) {
@@ -3200,27 +3501,31 @@ static void bttfn_eval_response(uint8_t *buf, bool checkCaps)
     }
 
     if(buf[5] & 0x01) {
-        memcpy(bttfnDateBuf, &buf[10], sizeof(bttfnDateBuf));
-        bttfnDateNow = millis();
+        m.type = NM_TCDDATE;
+        memcpy(m.date, &buf[10], sizeof(m.date));
+        postToMain(m);
     }
 
     if(buf[5] & 0x02) {
-        gpsSpeed = (int16_t)(buf[18] | (buf[19] << 8));
-        if(gpsSpeed > 88) gpsSpeed = 88;
-        spdIsRotEnc = !!(buf[26] & (0x80|0x20));    // Speed is from RotEnc or Remote
+        int16_t spd = (int16_t)(buf[18] | (buf[19] << 8));
+        m.type = NM_SPEED;
+        m.spd.speed = (spd > 88) ? 88 : spd;
+        m.spd.src = (buf[26] & (0x80|0x20)) ? NMS_OTHER : NMS_GPS;    // Speed is from RotEnc or Remote
+        postToMain(m);
     }
 
+    m.type = NM_TCDSTATE;
+    m.tcd.flags = 0;
+    m.tcd.mask = NMT_NM | NMT_FPO | NMT_REMOTE;
     if(buf[5] & 0x10) {
-        tcdNM  = !!(buf[26] & 0x01);
-        tcdFPO = !!(buf[26] & 0x02);   // 1 means fake power off
-        remoteAllowed = (buf[26] & 0x08) ? TCDSupportsRemKP : false;
-        tcdIsBusy = !!(buf[26] & 0x10);
-        if(!remoteAllowed || tcdIsBusy) remMode = remHoldKey = false;
-    } else {
-        tcdNM = false;
-        tcdFPO = false;
-        remoteAllowed = remMode = remHoldKey = false;
+        if(buf[26] & 0x01) m.tcd.flags |= NMT_NM;
+        if(buf[26] & 0x02) m.tcd.flags |= NMT_FPO;      // 1 means fake power off
+        if((buf[26] & 0x08) && TCDSupportsRemKP) m.tcd.flags |= NMT_REMOTE;
+        if(buf[26] & 0x10) m.tcd.flags |= NMT_BUSY;
+        m.tcd.mask |= NMT_BUSY;
     }
+    m.tcd.us = micros();
+    postToMain(m);
 
     if(!bttfnHaveTCDSSID && !checkCaps && TCDSupportsSSID) {
         bttfnHaveTCDSSID = 1;
@@ -3233,12 +3538,11 @@ static void bttfn_eval_response(uint8_t *buf, bool checkCaps)
 static void handle_tcd_notification(uint8_t *buf)
 {
     uint32_t seqCnt;
+    netMsg   m;
 
-    // Note: This might be called while we are in a
-    // wait-delay-loop. Best to just set flags here
-    // that are evaluated synchronously (=later).
-    // Do not stuff that messes with display, input,
-    // etc.
+    // Note: This runs on the network side. Only post
+    // messages here; main side evaluates them in
+    // handleNetMsgs().
 
     if(buf[5] & BTTFN_NOT_DATA) {
         if(TCDSupportsNOTData) {
@@ -3271,22 +3575,20 @@ static void handle_tcd_notification(uint8_t *buf)
     case BTTFN_NOT_SPD:
         seqCnt = GET32(buf, 12);
         if(seqCnt > bttfnTCDSeqCnt || seqCnt == 1 ) {
+            int16_t spd = (int16_t)(buf[6] | (buf[7] << 8));
             switch(buf[8] | (buf[9] << 8)) {
             case BTTFN_SSRC_GPS:
-                spdIsRotEnc = false;
+                m.spd.src = NMS_GPS;
                 break;
             case BTTFN_SSRC_P1:
-                // If packets come out-of-order, we might
-                // get this one before TTrunning, and we
-                // don't want the loop to switch to
-                // usingGPSS only because of P1 speed
-                if(!TTrunning) return;
-                // fall through
+                m.spd.src = NMS_P1;
+                break;
             default:
-                spdIsRotEnc = true;
+                m.spd.src = NMS_OTHER;
             }
-            gpsSpeed = (int16_t)(buf[6] | (buf[7] << 8));
-            if(gpsSpeed > 88) gpsSpeed = 88;
+            m.type = NM_SPEED;
+            m.spd.speed = (spd > 88) ? 88 : spd;
+            postToMain(m);
         } 
         bttfnTCDSeqCnt = seqCnt;
         break;
@@ -3296,60 +3598,55 @@ static void handle_tcd_notification(uint8_t *buf)
         // may not come at all.
         // We don't ignore this if TCD is connected by wire,
         // because this signal does not come via wire.
-        doPrepareTT = true;
+        postToMain(NM_PREPARE);
         break;
     case BTTFN_NOT_TT:
         // Trigger Time Travel (if not running already)
-        // Ignore command if TCD is connected by wire
-        if(!TCDconnected && !TTrunning && !IRLearning && !sidBusy) {
-            networkTimeTravel = true;
-            networkTCDTT = true;
-            networkReentry = false;
-            networkAbort = false;
-            networkLead = buf[6] | (buf[7] << 8);
-            networkP1 = buf[8] | (buf[9] << 8);
-        }
+        m.type = NM_TT;
+        m.tt.lead = buf[6] | (buf[7] << 8);
+        m.tt.p1 = buf[8] | (buf[9] << 8);
+        postToMain(m);
         break;
     case BTTFN_NOT_REENTRY:
         // Start re-entry (if TT currently running)
-        // Ignore command if TCD is connected by wire
-        if(!TCDconnected && (TTrunning || networkTimeTravel) && networkTCDTT) {
-            networkReentry = true;
-        }
+        postToMain(NM_REENTRY);
         break;
     case BTTFN_NOT_ABORT_TT:
         // Abort TT (if TT currently running)
-        // Ignore command if TCD is connected by wire
-        if(!TCDconnected && (TTrunning || networkTimeTravel) && networkTCDTT) {
-            networkAbort = true;
-        }
+        postToMain(NM_ABORT);
         break;
     case BTTFN_NOT_ALARM:
-        networkAlarm = true;
+        postToMain(NM_ALARM);
         break;
     case BTTFN_NOT_SID_CMD:
-        if(!sidBusy) {
-            addCmdQueue(GET32(buf, 6));
+        if(!(main_state() & MS_BUSY)) {
+            addCmdQueue(GET32(buf, 6), CMDSRC_BTTFN);
         }
         break;
     case BTTFN_NOT_WAKEUP:
-        doWakeup = true;
+        postToMain(NM_WAKEUP);
         break;
     case BTTFN_NOT_INFO:
         {
             uint16_t tcdi1 = buf[6] | (buf[7] << 8);
             uint16_t tcdi2 = buf[8] | (buf[9] << 8);
+            m.type = NM_TCDSTATE;
+            m.tcd.flags = 0;
+            m.tcd.mask = NMT_REMOTE | NMT_BUSY;
             if(tcdi1 & BTTFN_TCDI1_EXT) {
-                tcdNM  = !!(tcdi1 & BTTFN_TCDI1_NM);
-                tcdFPO = !!(tcdi1 & BTTFN_TCDI1_OFF);
+                if(tcdi1 & BTTFN_TCDI1_NM)  m.tcd.flags |= NMT_NM;
+                if(tcdi1 & BTTFN_TCDI1_OFF) m.tcd.flags |= NMT_FPO;
+                m.tcd.mask |= (NMT_NM | NMT_FPO);
             }
-            remoteAllowed = !(tcdi1 & BTTFN_TCDI1_NOREMKP);
-            tcdIsBusy = !!(tcdi2 & BTTFN_TCDI2_BUSY);
-            if(!remoteAllowed || tcdIsBusy) remMode = remHoldKey = false;
+            if(!(tcdi1 & BTTFN_TCDI1_NOREMKP)) m.tcd.flags |= NMT_REMOTE;
+            if(tcdi2 & BTTFN_TCDI2_BUSY)       m.tcd.flags |= NMT_BUSY;
+            m.tcd.us = micros();
+            postToMain(m);
 
             if(tcdi2 & BTTFN_TCDI2_TIMEINFO) {
-                memcpy(bttfnDateBuf, &buf[16], sizeof(bttfnDateBuf));
-                bttfnDateNow = millis();
+                m.type = NM_TCDDATE;
+                memcpy(m.date, &buf[16], sizeof(m.date));
+                postToMain(m);
             }
         }
         break;
@@ -3570,29 +3867,53 @@ static bool bttfn_connected()
     return true;
 }
 
+// Main side
 static bool bttfn_trigger_tt()
 {
-    if(!bttfn_connected())
+    if(!tcdLinkUp)
         return false;
 
     if(TTrunning || IRLearning || tcdIsBusy)
         return false;
 
+    return postToNet(NC_TRIGGER_TT);
+}
+
+// Main side
+static bool bttfn_queue_command(uint8_t cmd, uint8_t p1, uint8_t p2)
+{
+    netMsg m;
+    
+    if(!remoteAllowed && (cmd <= BTTFN_REM_MAX_COMMAND))
+        return false;
+
+    if(!tcdLinkUp)
+        return false;
+
+    m.type = NC_REMCMD;
+    m.rem.cmd = cmd;
+    m.rem.p1 = p1;
+    m.rem.p2 = p2;
+
+    return postToNet(m);
+}
+
+static void bttfn_do_trigger_tt()
+{
+    if(!bttfn_connected())
+        return;
+
     BTTFNPreparePacket();
 
     // Trigger BTTFN-wide TT
     BTTFUDPBuf[5] = 0x80;           
 
     BTTFNDispatch();
-
-    return true;
 }
 
+// Network side; remoteAllowed checked by main side
 static bool bttfn_send_command(uint8_t cmd, uint8_t p1, uint8_t p2)
 {
-    if(!remoteAllowed && (cmd <= BTTFN_REM_MAX_COMMAND))
-        return false;
-        
     if(!bttfn_connected())
         return false;
 
@@ -3653,16 +3974,41 @@ static void bttfn_setup()
 
 void bttfn_loop()
 {
+    // Commands from main side
+    handleMainMsgs();
+    
     if(!useBTTFN)
         return;
 
+    PROF_SCOPE(PROF_BTTFN);
+
     int t = 100;
+    bool link;
     
     while(bttfn_checkmc() && t--) {}
 
     unsigned long now = millisNonZero();
             
     BTTFNCheckPacket();
+
+    // If network is interrupted, return to stand-alone
+    if( !bttfnDataNotEnabled &&
+        ((lastBTTFNpacket && (now - lastBTTFNpacket > 30*1000)) ||
+         (!BTTFNBootTO && !lastBTTFNpacket && (now - powerupMillis > 60*1000))) ) {
+        lastBTTFNpacket = 0;
+        BTTFNBootTO = true;
+        postToMain(NM_TCDLOST);
+    }
+
+    // Tell main side whether we can send to TCD
+    if((link = bttfn_connected()) != bttfnLinkUp) {
+        netMsg m;
+        m.type = NM_TCDLINK;
+        m.val = link;
+        if(postToMain(m)) {
+            bttfnLinkUp = link;
+        }
+    }
     
     if(bttfnDataNotEnabled) {
         if(now - lastBTTFNKA > BTTFN_KA_INTERVAL) {
@@ -3693,12 +4039,15 @@ void bttfn_loop()
         if(!BTTFNWiFiUp && (WiFi.status() == WL_CONNECTED)) {
             BTTFNUpdateNow = 0;
         }
-        if((!BTTFNUpdateNow) || (now - BTTFNUpdateNow > bttfnSIDPollInt)) {
+        // Fast polling only makes sense if speed is not notified
+        if((!BTTFNUpdateNow) || 
+           (now - BTTFNUpdateNow > (bttfnTCDSeqCnt ? BTTFN_POLL_INT : bttfnSIDPollInt))) {
             BTTFNSendRequest();
         }
     }
 }
 
+#ifndef SID_NETTASK
 static void bttfn_loop_quick()
 {
     if(!useBTTFN)
@@ -3708,3 +4057,759 @@ static void bttfn_loop_quick()
     
     while(bttfn_checkmc() && t--) {}
 }
+#endif
+
+/*
+ * Network <-> main side messages
+ *
+ * Network side (WiFi, MQTT, BTTFN) and main side (display,
+ * SA, input) only talk through two lock-free queues, so the
+ * network side can run in its own task on the other core.
+ * Each queue has one producer and one consumer.
+ */
+
+// Slots in toMain only TT messages may use. A TT needs at most
+// three (tt, reentry, abort), so they get through even if speed
+// and state updates filled the queue while the main side was busy.
+#define TOMAIN_TT_RESERVE 4
+
+bool postToMain(const netMsg& m)
+{
+    switch(m.type) {
+    case NM_TT:
+    case NM_REENTRY:
+    case NM_ABORT:
+        if(toMain.put(m))
+            return true;
+        toMainTTLost++;
+        #ifdef SID_DBG
+        Serial.printf("postToMain: Queue full, TT message %d dropped (%u)\n", m.type, toMainTTLost);
+        #endif
+        return false;
+    }
+    
+    return toMain.put(m, TOMAIN_TT_RESERVE);
+}
+
+bool postToMain(uint8_t type)
+{
+    netMsg m;
+    m.type = type;
+    return postToMain(m);
+}
+
+bool postToNet(const netMsg& m)
+{
+    return toNet.put(m);
+}
+
+bool postToNet(uint8_t type, uint32_t val)
+{
+    netMsg m;
+    m.type = type;
+    m.val = val;
+    return toNet.put(m);
+}
+
+/*
+ * Called by network side before doing things that need
+ * the display and the file system for itself (saving 
+ * settings and rebooting, OTA update). Waits until the
+ * main side is parked in handleNetMsgs(); timeout 0 waits
+ * for as long as it takes. Returns false if the main side 
+ * did not stop in time; the caller must then not touch
+ * display or file system (and should try again later).
+ */
+bool main_halt(unsigned long timeout)
+{
+    #ifdef SID_NETTASK
+    unsigned long now = millis();
+
+    mainHaltReq = true;
+    while(!mainHalted) {
+        if(timeout && (millis() - now >= timeout)) {
+            mainHaltReq = false;
+            #ifdef SID_DBG
+            Serial.println("main_halt: Main side did not stop");
+            #endif
+            return false;
+        }
+        delay(5);
+    }
+    #endif
+
+    return true;
+}
+
+void main_resume()
+{
+    mainHaltReq = false;
+    
+    #ifdef SID_NETTASK
+    // Wait until main side is running again; otherwise
+    // a main_halt() right after this would see the stale
+    // mainHalted and go ahead while main side still runs
+    while(mainHalted) {
+        delay(1);
+    }
+    #endif
+}
+
+/*
+ * Main side state for the network side. The flags are only
+ * written on the main side; the network side, which may run
+ * on the other core, must not read them directly.
+ */
+uint8_t main_state()
+{
+    uint8_t s = 0;
+
+    if(__atomic_load_n(&TTrunning, __ATOMIC_RELAXED))    s |= MS_TT;
+    if(__atomic_load_n(&IRLearning, __ATOMIC_RELAXED))   s |= MS_IRLEARN;
+    if(__atomic_load_n(&sidBusy, __ATOMIC_RELAXED))      s |= MS_BUSY;
+    if(__atomic_load_n(&networkAlarm, __ATOMIC_RELAXED)) s |= MS_ALARM;
+    if(__atomic_load_n(&FPBUnitIsOn, __ATOMIC_RELAXED))  s |= MS_FPBON;
+    if(__atomic_load_n(&blockScan, __ATOMIC_RELAXED))    s |= MS_NOSCAN;
+
+    return s;
+}
+
+// Tell network side about a changed Config Portal value
+static void cpUpdate(uint8_t what)
+{
+    uint32_t v = 0;
+
+    switch(what) {
+    case NCU_STRICT:
+        v = strictMode ? 1 : 0;
+        break;
+    case NCU_SA:
+        v = saMode | (doPeaks ? 0x10 : 0) | (doMirror ? 0x20 : 0);
+        break;
+    case NCU_IRFB:
+        v = (irShowPosFBDisplay ? 0x01 : 0) | (irShowCmdFBDisplay ? 0x02 : 0);
+        break;
+    }
+
+    postToNet(NC_CPUPDATE, what | (v << 8));
+}
+
+// Main side
+static void handleNetMsg(const netMsg& m)
+{
+    switch(m.type) {
+    case NM_PREPARE:
+        doPrepareTT = true;
+        break;
+    case NM_TT:
+        // Ignore if TCD is connected by wire
+        if(!TCDconnected && !TTrunning && !IRLearning && !sidBusy) {
+            networkTimeTravel = true;
+            networkTCDTT = true;
+            networkReentry = false;
+            networkAbort = false;
+            networkLead = m.tt.lead;
+            networkP1 = m.tt.p1;
+        }
+        break;
+    case NM_REENTRY:
+        // Ignore if TCD is connected by wire
+        if(!TCDconnected && (TTrunning || networkTimeTravel) && networkTCDTT) {
+            networkReentry = true;
+        }
+        break;
+    case NM_ABORT:
+        // Ignore if TCD is connected by wire
+        if(!TCDconnected && (TTrunning || networkTimeTravel) && networkTCDTT) {
+            networkAbort = true;
+        }
+        break;
+    case NM_ALARM:
+        networkAlarm = true;
+        break;
+    case NM_WAKEUP:
+        doWakeup = true;
+        break;
+    case NM_SPEED:
+        // If packets come out-of-order, we might
+        // get this one before TTrunning, and we
+        // don't want the loop to switch to
+        // usingGPSS only because of P1 speed
+        if(m.spd.src == NMS_P1 && !TTrunning)
+            break;
+        gpsSpeed = m.spd.speed;
+        spdIsRotEnc = (m.spd.src != NMS_GPS);
+        break;
+    case NM_TCDSTATE:
+        if(m.tcd.mask & NMT_NM)     tcdNM = !!(m.tcd.flags & NMT_NM);
+        if(m.tcd.mask & NMT_FPO) {
+            bool fpo = !!(m.tcd.flags & NMT_FPO);
+            if(useFPO && fpo != tcdFPO) fpoTrigUs = m.tcd.us;
+            tcdFPO = fpo;
+        }
+        if(m.tcd.mask & NMT_REMOTE) remoteAllowed = !!(m.tcd.flags & NMT_REMOTE);
+        if(m.tcd.mask & NMT_BUSY)   tcdIsBusy = !!(m.tcd.flags & NMT_BUSY);
+        if(!remoteAllowed || tcdIsBusy) remMode = remHoldKey = false;
+        break;
+    case NM_TCDDATE:
+        memcpy(bttfnDateBuf, m.date, sizeof(bttfnDateBuf));
+        bttfnDateNow = millis();
+        break;
+    case NM_TCDLOST:
+        tcdNM = false;
+        tcdFPO = false;
+        remoteAllowed = remMode = remHoldKey = false;
+        gpsSpeed = -1;
+        break;
+    case NM_TCDLINK:
+        tcdLinkUp = !!m.val;
+        break;
+    case NM_TEXT:
+        memcpy(mqttMsg, m.text, sizeof(mqttMsg));
+        mqttMsg[sizeof(mqttMsg) - 1] = 0;
+        mqttDisp = true;
+        break;
+    }
+}
+
+static void handleNetMsgs()
+{
+    netMsg m;
+
+    #ifdef SID_NETTASK
+    if(mainHaltReq) {
+        mainHalted = true;
+        while(mainHaltReq) {
+            delay(10);
+        }
+        mainHalted = false;
+    }
+    #endif
+
+    while(toMain.get(m)) {
+        handleNetMsg(m);
+    }
+}
+
+// Network side
+static void handleMainMsgs()
+{
+    netMsg m;
+
+    while(toNet.get(m)) {
+        switch(m.type) {
+        case NC_TRIGGER_TT:
+            bttfn_do_trigger_tt();
+            break;
+        case NC_REMCMD:
+            bttfn_send_command(m.rem.cmd, m.rem.p1, m.rem.p2);
+            break;
+        case NC_POLLINT:
+            bttfnSIDPollInt = m.val;
+            break;
+        case NC_WIFION:
+            wifiOn(0, true, false);
+            break;
+        case NC_CPUPDATE:
+            switch(m.val & 0xff) {
+            case NCU_STRICT:
+                updateConfigPortalStrictValue(!!(m.val >> 8));
+                break;
+            case NCU_SA:
+                updateConfigPortalSAValues((m.val >> 8) & 0x0f, !!(m.val & (0x10 << 8)), !!(m.val & (0x20 << 8)));
+                break;
+            case NCU_IRFB:
+                updateConfigPortalIRFBValues(!!(m.val & (0x01 << 8)), !!(m.val & (0x02 << 8)));
+                break;
+            }
+            break;
+        case NC_SETCM:
+            wifiSetCarMode(!!m.val);
+            break;
+        }
+    }
+}
+
+#ifdef SID_BENCH
+/*
+ * Benchmarks: BTTFN packet check and parsing. Runs before the
+ * network task is started, so we may consume the messages
+ * posted by handle_tcd_notification() ourselves.
+ */
+static uint8_t benchPkt[BTTF_PACKET_SIZE];
+
+static void bench_checkPacket()
+{
+    check_packet(benchPkt);
+}
+
+static void bench_tcdNotification()
+{
+    netMsg m;
+    
+    handle_tcd_notification(benchPkt);
+    while(toMain.get(m)) { }
+}
+
+// Idle pattern step (interpreter only; random walk continues),
+// and the same step in the previous native code (sid_patref)
+static const uint8_t *benchProg;
+static patCtx benchPat;
+static int benchMode;
+static patRefState benchRef;
+
+static void bench_patRun()
+{
+    benchPat.r[PVR_FLG] = 0;
+    benchPat.now += 1000;
+    patRun(benchProg, benchPat);
+}
+
+static void bench_patRef()
+{
+    benchRef.flags = 0;
+    benchPat.now += 1000;
+    patRefStep(benchMode, !!benchPat.r[PVR_STRICT], false, benchPat.now, benchRef, patRNG, patBars);
+}
+
+void main_bench()
+{
+    uint32_t oldSeqCnt = bttfnTCDSeqCnt;
+    uint8_t a = 0;
+
+    memset(benchPkt, 0, sizeof(benchPkt));
+    memcpy(benchPkt, BTTFUDPHD, 4);
+    benchPkt[4] = BTTFN_VERSION | 0x40;
+    benchPkt[5] = BTTFN_NOT_SPD;
+    benchPkt[6] = 88;                   // Speed
+    benchPkt[8] = BTTFN_SSRC_GPS;       // Source
+    benchPkt[12] = 1;                   // Sequence counter: Always accepted
+    for(int i = 4; i < BTTF_PACKET_SIZE - 1; i++) {
+        a += benchPkt[i] ^ 0x55;
+    }
+    benchPkt[BTTF_PACKET_SIZE - 1] = a;
+
+    bench_run("bttfn_check_packet", bench_checkPacket, 1000);
+    bench_run("bttfn_tcd_notification", bench_tcdNotification, 1000);
+
+    memset(&benchPat, 0, sizeof(benchPat));
+    benchPat.rng = &patRNG;
+    benchPat.bars = patBars;
+    for(int st = 0; st <= 1; st++) {
+        for(int i = 0; i <= SID_IDLE_IDC; i++) {
+            const char *sfx = st ? "_strict" : "";
+            char name[24];
+            uint32_t vmCyc, refCyc;
+            benchPat.r[PVR_BL] = 10;
+            benchPat.r[PVR_SBL] = 20;
+            benchPat.r[PVR_STRICT] = st;
+            snprintf(name, sizeof(name), "pat_idle%d%s", i, sfx);
+            benchProg = patBuiltin[i];
+            vmCyc = bench_run(name, bench_patRun, 1000);
+            memset(&benchRef, 0, sizeof(benchRef));
+            benchRef.bl = 10;
+            benchRef.sbl = 20;
+            benchMode = i;
+            snprintf(name, sizeof(name), "pat_ref_idle%d%s", i, sfx);
+            refCyc = bench_run(name, bench_patRef, 1000);
+            Serial.printf("{\"pat\":\"idle%d%s\",\"vm_cyc\":%u,\"ref_cyc\":%u,\"vm_pct\":%.0f}\n",
+                i, sfx, vmCyc, refCyc, refCyc ? (float)vmCyc * 100.0f / (float)refCyc : 0.0f);
+        }
+    }
+
+    bttfnTCDSeqCnt = oldSeqCnt;
+    gpsSpeed = -1;
+}
+#endif
+
+#ifdef SID_GOLDEN
+/*
+ * Golden-frame regression
+ * 
+ * Runs the idle patterns (all modes, strict and non-strict), 
+ * the GPS-speed baselines and both TT sequences (stand-alone 
+ * and TCD-synced) on a virtual clock with a fixed PRNG seed.
+ * Every sid.show() is hashed (display buffer, brightness and
+ * virtual time). The hash sequence is compared against a golden
+ * file on SD; if there is none, it is recorded.
+ * Results are printed as JSON lines: "fps" is the rate of visible
+ * changes in virtual time (what the display would show), "real_us"
+ * the real time the scenario took to compute (without the yields,
+ * including hashing) and "real_fps" the frames rendered per real
+ * second.
+ */
+#define GOLDEN_MAXFRAMES 512
+#define GOLDEN_SEED      0x5eed1985
+#define GOLDEN_STEP      10         // Virtual ms per step
+#define GOLDEN_DUR       20000      // Virtual duration of scenario
+#define GOLDEN_TTDUR     40000      // Same, for TT scenarios
+#define GOLDEN_TTAT      2000       // TT start within scenario
+#define GOLDEN_REENTRY   4000       // Reentry after end of lead (TCD-synced)
+#define GOLDEN_BRI       12
+
+#define GLD_IDLE   0
+#define GLD_GPS    1
+#define GLD_TTINT  2
+#define GLD_TTTCD  3
+
+static const struct {
+    const char *name;
+    uint8_t    type;
+    uint8_t    idleMode;
+    bool       strict;
+} goldenScen[] = {
+    { "idle0",   GLD_IDLE,  SID_IDLE_0,   false },
+    { "idle0s",  GLD_IDLE,  SID_IDLE_0,   true  },
+    { "idle1",   GLD_IDLE,  SID_IDLE_1,   false },
+    { "idle1s",  GLD_IDLE,  SID_IDLE_1,   true  },
+    { "idle2",   GLD_IDLE,  SID_IDLE_2,   false },
+    { "idle2s",  GLD_IDLE,  SID_IDLE_2,   true  },
+    { "idle3",   GLD_IDLE,  SID_IDLE_3,   false },
+    { "idle3s",  GLD_IDLE,  SID_IDLE_3,   true  },
+    { "idle4",   GLD_IDLE,  SID_IDLE_BL,  false },
+    { "idle4s",  GLD_IDLE,  SID_IDLE_BL,  true  },
+    { "idle5",   GLD_IDLE,  SID_IDLE_IDC, false },
+    { "idle5s",  GLD_IDLE,  SID_IDLE_IDC, true  },
+    { "gps",     GLD_GPS,   SID_IDLE_0,   false },
+    { "gpss",    GLD_GPS,   SID_IDLE_0,   true  },
+    { "ttint",   GLD_TTINT, SID_IDLE_0,   false },
+    { "ttints",  GLD_TTINT, SID_IDLE_0,   true  },
+    { "ttintlm", GLD_TTINT, SID_IDLE_IDC, false },
+    { "tttcd",   GLD_TTTCD, SID_IDLE_0,   false },
+    { "tttcds",  GLD_TTTCD, SID_IDLE_0,   true  },
+    { "tttcdlm", GLD_TTTCD, SID_IDLE_IDC, false }
+};
+
+static uint32_t goldenHash[GOLDEN_MAXFRAMES];
+static int      goldenShows, goldenFrames;
+static uint32_t goldenLastBuf;
+
+// FNV-1a
+static uint32_t goldenFNV(uint32_t h, const uint8_t *p, int len)
+{
+    while(len--) {
+        h ^= *p++;
+        h *= 16777619;
+    }
+    return h;
+}
+
+static void goldenShow(const uint16_t *buf, int len, uint8_t bri)
+{
+    uint32_t h = goldenFNV(2166136261, (const uint8_t *)buf, len * sizeof(uint16_t));
+
+    h = goldenFNV(h, &bri, 1);
+
+    // Count visible changes for fps
+    if(!goldenShows || h != goldenLastBuf) {
+        goldenFrames++;
+        goldenLastBuf = h;
+    }
+    
+    // Stored hash includes time, so timing changes show up as well
+    if(goldenShows < GOLDEN_MAXFRAMES) {
+        goldenHash[goldenShows] = goldenFNV(h, (const uint8_t *)&goldenNow, sizeof(goldenNow));
+    }
+    goldenShows++;
+}
+
+static void goldenReset(uint8_t mode, bool strict)
+{
+    idleMode = mode;
+    strictMode = strict;
+    
+    useGPSS = usingGPSS = false;
+    gpsSpeed = -1;
+    prevGPSSpeed = -2;
+    
+    sidBaseLine = strictBaseLine = 0;
+    blWayup = true;
+    lastChange = lastChange2 = 0;
+    idleDelay = idleDelay2 = 800;
+    memset(oldIdleHeight, 19, sizeof(oldIdleHeight));
+    LMIdx = LMY = LMState = id5idx = 0;
+    LMAdvNow = LMDelay = 0;
+    
+    networkTCDTT = networkReentry = networkAbort = false;
+
+    patRNG.seed(GOLDEN_SEED);
+    goldenNow = 100000;
+    goldenShows = goldenFrames = 0;
+    
+    sid.clearBuf();
+    sid.setBrightness(GOLDEN_BRI);
+}
+
+static void goldenScenario(int idx)
+{
+    uint8_t type = goldenScen[idx].type;
+    unsigned long t, t0, dur;
+    bool ttStarted = false;
+    int steps = 0, stored, golden, at = -1;
+    unsigned long realStart, yieldUs = 0, realUs;
+    const char *res;
+    uint32_t *ref;
+    
+    goldenReset(goldenScen[idx].idleMode, goldenScen[idx].strict);
+
+    useGPSS = (type == GLD_GPS);
+    dur = (type >= GLD_TTINT) ? GOLDEN_TTDUR : GOLDEN_DUR;
+    t0 = goldenNow;
+    realStart = micros();
+    
+    while((t = goldenNow - t0) < dur) {
+
+        switch(type) {
+        case GLD_GPS:
+            // Ramp up 0->88 in 13.2 seconds, then hold
+            gpsSpeed = min(88, (int)(t / 150));
+            break;
+        case GLD_TTINT:
+        case GLD_TTTCD:
+            if(!ttStarted && t >= GOLDEN_TTAT) {
+                networkTCDTT = (type == GLD_TTTCD);
+                timeTravel(networkTCDTT, ETTO_LEAD);
+                ttStarted = true;
+            }
+            if(networkTCDTT && t >= GOLDEN_TTAT + ETTO_LEAD + GOLDEN_REENTRY) {
+                networkReentry = true;
+            }
+            break;
+        }
+
+        if(TTrunning) {
+            ttFeedEvents();
+            ttLoop(goldenNow);
+        } else {
+            showIdle();
+        }
+
+        goldenNow += GOLDEN_STEP;
+
+        if(!(++steps & 63)) {
+            unsigned long y = micros();
+            vTaskDelay(1);
+            yieldUs += micros() - y;
+        }
+    }
+
+    realUs = micros() - realStart - yieldUs;
+
+    if(TTrunning) {
+        ttSeq.stop();
+        TTrunning = false;
+    }
+    networkTCDTT = networkReentry = false;
+
+    stored = min(goldenShows, GOLDEN_MAXFRAMES);
+    
+    if(!(ref = (uint32_t *)malloc(GOLDEN_MAXFRAMES * sizeof(uint32_t)))) {
+        res = "nomem";
+    } else if((golden = readGolden(goldenScen[idx].name, ref, GOLDEN_MAXFRAMES)) < 0) {
+        res = writeGolden(goldenScen[idx].name, goldenHash, stored) ? "recorded" : "nosd";
+    } else {
+        for(int i = 0; i < min(stored, golden); i++) {
+            if(ref[i] != goldenHash[i]) {
+                at = i;
+                break;
+            }
+        }
+        if(at < 0 && stored != golden) {
+            at = min(stored, golden);
+        }
+        res = (at < 0) ? "match" : "mismatch";
+    }
+    free(ref);
+    
+    Serial.printf("{\"golden\":\"%s\",\"frames\":%d,\"shows\":%d,\"fps\":%.1f,\"real_us\":%lu,\"real_fps\":%.0f,\"result\":\"%s\",\"at\":%d}\n",
+        goldenScen[idx].name, goldenFrames, goldenShows, 
+        (float)goldenFrames * 1000.0f / (float)dur, 
+        realUs, realUs ? (float)goldenShows * 1000000.0f / (float)realUs : 0.0f, res, at);
+}
+
+void golden_run()
+{
+    uint16_t oIdleMode = idleMode;
+    bool     oStrict = strictMode, oUseGPSS = useGPSS, oSkipAnim = skipTTAnim;
+    bool     wasSA = saActive;
+    uint8_t  oBri = sid.getBrightness();
+
+    span_stop();
+    siddly_stop();
+    snake_stop();
+    
+    skipTTAnim = false;
+    
+    sid.setShowHook(goldenShow);
+    goldenRun = true;
+    
+    for(int i = 0; i < (int)(sizeof(goldenScen) / sizeof(goldenScen[0])); i++) {
+        goldenScenario(i);
+    }
+    
+    goldenRun = false;
+    sid.setShowHook(NULL);
+    
+    goldenReset(oIdleMode, oStrict);
+    useGPSS = oUseGPSS;
+    skipTTAnim = oSkipAnim;
+    sid.setBrightness(oBri);
+    sid.clearDisplayDirect();
+    patSeed();
+    
+    if(wasSA) {
+        span_start();
+    }
+}
+#endif
+
+#ifdef SID_INJECT
+/*
+ * Event injector: Line-based commands on serial, so that scenarios
+ * can be scripted from a host. Injected events take the same paths 
+ * as real ones.
+ *
+ *   k <n>            IR key (0-9, 10=*, 11=#, 12-15=arrows, 16=OK)
+ *   b [h]            TT button press [held]
+ *   c <code>         Remote command (as from BTTFN/MQTT)
+ *   n <type> [a [b]] Network message: prepare, tt <lead> <p1>, reentry,
+ *                    abort, alarm, wakeup, speed <spd> <src>, text <txt>
+ *   s                Status line
+ *   l                Latency statistics
+ *   p, r             Profiler report/reset (if SID_PROFILE)
+ *
+ * Every command is acknowledged with "OK" or "ERR".
+ */
+static void inj_status()
+{
+    Serial.printf("ST t=%lu tt=%d ph=%d fpb=%d sa=%d si=%d sn=%d ss=%d bl=%d sbl=%d pwr=%d lps=%u\n",
+        millis(), TTrunning, ttSeq.running() ? ttSeq.phase() : -1,
+        FPBUnitIsOn, saActive, siActive, snActive, ssActive, 
+        sidBaseLine, strictBaseLine, pwr.state(), pwr.loopRate(pwr.state()));
+}
+
+static void inj_latPrint(const char *name, ttLatStat& st)
+{
+    Serial.printf("LAT %s n=%u min=%u avg=%u max=%u\n", name, st.cnt,
+        st.cnt ? st.min : 0, st.cnt ? st.sum / st.cnt : 0, st.max);
+}
+
+// Latency statistics (us)
+static void inj_latency()
+{
+    inj_latPrint("tt_start", ttLatStart);
+    inj_latPrint("tt_frame", ttLatFrame);
+    inj_latPrint("fpo_off", fpoLatOff);
+    inj_latPrint("fpo_on", fpoLatOn);
+}
+
+static bool inj_net(char *type, char *args)
+{
+    static const struct {
+        const char *name;
+        uint8_t    type;
+    } nmNames[] = {
+        { "prepare", NM_PREPARE }, { "tt", NM_TT }, { "reentry", NM_REENTRY },
+        { "abort", NM_ABORT },     { "alarm", NM_ALARM }, { "wakeup", NM_WAKEUP },
+        { "speed", NM_SPEED },     { "text", NM_TEXT }
+    };
+    netMsg m;
+    long a = -1, b = -1;
+
+    memset(&m, 0, sizeof(m));
+    
+    for(int i = 0; i < (int)(sizeof(nmNames) / sizeof(nmNames[0])); i++) {
+        if(!strcmp(type, nmNames[i].name)) {
+            m.type = nmNames[i].type;
+            break;
+        }
+    }
+    if(!m.type) return false;
+
+    if(m.type == NM_TEXT) {
+        strncpy(m.text, args, sizeof(m.text) - 1);
+    } else {
+        sscanf(args, "%ld %ld", &a, &b);
+    }
+    if(m.type == NM_TT) {
+        m.tt.lead = (a >= 0) ? a : ETTO_LEAD;
+        m.tt.p1 = (b >= 0) ? b : P1_DUR_TCD;
+    } else if(m.type == NM_SPEED) {
+        if(a < 0) return false;
+        m.spd.speed = a;
+        m.spd.src = (b >= 0) ? b : NMS_GPS;
+    }
+    
+    handleNetMsg(m);
+    return true;
+}
+
+static bool inj_exec(char *line)
+{
+    char *args = line + 1;
+    long val;
+
+    while(*args == ' ') args++;
+
+    // Single characters are for the profiler
+    #ifdef SID_PROFILE
+    if(line[0] && !line[1]) {
+        if(prof_cmd(line[0])) return true;
+    }
+    #endif
+    
+    switch(line[0]) {
+    case 'k':
+        val = strtol(args, NULL, 10);
+        if(*args < '0' || *args > '9' || val > 16) return false;
+        handleIRKey(val);
+        break;
+    case 'b':
+        if(*args == 'h') TTKeyHeld();
+        else             TTKeyPressed();
+        break;
+    case 'c':
+        val = strtol(args, NULL, 10);
+        if(val <= 0) return false;
+        return addCmdQueue(val, CMDSRC_SERIAL);
+    case 'n':
+        {
+            char *p = args;
+            while(*p && *p != ' ') p++;
+            if(*p) *p++ = 0;
+            while(*p == ' ') p++;
+            return inj_net(args, p);
+        }
+    case 's':
+        inj_status();
+        break;
+    case 'l':
+        inj_latency();
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+static void inj_serial()
+{
+    static char buf[48];
+    static int  len = 0;
+
+    while(Serial.available()) {
+        char c = Serial.read();
+        if(c == '\r') continue;
+        if(c == '\n') {
+            buf[len] = 0;
+            if(len) {
+                Serial.println(inj_exec(buf) ? "OK" : "ERR");
+            }
+            len = 0;
+        } else if(len < (int)sizeof(buf) - 1) {
+            buf[len++] = c;
+        }
+    }
+}
+#endif
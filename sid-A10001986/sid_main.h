@@ -58,7 +58,30 @@
 
 void main_boot();
 void main_setup();
+void main_sched_setup();
+#ifdef SID_BENCH
+void main_bench();
+#endif
+#ifdef SID_GOLDEN
+void golden_run();
+#endif
+// Scheduler task intervals (ms); the TT and SA tasks
+// set their own deadlines within these limits
+#define IR_TASK_INT     5
+#define MAIN_TASK_INT   5
+#define TT_TASK_INT     5       // Max while TT runs
+#define TT_IDLE_INT   500       // While no TT; timeTravel() wakes it up
+#define SA_TASK_INT     5       // Games; SA: until next frame
+#define IDLE_TASK_INT   5
+#define NET_TASK_INT    5       // WiFi, BTTFN (without SID_NETTASK)
+#define HK_TASK_INT   250
+
 void main_loop();
+void main_ir_loop();
+void main_tt_loop();
+void main_sa_loop();
+void main_idle_loop();
+void main_housekeeping();
 
 void flushDelayedSave();
 
@@ -81,22 +104,23 @@ void wakeup();
 
 void setIdleMode(int idleNo);
 
-void addCmdQueue(uint32_t command);
+bool addCmdQueue(uint32_t command, uint8_t src, uint8_t flags = 0);
+bool cmdQueueFull();
+uint32_t cmdQueueDropped(uint8_t src);
 void bttfn_loop();
 
 extern unsigned long powerupMillis;
 
 extern sidDisplay sid;
 
-#define SID_MAX_IDLE_MODE 5
+#define SID_MAX_IDLE_MODE 6
 extern uint16_t idleMode;
 extern bool     strictMode;
 
 // Number of IR keys
 #define NUM_IR_KEYS 17
-#define NUM_REM_TYPES 2
-#define REM_KEYS_LEARNED 0
-#define REM_KEYS_DEFAULT 1
+// Number of learnable remotes
+#define NUM_IR_REMOTES 4
 
 extern bool irLocked;
 extern bool irShowPosFBDisplay;
@@ -111,24 +135,10 @@ extern bool blockScan;
 extern bool TTrunning;
 extern bool IRLearning;
 
-extern bool networkTimeTravel;
-extern bool networkTCDTT;
-extern bool networkReentry;
-extern bool networkAbort;
-extern bool networkAlarm;
-extern uint16_t networkLead;
-extern uint16_t networkP1;
-
-extern uint32_t mqttDisp;
-#ifdef SID_HAVEMQTT
-extern char mqttMsg[];
-#endif
+extern bool networkAlarm;       // Network side: Use main_state()
 
 extern uint32_t myRemID;
 
-extern bool doPrepareTT;
-extern bool doWakeup;
-
 extern bool sidBusy;
 
 extern bool showUpdAvail;
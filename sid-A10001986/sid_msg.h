@@ -0,0 +1,259 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Messages between network and main side
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _SID_MSG_H
+#define _SID_MSG_H
+
+/*
+ * Lock-free single-producer/single-consumer queue.
+ * N must be a power of 2. Safe across cores as long as only
+ * one task puts and only one task gets.
+ * put() with reserve > 0 leaves that many slots free, so
+ * important messages still find room when others fill it.
+ */
+template <typename T, uint32_t N>
+class msgQueue {
+    public:
+        bool put(const T& m, uint32_t reserve = 0) {
+            uint32_t h = _head;
+            if(h - _tail >= N - reserve) {
+                _lost++;
+                return false;
+            }
+            _buf[h & (N - 1)] = m;
+            __sync_synchronize();   // Data before index
+            _head = h + 1;
+            return true;
+        }
+        bool get(T& m) {
+            uint32_t t = _tail;
+            if(t == _head) 
+                return false;
+            __sync_synchronize();   // Index before data
+            m = _buf[t & (N - 1)];
+            __sync_synchronize();   // Data read before slot is freed
+            _tail = t + 1;
+            return true;
+        }
+        uint32_t lost() { return _lost; }
+        
+    private:
+        volatile uint32_t _head = 0;
+        volatile uint32_t _tail = 0;
+        uint32_t          _lost = 0;
+        T                 _buf[N];
+};
+
+/*
+ * Lock-free bounded multi-producer/single-consumer queue.
+ * N must be a power of 2. Each slot carries a sequence number
+ * which tells producers and consumer whose turn it is; producers
+ * claim slots by compare-and-swap on the head index.
+ */
+template <typename T, uint32_t N>
+class mpscQueue {
+    public:
+        mpscQueue() {
+            for(uint32_t i = 0; i < N; i++) {
+                _cells[i].seq = i;
+            }
+        }
+        bool put(const T& m) {
+            uint32_t pos = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+            cell *c;
+            for(;;) {
+                c = &_cells[pos & (N - 1)];
+                int32_t diff = (int32_t)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - pos);
+                if(!diff) {
+                    if(__atomic_compare_exchange_n(&_head, &pos, pos + 1, true, 
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                        break;
+                } else if(diff < 0) {
+                    // Full
+                    __atomic_fetch_add(&_lost, 1, __ATOMIC_RELAXED);
+                    return false;
+                } else {
+                    pos = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+                }
+            }
+            c->data = m;
+            __atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+        bool get(T& m) {
+            cell *c = &_cells[_tail & (N - 1)];
+            if(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) != _tail + 1)
+                return false;
+            m = c->data;
+            __atomic_store_n(&c->seq, _tail + N, __ATOMIC_RELEASE);
+            _tail++;
+            return true;
+        }
+        // Approximate; exact only when called by consumer
+        uint32_t count() { 
+            return __atomic_load_n(&_head, __ATOMIC_RELAXED) - __atomic_load_n(&_tail, __ATOMIC_RELAXED); 
+        }
+        uint32_t lost() { return _lost; }
+
+    private:
+        typedef struct {
+            uint32_t seq;
+            T        data;
+        } cell;
+        cell     _cells[N];
+        uint32_t _head = 0;
+        uint32_t _tail = 0;
+        uint32_t _lost = 0;
+};
+
+// Remote commands (BTTFN, MQTT) for main side
+typedef struct {
+    uint32_t      code;
+    unsigned long stamp;    // millis() when queued
+    uint8_t       src;
+    uint8_t       flags;
+} sidCmd;
+
+#define CMDSRC_BTTFN    0
+#define CMDSRC_MQTT     1
+#define CMDSRC_SERIAL   2       // Event injector (SID_INJECT)
+#define CMDSRC_NUM      3
+
+#define CMDF_INJECT     0x01    // Injected through MQTT (INJECT_)
+
+// Network side -> main side
+#define NM_PREPARE      1   // Prepare for TT
+#define NM_TT           2   // Time travel (tt.lead, tt.p1)
+#define NM_REENTRY      3   // Re-entry
+#define NM_ABORT        4   // Abort TT
+#define NM_ALARM        5   // Alarm
+#define NM_WAKEUP       6   // Wakeup
+#define NM_SPEED        7   // Speed (spd.speed, spd.src)
+#define NM_TCDSTATE     8   // TCD state (tcd.flags, tcd.mask)
+#define NM_TCDDATE      9   // TCD date/time (date)
+#define NM_TCDLOST     10   // Lost contact to TCD
+#define NM_TCDLINK     11   // BTTFN connected (val)
+#define NM_TEXT        12   // Text to display (text)
+
+// spd.src
+#define NMS_GPS         0
+#define NMS_P1          1
+#define NMS_OTHER       2   // Rotary encoder, remote
+
+// tcd.flags, tcd.mask
+#define NMT_NM          0x01
+#define NMT_FPO         0x02
+#define NMT_REMOTE      0x04
+#define NMT_BUSY        0x08
+
+// Main side -> network side
+#define NC_TRIGGER_TT  64   // Trigger BTTFN-wide TT
+#define NC_REMCMD      65   // Send remote command (rem.cmd, rem.p1, rem.p2)
+#define NC_POLLINT     66   // New BTTFN poll interval (val)
+#define NC_WIFION      67   // wifiOn(0, true, false)
+#define NC_CPUPDATE    68   // Update Config Portal value (val)
+#define NC_SETCM       69   // Set car mode and reboot (val)
+
+// NC_CPUPDATE val: What in the low byte, current
+// value(s) above, as the network side must not read
+// the main side's variables
+#define NCU_STRICT      1   // strictMode
+#define NCU_SA          2   // saMode, doPeaks << 4, doMirror << 5
+#define NCU_IRFB        3   // irShowPosFBDisplay, irShowCmdFBDisplay << 1
+
+typedef struct {
+    uint8_t type;
+    union {
+        struct {
+            uint16_t lead;
+            uint16_t p1;
+        } tt;
+        struct {
+            int16_t speed;
+            uint8_t src;
+        } spd;
+        struct {
+            uint8_t  flags;
+            uint8_t  mask;
+            uint32_t us;        // micros() when evaluated
+        } tcd;
+        struct {
+            uint8_t cmd;
+            uint8_t p1;
+            uint8_t p2;
+        } rem;
+        uint32_t val;
+        uint8_t  date[8];
+        char     text[10];
+    };
+} netMsg;
+
+bool postToMain(const netMsg& m);
+bool postToMain(uint8_t type);
+bool postToNet(const netMsg& m);
+bool postToNet(uint8_t type, uint32_t val = 0);
+
+bool main_halt(unsigned long timeout = 2000);
+void main_resume();
+
+// Main side state for the network side (main_state())
+#define MS_TT           0x01    // TTrunning
+#define MS_IRLEARN      0x02    // IRLearning
+#define MS_BUSY         0x04    // sidBusy
+#define MS_ALARM        0x08    // networkAlarm
+#define MS_FPBON        0x10    // FPBUnitIsOn
+#define MS_NOSCAN       0x20    // blockScan
+
+uint8_t main_state();
+
+#endif
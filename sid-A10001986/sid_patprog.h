@@ -0,0 +1,112 @@
+/*
+ * Built-in idle patterns
+ * Generated by tools/sidpatc.py from tools/patterns - do not edit
+ */
+#ifndef _SID_PATPROG_H
+#define _SID_PATPROG_H
+
+// idle0.sidp
+static const uint8_t pat_idle0[167] = {
+    0x07, 0x05, 0xbc, 0x02, 0x83, 0x03, 0x11, 0x09, 0x00, 0x00, 0x40, 0x00,
+    0x11, 0x0a, 0x00, 0x00, 0x89, 0x00, 0x11, 0x00, 0x0e, 0x00, 0x2b, 0x00,
+    0x11, 0x00, 0x08, 0x00, 0x32, 0x00, 0x12, 0x00, 0x03, 0x00, 0x39, 0x00,
+    0x05, 0x00, 0x04, 0xff, 0x10, 0x89, 0x00, 0x06, 0x00, 0x03, 0x01, 0x10,
+    0x89, 0x00, 0x06, 0x00, 0x05, 0x01, 0x10, 0x89, 0x00, 0x05, 0x00, 0x03,
+    0x02, 0x10, 0x89, 0x00, 0x04, 0x04, 0x80, 0x00, 0x11, 0x0a, 0x00, 0x00,
+    0x80, 0x00, 0x11, 0x01, 0x1e, 0x00, 0x6a, 0x00, 0x12, 0x01, 0x0a, 0x00,
+    0x75, 0x00, 0x11, 0x02, 0x00, 0x00, 0x63, 0x00, 0x05, 0x01, 0x07, 0xfc,
+    0x10, 0x89, 0x00, 0x05, 0x01, 0x07, 0xfe, 0x10, 0x89, 0x00, 0x06, 0x01,
+    0x03, 0x01, 0x01, 0x02, 0x00, 0x00, 0x10, 0x89, 0x00, 0x05, 0x01, 0x03,
+    0x02, 0x01, 0x02, 0x01, 0x00, 0x10, 0x89, 0x00, 0x13, 0x05, 0x02, 0x89,
+    0x00, 0x03, 0x01, 0x01, 0x00, 0x11, 0x0a, 0x00, 0x00, 0xa6, 0x00, 0x12,
+    0x07, 0x01, 0x00, 0xa6, 0x00, 0x01, 0x07, 0x00, 0x00, 0x11, 0x09, 0x00,
+    0x00, 0xa3, 0x00, 0x09, 0x00, 0x03, 0x00, 0x09, 0x01, 0x07, 0x00,
+};
+
+// idle1.sidp
+static const uint8_t pat_idle1[172] = {
+    0x07, 0x05, 0xbc, 0x02, 0x83, 0x03, 0x11, 0x09, 0x00, 0x00, 0x45, 0x00,
+    0x11, 0x0a, 0x00, 0x00, 0x8e, 0x00, 0x11, 0x00, 0x10, 0x00, 0x2f, 0x00,
+    0x11, 0x00, 0x0c, 0x00, 0x2f, 0x00, 0x12, 0x00, 0x03, 0x00, 0x3a, 0x00,
+    0x05, 0x00, 0x05, 0xff, 0x01, 0x03, 0x28, 0x00, 0x10, 0x8e, 0x00, 0x06,
+    0x00, 0x03, 0x01, 0x01, 0x03, 0x28, 0x00, 0x10, 0x8e, 0x00, 0x05, 0x00,
+    0x03, 0x02, 0x01, 0x03, 0x28, 0x00, 0x10, 0x8e, 0x00, 0x04, 0x04, 0x80,
+    0x00, 0x11, 0x0a, 0x00, 0x00, 0x85, 0x00, 0x11, 0x01, 0x28, 0x00, 0x6f,
+    0x00, 0x12, 0x01, 0x0a, 0x00, 0x7a, 0x00, 0x11, 0x02, 0x00, 0x00, 0x68,
+    0x00, 0x05, 0x01, 0x07, 0xfc, 0x10, 0x8e, 0x00, 0x05, 0x01, 0x07, 0xfe,
+    0x10, 0x8e, 0x00, 0x06, 0x01, 0x05, 0x01, 0x01, 0x02, 0x00, 0x00, 0x10,
+    0x8e, 0x00, 0x05, 0x01, 0x05, 0x02, 0x01, 0x02, 0x01, 0x00, 0x10, 0x8e,
+    0x00, 0x13, 0x05, 0x02, 0x8e, 0x00, 0x03, 0x01, 0x01, 0x00, 0x11, 0x0a,
+    0x00, 0x00, 0xab, 0x00, 0x12, 0x07, 0x01, 0x00, 0xab, 0x00, 0x01, 0x07,
+    0x00, 0x00, 0x11, 0x09, 0x00, 0x00, 0xa8, 0x00, 0x09, 0x00, 0x03, 0x00,
+    0x09, 0x01, 0x07, 0x00,
+};
+
+// idle2.sidp
+static const uint8_t pat_idle2[167] = {
+    0x07, 0x05, 0xc8, 0x00, 0x8f, 0x01, 0x11, 0x09, 0x00, 0x00, 0x40, 0x00,
+    0x11, 0x0a, 0x00, 0x00, 0x89, 0x00, 0x11, 0x00, 0x0e, 0x00, 0x2b, 0x00,
+    0x11, 0x00, 0x08, 0x00, 0x32, 0x00, 0x12, 0x00, 0x03, 0x00, 0x39, 0x00,
+    0x05, 0x00, 0x04, 0xff, 0x10, 0x89, 0x00, 0x06, 0x00, 0x03, 0x01, 0x10,
+    0x89, 0x00, 0x06, 0x00, 0x05, 0x01, 0x10, 0x89, 0x00, 0x05, 0x00, 0x03,
+    0x02, 0x10, 0x89, 0x00, 0x04, 0x04, 0x80, 0x00, 0x11, 0x0a, 0x00, 0x00,
+    0x80, 0x00, 0x11, 0x01, 0x1e, 0x00, 0x6a, 0x00, 0x12, 0x01, 0x0a, 0x00,
+    0x75, 0x00, 0x11, 0x02, 0x00, 0x00, 0x63, 0x00, 0x05, 0x01, 0x07, 0xfc,
+    0x10, 0x89, 0x00, 0x05, 0x01, 0x07, 0xfe, 0x10, 0x89, 0x00, 0x06, 0x01,
+    0x03, 0x01, 0x01, 0x02, 0x00, 0x00, 0x10, 0x89, 0x00, 0x05, 0x01, 0x03,
+    0x02, 0x01, 0x02, 0x01, 0x00, 0x10, 0x89, 0x00, 0x13, 0x05, 0x02, 0x89,
+    0x00, 0x03, 0x01, 0x01, 0x00, 0x11, 0x0a, 0x00, 0x00, 0xa6, 0x00, 0x12,
+    0x07, 0x01, 0x00, 0xa6, 0x00, 0x01, 0x07, 0x00, 0x00, 0x11, 0x09, 0x00,
+    0x00, 0xa3, 0x00, 0x09, 0x00, 0x03, 0x00, 0x09, 0x01, 0x07, 0x00,
+};
+
+// idle3.sidp
+static const uint8_t pat_idle3[172] = {
+    0x07, 0x05, 0xc8, 0x00, 0x8f, 0x01, 0x11, 0x09, 0x00, 0x00, 0x45, 0x00,
+    0x11, 0x0a, 0x00, 0x00, 0x8e, 0x00, 0x11, 0x00, 0x10, 0x00, 0x2f, 0x00,
+    0x11, 0x00, 0x0c, 0x00, 0x2f, 0x00, 0x12, 0x00, 0x03, 0x00, 0x3a, 0x00,
+    0x05, 0x00, 0x05, 0xff, 0x01, 0x03, 0x28, 0x00, 0x10, 0x8e, 0x00, 0x06,
+    0x00, 0x03, 0x01, 0x01, 0x03, 0x28, 0x00, 0x10, 0x8e, 0x00, 0x05, 0x00,
+    0x03, 0x02, 0x01, 0x03, 0x28, 0x00, 0x10, 0x8e, 0x00, 0x04, 0x04, 0x80,
+    0x00, 0x11, 0x0a, 0x00, 0x00, 0x85, 0x00, 0x11, 0x01, 0x28, 0x00, 0x6f,
+    0x00, 0x12, 0x01, 0x0a, 0x00, 0x7a, 0x00, 0x11, 0x02, 0x00, 0x00, 0x68,
+    0x00, 0x05, 0x01, 0x07, 0xfc, 0x10, 0x8e, 0x00, 0x05, 0x01, 0x07, 0xfe,
+    0x10, 0x8e, 0x00, 0x06, 0x01, 0x05, 0x01, 0x01, 0x02, 0x00, 0x00, 0x10,
+    0x8e, 0x00, 0x05, 0x01, 0x05, 0x02, 0x01, 0x02, 0x01, 0x00, 0x10, 0x8e,
+    0x00, 0x13, 0x05, 0x02, 0x8e, 0x00, 0x03, 0x01, 0x01, 0x00, 0x11, 0x0a,
+    0x00, 0x00, 0xab, 0x00, 0x12, 0x07, 0x01, 0x00, 0xab, 0x00, 0x01, 0x07,
+    0x00, 0x00, 0x11, 0x09, 0x00, 0x00, 0xa8, 0x00, 0x09, 0x00, 0x03, 0x00,
+    0x09, 0x01, 0x07, 0x00,
+};
+
+// idle4.sidp
+static const uint8_t pat_idle4[159] = {
+    0x01, 0x05, 0x5a, 0x00, 0x0c, 0x0e, 0x06, 0x08, 0x06, 0x05, 0x08, 0x0b,
+    0x0b, 0x0b, 0x0c, 0x0c, 0x0a, 0x0a, 0x0a, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+    0x0c, 0x0c, 0x0e, 0x0e, 0x0f, 0x0d, 0x0d, 0x0b, 0x0b, 0x0b, 0x0c, 0x0c,
+    0x0e, 0x0e, 0x0f, 0x0d, 0x0d, 0x0d, 0x0d, 0x0f, 0x0e, 0x0e, 0x0e, 0x0e,
+    0x0f, 0x0d, 0x0d, 0x0f, 0x10, 0x13, 0x10, 0x11, 0x10, 0x12, 0x11, 0x0f,
+    0x11, 0x0f, 0x10, 0x13, 0x10, 0x11, 0x10, 0x12, 0x11, 0x0f, 0x11, 0x14,
+    0x12, 0x14, 0x14, 0x14, 0x13, 0x14, 0x14, 0x11, 0x13, 0x14, 0x12, 0x14,
+    0x14, 0x14, 0x10, 0x12, 0x11, 0x0f, 0x11, 0x14, 0x12, 0x14, 0x14, 0x14,
+    0x10, 0x12, 0x11, 0x0f, 0x11, 0x0f, 0x10, 0x13, 0x10, 0x11, 0x0e, 0x0e,
+    0x0f, 0x0d, 0x0d, 0x0f, 0x10, 0x13, 0x10, 0x11, 0x0e, 0x0e, 0x0f, 0x0d,
+    0x0d, 0x0d, 0x0d, 0x0f, 0x0e, 0x0e, 0x0e, 0x0e, 0x0f, 0x0d, 0x0d, 0x0b,
+    0x0b, 0x0b, 0x0c, 0x0c, 0x0a, 0x0a, 0x0a, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+    0x0c, 0x0c, 0x01, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x04, 0x04,
+    0x20, 0x00, 0x00,
+};
+
+// idle5.sidp
+static const uint8_t pat_idle5[91] = {
+    0x01, 0x05, 0x50, 0x00, 0x04, 0x04, 0x0c, 0x00, 0x14, 0x43, 0x00, 0x11,
+    0x0a, 0x00, 0x00, 0x3b, 0x00, 0x11, 0x00, 0x12, 0x00, 0x28, 0x00, 0x12,
+    0x00, 0x03, 0x00, 0x33, 0x00, 0x05, 0x00, 0x05, 0xff, 0x01, 0x03, 0x28,
+    0x00, 0x10, 0x3b, 0x00, 0x06, 0x00, 0x03, 0x01, 0x01, 0x03, 0x28, 0x00,
+    0x10, 0x3b, 0x00, 0x05, 0x00, 0x03, 0x02, 0x01, 0x03, 0x28, 0x00, 0x0b,
+    0xbc, 0x02, 0x83, 0x03, 0x10, 0x47, 0x00, 0x04, 0x04, 0x01, 0x00, 0x11,
+    0x0a, 0x00, 0x00, 0x5a, 0x00, 0x12, 0x07, 0x01, 0x00, 0x5a, 0x00, 0x01,
+    0x07, 0x00, 0x00, 0x09, 0x00, 0x03, 0x00,
+};
+
+#endif
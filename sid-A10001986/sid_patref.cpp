@@ -0,0 +1,217 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Idle patterns: Previous native implementation, for reference
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sid_global.h"
+
+#ifdef SID_BENCH
+
+#include <stdlib.h>
+
+#include "sid_patvm.h"
+#include "sid_patref.h"
+
+#define ID5_STEPS 14
+static const uint8_t idle5[ID5_STEPS][10] = {
+    {  6,  8,  6,  5,  8, 11, 11, 11, 12, 12 }, // 1
+    { 10, 10, 10, 11, 11, 11, 11, 11, 12, 12 }, // 2
+    { 14, 14, 15, 13, 13, 11, 11, 11, 12, 12 }, // 3
+    { 14, 14, 15, 13, 13, 13, 13, 15, 14, 14 }, // 4
+    { 14, 14, 15, 13, 13, 15, 16, 19, 16, 17 }, // 5
+    { 16, 18, 17, 15, 17, 15, 16, 19, 16, 17 }, // 6
+    { 16, 18, 17, 15, 17, 20, 18, 20, 20, 20 }, // 7
+    { 19, 20, 20, 17, 19, 20, 18, 20, 20, 20 }, // 8
+    { 16, 18, 17, 15, 17, 20, 18, 20, 20, 20 }, // 9
+    { 16, 18, 17, 15, 17, 15, 16, 19, 16, 17 }, // 10
+    { 14, 14, 15, 13, 13, 15, 16, 19, 16, 17 }, // 11
+    { 14, 14, 15, 13, 13, 13, 13, 15, 14, 14 }, // 12
+    { 14, 14, 15, 13, 13, 11, 11, 11, 12, 12 }, // 13
+    { 10, 10, 10, 11, 11, 11, 11, 11, 12, 12 }  // 14
+};
+
+/*
+ * One (not speed-driven) step of showIdle(), as it was
+ */
+void patRefStep(int mode, bool strict, bool freeze, unsigned long now, 
+                patRefState& s, sidPRNG& rng, void (*bars)(const uint8_t *heights))
+{
+    int oldBaseLine = s.bl;
+    int oldSBaseLine = s.sbl;
+
+    if(mode == SID_IDLE_BL) {     // "backlot mode"
+
+        s.delay = 90;
+
+        bars(idle5[s.idx]);
+        s.idx++;
+        if(s.idx >= ID5_STEPS) s.idx = 0;
+        
+        s.bl = s.sbl = 0;
+        s.flags |= SBLF_NOBL;
+
+        return;
+    }
+        
+    if(strict) {
+        if(mode != SID_IDLE_IDC) {
+            s.flags |= SBLF_STRICT;
+        }
+    }
+
+    switch(mode) {
+    case SID_IDLE_1:     // higher peaks, tempo as 0
+    case SID_IDLE_3:     // higher peaks, faster
+        s.delay = (mode == SID_IDLE_1) ? rng.range(700, 899) : rng.range(200, 399);
+        if(!strict) {
+            if(!freeze) {
+                if(s.bl > 16) {
+                    s.bl -= (rng.below(3) + 1);
+                } else if(s.bl > 12) {
+                    s.bl -= (rng.below(3) + 1);
+                } else if(s.bl < 3) {
+                    s.bl += (rng.below(3) + 2);
+                } else {
+                    s.bl += (rng.below(5) - 1);
+                }
+                s.variation = 40;
+            }
+        } else {
+            if(!freeze) {
+                if(s.sbl > 40) {
+                    s.sbl -= (rng.below(5) + 1);
+                    s.wayUp = false;
+                } else if(s.sbl < 10) {
+                    s.sbl += (rng.below(5) + 2);
+                    s.wayUp = true;
+                } else {
+                    s.sbl += (rng.below(7) - (s.wayUp ? 2 : 4));
+                }
+            } else {
+                if(rng.below(5) >= 2) {
+                    s.sbl ^= 0x01;   // toggle bit 0, nothing more
+                }
+            }
+        }
+        break;
+    case SID_IDLE_IDC:   // with masked text & "identity crisis" tt seq
+        s.delay = 80;
+        s.flags |= (SBLF_LM|SBLF_SKIPSHOW);
+        if(now - s.mark < s.hold) {
+            s.flags |= SBLF_REPEAT;
+        } else {
+            if(!freeze) {
+                if(s.bl > 18) {
+                    s.bl -= (rng.below(3) + 1);
+                } else if(s.bl < 3) {
+                    s.bl += (rng.below(3) + 2);
+                } else {
+                    s.bl += (rng.below(5) - 1);
+                }
+                s.variation = 40;
+            }
+            s.mark = now;
+            s.hold = rng.range(700, 899);
+        }
+        break;
+    default:            // 0, and 2: Same as 0, but faster
+        s.delay = (mode == SID_IDLE_2) ? rng.range(200, 399) : rng.range(700, 899);
+        if(!strict) {
+            if(!freeze) {
+                if(s.bl > 14) {
+                    s.bl -= (rng.below(3) + 1);
+                } else if(s.bl > 8) {
+                    s.bl -= (rng.below(5) + 1);
+                } else if(s.bl < 3) {
+                    s.bl += (rng.below(3) + 2);
+                } else {
+                    s.bl += (rng.below(4) - 1);
+                }
+            }
+        } else {
+            if(!freeze) {
+                if(s.sbl > 30) {
+                    s.sbl -= (rng.below(3) + 1);
+                    s.wayUp = false;
+                } else if(s.sbl < 10) {
+                    s.sbl += (rng.below(3) + 2);
+                    s.wayUp = true;
+                } else {
+                    s.sbl += (rng.below(7) - (s.wayUp ? 2 : 4));
+                }
+            } else {
+                if(rng.below(5) >= 2) {
+                    s.sbl ^= 0x01;   // toggle bit 0, nothing more
+                }
+            }
+        }
+        break;
+    }
+    
+    if(!freeze) {
+        if(s.gps) {
+            // Smoothen
+            if(!(s.flags & SBLF_STRICT)) {
+                if(abs(oldBaseLine - s.bl) > 3) {
+                    s.bl = (s.bl + oldBaseLine) / 2;
+                }
+            } else {
+                if(abs(oldSBaseLine - s.sbl) > 7) {
+                    s.sbl = (s.sbl + oldSBaseLine) / 2;
+                }
+            }
+            s.gps = false;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Idle patterns: Previous native implementation, for reference
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _SID_PATREF_H
+#define _SID_PATREF_H
+
+#ifdef SID_BENCH
+
+#include <stdint.h>
+
+#include "sid_prng.h"
+
+/*
+ * The idle pattern step as it was before the patterns became
+ * bytecode (sid_patvm), kept to check and benchmark the 
+ * programs in sid_patprog.h against: SID_BENCH runs both, 
+ * tools/host/test_patvm compares them.
+ * 
+ * State is what showIdle() kept in statics; the speed-driven 
+ * branch and the final clamp are not part of it, they are 
+ * shared by both.
+ */
+
+typedef struct {
+    int           bl;           // sidBaseLine
+    int           sbl;          // strictBaseLine
+    bool          wayUp;        // blWayup
+    int           variation;
+    uint16_t      flags;        // SBLF_xxx
+    unsigned long delay;        // idleDelay
+    unsigned long mark;         // lastChange2
+    unsigned long hold;         // idleDelay2
+    int           idx;          // id5idx
+    bool          gps;          // usingGPSS
+} patRefState;
+
+void patRefStep(int mode, bool strict, bool freeze, unsigned long now, 
+                patRefState& s, sidPRNG& rng, void (*bars)(const uint8_t *heights));
+
+#endif
+
+#endif
@@ -0,0 +1,307 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Idle pattern bytecode interpreter
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+
+#include "sid_patvm.h"
+
+static int16_t get16(const uint8_t *p)
+{
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+// Instruction length, 0 if invalid opcode
+static int opLen(const uint8_t *p)
+{
+    switch(*p) {
+    case PV_END:
+        return 1;
+    case PV_SMOOTH:
+    case PV_JMP:
+    case PV_JHOLD:
+        return 3;
+    case PV_SET:
+    case PV_ADD:
+    case PV_XOR:
+    case PV_OR:
+    case PV_RADD:
+    case PV_RSUB:
+    case PV_SPEED:
+        return 4;
+    case PV_MARK:
+    case PV_JRND:
+        return 5;
+    case PV_RSET:
+    case PV_CLAMP:
+    case PV_JGT:
+    case PV_JLT:
+        return 6;
+    case PV_FRAMES:
+        return 2 + p[1] * 10;
+    }
+    return 0;
+}
+
+// Jump target; 0 (always valid) if no jump
+static int jumpTarget(const uint8_t *p)
+{
+    switch(*p) {
+    case PV_JMP:
+    case PV_JHOLD:
+        return get16(p + 1);
+    case PV_JRND:
+        return get16(p + 3);
+    case PV_JGT:
+    case PV_JLT:
+        return get16(p + 4);
+    }
+    return 0;
+}
+
+/*
+ * Check a program before it is run: Opcodes, operands, registers,
+ * jump targets. patRun() relies on this and does not check again.
+ */
+bool patVerify(const uint8_t *code, int len)
+{
+    uint8_t starts[PAT_MAX_SIZE / 8];
+    const uint8_t *p;
+    int pc, l = 0, wr;
+
+    if(len <= 0 || len > PAT_MAX_SIZE)
+        return false;
+
+    memset(starts, 0, sizeof(starts));
+        
+    for(pc = 0; pc < len; pc += l) {
+        
+        p = code + pc;
+        if(!(l = opLen(p)) || pc + l > len)
+            return false;
+
+        starts[pc >> 3] |= (1 << (pc & 7));
+        wr = -1;
+
+        switch(*p) {
+        case PV_SET:
+        case PV_ADD:
+        case PV_XOR:
+        case PV_OR:
+        case PV_SMOOTH:
+            wr = p[1];
+            break;
+        case PV_RADD:
+        case PV_RSUB:
+            if(!p[2])
+                return false;
+            wr = p[1];
+            break;
+        case PV_RSET:
+        case PV_CLAMP:
+            if(get16(p + 2) > get16(p + 4))
+                return false;
+            wr = p[1];
+            break;
+        case PV_SPEED:
+            if(!p[3])
+                return false;
+            wr = p[1];
+            break;
+        case PV_MARK:
+            if(get16(p + 1) < 0 || get16(p + 1) > get16(p + 3))
+                return false;
+            break;
+        case PV_FRAMES:
+            if(!p[1])
+                return false;
+            for(int i = 2; i < l; i++) {
+                if(p[i] > 20)
+                    return false;
+            }
+            break;
+        case PV_JGT:
+        case PV_JLT:
+            if(p[1] >= PVR_NUM)
+                return false;
+            break;
+        case PV_JRND:
+            if(!p[1])
+                return false;
+            break;
+        }
+
+        if(wr >= PVR_NUM_RW)
+            return false;
+    }
+
+    // Must end with END or JMP, so we can't run off the end
+    if(code[len - l] != PV_END && code[len - l] != PV_JMP)
+        return false;
+
+    // Jumps must go to start of an instruction
+    for(pc = 0; pc < len; pc += opLen(code + pc)) {
+        int a = jumpTarget(code + pc);
+        if(a < 0 || a >= len || !(starts[a >> 3] & (1 << (a & 7))))
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * Run program (verified by patVerify) until END. Returns false
+ * if the step limit was hit.
+ */
+bool patRun(const uint8_t *code, patCtx& c)
+{
+    int32_t *r = c.r;
+    int32_t r0[PVR_NUM_RW];
+    const uint8_t *p = code;
+    int steps = PAT_MAX_STEPS;
+    
+    for(int i = 0; i < PVR_NUM_RW; i++) {
+        r0[i] = r[i];
+    }
+
+    while(steps--) {
+
+        switch(*p) {
+        case PV_END:
+            return true;
+        case PV_SET:
+            r[p[1]] = get16(p + 2);
+            p += 4;
+            break;
+        case PV_ADD:
+            r[p[1]] += get16(p + 2);
+            p += 4;
+            break;
+        case PV_XOR:
+            r[p[1]] ^= get16(p + 2);
+            p += 4;
+            break;
+        case PV_OR:
+            r[p[1]] |= get16(p + 2);
+            p += 4;
+            break;
+        case PV_RADD:
+            r[p[1]] += (int32_t)c.rng->below(p[2]) + (int8_t)p[3];
+            p += 4;
+            break;
+        case PV_RSUB:
+            r[p[1]] -= (int32_t)c.rng->below(p[2]) + (int8_t)p[3];
+            p += 4;
+            break;
+        case PV_RSET:
+            if(get16(p + 2) == get16(p + 4)) {
+                r[p[1]] = get16(p + 2);
+            } else {
+                r[p[1]] = c.rng->range(get16(p + 2), get16(p + 4));
+            }
+            p += 6;
+            break;
+        case PV_CLAMP:
+            if(r[p[1]] < get16(p + 2)) r[p[1]] = get16(p + 2);
+            else if(r[p[1]] > get16(p + 4)) r[p[1]] = get16(p + 4);
+            p += 6;
+            break;
+        case PV_SMOOTH:
+            {
+                int32_t d = r[p[1]] - r0[p[1]];
+                if(d > p[2] || d < -(int32_t)p[2]) {
+                    r[p[1]] = (r[p[1]] + r0[p[1]]) / 2;
+                }
+            }
+            p += 3;
+            break;
+        case PV_SPEED:
+            if(r[PVR_SPD] >= 0) {
+                r[p[1]] = r[PVR_SPD] * p[2] / p[3];
+            }
+            p += 4;
+            break;
+        case PV_MARK:
+            c.mark = c.now;
+            c.hold = c.rng->range(get16(p + 1), get16(p + 3));
+            p += 5;
+            break;
+        case PV_FRAMES:
+            if(r[PVR_IDX] < 0 || r[PVR_IDX] >= p[1]) {
+                r[PVR_IDX] = 0;
+            }
+            c.bars(p + 2 + r[PVR_IDX] * 10);
+            if(++r[PVR_IDX] >= p[1]) {
+                r[PVR_IDX] = 0;
+            }
+            p += 2 + p[1] * 10;
+            break;
+        case PV_JMP:
+            p = code + get16(p + 1);
+            break;
+        case PV_JGT:
+            p = (r[p[1]] > get16(p + 2)) ? code + get16(p + 4) : p + 6;
+            break;
+        case PV_JLT:
+            p = (r[p[1]] < get16(p + 2)) ? code + get16(p + 4) : p + 6;
+            break;
+        case PV_JRND:
+            p = (c.rng->below(p[1]) < p[2]) ? code + get16(p + 3) : p + 5;
+            break;
+        case PV_JHOLD:
+            p = (c.now - c.mark < c.hold) ? code + get16(p + 1) : p + 3;
+            break;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,146 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Idle pattern bytecode interpreter
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _SID_PATVM_H
+#define _SID_PATVM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sid_prng.h"
+
+/*
+ * Idle patterns are small bytecode programs, run once per
+ * pattern step (ie whenever the previous step's delay has
+ * expired). They modify the baseline(s) and flags, which
+ * are then drawn by showBaseLine().
+ * 
+ * Source: tools/sidpatc.py compiles a text DSL into this
+ * bytecode; built-in patterns are in sid_patprog.h.
+ */
+
+#define PAT_MAGIC       "SIDP"
+#define PAT_VERSION     1
+#define PAT_HDR_SIZE    8           // Magic, version, reserved, uint16 code length
+#define PAT_MAX_SIZE    2048
+#define PAT_MAX_STEPS   512         // Max instructions per run
+
+// Registers
+#define PVR_BL          0           // Baseline (0-19)
+#define PVR_SBL         1           // Strict baseline (index into movie sequence)
+#define PVR_WAY         2           // Direction flag (strict)
+#define PVR_VAR         3           // Variation of bar heights around baseline
+#define PVR_FLG         4           // showBaseLine flags (SBLF_xxx)
+#define PVR_DLY         5           // Delay until next step (ms)
+#define PVR_IDX         6           // FRAMES index
+#define PVR_GPS         7           // Baseline was last derived from speed
+#define PVR_T           8           // Scratch
+#define PVR_STRICT      9           // read-only: Strict mode
+#define PVR_FRZ         10          // read-only: Baseline frozen (TT P0)
+#define PVR_SPD         11          // read-only: Speed; -1 if none
+#define PVR_NUM         12
+#define PVR_NUM_RW      PVR_STRICT
+
+// Opcodes                             Operands (imm/addr: int16 LE)
+#define PV_END          0x00        // -
+#define PV_SET          0x01        // r imm:        r = imm
+#define PV_ADD          0x02        // r imm:        r += imm
+#define PV_XOR          0x03        // r imm:        r ^= imm
+#define PV_OR           0x04        // r imm:        r |= imm
+#define PV_RADD         0x05        // r n k8:       r += rnd(n) + k
+#define PV_RSUB         0x06        // r n k8:       r -= rnd(n) + k
+#define PV_RSET         0x07        // r lo hi:      r = rnd(lo..hi); no rnd if lo == hi
+#define PV_CLAMP        0x08        // r lo hi:      lo <= r <= hi
+#define PV_SMOOTH       0x09        // r t8:         r = (r + r0) / 2 if |r - r0| > t
+#define PV_SPEED        0x0a        // r mul8 div8:  r = speed * mul / div if speed >= 0
+#define PV_MARK         0x0b        // lo hi:        Start hold time rnd(lo..hi)
+#define PV_FRAMES       0x0c        // n8 n*10 heights: Draw frame IDX, advance IDX
+#define PV_JMP          0x10        // addr
+#define PV_JGT          0x11        // r imm addr:   jump if r > imm
+#define PV_JLT          0x12        // r imm addr:   jump if r < imm
+#define PV_JRND         0x13        // n8 m8 addr:   jump if rnd(n) < m
+#define PV_JHOLD        0x14        // addr:         jump if hold time (MARK) not expired
+
+// Idle modes
+#define SID_IDLE_0    0
+#define SID_IDLE_1    1
+#define SID_IDLE_2    2
+#define SID_IDLE_3    3
+#define SID_IDLE_BL   4   // "backlot mode"
+#define SID_IDLE_IDC  5   // text / "identity crisis"
+#define SID_IDLE_USER 6   // user pattern from SD
+
+// showBaseLine() flags. Patterns set REPEAT, LM, SKIPSHOW,
+// NOBL and STRICT (tools/sidpatc.py knows these)
+#define SBLF_REPEAT   1
+#define SBLF_ISTT     2
+#define SBLF_LM       4
+#define SBLF_SKIPSHOW 8
+#define SBLF_LMTT     16
+#define SBLF_NOBL     32
+#define SBLF_ANIM     64
+#define SBLF_STRICT   128
+
+typedef struct {
+    int32_t       r[PVR_NUM];
+    unsigned long now;
+    unsigned long mark;             // Time of last MARK
+    unsigned long hold;             // Hold time set by MARK
+    sidPRNG       *rng;
+    void          (*bars)(const uint8_t *heights);
+} patCtx;
+
+bool patVerify(const uint8_t *code, int len);
+bool patRun(const uint8_t *code, patCtx& c);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Power state
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "sid_power.h"
+
+const pwrParams pwrTable[PWR_NUM] = {
+    { "active", 240,  0, false },
+    { "quiet",   80, 20, true  },      // 20ms: IR response, clock redraw
+    { "off",     80, 50, true  }
+};
+
+bool pwrState::update(unsigned long now, bool fpoOff, bool ssActive, bool busy)
+{
+    int target = PWR_ACTIVE;
+
+    if(!busy) {
+        if(fpoOff) target = PWR_OFF;
+        else if(ssActive) target = PWR_QUIET;
+    }
+
+    if(target != _target) {
+        _target = target;
+        _targetSince = now;
+    }
+
+    // Wake up at once, go to sleep only after a while
+    if(_target == _state || (_target != PWR_ACTIVE && now - _targetSince < PWR_ENTER_DELAY))
+        return false;
+
+    _state = _target;
+    _winStart = now;
+    _loops = 0;
+    
+    return true;
+}
+
+void pwrState::countLoop(unsigned long now)
+{
+    uint32_t d = now - _winStart;
+    
+    _loops++;
+
+    if(d >= PWR_RATE_WIN) {
+        _rate[_state] = (uint32_t)((uint64_t)_loops * 1000 / d);
+        _winStart = now;
+        _loops = 0;
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Power state
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _SID_POWER_H
+#define _SID_POWER_H
+
+#include <stdint.h>
+
+// States
+#define PWR_ACTIVE      0       // Normal operation
+#define PWR_QUIET       1       // Screen saver
+#define PWR_OFF         2       // Fake power off
+#define PWR_NUM         3
+
+#define PWR_ENTER_DELAY 3000    // Conditions must hold this long before entering QUIET/OFF
+#define PWR_RATE_WIN    2000    // Window for loop rate measurement (ms)
+
+typedef struct {
+    const char *name;
+    uint16_t   cpuMHz;          // CPU clock
+    uint16_t   loopInt;         // Min interval for scheduler tasks (ms)
+    bool       lightSleep;      // Light sleep between scheduled wakeups allowed
+} pwrParams;
+
+extern const pwrParams pwrTable[PWR_NUM];
+
+/*
+ * Decides the power state from what the main loop is doing.
+ * No hardware dependencies, times come from the caller; the
+ * caller applies the state's parameters on change.
+ */
+class pwrState {
+
+    public:
+
+        // busy: Something that needs full speed (TT, IR learning, 
+        // games...) is running. Returns true if state changed.
+        bool update(unsigned long now, bool fpoOff, bool ssActive, bool busy);
+
+        int  state()                    { return _state; }
+        const pwrParams& params()       { return pwrTable[_state]; }
+
+        // Loop rate accounting; call once per loop pass
+        void countLoop(unsigned long now);
+        uint32_t loopRate(int state)    { return _rate[state]; }
+
+    private:
+
+        int           _state = PWR_ACTIVE;
+        int           _target = PWR_ACTIVE;
+        unsigned long _targetSince = 0;
+
+        unsigned long _winStart = 0;
+        uint32_t      _loops = 0;
+        uint32_t      _rate[PWR_NUM] = { 0, 0, 0 };
+};
+
+#endif
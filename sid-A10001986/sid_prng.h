@@ -0,0 +1,130 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Pattern PRNG
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _SID_PRNG_H
+#define _SID_PRNG_H
+
+#include <stdint.h>
+
+/*
+ * Fast pseudo random numbers for patterns: xoshiro128** (Blackman,
+ * Vigna). Seeded once (from the hardware RNG, or with a fixed seed),
+ * the sequence is reproducible: Same seed, same pattern.
+ */
+class sidPRNG {
+
+    public:
+
+        sidPRNG() { seed(1); }
+
+        // Expand 32 bit seed to state (splitmix32)
+        void seed(uint32_t s)
+        {
+            for(int i = 0; i < 4; i++) {
+                uint32_t z = (s += 0x9e3779b9);
+                z = (z ^ (z >> 16)) * 0x85ebca6b;
+                z = (z ^ (z >> 13)) * 0xc2b2ae35;
+                _s[i] = z ^ (z >> 16);
+            }
+        }
+
+        uint32_t next()
+        {
+            uint32_t r = rotl(_s[1] * 5, 7) * 9;
+            uint32_t t = _s[1] << 9;
+
+            _s[2] ^= _s[0];
+            _s[3] ^= _s[1];
+            _s[1] ^= _s[2];
+            _s[0] ^= _s[3];
+            _s[2] ^= t;
+            _s[3] = rotl(_s[3], 11);
+
+            return r;
+        }
+
+        // 0 <= r < n, without bias (Lemire). The division in
+        // the rejection path is taken with probability n/2^32.
+        uint32_t below(uint32_t n)
+        {
+            uint64_t m = (uint64_t)next() * n;
+            uint32_t l = (uint32_t)m;
+
+            if(l < n) {
+                uint32_t t = (0 - n) % n;
+                while(l < t) {
+                    m = (uint64_t)next() * n;
+                    l = (uint32_t)m;
+                }
+            }
+
+            return (uint32_t)(m >> 32);
+        }
+
+        // lo <= r <= hi
+        int32_t range(int32_t lo, int32_t hi)
+        {
+            return lo + (int32_t)below((uint32_t)(hi - lo) + 1);
+        }
+
+    private:
+
+        static uint32_t rotl(uint32_t x, int k)
+        {
+            return (x << k) | (x >> (32 - k));
+        }
+
+        uint32_t _s[4];
+};
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Loop profiler
+ *
+ * Measures the time spent in the main subsystems using the
+ * us timer, and keeps a log2 histogram plus the
+ * worst case (and when it happened) for each of them.
+ * Compiled in only if SID_PROFILE is defined in sid_global.h.
+ *
+ * Serial: 'p' prints the report, 'r' resets all counters.
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sid_global.h"
+
+#ifdef SID_PROFILE
+
+#include <Arduino.h>
+
+#include "sid_prof.h"
+
+typedef struct {
+    uint32_t count;
+    uint32_t maxUs;
+    unsigned long maxAt;        // millis() when max was seen
+    uint64_t totalUs;
+    uint32_t hist[PROF_BUCKETS];
+} profSlot;
+
+static const char *profNames[PROF_NUM] = {
+    "Main", "WiFi", "BTTFN", "SA", "Show", "MQTT", "WM"
+};
+
+static profSlot profSlots[PROF_NUM];
+static uint32_t cpuMHz = 240;
+static uint32_t ovhNs = 0;
+
+// With SID_NETTASK, WiFi/BTTFN are profiled on core 0, the
+// rest on core 1, and reports and reset come from either side
+#ifdef SID_NETTASK
+static portMUX_TYPE profMux = portMUX_INITIALIZER_UNLOCKED;
+#define PROF_LOCK()   portENTER_CRITICAL(&profMux)
+#define PROF_UNLOCK() portEXIT_CRITICAL(&profMux)
+#else
+#define PROF_LOCK()
+#define PROF_UNLOCK()
+#endif
+
+#define PROF_OVH_RUNS 1000
+
+void prof_begin()
+{
+    uint32_t c;
+
+    prof_setCpuMHz(getCpuFrequencyMhz());
+
+    // Measure what an (empty) PROF_SCOPE costs: Timer reads
+    // and bookkeeping. Cycles are fine here, the clock doesn't
+    // change during this loop.
+    c = ESP.getCycleCount();
+    for(int i = 0; i < PROF_OVH_RUNS; i++) {
+        PROF_SCOPE(PROF_MAIN);
+    }
+    c = ESP.getCycleCount() - c;
+    ovhNs = (uint32_t)((uint64_t)c * 1000 / cpuMHz / PROF_OVH_RUNS);
+
+    prof_reset();
+}
+
+/*
+ * Called whenever the CPU clock is changed (power management).
+ * For the report only; times don't depend on it.
+ */
+void prof_setCpuMHz(uint32_t mhz)
+{
+    cpuMHz = mhz ? mhz : 240;
+}
+
+// Cost of one PROF_SCOPE at boot (240MHz) in ns
+uint32_t prof_overhead()
+{
+    return ovhNs;
+}
+
+void prof_reset()
+{
+    PROF_LOCK();
+    memset((void *)profSlots, 0, sizeof(profSlots));
+    PROF_UNLOCK();
+}
+
+void prof_add(int id, int64_t t)
+{
+    profSlot *s = &profSlots[id];
+    uint32_t us = (t > 0xffffffffLL) ? 0xffffffff : (uint32_t)t;
+    int b = 31 - __builtin_clz(us | 1);
+
+    if(b >= PROF_BUCKETS) b = PROF_BUCKETS - 1;
+    PROF_LOCK();
+    s->hist[b]++;
+    s->count++;
+    s->totalUs += us;
+    if(us > s->maxUs) {
+        s->maxUs = us;
+        s->maxAt = millis();
+    }
+    PROF_UNLOCK();
+}
+
+/*
+ * Print report for one subsystem into buf.
+ * Format: name n=<count> avg=<us> max=<us>@<ms> h=<b0>,<b1>,...
+ * Returns length, 0 if id is out of range.
+ */
+int prof_report(int id, char *buf, int bufSize, bool html)
+{
+    profSlot sc, *s = &sc;
+    int l;
+
+    if(id < 0 || id >= PROF_NUM)
+        return 0;
+
+    // Copy, so the report is consistent
+    PROF_LOCK();
+    sc = profSlots[id];
+    PROF_UNLOCK();
+    
+    l = snprintf(buf, bufSize, html ? "<b>%s</b> n=%u avg=%uus max=%uus@%lums h=" : 
+                                      "%s n=%u avg=%uus max=%uus@%lums h=",
+            profNames[id], s->count, 
+            s->count ? (uint32_t)(s->totalUs / s->count) : 0,
+            s->maxUs, s->maxAt);
+            
+    for(int i = 0; i < PROF_BUCKETS && l < bufSize; i++) {
+        l += snprintf(buf + l, bufSize - l, i ? ",%u" : "%u", s->hist[i]);
+    }
+
+    return (l < bufSize) ? l : bufSize - 1;
+}
+
+bool prof_cmd(int c)
+{
+    char buf[192];
+
+    switch(c) {
+    case 'p':
+    case 'P':
+        Serial.printf("Profile at %lums (CPU %uMHz, overhead %uns):\n", millis(), cpuMHz, ovhNs);
+        for(int i = 0; i < PROF_NUM; i++) {
+            prof_report(i, buf, sizeof(buf));
+            Serial.println(buf);
+        }
+        return true;
+    case 'r':
+    case 'R':
+        prof_reset();
+        Serial.println("Profile reset");
+        return true;
+    }
+
+    return false;
+}
+
+void prof_serial()
+{
+    while(Serial.available()) {
+        prof_cmd(Serial.read());
+    }
+}
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Loop profiler
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _SID_PROF_H
+#define _SID_PROF_H
+
+#ifdef SID_PROFILE
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// Profiled subsystems. Times are inclusive: WiFi contains
+// MQTT and WM, Main contains SA and (most) Show.
+enum {
+    PROF_MAIN = 0,
+    PROF_WIFI,
+    PROF_BTTFN,
+    PROF_SA,
+    PROF_SHOW,
+    PROF_MQTT,
+    PROF_WM,
+    PROF_NUM
+};
+
+// Histogram: Bucket n counts durations < 2^(n+1) us;
+// the last bucket counts everything above.
+#define PROF_BUCKETS 16
+
+void prof_begin();
+void prof_setCpuMHz(uint32_t mhz);
+void prof_add(int id, int64_t us);
+uint32_t prof_overhead();
+void prof_reset();
+int  prof_report(int id, char *buf, int bufSize, bool html = false);
+bool prof_cmd(int c);
+void prof_serial();
+
+// Times come from the 64-bit us timer: Unlike the CPU cycle
+// counter, it doesn't depend on the CPU clock (which power
+// management changes) and doesn't wrap (CCOUNT wraps after
+// 17.9s at 240MHz).
+class profScope {
+    public:
+        profScope(int id) : _id(id) { _start = esp_timer_get_time(); }
+        ~profScope() { prof_add(_id, esp_timer_get_time() - _start); }
+    private:
+        int     _id;
+        int64_t _start;
+};
+
+#define PROF_SCOPE(id) profScope _profScope(id)
+
+#else
+
+#define PROF_SCOPE(id)
+
+#endif
+
+#endif
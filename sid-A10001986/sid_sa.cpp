@@ -59,33 +59,71 @@
 #include <driver/adc.h>
 #include <soc/i2s_reg.h>
 #include "sid_main.h"
+#include "sid_sa.h"
+#include "sid_prof.h"
+#ifdef SID_BENCH
+#include "sid_bench.h"
+#endif
 
 #define NUMBANDS      11    // Number of bands ("bins" in FFT-speak)
 #define DISPLAYBANDS  10    // Displayed number of bands
 #define LEDS_PER_BAR  20    // Height of bar
 
-#define NUMSAMPLES  1024    // Size of sample block
+#define NUMSAMPLES  1024    // Reference size of sample block (default)
+#define MINSAMPLES   256    // Smallest supported sample block size
+#define MAXSAMPLES  2048    // Largest supported sample block size
 #define SAMPLERATE 32000    // Sampling frequency
 
+// Frequency offset in band mapping; originally 2 bins at 1024 samples
+#define FQ_OFFSET   (2 * SAMPLERATE / NUMSAMPLES)
+#define BAND_END    0xff
+
 #define PEAK_HOLD    500    // ms - Peak hold time
 #define PEAK_FALL    100    // ms - Peak fall speed
 
+#define WF_THRESHOLD 0.35f  // Waterfall: Min band level to light LED
+
+#define VU_FS_DB     102.35f  // 20*log10(2^17): Full scale of 18-bit samples
+#define VU_DB_TOP    -26.0f   // VU: dBFS at full bar height (SPH0645: 94dB SPL)
+#define VU_DB_RANGE   48.0f   // VU: dB range covered by bar height
+#define VU_ATTACK     0.50f   // VU ballistics (per frame)
+#define VU_RELEASE    0.12f
+#define VU_PEAK_FALL  0.60f   // Peak meter fall speed (LEDs per frame)
+
+#define SA_MULTIRATE        // Use low-rate FFT for lowest bands
+
 //#define SA_DBG_WRITEOUT   // For debugging
+//#define SA_DBG_TIMING     // For debugging
 
 static const i2s_port_t I2S_PORT = I2S_NUM_0;
 
-static int32_t rawSamples[NUMSAMPLES];
-static FTYPE vReal[NUMSAMPLES];
-static FTYPE vImag[NUMSAMPLES];
+// Analysis buffers are allocated (in one block) only while
+// the SA is active, and freed when deactivated.
+// rawSamples and vReal share the same memory: Samples are
+// converted in place.
+static uint8_t *saArena    = NULL;
+static int32_t *rawSamples = NULL;
+static FTYPE   *vReal      = NULL;
+static FTYPE   *vImag      = NULL;
+static uint8_t *binBand    = NULL;   // Band number for each FFT bin
+
+// Size of sample block (= FFT size), selectable 256-2048
+static int numSamples = NUMSAMPLES;
 
 static FTYPE freqBands[NUMBANDS] = { 0.0f };
 
 // 32 = 32ms * 32 = 1 sec
 // 64 = 32ms * 64 = 2 secs
 // 128 = 32ms * 128 = 4 secs
+// For smaller blocks, several frames are combined into one
+// entry (histFrames), for larger ones, the history is shortened 
+// (histLen), so that the history always covers 4 secs.
 #define FQ_HIST 128
 static int histIdx = 0;
-static FTYPE freqBandsHistory[FQ_HIST][NUMBANDS] = { 0.0f };
+static int histSub = 0;
+static int histLen = FQ_HIST;
+static int histFrames = 1;
+static FTYPE (*freqBandsHistory)[NUMBANDS] = NULL;
 
 // The frequency bands
 // First one is "garbage bin", not used for display
@@ -95,9 +133,48 @@ static const int freqSteps[NUMBANDS] = {
 };
 
 // Noise threshold per band. Lower bands have more noise.
+// (For NUMSAMPLES; scaled for other sizes into bandThresh)
 static const FTYPE minTreshold[NUMBANDS] = {
     0.0f, 5000.0f, 5000.0f, 5000.0f, 3000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f
 };
+static FTYPE bandThresh[NUMBANDS];
+
+#ifdef SA_MULTIRATE
+// Multirate front-end for the lowest bands:
+// At 32kHz and 1024 samples, FFT bins are 31.25Hz wide, which leaves
+// only a handful of bins for the bands below 250Hz, making them jumpy.
+// So we additionally decimate the input by 16 (to 2kHz) through a 
+// 3-stage CIC filter, and run a second, small FFT over the last 256 
+// decimated samples (128ms, bin width 7.8Hz). Bands 1-3 are taken 
+// from this low-rate FFT, all others from the full-rate FFT.
+#define LR_DECIM        16                        // Decimation factor
+#define LR_NUMSAMPLES  256                        // Size of low-rate FFT
+#define LR_SAMPLERATE  (SAMPLERATE / LR_DECIM)    // 2000Hz
+#define LR_BANDS         4                        // Bands 1-3 from low-rate FFT
+#define CIC_STAGES       3
+#define CIC_GAIN      (LR_DECIM * LR_DECIM * LR_DECIM)  // LR_DECIM ^ CIC_STAGES
+// Magnitude of a 256-point FFT is 1/4 of a 1024-point one, etc.
+#define LR_MAGSCALE   ((FTYPE)numSamples / (FTYPE)LR_NUMSAMPLES)
+
+static FTYPE   *lrSamples = NULL;
+static int      lrIdx = 0;
+static int      cicPhase = 0;
+static uint32_t cicInteg[CIC_STAGES] = { 0 };   // Unsigned: Overflow
+static uint32_t cicComb[CIC_STAGES]  = { 0 };   // wraps around as intended
+#endif
+
+#define SA_SAMPLES_SIZE  (numSamples * sizeof(int32_t))   // rawSamples & vReal
+#define SA_IMAG_SIZE     (numSamples * sizeof(FTYPE))
+#define SA_HIST_SIZE     (FQ_HIST * NUMBANDS * sizeof(FTYPE))
+#define SA_BINMAP_SIZE   (numSamples / 2)
+#ifdef SA_MULTIRATE
+#define SA_LR_SIZE       (LR_NUMSAMPLES * sizeof(FTYPE))
+#else
+#define SA_LR_SIZE       0
+#endif
+#define SA_ARENA_SIZE    (SA_SAMPLES_SIZE + SA_IMAG_SIZE + SA_HIST_SIZE + SA_LR_SIZE + SA_BINMAP_SIZE)
+
+static_assert(sizeof(FTYPE) == sizeof(int32_t), "In-place conversion requires FTYPE and int32_t to be of same size");
 
 static const int maxTTHeight[10] = {
     20, 20, 13, 20, 20, 19, 20, 10, 20, 17
@@ -105,6 +182,20 @@ static const int maxTTHeight[10] = {
 
 static int oldHeight[DISPLAYBANDS]  = { 0 };
 
+// Waterfall: One word per line (bit 0 = bar 0), ring
+// buffered so that scrolling only moves the index.
+static uint16_t wfRows[LEDS_PER_BAR] = { 0 };
+static int      wfTopRow = 0;
+
+// VU meter: Levels in LEDs
+static FTYPE vuRMS  = 0.0f;
+static FTYPE vuPeak = 0.0f;
+
+// VU meter: Shape of centre-out (mirrored) display in percent
+static const uint8_t vuShape[DISPLAYBANDS] = {
+    60, 75, 87, 95, 100, 100, 95, 87, 75, 60
+};
+
 static uint8_t       peaks[DISPLAYBANDS]     = { 0 };
 static unsigned long newPeak[DISPLAYBANDS]   = { 0 };
 static unsigned long peakTimer[DISPLAYBANDS] = { 0 };
@@ -113,15 +204,20 @@ bool        saActive = false;
 static bool sa_avail = false;
 bool        doPeaks  = false;
 bool        doMirror = false;
+uint8_t     saMode   = SA_MODE_BARS;
 static bool startFlag = false;
 static bool initFlag = false;
 static bool initDisplay = true;
+static bool warmStart = false;      // Suspended, arena/history kept
 static unsigned long lastTime  = 0;
 static unsigned long lastStart = 0;
 static unsigned long startDelay = 0;
 
 int         ampFact = 100;
 
+// Measured processing time per frame (us, averaged)
+static unsigned long saCost = 0;
+
 #if defined(SID_DBG) && defined(SA_DBG_WRITEOUT)
 #include "sid_settings.h"
 #include "src/SD/SD.h"
@@ -130,6 +226,12 @@ static File outFile;
 static bool outFileOpen = false;
 #endif
 
+#if defined(SID_DBG) && defined(SA_DBG_TIMING)
+#include <esp_heap_caps.h>
+static unsigned long dbgFFTTime = 0, dbgLRTime = 0, dbgVUTime = 0;
+static int dbgCnt = 0, dbgVUCnt = 0;
+#endif
+
 static const i2s_pin_config_t i2sPins = {
     .bck_io_num   = I2S_BCLK_PIN,
     .ws_io_num    = I2S_LRCLK_PIN,
@@ -137,7 +239,7 @@ static const i2s_pin_config_t i2sPins = {
     .data_in_num  = I2S_DIN_PIN,
 };
 
-static const i2s_config_t i2s_config = {
+static i2s_config_t i2s_config = {
     .mode                 = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX),
     .sample_rate          = SAMPLERATE,
     .bits_per_sample      = I2S_BITS_PER_SAMPLE_32BIT,
@@ -145,7 +247,7 @@ static const i2s_config_t i2s_config = {
     .communication_format = I2S_COMM_FORMAT_STAND_MSB,
     .intr_alloc_flags     = ESP_INTR_FLAG_LEVEL1,
     .dma_buf_count        = 4,
-    .dma_buf_len          = 1024,
+    .dma_buf_len          = NUMSAMPLES,     // Adjusted to numSamples
     .use_apll             = false,
     .tx_desc_auto_clear   = false,
     .fixed_mclk           = 0
@@ -158,6 +260,10 @@ static bool sa_setup()
     if(sa_avail)
         return true;
 
+    // DMA buffer size follows block size; with larger buffers,
+    // data would only be delivered in chunks of buffer size.
+    i2s_config.dma_buf_len = min(numSamples, 1024);
+
     err = i2s_driver_install(I2S_PORT, &i2s_config,  0, NULL);
     if(err != ESP_OK) {
         #ifdef SID_DBG
@@ -184,8 +290,102 @@ static bool sa_setup()
     return true;
 }
 
-#if 0   // Unused
-void sa_remove()
+// Calculate band number for each FFT bin, and all other
+// parameters depending on numSamples
+
+static void sa_calcBinMap()
+{
+    int band = 0;
+
+    binBand[0] = 0;     // DC
+    for(int i = 1; i < numSamples / 2; i++) {
+        int freq = (i * SAMPLERATE / numSamples) - FQ_OFFSET;
+        // Small FFTs: Bin might be wider than a band
+        while(band < NUMBANDS && freq >= freqSteps[band]) {
+            band++;
+        }
+        binBand[i] = (band < NUMBANDS) ? band : BAND_END;
+    }
+
+    // Magnitudes (of tones) scale with FFT size
+    for(int i = 0; i < NUMBANDS; i++) {
+        bandThresh[i] = minTreshold[i] * (FTYPE)numSamples / (FTYPE)NUMSAMPLES;
+    }
+
+    if(numSamples > NUMSAMPLES) {
+        histLen = FQ_HIST * NUMSAMPLES / numSamples;
+        histFrames = 1;
+    } else {
+        histLen = FQ_HIST;
+        histFrames = NUMSAMPLES / numSamples;
+    }
+}
+
+// Buffer allocation
+
+static bool sa_alloc()
+{
+    if(saArena)
+        return true;
+
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    uint32_t heapBefore = ESP.getFreeHeap();
+    size_t intBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    #endif
+
+    // calloc: History must start out as zero
+    if(!(saArena = (uint8_t *)calloc(1, SA_ARENA_SIZE))) {
+        #ifdef SID_DBG
+        Serial.printf("sa_alloc: Failed to allocate %d bytes (free %d)\n", (int)SA_ARENA_SIZE, ESP.getFreeHeap());
+        #endif
+        return false;
+    }
+
+    rawSamples = (int32_t *)saArena;
+    vReal = (FTYPE *)saArena;
+    vImag = (FTYPE *)(saArena + SA_SAMPLES_SIZE);
+    freqBandsHistory = (FTYPE (*)[NUMBANDS])(saArena + SA_SAMPLES_SIZE + SA_IMAG_SIZE);
+    #ifdef SA_MULTIRATE
+    lrSamples = (FTYPE *)(saArena + SA_SAMPLES_SIZE + SA_IMAG_SIZE + SA_HIST_SIZE);
+    #endif
+    binBand = saArena + SA_SAMPLES_SIZE + SA_IMAG_SIZE + SA_HIST_SIZE + SA_LR_SIZE;
+
+    sa_calcBinMap();
+
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    Serial.printf("sa_alloc: Arena %d bytes; free heap %u -> %u, internal %u -> %u\n",
+        (int)SA_ARENA_SIZE, heapBefore, ESP.getFreeHeap(),
+        intBefore, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    #endif
+
+    return true;
+}
+
+static void sa_free()
+{
+    if(!saArena)
+        return;
+
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    uint32_t heapBefore = ESP.getFreeHeap();
+    #endif
+        
+    free(saArena);
+    saArena = NULL;
+    rawSamples = NULL;
+    vReal = vImag = NULL;
+    freqBandsHistory = NULL;
+    #ifdef SA_MULTIRATE
+    lrSamples = NULL;
+    #endif
+    binBand = NULL;
+
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    Serial.printf("sa_free: Free heap %u -> %u\n", heapBefore, ESP.getFreeHeap());
+    #endif
+}
+
+static void sa_remove()
 {
     if(!sa_avail)
         return;
@@ -193,7 +393,6 @@ void sa_remove()
     i2s_driver_uninstall(I2S_PORT);
     sa_avail = false;
 }
-#endif
 
 // internal resume/stop
 
@@ -209,6 +408,17 @@ static void sa_resume(bool initDisp, unsigned long start_Delay)
     startDelay = start_Delay;
     initFlag = false;
     initDisplay = initDisp;
+
+    #ifdef SA_MULTIRATE
+    memset((void *)lrSamples, 0, SA_LR_SIZE);
+    memset((void *)cicInteg, 0, sizeof(cicInteg));
+    memset((void *)cicComb, 0, sizeof(cicComb));
+    lrIdx = cicPhase = 0;
+    #endif
+
+    if(!warmStart) {
+        vuRMS = vuPeak = 0.0f;
+    }
 }
 
 static void sa_stop()
@@ -220,10 +430,18 @@ static void sa_stop()
 
 void sa_activate(bool init, unsigned long start_Delay)
 {
+    warmStart = false;
+
+    if(!sa_alloc())
+        return;
+        
     sa_resume(init, start_Delay);
 
-    if(sa_avail)
+    if(sa_avail) {
         saActive = true;
+    } else {
+        sa_free();
+    }
 }
 
 void sa_deactivate()
@@ -232,6 +450,9 @@ void sa_deactivate()
         sa_stop();
 
     saActive = false;
+    warmStart = false;
+
+    sa_free();
 
     #if defined(SID_DBG) && defined(SA_DBG_WRITEOUT)
     outFile.close();
@@ -239,6 +460,38 @@ void sa_deactivate()
     #endif
 }
 
+// Suspend/wake: Like deactivate/activate, but keep the arena
+// (history), peaks and waterfall rows, and don't touch the display
+// on wake. The mic's startup noise is skipped, not analyzed.
+
+void sa_suspend()
+{
+    if(!saActive)
+        return;
+
+    if(sa_avail)
+        sa_stop();
+
+    saActive = false;
+    warmStart = true;
+}
+
+void sa_wake()
+{
+    if(!warmStart || !saArena) {
+        sa_activate();
+        return;
+    }
+
+    sa_resume(false, SA_START_DELAY);
+
+    if(sa_avail) {
+        saActive = true;
+    } else {
+        sa_deactivate();
+    }
+}
+
 // Set amplification factor
 
 int sa_setAmpFact(int newAmpFact)
@@ -252,57 +505,184 @@ int sa_setAmpFact(int newAmpFact)
     return old;
 }
 
-// The loop
+// Set FFT size (index 0-3 => 256-2048)
+// Takes effect upon next activation
 
-void sa_loop()
+void sa_setFFTSize(int idx)
 {
-    size_t bytesRead = 0;
-    unsigned long now = millis();
-    int band = 0;
-    FTYPE mmax = 1.0f;
-    
-    if(!saActive || !sa_avail)
+    int newSize = MINSAMPLES << idx;
+
+    if(newSize < MINSAMPLES || newSize > MAXSAMPLES || newSize == numSamples)
         return;
+
+    if(saActive || warmStart)
+        sa_deactivate();
+
+    // DMA buffer size depends on numSamples
+    if(sa_avail)
+        sa_remove();
+
+    numSamples = newSize;
+    saCost = 0;
+}
+
+// Get FFT size, frame duration and measured 
+// processing time per frame (0 if not measured yet)
+
+int sa_getFFTSize(unsigned long& frameUs, unsigned long& procUs)
+{
+    frameUs = (unsigned long)numSamples * 1000 / (SAMPLERATE / 1000);
+    procUs = saCost;
     
-    if(lastTime && (now - lastTime < (NUMSAMPLES * 1000 / SAMPLERATE)))
-        return;
+    return numSamples;
+}
 
-    //unsigned long dnow1 = millis();
+// ms until sa_loop() has a new frame to read; 0 if due
 
-    // Read. This waits until our requested data is fully available,...
-    i2s_read(I2S_PORT, (void *)rawSamples, sizeof(rawSamples), &bytesRead, portMAX_DELAY);
+uint32_t sa_due()
+{
+    unsigned long fi = numSamples * 1000 / SAMPLERATE;
+    unsigned long d = millis() - lastTime;
+    
+    if(!saActive || !sa_avail || !lastTime || d >= fi)
+        return 0;
 
-    // .. and therefore, to keep the pace, we update lastTime here, and not above.
-    // (-X because ... this leads to us being called a bit earlier than necessary
-    // but that's better than too late (if we return above a tad before the data 
-    // is ready). Could as well be -5 or -10, but then we burn too much time here.)
-    lastTime = millis() - 2;
+    return fi - d;
+}
 
-    if(bytesRead != sizeof(rawSamples)) {
-        // what now?
-        #ifdef SID_DBG
-        Serial.println("bytesRead != sizeof(rawSamples)");
-        #endif
+// Sum FFT magnitudes (full-rate) into frequency bands
+
+static void sa_fillBands()
+{
+    int band;
+    
+    // Fill frequency bands
+    // Max freq = Half of sampling rate => (SAMPLERATE / 2)
+    // vReal only filled half because of this => (numSamples / 2)
+    for(int i = 1; i < NUMBANDS; i++) {
+        freqBands[i] = 0.0f;
     }
+    for(int i = 1; i < numSamples / 2; i++) {
+        band = binBand[i];
+        if(band == BAND_END) break;
+        if(band && (vReal[i] > bandThresh[band])) {
+            freqBands[band] += vReal[i];      
+        }
+    }
+}
 
-    #if defined(SID_DBG) && defined(SA_DBG_WRITEOUT)
+// Scale bands by maximum in history
+
+static void sa_history()
+{
+    FTYPE mmax;
     
-    if(outFileOpen) {
-        outFile.write((uint8_t *)&rawSamples[0], NUMSAMPLES * 4);
+    // Store absolute band sums to our history table
+    // (Max of histFrames frames per entry)
+    for(int i = 1; i < NUMBANDS; i++) {
+        if(!histSub || freqBands[i] > freqBandsHistory[histIdx][i]) {
+            freqBandsHistory[histIdx][i] = freqBands[i];
+        }
+    }
+    if(++histSub >= histFrames) {
+        histSub = 0;
+        histIdx++;
+        histIdx &= (histLen-1);
+    }
+
+    // Find maximum in history table for scaling each bar
+    for(int i = 1; i < NUMBANDS; i++) {
+        mmax = 1.0f;
+        for(int j = 0; j < histLen; j++) {
+            if(mmax < freqBandsHistory[j][i]) mmax = freqBandsHistory[j][i];
+        }
+        freqBands[i] /= mmax;
+    }
+}
+
+// FFT-based analysis
+
+#ifdef SA_MULTIRATE
+// CIC decimator, fed with every full-rate sample
+
+static inline void sa_cic(int32_t s)
+{
+    // Integrators at full rate...
+    cicInteg[0] += (uint32_t)s;
+    cicInteg[1] += cicInteg[0];
+    cicInteg[2] += cicInteg[1];
+    if(++cicPhase == LR_DECIM) {
+        // ...combs at decimated rate
+        uint32_t t = cicInteg[2];
+        cicPhase = 0;
+        for(int j = 0; j < CIC_STAGES; j++) {
+            uint32_t c = t - cicComb[j];
+            cicComb[j] = t;
+            t = c;
+        }
+        lrSamples[lrIdx++] = (FTYPE)((int32_t)t) / (FTYPE)CIC_GAIN;
+        lrIdx &= (LR_NUMSAMPLES - 1);
+    }
+}
+
+// Low-rate FFT for the lowest bands. Uses vReal/vImag (only the
+// first LR_NUMSAMPLES entries), so call only after the full-rate 
+// bands have been filled.
+
+static void sa_lowRate()
+{
+    int band = 0;
+
+    for(int i = 0, j = lrIdx; i < LR_NUMSAMPLES; i++) {
+        vReal[i] = lrSamples[j++];
+        vImag[i] = 0.0f;
+        j &= (LR_NUMSAMPLES - 1);
     }
     
-    #else
+    arduinoFFT LRFFT = arduinoFFT(vReal, vImag, LR_NUMSAMPLES, LR_SAMPLERATE);
+    LRFFT.DCRemoval();
+    LRFFT.Compute(FFT_FORWARD);
+    LRFFT.ComplexToMagnitude(vReal, vImag, LR_NUMSAMPLES/2);
+
+    // Replace the bands. Frequencies are offset like in the
+    // full-rate mapping, so that the bands join seamlessly.
+    for(int i = 1; i < LR_BANDS; i++) {
+        freqBands[i] = 0.0f;
+    }
+    for(int i = 1; i < LR_NUMSAMPLES / 2; i++) {
+        int freq = (i * LR_SAMPLERATE / LR_NUMSAMPLES) - FQ_OFFSET;
+        if(freq >= freqSteps[band]) {
+            band++;
+            if(band == LR_BANDS) break;
+        }
+        if(band) {
+            FTYPE mag = vReal[i] * LR_MAGSCALE;
+            if(mag > bandThresh[band]) {
+                freqBands[band] += mag;
+            }
+        }
+    }
+}
+#endif
 
-    //unsigned long dnow2 = millis();
+static void sa_fft()
+{
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    unsigned long dnow1 = micros();
+    #endif
 
-    // Convert; clear vImag
-    for(int i = 0; i < NUMSAMPLES; i++) {
-        vReal[i] = (FTYPE)(rawSamples[i] / 16384); // do NOT shift; result of shifting negative integer is undefined
+    // Convert (in place; rawSamples and vReal share memory); clear vImag
+    for(int i = 0; i < numSamples; i++) {
+        int32_t s = rawSamples[i] / 16384;   // do NOT shift; result of shifting negative integer is undefined
+        vReal[i] = (FTYPE)s;
         vImag[i] = 0.0f;
+        #ifdef SA_MULTIRATE
+        sa_cic(s);
+        #endif
     }
 
     // Do the FFT
-    arduinoFFT FFT = arduinoFFT(vReal, vImag, NUMSAMPLES, SAMPLERATE);
+    arduinoFFT FFT = arduinoFFT(vReal, vImag, numSamples, SAMPLERATE);
 
     // Remove hum and dc offset
     FFT.DCRemoval();
@@ -315,38 +695,142 @@ void sa_loop()
     FFT.Compute(FFT_FORWARD);
     
     //FFT.ComplexToMagnitude(); // Covers entire array, half would do
-    FFT.ComplexToMagnitude(vReal, vImag, NUMSAMPLES/2);
+    FFT.ComplexToMagnitude(vReal, vImag, numSamples/2);
 
-    // Fill frequency bands
-    // Max freq = Half of sampling rate => (SAMPLERATE / 2)
-    // vReal only filled half because of this => (NUMSAMPLES / 2)
-    band = 0;
-    for(int i = 3; i < NUMSAMPLES / 2; i++) {
-        int freq = (i - 2) * (SAMPLERATE / 2) / (NUMSAMPLES / 2);
-        if(freq >= freqSteps[band]) {
-            band++;
-            if(band == NUMBANDS) break;
-            else freqBands[band] = 0.0f;
-        }
-        if(band && (vReal[i] > minTreshold[band])) {
-            freqBands[band] += vReal[i];      
-        }
+    sa_fillBands();
+
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    unsigned long dnow2 = micros();
+    #endif
+
+    #ifdef SA_MULTIRATE
+    sa_lowRate();
+    #endif
+
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    dbgFFTTime += (dnow2 - dnow1);
+    dbgLRTime += (micros() - dnow2);
+    if(++dbgCnt == 64) {
+        Serial.printf("SA: Full-rate %luus, low-rate %luus per frame (budget %dus)\n",
+            dbgFFTTime / 64, dbgLRTime / 64, numSamples * 1000 / (SAMPLERATE / 1000));
+        dbgFFTTime = dbgLRTime = 0;
+        dbgCnt = 0;
     }
+    #endif
 
-    // Store absolute band sums to our history table
-    for(int i = 1; i < NUMBANDS; i++) {
-        freqBandsHistory[histIdx][i] = freqBands[i];
+    sa_history();
+}
+
+// VU/peak meter; works on integer samples, no FFT
+
+static FTYPE sa_vu_dB2LEDs(FTYPE dB)
+{
+    FTYPE l = (dB - (VU_DB_TOP - VU_DB_RANGE)) * (FTYPE)LEDS_PER_BAR / VU_DB_RANGE;
+
+    if(l < 0.0f) return 0.0f;
+    if(l > (FTYPE)LEDS_PER_BAR) return (FTYPE)LEDS_PER_BAR;
+    return l;
+}
+
+static void sa_vu()
+{
+    int64_t sum = 0, sumSq = 0;
+    int32_t smin = INT32_MAX, smax = INT32_MIN;
+    
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    unsigned long dnow1 = micros();
+    #endif
+
+    // Single pass, no data-dependent branches
+    for(int i = 0; i < numSamples; i++) {
+        int32_t s = rawSamples[i] / 16384;   // do NOT shift, see above
+        sum += s;
+        sumSq += (int64_t)s * s;
+        smin = min(smin, s);
+        smax = max(smax, s);
     }
-    histIdx++;
-    histIdx &= (FQ_HIST-1);
 
-    // Find maximum in history table for scaling each bar
-    for(int i = 1; i < NUMBANDS; i++) {
-        mmax = 1.0f;
-        for(int j = 0; j < FQ_HIST; j++) {
-            if(mmax < freqBandsHistory[j][i]) mmax = freqBandsHistory[j][i];
+    // Remove DC offset: mean square = E[s^2] - E[s]^2
+    int32_t mean = (int32_t)(sum / numSamples);
+    FTYPE ms = (FTYPE)(sumSq / numSamples) - (FTYPE)mean * (FTYPE)mean;
+    int32_t pk = max(smax - mean, mean - smin);
+
+    FTYPE rmsL = sa_vu_dB2LEDs(10.0f * log10f(ms + 1.0f) - VU_FS_DB);
+    FTYPE pkL  = sa_vu_dB2LEDs(20.0f * log10f((FTYPE)pk + 1.0f) - VU_FS_DB);
+
+    // Ballistics: VU integrates, peak meter has instant attack
+    vuRMS += (rmsL - vuRMS) * ((rmsL > vuRMS) ? VU_ATTACK : VU_RELEASE);
+    vuPeak = (pkL > vuPeak) ? pkL : max(pkL, vuPeak - VU_PEAK_FALL);
+
+    #if defined(SID_DBG) && defined(SA_DBG_TIMING)
+    dbgVUTime += (micros() - dnow1);
+    if(++dbgVUCnt == 64) {
+        Serial.printf("SA: VU %luus (%lu cycles) per frame\n",
+            dbgVUTime / 64, (dbgVUTime / 64) * ESP.getCpuFreqMHz());
+        dbgVUTime = 0;
+        dbgVUCnt = 0;
+    }
+    #endif
+}
+
+// The loop
+
+void sa_loop()
+{
+    size_t bytesRead = 0;
+    unsigned long now = millis();
+    
+    if(!saActive || !sa_avail)
+        return;
+    
+    if(lastTime && (now - lastTime < (unsigned long)(numSamples * 1000 / SAMPLERATE)))
+        return;
+
+    PROF_SCOPE(PROF_SA);
+
+    //unsigned long dnow1 = millis();
+
+    // Read. This waits until our requested data is fully available,...
+    i2s_read(I2S_PORT, (void *)rawSamples, SA_SAMPLES_SIZE, &bytesRead, portMAX_DELAY);
+
+    // .. and therefore, to keep the pace, we update lastTime here, and not above.
+    // (-X because ... this leads to us being called a bit earlier than necessary
+    // but that's better than too late (if we return above a tad before the data 
+    // is ready). Could as well be -5 or -10, but then we burn too much time here.)
+    lastTime = millis() - 2;
+
+    if(bytesRead != SA_SAMPLES_SIZE) {
+        // what now?
+        #ifdef SID_DBG
+        Serial.println("bytesRead != SA_SAMPLES_SIZE");
+        #endif
+    }
+
+    // Waking from suspend: Discard samples until the mic has
+    // settled; display keeps showing what it had before.
+    if(warmStart) {
+        if(millis() - lastStart >= startDelay) {
+            startFlag = warmStart = false;
         }
-        freqBands[i] /= mmax;
+        return;
+    }
+
+    #if defined(SID_DBG) && defined(SA_DBG_WRITEOUT)
+    
+    if(outFileOpen) {
+        outFile.write((uint8_t *)&rawSamples[0], numSamples * 4);
+    }
+    
+    #else
+
+    unsigned long procStart = micros();
+
+    //unsigned long dnow2 = millis();
+
+    if(saMode == SA_MODE_VU) {
+        sa_vu();
+    } else {
+        sa_fft();
     }
 
     //Serial.printf("   %d \n", dnow2-dnow1); 
@@ -362,31 +846,63 @@ void sa_loop()
                     newPeak[i] = now;
                     peakTimer[i] = PEAK_HOLD;
                     oldHeight[i] = 1;
-                    if(initDisplay) {
+                    if(initDisplay && saMode != SA_MODE_WATERFALL) {
                         doMirror ? sid.drawMirrorBarWithHeight(i, 1, LEDS_PER_BAR) : sid.drawBarWithHeight(i, 1);
                     }
                 }
+                memset((void *)wfRows, 0, sizeof(wfRows));
+                wfTopRow = 0;
                 if(initDisplay) {
-                    sid.show();
+                    if(saMode == SA_MODE_WATERFALL) {
+                        sid.drawPackedFieldAndShow(wfRows, wfTopRow);
+                    } else {
+                        sid.show();
+                    }
                 }
                 initFlag = true;
             }
         } else {
             startFlag = false;
-            histIdx = 0;
-            for(int i = 0; i < FQ_HIST; i++) {
+            histIdx = histSub = 0;
+            for(int i = 0; i < histLen; i++) {
                 for(int j = 1; j < NUMBANDS; j++) {
                     freqBandsHistory[i][j] = 0.0f;
                 }
             }
         }
 
+    } else if(saMode == SA_MODE_WATERFALL) {
+
+        // New line on top, older ones scroll down
+        uint16_t row = 0;
+        for(int i = 0; i < DISPLAYBANDS; i++) {
+            if(freqBands[i+1] * (FTYPE)ampFact / 100.0f >= WF_THRESHOLD) {
+                row |= (1 << i);
+            }
+        }
+        wfTopRow = wfTopRow ? wfTopRow - 1 : LEDS_PER_BAR - 1;
+        wfRows[wfTopRow] = row;
+
+        // Put result on display
+        sid.drawPackedFieldAndShow(wfRows, wfTopRow);
+
     } else {
 
         // Calculate bar heights
         for(int i = 0; i < DISPLAYBANDS; i++) {
-            int height = (int)(freqBands[i+1] * (FTYPE)(LEDS_PER_BAR - 1));
-            int maxHeight;
+            int height, maxHeight;
+
+            if(saMode == SA_MODE_VU) {
+                // Centre-out (mirrored): VU, shaped
+                // Stereo-style: Left half VU, right half peak meter
+                if(doMirror) {
+                    height = (int)(vuRMS * (FTYPE)vuShape[i] / 100.0f);
+                } else {
+                    height = (int)((i < DISPLAYBANDS / 2) ? vuRMS : vuPeak);
+                }
+            } else {
+                height = (int)(freqBands[i+1] * (FTYPE)(LEDS_PER_BAR - 1));
+            }
     
             if(ampFact != 100) {
                 if(!height) height = 1;
@@ -399,8 +915,8 @@ void sa_loop()
                 if(!height) height = 1;
             }
       
-            // Smoothen jumps in downward direction
-            if(height < oldHeight[i]) {
+            // Smoothen jumps in downward direction (VU: see ballistics)
+            if(saMode != SA_MODE_VU && height < oldHeight[i]) {
                 if(oldHeight[i] - height > 10) height = (oldHeight[i] + height) / 2;
                 else                           height = oldHeight[i] - 1;
             }
@@ -447,5 +963,131 @@ void sa_loop()
         }
     }
 
+    // Measure processing time (excluding waiting for data)
+    procStart = micros() - procStart;
+    saCost = saCost ? (saCost * 7 + procStart) / 8 : procStart;
+
     #endif
 }
+
+#ifdef SID_BENCH
+/*
+ * Benchmarks on a synthetic signal (two tones plus noise)
+ */
+static int32_t *benchSamples = NULL;
+
+static void sa_benchFFT()
+{
+    for(int i = 0; i < numSamples; i++) {
+        vReal[i] = (FTYPE)(benchSamples[i] / 16384);
+        vImag[i] = 0.0f;
+    }
+    arduinoFFT FFT = arduinoFFT(vReal, vImag, numSamples, SAMPLERATE);
+    FFT.DCRemoval();
+    FFT.Compute(FFT_FORWARD);
+    FFT.ComplexToMagnitude(vReal, vImag, numSamples/2);
+}
+
+static void sa_benchBands()
+{
+    sa_fillBands();
+    sa_history();
+}
+
+static void sa_benchFrame()
+{
+    memcpy(rawSamples, benchSamples, SA_SAMPLES_SIZE);
+    sa_fft();
+}
+
+static void sa_benchVU()
+{
+    sa_vu();
+}
+
+#ifdef SA_MULTIRATE
+static void sa_benchCIC()
+{
+    for(int i = 0; i < numSamples; i++) {
+        sa_cic(benchSamples[i] / 16384);
+    }
+}
+
+static void sa_benchLowRate()
+{
+    sa_lowRate();
+}
+#endif
+
+static void sa_benchSize()
+{
+    char name[32];
+    uint32_t frameCyc, vuCyc, lrCyc = 0;
+    
+    if(!(benchSamples = (int32_t *)malloc(SA_SAMPLES_SIZE)))
+        return;
+    
+    if(!sa_alloc()) {
+        free(benchSamples);
+        return;
+    }
+
+    for(int i = 0; i < numSamples; i++) {
+        FTYPE t = (FTYPE)i / (FTYPE)SAMPLERATE;
+        FTYPE v = 20000.0f * sinf(2.0f * PI * 440.0f * t) + 
+                  8000.0f * sinf(2.0f * PI * 3000.0f * t) +
+                  (FTYPE)((int)(esp_random() % 1024) - 512);
+        benchSamples[i] = (int32_t)v * 16384;
+    }
+
+    snprintf(name, sizeof(name), "fft_compute_mag_%d", numSamples);
+    bench_run(name, sa_benchFFT, 200);
+    snprintf(name, sizeof(name), "sa_bands_history_%d", numSamples);
+    bench_run(name, sa_benchBands, 1000);
+    #ifdef SA_MULTIRATE
+    snprintf(name, sizeof(name), "sa_cic_%d", numSamples);
+    lrCyc = bench_run(name, sa_benchCIC, 200);
+    lrCyc += bench_run("sa_lowrate_fft", sa_benchLowRate, 200);
+    #endif
+    snprintf(name, sizeof(name), "sa_frame_%d", numSamples);
+    frameCyc = bench_run(name, sa_benchFrame, 200);
+    memcpy(rawSamples, benchSamples, SA_SAMPLES_SIZE);
+    snprintf(name, sizeof(name), "sa_vu_%d", numSamples);
+    vuCyc = bench_run(name, sa_benchVU, 200);
+
+    // Cost per frame against the budget, ie the time a frame
+    // takes to be sampled: frame is the FFT path (bars and
+    // waterfall modes), lr the low-rate FFT's share of it (CIC
+    // and FFT), vu the VU meter, which skips the FFT.
+    uint32_t mhz = getCpuFrequencyMhz();
+    uint32_t frameUs = numSamples * 1000 / (SAMPLERATE / 1000);
+    uint32_t budget = frameUs * mhz;
+    
+    Serial.printf("{\"sa_budget\":%d,\"mhz\":%u,\"frame_us\":%u,\"budget_cyc\":%u,"
+                  "\"frame_cyc\":%u,\"frame_pct\":%.2f,\"lr_cyc\":%u,\"lr_pct\":%.2f,"
+                  "\"vu_cyc\":%u,\"vu_pct\":%.2f}\n",
+        numSamples, mhz, frameUs, budget, 
+        frameCyc, (float)frameCyc * 100.0f / (float)budget,
+        lrCyc, (float)lrCyc * 100.0f / (float)budget,
+        vuCyc, (float)vuCyc * 100.0f / (float)budget);
+
+    sa_free();
+    free(benchSamples);
+    benchSamples = NULL;
+}
+
+// All FFT sizes, as the budget scales with the size
+void sa_bench()
+{
+    int oldSize = numSamples;
+    
+    if(saArena)
+        return;
+
+    for(numSamples = MINSAMPLES; numSamples <= MAXSAMPLES; numSamples <<= 1) {
+        sa_benchSize();
+    }
+
+    numSamples = oldSize;
+}
+#endif
@@ -56,15 +56,31 @@
 
 #define SA_START_DELAY  1000   // Delay to skip the mic's startup noise
 
+#define SA_MODE_BARS       0   // Display modes
+#define SA_MODE_WATERFALL  1
+#define SA_MODE_VU         2
+#define SA_MODE_MAX        SA_MODE_VU
+
 void sa_activate(bool init = true, unsigned long start_Delay = SA_START_DELAY);
 void sa_deactivate();
+void sa_suspend();
+void sa_wake();
 
 int sa_setAmpFact(int newAmpFact);
 
+void sa_setFFTSize(int idx);
+int  sa_getFFTSize(unsigned long& frameUs, unsigned long& procUs);
+uint32_t sa_due();
+
 void sa_loop();
 
+#ifdef SID_BENCH
+void sa_bench();
+#endif
+
 extern bool saActive;   // Read only!
 extern bool doPeaks;
 extern bool doMirror;
+extern uint8_t saMode;
 
 #endif
@@ -0,0 +1,214 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Task scheduler
+ *
+ * A simple cooperative scheduler: Tasks are registered with an
+ * interval and a priority, and run when their deadline is reached.
+ * Tasks with interval 0 run on every pass. If no task is due, the
+ * scheduler sleeps until the earliest deadline.
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_sched.h"
+
+static schedTask tasks[SCHED_MAX_TASKS];    // Indexed by handle
+static uint8_t   order[SCHED_MAX_TASKS];    // Handles in run order
+static int       numTasks = 0;
+static uint32_t  minInterval = 0;
+static void      (*sleepFunc)(unsigned long ms) = NULL;
+
+/*
+ * Register a task. Tasks run sorted by priority; tasks of 
+ * equal priority run in order of registration.
+ * Returns a handle which stays valid when more tasks are
+ * added, or -1 if there is no room.
+ */
+int sched_add(const char *name, void (*func)(void), uint32_t interval, uint8_t prio)
+{
+    int h = numTasks, i;
+    
+    if(numTasks >= SCHED_MAX_TASKS)
+        return -1;
+
+    memset(&tasks[h], 0, sizeof(schedTask));
+    tasks[h].name = name;
+    tasks[h].func = func;
+    tasks[h].interval = interval;
+    tasks[h].prio = prio;
+    tasks[h].next = millis();
+
+    for(i = numTasks; i > 0 && tasks[order[i - 1]].prio < prio; i--) {
+        order[i] = order[i - 1];
+    }
+    order[i] = h;
+
+    numTasks++;
+
+    return h;
+}
+
+// Set a task's next deadline (eg to have it run sooner).
+// Called by the task itself, this replaces its interval
+// for this run.
+void sched_runAt(int task, unsigned long when)
+{
+    if(task >= 0 && task < numTasks) {
+        tasks[task].next = when;
+        tasks[task].moved = true;
+    }
+}
+
+void sched_setInterval(int task, uint32_t ms)
+{
+    if(task >= 0 && task < numTasks) {
+        tasks[task].interval = ms;
+    }
+}
+
+// Throttle tasks to run at most every ms (low power); 
+// 0 = as given by their intervals
+void sched_setMinInterval(uint32_t ms)
+{
+    minInterval = ms;
+}
+
+// Use func instead of delay() to wait for next deadline
+void sched_setSleep(void (*func)(unsigned long ms))
+{
+    sleepFunc = func;
+}
+
+void sched_run()
+{
+    unsigned long now = millis();
+    unsigned long wait = max((uint32_t)SCHED_MAX_SLEEP, minInterval);
+    
+    for(int i = 0; i < numTasks; i++) {
+        schedTask *t = &tasks[order[i]];
+        uint32_t interval = max(t->interval, minInterval);
+        
+        if(interval && (long)(now - t->next) < 0)
+            continue;
+
+        t->moved = false;
+
+        unsigned long startUs = micros();
+        t->func();
+        uint32_t dur = micros() - startUs;
+
+        t->runs++;
+        t->totalUs += dur;
+        if(dur > t->maxUs) t->maxUs = dur;
+
+        now = millis();
+
+        // Task chose its next deadline
+        if(t->moved) {
+            if(minInterval && (long)(t->next - now) < (long)minInterval) {
+                t->next = now + minInterval;
+            }
+            continue;
+        }
+        
+        // Don't try to catch up if we are late
+        t->next += interval;
+        if((long)(now - t->next) >= 0) {
+            t->next = now + interval;
+        }
+    }
+
+    // Sleep until earliest deadline
+    for(int i = 0; i < numTasks; i++) {
+        if(!tasks[i].interval && !minInterval)
+            return;
+        long d = (long)(tasks[i].next - now);
+        if(d <= 0)
+            return;
+        if((unsigned long)d < wait) wait = d;
+    }
+
+    if(sleepFunc) {
+        sleepFunc(wait);
+    } else {
+        delay(wait);
+    }
+}
+
+/*
+ * Runtime accounting
+ */
+
+// Returns next task handle, or -1 if task invalid
+int sched_getStats(int task, const char *&name, uint32_t& runs, uint32_t& avgUs, uint32_t& maxUs)
+{
+    if(task < 0 || task >= numTasks)
+        return -1;
+
+    name = tasks[task].name;
+    runs = tasks[task].runs;
+    avgUs = runs ? (uint32_t)(tasks[task].totalUs / runs) : 0;
+    maxUs = tasks[task].maxUs;
+
+    return task + 1;
+}
+
+void sched_resetStats()
+{
+    for(int i = 0; i < numTasks; i++) {
+        tasks[i].runs = 0;
+        tasks[i].totalUs = 0;
+        tasks[i].maxUs = 0;
+    }
+}
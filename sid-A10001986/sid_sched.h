@@ -0,0 +1,88 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Task scheduler
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _SID_SCHED_H
+#define _SID_SCHED_H
+
+#define SCHED_MAX_TASKS 10
+#define SCHED_MAX_SLEEP 10      // Max ms to sleep if no task is due
+
+// Priorities: Higher runs first when several tasks are due
+#define SCHED_PRIO_LOW    0
+#define SCHED_PRIO_NORMAL 1
+#define SCHED_PRIO_HIGH   2
+
+typedef struct {
+    const char    *name;
+    void          (*func)(void);
+    uint32_t      interval;     // ms; 0 = every pass
+    uint8_t       prio;
+    bool          moved;        // next set through sched_runAt()
+    unsigned long next;         // Next deadline (millis)
+    // Runtime accounting
+    uint32_t      runs;
+    uint32_t      maxUs;
+    uint64_t      totalUs;
+} schedTask;
+
+int  sched_add(const char *name, void (*func)(void), uint32_t interval, uint8_t prio);
+void sched_runAt(int task, unsigned long when);
+void sched_setInterval(int task, uint32_t ms);
+void sched_setMinInterval(uint32_t ms);
+void sched_setSleep(void (*func)(unsigned long ms));
+void sched_run();
+
+int  sched_getStats(int task, const char *&name, uint32_t& runs, uint32_t& avgUs, uint32_t& maxUs);
+void sched_resetStats();
+
+#endif
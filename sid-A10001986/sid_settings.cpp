@@ -72,6 +72,11 @@
 #include "sid_settings.h"
 #include "sid_main.h"
 #include "sid_wifi.h"
+#include "sid_sa.h"
+#include "sid_patvm.h"
+#ifdef SID_BENCH
+#include "sid_bench.h"
+#endif
 
 // Settings transition, stage 2: Assume new settings
 // are present, but still delete obsolete files.
@@ -103,6 +108,7 @@ static struct [[gnu::packed]] {
     uint8_t  updateR            = 0;
     uint8_t  SAmirror           = DEF_SA_MIRROR;
     uint8_t  carMode            = 0;
+    uint8_t  SAmode             = DEF_SA_MODE;
 } secSettings;
 
 // Tertiary settings (SD only)
@@ -127,8 +133,11 @@ static const char *cfgName    = "/sidconfig.json";  // Main config (flash)
 static const char *ipCfgName  = "/sidipcfg";        // IP config (flash)
 static const char *idName     = "/sidid";           // SID remote ID (flash)
 static const char *irCfgName  = "/sidirkeys.json";  // IR keys (system-created) (flash/SD)
+static const char *irCfgNameN = "/sidirkeys%d.json";// IR keys of further remotes (flash/SD)
 static const char *secCfgName = "/sid2cfg";         // Secondary settings (flash/SD)
 static const char *terCfgName = "/sid3cfg";         // Tertiary settings (SD)
+static const char *irTraceName= "/sidirtrace.bin";  // IR timing trace (SD)
+static const char *patFileName= "/sidpat.bin";      // User idle pattern (SD)
 
 #ifdef SETTINGS_TRANSITION_2
 static const char *obsFiles[] = {
@@ -194,6 +203,7 @@ static bool formatFlashFS(bool userSignal);
 static DeserializationError readJSONCfgFile(JsonDocument& json, File& configFile, uint32_t *newHash = NULL);
 static bool writeJSONCfgFile(const JsonDocument& json, const char *fn, bool useSD, uint32_t oldHash = 0, uint32_t *newHash = NULL);
 
+static bool readFileFromSDU(const char *fn, uint8_t*& buf, int& len);
 static bool writeFileToSD(const char *fn, uint8_t *buf, int len);
 static bool writeFileToFS(const char *fn, uint8_t *buf, int len);
 
@@ -416,7 +426,9 @@ void unmount_fs()
 
 static bool read_settings(File configFile, int cfgReadCount)
 {
+    #ifdef SID_DBG
     const char *funcName = "read_settings";
+    #endif
     bool wd = false;
     size_t jsonSize = 0;
     DECLARE_D_JSON(JSON_SIZE,json);
@@ -426,14 +438,14 @@ static bool read_settings(File configFile, int cfgReadCount)
     #if ARDUINOJSON_VERSION_MAJOR < 7
     jsonSize = json.memoryUsage();
     if(jsonSize > JSON_SIZE) {
-        Serial.printf("ERROR: Config file too large (%d vs %d), memory corrupted, awaiting doom.\n", jsonSize, JSON_SIZE);
+        Serial.printf("ERROR: Config file too large (%d vs %d), memory corrupted, awaiting doom.\n", (int)jsonSize, JSON_SIZE);
     }
     
     #ifdef SID_DBG
     if(jsonSize > JSON_SIZE - 256) {
           Serial.printf("%s: WARNING: JSON_SIZE needs to be adapted **************\n", funcName);
     }
-    Serial.printf("%s: Size of document: %d (JSON_SIZE %d)\n", funcName, jsonSize, JSON_SIZE);
+    Serial.printf("%s: Size of document: %d (JSON_SIZE %d)\n", funcName, (int)jsonSize, JSON_SIZE);
     #endif
     #endif
 
@@ -485,6 +497,7 @@ static bool read_settings(File configFile, int cfgReadCount)
 
         wd |= CopyCheckValidNumParm(json["skipTTAnim"], settings.skipTTAnim, sizeof(settings.skipTTAnim), 0, 1, DEF_SKIP_TTANIM);
         wd |= CopyCheckValidNumParm(json["ssTimer"], settings.ssTimer, sizeof(settings.ssTimer), 0, 999, DEF_SS_TIMER);
+        wd |= CopyCheckValidNumParm(json["SAfft"], settings.SAfftSz, sizeof(settings.SAfftSz), 0, 3, DEF_SA_FFTSZ);
 
         wd |= CopyTextParm(json["tcdIP"], settings.tcdIP, sizeof(settings.tcdIP));
         wd |= CopyCheckValidNumParm(json["useGPSS"], settings.useGPSS, sizeof(settings.useGPSS), 0, 1, DEF_USE_GPSS);
@@ -554,6 +567,7 @@ void write_settings()
 
     json["skipTTAnim"] = (const char *)settings.skipTTAnim;
     json["ssTimer"] = (const char *)settings.ssTimer;
+    json["SAfft"] = (const char *)settings.SAfftSz;
     
     json["tcdIP"] = (const char *)settings.tcdIP;
     json["useGPSS"] = (const char *)settings.useGPSS;
@@ -742,22 +756,46 @@ static bool loadIRkeysFromFile(File configFile, int index)
     return true;
 }
 
+// First remote in irCfgName, others numbered
+static const char *irCfgFileName(char *buf, int remote)
+{
+    if(!remote) return irCfgName;
+    sprintf(buf, irCfgNameN, remote);
+    return buf;
+}
+
+static void removeIRKeys(int remote, bool onSD)
+{
+    char buf[24];
+    const char *fn = irCfgFileName(buf, remote);
+    
+    if(onSD) {
+        SD.remove(fn);
+    } else if(haveFS) {
+        MYNVS.remove(fn);
+    }
+}
+
 static bool loadIRKeys()
 {
     File configFile;
+    char buf[24];
 
     // Load learned keys from Flash/SD
-    if(openCfgFileRead(irCfgName, configFile)) {
-        if(!loadIRkeysFromFile(configFile, REM_KEYS_LEARNED)) {
+    for(int i = 0; i < NUM_IR_REMOTES; i++) {
+        const char *fn = irCfgFileName(buf, i);
+        if(openCfgFileRead(fn, configFile)) {
+            if(!loadIRkeysFromFile(configFile, i)) {
+                #ifdef SID_DBG
+                Serial.printf("%s is incomplete, deleting\n", fn);
+                #endif
+                removeIRKeys(i, configOnSD);
+            }
+        } else {
             #ifdef SID_DBG
-            Serial.printf("%s is incomplete, deleting\n", irCfgName);
+            Serial.printf("%s does not exist\n", fn);
             #endif
-            deleteIRKeys();
         }
-    } else {
-        #ifdef SID_DBG
-        Serial.printf("%s does not exist\n", irCfgName);
-        #endif
     }
 
     return true;
@@ -766,39 +804,40 @@ static bool loadIRKeys()
 void saveIRKeys()
 {
     uint32_t ir_keys[NUM_IR_KEYS];
-    char buf[12];
+    char buf[24];
 
     if(!haveFS && !configOnSD)
         return;
 
-    copyIRarray(ir_keys, REM_KEYS_LEARNED);
+    for(int r = 0; r < NUM_IR_REMOTES; r++) {
+        
+        copyIRarray(ir_keys, r);
 
-    // Delete file if keys incomplete
-    bool keysMissing = false;
-    for(int i = 0; i < NUM_IR_KEYS; i++) {
-        if(!ir_keys[i]) keysMissing = true;
-    }
-    if(keysMissing) {
-        deleteIRKeys();
-        return;
-    }
+        // Delete file if keys incomplete
+        bool keysMissing = false;
+        for(int i = 0; i < NUM_IR_KEYS; i++) {
+            if(!ir_keys[i]) keysMissing = true;
+        }
+        if(keysMissing) {
+            removeIRKeys(r, configOnSD);
+            continue;
+        }
 
-    DECLARE_S_JSON(1024,json);
+        DECLARE_S_JSON(1024,json);
 
-    for(int i = 0; i < NUM_IR_KEYS; i++) {
-        sprintf(buf, "0x%08x", ir_keys[i]);
-        json[(const char *)jsonNames[i]] = buf;   // no const cast, needs to be copied
-    }
+        for(int i = 0; i < NUM_IR_KEYS; i++) {
+            sprintf(buf, "0x%08x", ir_keys[i]);
+            json[(const char *)jsonNames[i]] = buf;   // no const cast, needs to be copied
+        }
 
-    writeJSONCfgFile(json, irCfgName, configOnSD);
+        writeJSONCfgFile(json, irCfgFileName(buf, r), configOnSD);
+    }
 }
 
 void deleteIRKeys()
 {
-    if(configOnSD) {
-        SD.remove(irCfgName);
-    } else if(haveFS) {
-        MYNVS.remove(irCfgName);
+    for(int i = 0; i < NUM_IR_REMOTES; i++) {
+        removeIRKeys(i, configOnSD);
     }
 }
 
@@ -887,6 +926,7 @@ void loadSASettings()
         #endif
         doPeaks = !!secSettings.SApeaks;
         doMirror = !!secSettings.SAmirror;
+        saMode = (secSettings.SAmode <= SA_MODE_MAX) ? secSettings.SAmode : DEF_SA_MODE;
     }
 }
 
@@ -894,6 +934,7 @@ void saveSASettings()
 {
     secSettings.SApeaks = doPeaks ? 1 : 0;
     secSettings.SAmirror = doMirror ? 1 : 0;
+    secSettings.SAmode = saMode;
     saveSecSettings(true);
 }
 
@@ -983,6 +1024,7 @@ void saveAllSecCP()
     secSettings.strictMode = strictMode ? 1 : 0;
     secSettings.SApeaks = doPeaks ? 1 : 0;
     secSettings.SAmirror = doMirror ? 1 : 0;
+    secSettings.SAmode = saMode;
     secSettings.irShowPosFBDisplay = irShowPosFBDisplay ? 1 : 0;
     secSettings.irShowCmdFBDisplay = irShowCmdFBDisplay ? 1 : 0;
     saveSecSettings(true);
@@ -1024,6 +1066,33 @@ void loadIdlePat()
     }
 }
 
+/*
+ * Load user idle pattern (SD): Header plus bytecode, see sid_patvm.h
+ * Returns code (malloc'd, to be verified by caller), or NULL
+ */
+uint8_t *loadUserPattern(int& codeLen)
+{
+    uint8_t *buf = NULL;
+    int len;
+
+    if(!haveSD || !SD.exists(patFileName))
+        return NULL;
+
+    if(!readFileFromSDU(patFileName, buf, len) ||
+       len <= PAT_HDR_SIZE || len > PAT_HDR_SIZE + PAT_MAX_SIZE ||
+       memcmp(buf, PAT_MAGIC, 4) || buf[4] != PAT_VERSION ||
+       (buf[6] | (buf[7] << 8)) != len - PAT_HDR_SIZE) {
+        Serial.printf("%s invalid\n", patFileName);
+        if(buf) free(buf);
+        return NULL;
+    }
+
+    codeLen = len - PAT_HDR_SIZE;
+    memmove(buf, buf + PAT_HDR_SIZE, codeLen);
+
+    return buf;
+}
+
 void storeIdlePat()
 {
     // Used to keep terSettings up-to-date in case
@@ -1216,10 +1285,11 @@ void moveSettings()
 
     if(configOnSD) {
         SD.remove(secCfgName);
-        SD.remove(irCfgName);
     } else {
         MYNVS.remove(secCfgName);
-        MYNVS.remove(irCfgName);
+    }
+    for(int i = 0; i < NUM_IR_REMOTES; i++) {
+        removeIRKeys(i, configOnSD);
     }
 }
 
@@ -1233,7 +1303,7 @@ static DeserializationError readJSONCfgFile(JsonDocument& json, File& configFile
     DeserializationError ret;
 
     if(!(buf = (const char *)malloc(bufSize + 1))) {
-        Serial.printf("rJSON: Buffer allocation failed (%d)\n", bufSize);
+        Serial.printf("rJSON: Buffer allocation failed (%d)\n", (int)bufSize);
         return DeserializationError::NoMemory;
     }
 
@@ -1263,7 +1333,7 @@ static bool writeJSONCfgFile(const JsonDocument& json, const char *fn, bool useS
     bool success = false;
 
     if(!(buf = (char *)malloc(bufSize + 1))) {
-        Serial.printf("wJSON: Buffer allocation failed (%d)\n", bufSize);
+        Serial.printf("wJSON: Buffer allocation failed (%d)\n", (int)bufSize);
         return false;
     }
 
@@ -1315,7 +1385,7 @@ static bool readFile(File& myFile, uint8_t *buf, int len)
     if(myFile) {
         size_t bytesr = myFile.read(buf, len);
         myFile.close();
-        return (bytesr == len);
+        return (bytesr == (size_t)len);
     } else
         return false;
 }
@@ -1380,7 +1450,7 @@ static bool writeFile(File& myFile, uint8_t *buf, int len)
     if(myFile) {
         size_t bytesw = myFile.write(buf, len);
         myFile.close();
-        return (bytesw == len);
+        return (bytesw == (size_t)len);
     } else
         return false;
 }
@@ -1405,6 +1475,66 @@ static bool writeFileToFS(const char *fn, uint8_t *buf, int len)
     return writeFile(myFile, buf, len);
 }
 
+/*
+ * IR raw timing trace (diagnostics)
+ * File starts with "SIDIRTR1", followed by IRTraceRec records,
+ * each cut after the last used duration.
+ */
+bool appendIRTrace(const uint8_t *rec, int len)
+{
+    if(!haveSD)
+        return false;
+
+    if(!SD.exists(irTraceName)) {
+        if(!writeFileToSD(irTraceName, (uint8_t *)"SIDIRTR1", 8))
+            return false;
+    }
+
+    File myFile = SD.open(irTraceName, FILE_APPEND);
+    return writeFile(myFile, (uint8_t *)rec, len);
+}
+
+#ifdef SID_GOLDEN
+/*
+ * Golden-frame files (regression, see golden_run())
+ * "/sidgld-<name>.bin", raw frame hashes, uint32 each
+ */
+static void goldenFileName(char *fn, int len, const char *name)
+{
+    snprintf(fn, len, "/sidgld-%s.bin", name);
+}
+
+// Returns number of frames read, -1 if no golden file
+int readGolden(const char *name, uint32_t *buf, int maxFrames)
+{
+    char fn[48];
+    int ret = -1;
+
+    if(!haveSD)
+        return -1;
+
+    goldenFileName(fn, sizeof(fn), name);
+    if(!SD.exists(fn))
+        return -1;
+
+    File myFile = SD.open(fn, FILE_READ);
+    if(myFile) {
+        ret = myFile.read((uint8_t *)buf, maxFrames * sizeof(uint32_t)) / sizeof(uint32_t);
+        myFile.close();
+    }
+
+    return ret;
+}
+
+bool writeGolden(const char *name, const uint32_t *buf, int frames)
+{
+    char fn[48];
+
+    goldenFileName(fn, sizeof(fn), name);
+    return writeFileToSD(fn, (uint8_t *)buf, frames * sizeof(uint32_t));
+}
+#endif
+
 static uint8_t cfChkSum(const uint8_t *buf, int len)
 {
     uint16_t s = 0;
@@ -1593,3 +1723,40 @@ static void firmware_update()
     fw_error_blink(0);
     esp_restart();
 }    
+
+#ifdef SID_BENCH
+/*
+ * Benchmark: Parse main config file (from flash)
+ */
+static char *benchBuf = NULL;
+static DynamicJsonDocument *benchJson = NULL;
+
+static void settings_benchParse()
+{
+    deserializeJson(*benchJson, (const char *)benchBuf);
+}
+
+void settings_bench()
+{
+    File configFile;
+    size_t len;
+    
+    if(!haveFS || !MYNVS.exists(cfgName))
+        return;
+
+    if(!(configFile = MYNVS.open(cfgName, "r")))
+        return;
+
+    len = configFile.size();
+    if((benchBuf = (char *)calloc(1, len + 1))) {
+        configFile.read((uint8_t *)benchBuf, len);
+        benchJson = new DynamicJsonDocument(JSON_SIZE);
+        bench_run("json_settings", settings_benchParse, 200);
+        delete benchJson;
+        free(benchBuf);
+        benchBuf = NULL;
+    }
+    
+    configFile.close();
+}
+#endif
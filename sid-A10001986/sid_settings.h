@@ -59,6 +59,9 @@
 #define XMS(s) #s
 
 void settings_setup();
+#ifdef SID_BENCH
+void settings_bench();
+#endif
 
 void unmount_fs();
 
@@ -69,6 +72,11 @@ bool evalBool(char *s);
 
 void saveIRKeys();
 void deleteIRKeys();
+bool appendIRTrace(const uint8_t *rec, int len);
+#ifdef SID_GOLDEN
+int  readGolden(const char *name, uint32_t *buf, int maxFrames);
+bool writeGolden(const char *name, const uint32_t *buf, int frames);
+#endif
 
 void loadBrightness();
 void storeBrightness();
@@ -102,6 +110,7 @@ void saveCarMode();
 void loadIdlePat();
 void storeIdlePat();
 void saveIdlePat();
+uint8_t *loadUserPattern(int& codeLen);
 
 #define BOOTM_NORMAL 0
 #define BOOTM_IGNORE BOOTM_NORMAL
@@ -127,6 +136,8 @@ void moveSettings();
 #define DEF_SKIP_TTANIM     1     // 0: Don't skip tt anim; 1: do
 #define DEF_SA_PEAKS        0     // 1: Show peaks in SA, 0: don't
 #define DEF_SA_MIRROR       0     // 1: Show "mirrored" SA, 0: don't
+#define DEF_SA_MODE         0     // SA display mode: 0: Bars, 1: Waterfall, 2: VU meter
+#define DEF_SA_FFTSZ        2     // SA FFT size: 0: 256, 1: 512, 2: 1024, 3: 2048
 #define DEF_IRFB            1     // 0: Don't show positive IR feedback on display; 1: do
 #define DEF_IRCFB           1     // 0: Don't show command entry feedback; 1: do
 #define DEF_SS_TIMER        0     // "Screen saver" timeout in minutes; 0 = ss off
@@ -165,6 +176,7 @@ struct Settings {
     
     char skipTTAnim[2]      = MS(DEF_SKIP_TTANIM);
     char ssTimer[4]         = MS(DEF_SS_TIMER);
+    char SAfftSz[2]         = MS(DEF_SA_FFTSZ);
     
     char tcdIP[32]          = DEF_TCD_IP;
     char useGPSS[2]         = MS(DEF_USE_GPSS);
@@ -194,6 +206,7 @@ struct Settings {
     char strictMode[2]      = MS(DEF_STRICT);
     char SApeaks[2]         = MS(DEF_SA_PEAKS);
     char SAmirror[2]        = MS(DEF_SA_MIRROR);
+    char SAmode[2]          = MS(DEF_SA_MODE);
     char PIRFB[2]           = MS(DEF_IRFB);
     char PIRCFB[2]          = MS(DEF_IRCFB);
     char ecmKludge[2]       = "0";  // MUST BE 0
@@ -437,6 +437,24 @@ void si_end()
     siActive = false;
 }
 
+// Continue a game ended by si_end(); board and piece
+// are still intact. Comes back paused.
+void si_resume()
+{
+    if(siActive)
+        return;
+
+    cp_now = millis();
+    if(siStartup) {
+        siStartup = cp_now;
+    } else if(!gameOver) {
+        pauseGame = true;
+        pauseShown = false;
+    }
+
+    siActive = true;
+}
+
 void si_newGame()
 {
     if(!siActive || siStartup)
@@ -58,6 +58,7 @@
 void si_init();          // start game
 void si_loop();          // game loop
 void si_end();           // end game (quit)
+void si_resume();        // continue game after si_end()
 void si_newGame();       // restart game (when active)
 void si_pause();         // pause game (toggle)
 void si_moveRight();     // user input: move right
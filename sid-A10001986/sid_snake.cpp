@@ -272,6 +272,24 @@ void sn_end()
     snActive = false;
 }
 
+// Continue a game ended by sn_end(); snake and apple
+// are still intact. Comes back paused.
+void sn_resume()
+{
+    if(snActive)
+        return;
+
+    cp_now = millis();
+    if(snStartup) {
+        snStartup = cp_now;
+    } else if(!gameOver) {
+        pauseGame = true;
+        pauseShown = false;
+    }
+
+    snActive = true;
+}
+
 void sn_newGame()
 {
     if(!snActive || snStartup)
@@ -58,6 +58,7 @@
 void sn_init();          // start game
 void sn_loop();          // game loop
 void sn_end();           // end game (quit)
+void sn_resume();        // continue game after sn_end()
 void sn_newGame();       // restart game (when active)
 void sn_pause();         // pause game (toggle)
 void sn_moveRight();     // user input: move right
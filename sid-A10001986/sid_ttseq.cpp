@@ -0,0 +1,243 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Time travel sequencer
+ *
+ * A time travel is described by a timeline of three phases:
+ * Acceleration (P0), time tunnel (P1) and reentry (P2). The
+ * sequencer tells the caller when keyframes or ticks are due
+ * and when a phase ends; what to draw is up to the caller.
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sid_ttseq.h"
+
+/*
+ * Timelines
+ */
+
+// Internal tt (button, IR, MQTT without TCD): Fixed durations
+const ttPhase ttTimelineInt[TTPH_NUM] = {
+    { TTK_RAMP, TTE_TIME,              TTEASE_LINEAR, 0, P0_DUR, 2500, 65 },
+    { TTK_TICK, TTE_TIME,              0,             0, P1_DUR,    0,  0, { 1000, 100 }, { 100, 50 }, { 130, 0 } },
+    { TTK_TICK, TTE_TIME | TTE_CALLER, 0,             1, P2_DUR,    0,  0, {   50,   0 }, { 195, 15 }, { 195, 15 } }
+};
+
+// TCD-triggered tt (GPIO, BTTFN, MQTT): P0 duration is the TCD's
+// lead time, P1 lasts until reentry (or a timeout).
+// In both, P2 ticks step the SA back to normal (15 ticks fit in
+// P2_DUR); the caller finishes P2 earlier once calmed down.
+const ttPhase ttTimelineTCD[TTPH_NUM] = {
+    { TTK_RAMP, TTE_TIME | TTE_ABORT,               TTEASE_LINEAR, 0,      0, 2500, 65 },
+    { TTK_TICK, TTE_TIME | TTE_REENTRY | TTE_ABORT, 0,             0,      0,    0,  0, { 1000, 100 }, { 100, 50 }, { 130, 0 } },
+    { TTK_TICK, TTE_TIME | TTE_CALLER,              0,             1, P2_DUR,    0,  0, {   50,   0 }, { 195, 15 }, { 195, 15 } }
+};
+
+ttSequencer::ttSequencer(uint32_t (*rnd)(uint32_t n))
+{
+    _rnd = rnd;
+}
+
+/*
+ * Start sequence at phase 0.
+ * p0Dur, p1Dur: Durations for phases whose timeline dur is 0
+ * cnt:          Number of keyframes for the ramp
+ * alt:          Use alternative tick intervals
+ */
+void ttSequencer::begin(const ttPhase *tl, unsigned long now, uint32_t p0Dur, uint32_t p1Dur, 
+                        int cnt, bool alt)
+{
+    _tl = tl;
+    _sup[0] = p0Dur;
+    _sup[1] = p1Dur;
+    _cnt = cnt;
+    _alt = alt;
+    _events = 0;
+    _phase = TTPH_ACCEL;
+
+    enter(now);
+}
+
+void ttSequencer::next(unsigned long now)
+{
+    if(!running())
+        return;
+
+    if(++_phase < TTPH_NUM) {
+        enter(now);
+    }
+}
+
+void ttSequencer::stop()
+{
+    _phase = TTPH_NUM;
+}
+
+/*
+ * Advance; returns TTEV_xxx flags. At most one keyframe
+ * or tick is reported per call.
+ */
+uint8_t ttSequencer::run(unsigned long now)
+{
+    const ttPhase *p;
+    uint32_t t;
+
+    if(!running())
+        return 0;
+
+    p = &_tl[_phase];
+    t = now - _start;
+
+    if((p->ends & _events) || ((p->ends & TTE_TIME) && t >= _dur)) {
+        return TTEV_END;
+    }
+
+    if(p->kind == TTK_RAMP) {
+        if(_key < _keys && t >= keyTime(_key + 1)) {
+            _key++;
+            _cnt--;
+            return TTEV_STEP;
+        }
+    } else if(t >= _nextT) {
+        _key++;
+        _cnt += p->dir;
+        _nextT = t + interval(_alt ? p->alt : p->next);
+        return TTEV_STEP;
+    }
+
+    return 0;
+}
+
+// ms until next keyframe, tick or timed phase end;
+// 0 if due now
+uint32_t ttSequencer::due(unsigned long now)
+{
+    const ttPhase *p;
+    uint32_t t, d = 0xffffffff;
+
+    if(!running())
+        return d;
+
+    p = &_tl[_phase];
+    t = now - _start;
+
+    if(p->ends & TTE_TIME) {
+        d = _dur;
+    }
+
+    if(p->kind == TTK_RAMP) {
+        if(_key < _keys && keyTime(_key + 1) < d) {
+            d = keyTime(_key + 1);
+        }
+    } else if(_nextT < d) {
+        d = _nextT;
+    }
+
+    return (t < d) ? d - t : 0;
+}
+
+bool ttSequencer::inRamp(unsigned long now)
+{
+    return running() && (_tl[_phase].kind == TTK_RAMP) && (now - _start >= _lead);
+}
+
+void ttSequencer::enter(unsigned long now)
+{
+    const ttPhase *p = &_tl[_phase];
+
+    _start = now;
+    _dur = p->dur ? p->dur : (_phase < 2 ? _sup[_phase] : 0);
+    _key = 0;
+
+    if(p->kind == TTK_RAMP) {
+        // Keyframes are spread over a window at the end of the
+        // phase, at least minInt apart if the phase is long enough.
+        // The last keyframe is one interval before the end.
+        uint32_t n1 = (_cnt > 0 ? _cnt : 0) + 1;
+        _keys = n1 - 1;
+        _win = (p->window < _dur) ? p->window : _dur;
+        if(_keys && (_win / n1 < p->minInt) && (n1 * p->minInt <= _dur)) {
+            _win = n1 * p->minInt;
+        }
+        _lead = _keys ? _dur - _win : 0;
+    } else {
+        _keys = 0;
+        _lead = 0;
+        _nextT = interval(p->first);
+    }
+}
+
+uint32_t ttSequencer::interval(const ttInterval& iv)
+{
+    if(!iv.jitter)
+        return iv.base;
+
+    return iv.base + (int)_rnd(2 * iv.jitter) - iv.jitter;
+}
+
+// Time of keyframe k (1.._keys) from phase start
+uint32_t ttSequencer::keyTime(int k)
+{
+    uint32_t n1 = _keys + 1, m, d;
+
+    switch(_tl[_phase].ease) {
+    case TTEASE_IN:
+        d = _win * k / n1 * k / n1;
+        break;
+    case TTEASE_OUT:
+        m = n1 - k;
+        d = _win - (_win * m / n1 * m / n1);
+        break;
+    default:
+        d = _win * k / n1;
+    }
+
+    return _lead + d;
+}
@@ -0,0 +1,166 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Time travel sequencer
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _SID_TTSEQ_H
+#define _SID_TTSEQ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Durations of tt phases for internal tt
+#define P0_DUR          5000    // acceleration phase
+#define P1_DUR_TCD      6600    // time tunnel phase (synced; overruled by TCD network commands)
+#define P1_DUR          5000    // time tunnel phase (stand-alone)
+#define P2_DUR          3000    // re-entry phase (max)
+#define P1_GRACE        3000    // Added to P1 duration for max timeout if synced
+
+// Phases
+#define TTPH_ACCEL      0       // P0
+#define TTPH_TUNNEL     1       // P1
+#define TTPH_REENTRY    2       // P2
+#define TTPH_NUM        3
+
+// Phase kinds
+#define TTK_RAMP        0       // Counts down to 0 in keyframes at end of phase
+#define TTK_TICK        1       // Ticks at jittered intervals
+
+// What ends a phase (besides TTE_TIME, these are latched events)
+#define TTE_TIME        0x01    // Phase duration
+#define TTE_REENTRY     0x02    // External: Reentry (TCD, pin)
+#define TTE_ABORT       0x04    // External: Abort (TCD)
+#define TTE_CALLER      0x08    // Caller: finish()
+
+// Keyframe distribution over ramp window
+#define TTEASE_LINEAR   0
+#define TTEASE_IN       1       // Slow start
+#define TTEASE_OUT      2       // Slow end
+
+// Return flags of run()
+#define TTEV_STEP       0x01    // Keyframe or tick due
+#define TTEV_END        0x02    // Phase ended; caller then calls next()
+
+typedef struct {
+    uint16_t base;
+    uint16_t jitter;            // +/- ms
+} ttInterval;
+
+typedef struct {
+    uint8_t    kind;            // TTK_xxx
+    uint8_t    ends;            // TTE_xxx
+    uint8_t    ease;            // RAMP: TTEASE_xxx
+    int8_t     dir;             // TICK: Count change per tick
+    uint16_t   dur;             // ms; 0 = supplied to begin()
+    uint16_t   window;          // RAMP: Max ramp window at end of phase
+    uint16_t   minInt;          // RAMP: Min interval between keyframes
+    ttInterval first;           // TICK: First interval
+    ttInterval next;            // TICK: Following intervals
+    ttInterval alt;             // TICK: Following intervals in alt mode
+} ttPhase;
+
+extern const ttPhase ttTimelineInt[TTPH_NUM];
+extern const ttPhase ttTimelineTCD[TTPH_NUM];
+
+/*
+ * Executes a timeline of phases. Has no hardware dependencies
+ * and takes time from the caller, so it can be run in a host
+ * simulation at any speed.
+ */
+class ttSequencer {
+
+    public:
+
+        ttSequencer(uint32_t (*rnd)(uint32_t n));
+
+        void begin(const ttPhase *tl, unsigned long now, uint32_t p0Dur, uint32_t p1Dur, 
+                   int cnt, bool alt);
+        uint8_t run(unsigned long now);
+        void next(unsigned long now);
+        void stop();
+
+        void event(uint8_t ev) { _events |= ev; }
+        void finish()          { _events |= TTE_CALLER; }
+
+        bool running()         { return _phase < TTPH_NUM; }
+        int  phase()           { return _phase; }
+        int  count()           { return _cnt; }
+        int  keys()            { return _key; }
+        bool inRamp(unsigned long now);
+        uint32_t due(unsigned long now);
+        bool aborted()         { return !!(_events & TTE_ABORT); }
+        unsigned long phaseStart() { return _start; }
+
+    private:
+
+        void     enter(unsigned long now);
+        uint32_t interval(const ttInterval& iv);
+        uint32_t keyTime(int k);
+        
+        uint32_t      (*_rnd)(uint32_t n);    // 0 <= r < n
+        const ttPhase *_tl = NULL;
+        int           _phase = TTPH_NUM;
+        uint8_t       _events = 0;
+        bool          _alt = false;
+        int           _cnt = 0;
+        uint32_t      _sup[2] = { 0, 0 };
+
+        // Current phase
+        unsigned long _start = 0;
+        uint32_t      _dur = 0;
+        int           _key = 0;     // Keyframes/ticks so far
+        int           _keys = 0;    // RAMP: Total keyframes
+        uint32_t      _lead = 0;    // RAMP: Time before ramp starts
+        uint32_t      _win = 0;     // RAMP: Ramp window
+        uint32_t      _nextT = 0;   // TICK: Time of next tick
+};
+
+#endif
@@ -66,6 +66,9 @@
 #include "sid_settings.h"
 #include "sid_wifi.h"
 #include "sid_main.h"
+#include "sid_sa.h"
+#include "sid_prof.h"
+#include "sid_msg.h"
 #ifdef SID_HAVEMQTT
 #include "mqtt.h"
 #endif
@@ -107,6 +110,25 @@ static const char *apChannelCustHTMLSrc[14] = {
     ">11%s"
 };
 
+static const char *saModeCustHTMLSrc[5] = {
+    "'>Spectrum Analyzer display",
+    "samode",
+    ">Bars%s1'",
+    ">Waterfall%s2'",
+    ">VU meter%s"
+};
+
+static const char *saFFTCustHTMLSrc[6] = {
+    "'>Spectrum Analyzer resolution",
+    "safft",
+    ">256 (8ms, coarse)%s1'",
+    ">512 (16ms)%s2'",
+    ">1024 (32ms, default)%s3'",
+    ">2048 (64ms, fine)%s"
+};
+static const char saCostFmt[] = "FFT size %d: %lu.%lums processing per %lums frame (%lu%%)";
+static const char saNoCost[] = "FFT size %d: Processing time not measured yet";
+
 #ifdef SID_HAVEMQTT
 static const char *mqttpCustHTMLSrc[4] = {
     "'>Protocol version",
@@ -133,6 +155,12 @@ static const char *wmBuildApChnl(const char *dest, int op);
 static const char *wmBuildBestApChnl(const char *dest, int op);
 
 static const char *wmBuildHaveSD(const char *dest, int op);
+static const char *wmBuildSAMode(const char *dest, int op);
+static const char *wmBuildSAFFT(const char *dest, int op);
+static const char *wmBuildSACost(const char *dest, int op);
+#ifdef SID_PROFILE
+static const char *wmBuildProfile(const char *dest, int op);
+#endif
 
 #ifdef SID_HAVEMQTT
 static const char *wmBuildMQTTprot(const char *dest, int op);
@@ -203,6 +231,12 @@ WiFiManagerParameter custom_sStrict("sStrict", "Adhere strictly to movie pattern
 WiFiManagerParameter custom_sTTANI("sTTANI", "Skip time tunnel animation", settings.skipTTAnim, "title='Check to skip the time tunnel animation'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_SApeaks("sap", "Show peaks in Spectrum Analyzer", settings.SApeaks, "", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_SAmirror("sam", "Mirrored Spectrum Analyzer", settings.SAmirror, "", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
+WiFiManagerParameter custom_SAmode(wmBuildSAMode);
+WiFiManagerParameter custom_SAfft(wmBuildSAFFT);
+WiFiManagerParameter custom_SAcost(wmBuildSACost);
+#ifdef SID_PROFILE
+WiFiManagerParameter custom_profile(wmBuildProfile);
+#endif
 WiFiManagerParameter custom_PIRFB("pir", "Show positive IR feedback on display", settings.PIRFB, "", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_PIRCFB("pirc", "Show IR command entry feedback on display", settings.PIRCFB, "class='mb10'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_ssDelay("ssDel", "Screen Saver timer (1-999[minutes]; 0=off)", settings.ssTimer, 3, "type='number' min='0' max='999'");
@@ -315,9 +349,12 @@ static bool          mqttPingDone = false;
 static unsigned long mqttPingNow = 0;
 static unsigned long mqttPingInt = MQTT_SHORT_INT;
 static uint16_t      mqttPingsExpired = 0;
-char                 mqttMsg[10] = { 0 };
+#define       MQTT_MAX_BP     2000    // Max time to hold back incoming msgs
+static unsigned long mqttBPNow = 0;
+#ifdef SID_PROFILE
+static bool          mqttProfReq = false;
+#endif
 #endif
-uint32_t             mqttDisp = 0;
 
 static unsigned int wmLenBuf = 0;
 
@@ -356,6 +393,9 @@ static bool mqttReconnect(bool force = false);
 static void mqttLooper();
 static void mqttCallback(char *topic, byte *payload, unsigned int length);
 static void mqttSubscribe();
+#ifdef SID_PROFILE
+static void mqttPublishProfile();
+#endif
 #endif
 
 /*
@@ -402,6 +442,9 @@ void wifi_setup()
       &custom_sTTANI,
       &custom_SApeaks,
       &custom_SAmirror,
+      &custom_SAmode,
+      &custom_SAfft,
+      &custom_SAcost,
       &custom_PIRFB,
       &custom_PIRCFB,
       &custom_ssDelay,
@@ -423,6 +466,10 @@ void wifi_setup()
       //&custom_sdFrq,
 
       &custom_disDIR,         // 1
+
+      #ifdef SID_PROFILE
+      &custom_profile,
+      #endif
   
       NULL
     };
@@ -680,6 +727,8 @@ void wifi_loop()
     if(!wifiSetupDone)
         return;
 
+    PROF_SCOPE(PROF_WIFI);
+
 #ifdef SID_HAVEMQTT
     if(useMQTT) {
         if(mqttClient.state() != MQTT_CONNECTING) {
@@ -708,32 +757,56 @@ void wifi_loop()
                 mqttOldState = true;
             }
         }
-        mqttClient.loop();
+        // Back-pressure: While the command queue is full, leave
+        // incoming messages in the socket, but not for too long
+        // lest the broker drop us.
+        if(cmdQueueFull() && (!mqttBPNow || millis() - mqttBPNow < MQTT_MAX_BP)) {
+            if(!mqttBPNow) mqttBPNow = millis() | 1;
+        } else {
+            mqttBPNow = 0;
+            PROF_SCOPE(PROF_MQTT);
+            mqttClient.loop();
+        }
+        #ifdef SID_PROFILE
+        if(mqttProfReq) {
+            mqttPublishProfile();
+            mqttProfReq = false;
+        }
+        #endif
     }
 #endif
 
     if(millis() - lastUpdateCheck > 24*60*60*1000) {
-        if(!TTrunning && !IRLearning && !sidBusy) {
+        if(!(main_state() & (MS_TT|MS_IRLEARN|MS_BUSY))) {
             checkForUpdate();
         }
     }
 
     if(wifiLoopSaveAction & WLA_SET_CM) {
-        bool ocm = carMode;
-        carMode = !!(wifiLoopSaveAction & WLA_SET_CM_ON);
-        if(!*settings.cm_ssid) carMode = false;
-        if(carMode != ocm) {
-            saveCarMode();
-            if(!(wifiLoopSaveAction & WLA_SET)) {
-                prepareReboot();
-                delay(1000);
-                esp_restart();
+        bool ncm = !!(wifiLoopSaveAction & WLA_SET_CM_ON);
+        bool done = true;
+        if(!*settings.cm_ssid) ncm = false;
+        if(ncm != carMode) {
+            // If main side does not stop, try again next time
+            if((done = main_halt())) {
+                carMode = ncm;
+                saveCarMode();
+                if(!(wifiLoopSaveAction & WLA_SET)) {
+                    prepareReboot();
+                    delay(1000);
+                    esp_restart();
+                }
+                main_resume();
             }
         }
-        wifiLoopSaveAction &= ~(WLA_SET_CM|WLA_SET_CM_ON);
+        if(done) {
+            wifiLoopSaveAction &= ~(WLA_SET_CM|WLA_SET_CM_ON);
+        }
     }
 
-    if(wifiLoopSaveAction & WLA_SET) {
+    // Main side must not touch display and FS from here;
+    // if it does not stop, try again next time
+    if((wifiLoopSaveAction & WLA_SET) && main_halt()) {
 
         int temp;
 
@@ -804,6 +877,7 @@ void wifi_loop()
             doPeaks = evalBool(settings.SApeaks);
             evalCB(settings.SAmirror, &custom_SAmirror);
             doMirror = evalBool(settings.SAmirror);
+            saMode = atoi(settings.SAmode);
             evalCB(settings.PIRFB, &custom_PIRFB);
             irShowPosFBDisplay = evalBool(settings.PIRFB);
             evalCB(settings.PIRCFB, &custom_PIRCFB);
@@ -869,7 +943,10 @@ void wifi_loop()
         esp_restart();
     }
 
-    wm.process(true);
+    {
+        PROF_SCOPE(PROF_WM);
+        wm.process(true);
+    }
 
     // WiFi power management
     // If a delay > 0 is configured, WiFi is powered-down after timer has
@@ -1322,6 +1399,8 @@ static void saveParamsCallback(int paramspage)
 
     switch(paramspage) {
     case 1:
+        getServerParam("samode", settings.SAmode, 1, 0, SA_MODE_MAX, DEF_SA_MODE);
+        getServerParam("safft", settings.SAfftSz, 1, 0, 3, DEF_SA_FFTSZ);
         break;
     case 2:
         #ifdef SID_HAVEMQTT
@@ -1334,6 +1413,10 @@ static void saveParamsCallback(int paramspage)
 // This is called before a firmware updated is initiated.
 static void preUpdateCallback()
 {
+    // The upload can't be postponed, so wait for
+    // as long as the main side needs
+    main_halt(0);
+
     wifiAPOffDelay = 0;
     origWiFiOffDelay = 0;
 
@@ -1366,7 +1449,7 @@ static bool preWiFiScanCallback()
     // Do not allow a WiFi scan under some circumstances (as
     // it may disrupt sequences)
     
-    if(blockScan || TTrunning || IRLearning || networkAlarm)
+    if(main_state() & (MS_NOSCAN|MS_TT|MS_IRLEARN|MS_ALARM))
         return false;
 
     return true;
@@ -1429,21 +1512,34 @@ static void updateConfigPortalValues()
     #endif
 }
 
-void updateConfigPortalStrictValue()
+/*
+ * Values come from the main side through NC_CPUPDATE;
+ * strictMode, saMode etc must not be read here
+ */
+void updateConfigPortalStrictValue(bool strict)
 {
-    setBoolAndUpdCB(strictMode, settings.strictMode, &custom_sStrict);
+    setBoolAndUpdCB(strict, settings.strictMode, &custom_sStrict);
 }
 
-void updateConfigPortalSAValues()
+void updateConfigPortalSAValues(int mode, bool peaks, bool mirror)
 {
-    setBoolAndUpdCB(doPeaks, settings.SApeaks, &custom_SApeaks);
-    setBoolAndUpdCB(doMirror, settings.SAmirror, &custom_SAmirror);
+    setBoolAndUpdCB(peaks, settings.SApeaks, &custom_SApeaks);
+    setBoolAndUpdCB(mirror, settings.SAmirror, &custom_SAmirror);
+    settings.SAmode[0] = '0' + mode;
+    settings.SAmode[1] = 0;
 }
 
-void updateConfigPortalIRFBValues()
+void updateConfigPortalIRFBValues(bool posFB, bool cmdFB)
 {
-    setBoolAndUpdCB(irShowPosFBDisplay, settings.PIRFB, &custom_PIRFB);
-    setBoolAndUpdCB(irShowCmdFBDisplay, settings.PIRCFB, &custom_PIRCFB);
+    setBoolAndUpdCB(posFB, settings.PIRFB, &custom_PIRFB);
+    setBoolAndUpdCB(cmdFB, settings.PIRCFB, &custom_PIRCFB);
+}
+
+// Car mode change from main side (NC_SETCM); saved 
+// and rebooted in wifi_loop()
+void wifiSetCarMode(bool enable)
+{
+    setCMCallback(enable);
 }
 
 static const char *buildBanner(const char *msg, const char *col, int op) 
@@ -1612,6 +1708,69 @@ static const char *wmBuildHaveSD(const char *dest, int op)
     return buildBanner(haveNoSD, col_r, op);
 }
 
+static const char *wmBuildSAMode(const char *dest, int op)
+{
+    return wmBuildSelect(dest, op, saModeCustHTMLSrc, 5, settings.SAmode, false);
+}
+
+static const char *wmBuildSAFFT(const char *dest, int op)
+{
+    return wmBuildSelect(dest, op, saFFTCustHTMLSrc, 6, settings.SAfftSz, false);
+}
+
+static const char *wmBuildSACost(const char *dest, int op)
+{
+    char buf[80];
+    unsigned long frameUs, procUs;
+    int fftSize;
+
+    if(op == WM_CP_DESTROY) {
+        if(dest) free((void *)dest);
+        return NULL;
+    }
+
+    fftSize = sa_getFFTSize(frameUs, procUs);
+
+    if(procUs) {
+        sprintf(buf, saCostFmt, fftSize, procUs / 1000, (procUs % 1000) / 100, frameUs / 1000, procUs * 100 / frameUs);
+    } else {
+        sprintf(buf, saNoCost, fftSize);
+    }
+
+    return buildBanner(buf, col_gr, op);
+}
+
+#ifdef SID_PROFILE
+static const char *wmBuildProfile(const char *dest, int op)
+{
+    char *buf;
+    const char *str;
+    int l = 0, bs = PROF_NUM * 160;
+
+    if(op == WM_CP_DESTROY) {
+        if(dest) free((void *)dest);
+        return NULL;
+    }
+
+    if(!(buf = (char *)malloc(bs))) {
+        return NULL;
+    }
+
+    l = sprintf(buf, "Overhead %uns per measurement<br>", prof_overhead());
+
+    for(int i = 0; i < PROF_NUM && l < bs - 8; i++) {
+        if(i) l += sprintf(buf + l, "<br>");
+        l += prof_report(i, buf + l, bs - l, true);
+    }
+
+    str = buildBanner(buf, col_gr, op);
+
+    free(buf);
+
+    return str;
+}
+#endif
+
 #ifdef SID_HAVEMQTT
 static const char *wmBuildMQTTprot(const char *dest, int op)
 {
@@ -1967,13 +2126,19 @@ static uint16_t a2i(char *p)
 static void mqttCallback(char *topic, byte *payload, unsigned int length)
 {
     int i = 0, j, ml = (length <= 255) ? length : 255;
+    uint8_t ms;
     char tempBuf[256];
     static const char *cmdList[] = {
       "\x01" "TIMETRAVEL",       // 0
       "\x01" "IDLE_",            // 1
       "\x41" "IDLE",             // 2
-      "\x01" "SA",               // 3
-      "\x01" "INJECT_",          // 4
+      "\x01" "SA_WATERFALL",     // 3
+      "\x01" "SA_VU",            // 4
+      "\x01" "SA",               // 5
+      "\x01" "INJECT_",          // 6
+      #ifdef SID_PROFILE
+      "\xc1" "PROFILE",          // 7
+      #endif
       NULL
     };
     static const char *cmdList2[] = {
@@ -1986,11 +2151,10 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
       NULL
     };
 
-    // Note: This might be called while we are in a
-    // wait-delay-loop. Best to just set flags here
-    // that are evaluated synchronously (=later).
-    // Do not stuff that messes with display, input,
-    // etc.
+    // Note: This runs on the network side. Only post
+    // messages to the main side here (sid_msg.h), do 
+    // not touch display, input, etc., and check the
+    // main side's state through main_state() only.
 
     if(!length) return;
 
@@ -2007,7 +2171,7 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
 
         while(cmdList2[i]) {
             j = strlen(cmdList2[i]);
-            if((length >= j) && !strncmp((const char *)tempBuf, cmdList2[i], j)) {
+            if((length >= (unsigned int)j) && !strncmp((const char *)tempBuf, cmdList2[i], j)) {
                 break;
             }
             i++;          
@@ -2023,45 +2187,35 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
             // We disable our Screen Saver.
             // We don't ignore this if TCD is connected by wire,
             // because this signal does not come via wire.
-            doPrepareTT = true;
+            postToMain(NM_PREPARE);
             break;
         case 1:
             // Trigger Time Travel (if not running already)
-            // Ignore command if TCD is connected by wire
-            if(!TCDconnected && !TTrunning && !IRLearning && !sidBusy) {
-                networkTimeTravel = true;
-                networkTCDTT = true;
-                networkReentry = false;
-                networkAbort = false;
+            {
+                netMsg m;
+                m.type = NM_TT;
                 if(strlen(tempBuf) == 20) {
-                    networkLead = a2i(&tempBuf[11]);
-                    networkP1 = a2i(&tempBuf[16]);
+                    m.tt.lead = a2i(&tempBuf[11]);
+                    m.tt.p1 = a2i(&tempBuf[16]);
                 } else {
-                    networkLead = ETTO_LEAD;
-                    networkP1 = 6600;
+                    m.tt.lead = ETTO_LEAD;
+                    m.tt.p1 = 6600;
                 }
+                postToMain(m);
             }
             break;
         case 2:   // Re-entry
             // Start re-entry (if TT currently running)
-            // Ignore command if TCD is connected by wire
-            if(!TCDconnected && TTrunning && networkTCDTT) {
-                networkReentry = true;
-            }
+            postToMain(NM_REENTRY);
             break;
         case 3:   // Abort TT (TCD fake-powered down during TT)
-            // Ignore command if TCD is connected by wire
-            // (mainly because this is no network-triggered TT)
-            if(!TCDconnected && TTrunning && networkTCDTT) {
-                networkAbort = true;
-            }
+            postToMain(NM_ABORT);
             break;
         case 4:
-            networkAlarm = true;
-            // Eval this at our convenience
+            postToMain(NM_ALARM);
             break;
         case 5:
-            doWakeup = true;
+            postToMain(NM_WAKEUP);
             break;
         }
        
@@ -2079,7 +2233,7 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
         while(cmdList[i]) {
             k = (uint8_t)*cmdList[i];
             j = strlen(cmdList[i] + 1);
-            if((length >= j) && !strncmp((const char *)tempBuf, cmdList[i] + 1, j)) {
+            if((length >= (unsigned int)j) && !strncmp((const char *)tempBuf, cmdList[i] + 1, j)) {
                 break;
             }
             i++;          
@@ -2087,10 +2241,12 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
 
         if(!cmdList[i]) return;
 
-        if(!FPBUnitIsOn && (!(k & 0x80)))
+        ms = main_state();
+
+        if(!(ms & MS_FPBON) && (!(k & 0x80)))
             return;
 
-        if(sidBusy && (!(k & 0x40)))
+        if((ms & MS_BUSY) && (!(k & 0x40)))
             return;
 
         // What needs to be handled here:
@@ -2103,30 +2259,45 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
         switch(i) {
         case 1:
             if(tblen > j && tempBuf[j] >= '0' && tempBuf[j] <= '5') {
-                addCmdQueue(10 + (uint32_t)(tempBuf[j] - '0'));
+                addCmdQueue(10 + (uint32_t)(tempBuf[j] - '0'), CMDSRC_MQTT);
             }
             break;
         case 2:
-            addCmdQueue(20);
+            addCmdQueue(20, CMDSRC_MQTT);
             break;
         case 3:
-            addCmdQueue(21);
+            addCmdQueue(65, CMDSRC_MQTT);
             break;
         case 4:
+            addCmdQueue(66, CMDSRC_MQTT);
+            break;
+        case 5:
+            addCmdQueue(21, CMDSRC_MQTT);
+            break;
+        case 6:
             if(tblen > j) {
-                addCmdQueue(atoi(tempBuf+j) | 0x80000000);
+                addCmdQueue(atoi(tempBuf+j), CMDSRC_MQTT, CMDF_INJECT);
             }
             break;
+        #ifdef SID_PROFILE
+        case 7:
+            // Publish from wifi_loop, not from within callback
+            mqttProfReq = true;
+            break;
+        #endif
         default:
-            addCmdQueue(1000 + i);
+            addCmdQueue(1000 + i, CMDSRC_MQTT);
         }
             
     } else if(*settings.mqttTopic && (!strcmp(topic, settings.mqttTopic))) {
 
-        if(filterOutNonDisp(tempBuf, mqttMsg, 0, 8)) {
-            mqttDisp = 1;
+        netMsg m;
+        
+        if(filterOutNonDisp(tempBuf, m.text, 0, 8)) {
+            m.type = NM_TEXT;
+            postToMain(m);
             #ifdef SID_DBG
-            Serial.printf("MQTT: Message about [%s]: %s\n", topic, mqttMsg);
+            Serial.printf("MQTT: Message about [%s]: %s\n", topic, m.text);
             #endif
         } else {
             #ifdef SID_DBG
@@ -2259,4 +2430,19 @@ void mqttPublish(const char *topic, const char *pl, unsigned int len)
     }
 }           
 
+#ifdef SID_PROFILE
+static void mqttPublishProfile()
+{
+    char buf[192];
+    int l;
+
+    // One message per subsystem, to stay within packet size
+    for(int i = 0; i < PROF_NUM; i++) {
+        if((l = prof_report(i, buf, sizeof(buf)))) {
+            mqttPublish("bttf/sid/profile", buf, l);
+        }
+    }
+}
+#endif
+
 #endif
@@ -62,9 +62,10 @@ bool wifiOnWillBlock();
 void wifiStartCP();
 bool updateAvailable();
 
-void updateConfigPortalStrictValue();
-void updateConfigPortalSAValues();
-void updateConfigPortalIRFBValues();
+void updateConfigPortalStrictValue(bool strict);
+void updateConfigPortalSAValues(int mode, bool peaks, bool mirror);
+void updateConfigPortalIRFBValues(bool posFB, bool cmdFB);
+void wifiSetCarMode(bool enable);
 
 bool wifi_getIP(uint8_t& a, uint8_t& b, uint8_t& c, uint8_t& d);
 bool isIp(char *str);
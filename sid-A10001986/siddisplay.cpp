@@ -60,6 +60,7 @@
 #include "siddisplay.h"
 
 #include "sid_font.h"
+#include "sid_prof.h"
 
 static const uint16_t translator[10][20][2] =
 { 
@@ -386,6 +387,10 @@ uint8_t sidDisplay::setBrightnessDirect(uint8_t level)
 
     directCmd(0xe0 | level);
 
+    #ifdef SID_GOLDEN
+    _curBrightness = level;
+    #endif
+
     return level;
 }
 
@@ -600,6 +605,37 @@ void sidDisplay::drawFieldAndShow(uint8_t *fieldData)
     show();
 }
 
+void sidDisplay::drawPackedFieldAndShow(const uint16_t *rows, int firstRow)
+{
+    // Draw entire field. Data is one word per line, bit 0 being
+    // bar 0. rows[] is a ring buffer of 20 lines, firstRow being
+    // the index of the top line.
+    for(int i = 0, k = firstRow; i < 20; i++) {
+        uint16_t row = rows[k];
+        for(int j = 0; j < 10; j++, row >>= 1) {
+            if(row & 1) {
+                _displayBuffer[translator[j][i][0]] |= translator[j][i][1];
+            } else {
+                _displayBuffer[translator[j][i][0]] &= ~(translator[j][i][1]);
+            }
+        }
+        if(++k == 20) k = 0;
+    }
+    show();
+}
+
+// Raw buffer access (SD_BUF_SIZE words), for snapshots
+void sidDisplay::getRawBuf(uint16_t *buf)
+{
+    memcpy(buf, _displayBuffer, sizeof(_displayBuffer));
+}
+
+void sidDisplay::drawRawAndShow(const uint16_t *buf)
+{
+    memcpy(_displayBuffer, buf, sizeof(_displayBuffer));
+    show();
+}
+
 void sidDisplay::drawLetterAndShow(char alpha, int x, int y)
 {
     uint8_t field[20*10] = { 0 };
@@ -748,6 +784,7 @@ void sidDisplay::drawClockAndShow(uint8_t *dateBuf, int dx, int dy)
     // AM/PM not shown; no idea where to put
     // it; corners are not an option, defeats
     // the idea of a screenSAVER.
+    (void)ampm;
     
     for(c = 0; c < 4; c++) {
         for(int yy = y[c], yyy = 0; yy < y[c] + 5; yy++, yyy++) {
@@ -808,6 +845,8 @@ void sidDisplay::show()
 {
     uint16_t *tp = &_displayBuffer[0];
 
+    PROF_SCOPE(PROF_SHOW);
+
     if(_specialSig) {
         if(millis() - _specialSigNow < _specialDuration) {
             superImposeSpecSig();
@@ -816,6 +855,12 @@ void sidDisplay::show()
             _specialTrigger = false;
         }
     }
+
+    #ifdef SID_GOLDEN
+    if(_showHook) {
+        _showHook(_displayBuffer, SD_BUF_SIZE, _curBrightness);
+    }
+    #endif
     
     for(int j = 0; j < 2; j++) {
         Wire.beginTransmission(_address[j]);
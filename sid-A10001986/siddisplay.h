@@ -97,6 +97,10 @@ class sidDisplay {
         void drawMirrorDot(int bar, int dot_y, int maxHeight);
 
         void drawFieldAndShow(uint8_t *fieldData);
+        void drawPackedFieldAndShow(const uint16_t *rows, int firstRow = 0);
+
+        void getRawBuf(uint16_t *buf);
+        void drawRawAndShow(const uint16_t *buf);
 
         void drawLetterAndShow(char alpha, int x = 0, int y = 8);
         void drawLetterMask(char alpha, int x, int y);
@@ -105,6 +109,10 @@ class sidDisplay {
         void specialSig(uint8_t sig);
         bool specialTrigger();
 
+        #ifdef SID_GOLDEN
+        void setShowHook(void (*hook)(const uint16_t *buf, int len, uint8_t bri)) { _showHook = hook; }
+        #endif
+
     private:
         void superImposeSpecSig();
         void directCmd(uint8_t val);
@@ -121,6 +129,11 @@ class sidDisplay {
         
         uint16_t _displayBuffer[SD_BUF_SIZE];
 
+        #ifdef SID_GOLDEN
+        uint8_t  _curBrightness = 15;
+        void     (*_showHook)(const uint16_t *buf, int len, uint8_t bri) = NULL;
+        #endif
+
 };
 
 #endif
@@ -0,0 +1,167 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Minimal Arduino/ESP32 API for the firmware. The
+ * other SDK headers in this directory (Wire, WiFi, I2S, FS, ...)
+ * build on it.
+ *
+ * Time is virtual: millis()/micros() only advance through
+ * host_advance() or delay(), so hours of runtime can be
+ * simulated in seconds. GPIO levels are set by the host code
+ * (host_setPin()), which also fires attached interrupts.
+ */
+
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <ctype.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#define IRAM_ATTR
+#define PROGMEM
+#define F(x)            (x)
+
+#ifndef PI
+#define PI              3.1415926535897932384626433832795
+#endif
+#define sq(x)           ((x)*(x))
+#define BIT(n)          (1UL << (n))
+
+typedef int esp_err_t;
+#define ESP_OK          0
+#define ESP_FAIL        -1
+
+#define portMAX_DELAY           0xffffffff
+#define ESP_INTR_FLAG_LEVEL1    (1 << 1)
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define INPUT_PULLDOWN  0x09
+#define RISING          0x01
+#define FALLING         0x02
+#define CHANGE          0x03
+
+#define digitalPinToInterrupt(p) (p)
+
+#define HOST_NUMPINS    40
+
+/*
+ * Virtual clock
+ */
+
+uint64_t host_us();
+void     host_setUs(uint64_t us);
+void     host_advance(uint64_t us);
+
+unsigned long millis();
+unsigned long micros();
+
+// Call hook once, at the start of the next micros(), eg to have 
+// an "interrupt" come in at a given point of the code
+void host_onNextMicros(void (*hook)());
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// Run func every intervalUs of virtual time spent waiting, as
+// a task on the other core would (eg the network side)
+void host_coreTask(void (*func)(), uint32_t intervalUs);
+
+/*
+ * GPIO, interrupts, timers
+ */
+
+void pinMode(uint8_t pin, uint8_t mode);
+int  digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// Set input level; fires the pin's interrupt on a matching edge
+void host_setPin(uint8_t pin, int level);
+
+
+typedef struct hw_timer_s hw_timer_t;
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t *timer, void (*isr)(void), bool edge);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+void timerAlarmDisable(hw_timer_t *timer);
+
+// Call the ISR of timer num (if attached and enabled)
+void host_timerTick(uint8_t num);
+
+// Critical sections: A spinlock, so that an "ISR" can
+// be run in a thread of its own
+typedef struct {
+    volatile int lock;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+void portENTER_CRITICAL(portMUX_TYPE *mux);
+void portEXIT_CRITICAL(portMUX_TYPE *mux);
+#define portENTER_CRITICAL_ISR(m) portENTER_CRITICAL(m)
+#define portEXIT_CRITICAL_ISR(m)  portEXIT_CRITICAL(m)
+
+/*
+ * CPU clock: The cycle counter runs at the current CPU clock
+ * on the virtual time line, and wraps at 32 bits like CCOUNT.
+ */
+
+uint32_t getCpuFrequencyMhz();
+bool     setCpuFrequencyMhz(uint32_t mhz);
+
+class HostESP {
+    public:
+        uint32_t getCycleCount();
+        uint32_t getCpuFreqMHz()   { return getCpuFrequencyMhz(); }
+        uint32_t getFreeHeap();
+        uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+        void     restart();
+};
+
+extern HostESP ESP;
+
+/*
+ * Misc
+ */
+
+uint32_t esp_random();
+void     host_seed(uint32_t seed);
+
+// Prints and exits with status 3: The host can't reboot
+void     esp_restart() __attribute__((noreturn));
+
+void vTaskDelay(uint32_t ticks);
+
+class HostSerial {
+    public:
+        void   begin(unsigned long baud) {}
+        size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+        size_t print(const char *s)   { return fputs(s, stdout); }
+        size_t println(const char *s = "") { return printf("%s\n", s); }
+        int    available()            { return 0; }
+        int    read()                 { return -1; }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,301 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: The part of the ArduinoJson 6 API the settings
+ * use. Documents are flat objects; members are strings, numbers
+ * (kept as text, but not readable as strings, as in ArduinoJson),
+ * true/false and null. Nested objects and arrays fail to parse
+ * with InvalidInput. Strings are always copied.
+ */
+
+#ifndef _HOST_ARDUINOJSON_H
+#define _HOST_ARDUINOJSON_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+#define ARDUINOJSON_VERSION_MAJOR 6
+
+class DeserializationError {
+    public:
+        enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+
+        DeserializationError(Code c = Ok) : _code(c) { }
+
+        explicit operator bool() const  { return _code != Ok; }
+        bool operator==(Code c) const   { return _code == c; }
+        bool operator!=(Code c) const   { return _code != c; }
+        Code code() const               { return _code; }
+        const char *c_str() const
+        {
+            static const char *n[] = { "Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep" };
+            return n[_code];
+        }
+
+    private:
+        Code _code;
+};
+
+class JsonDocument;
+
+struct hostJsonMember {
+    std::string key;
+    std::string val;            // Text as in the file, unquoted for strings
+    bool        isStr;
+};
+
+// doc[key]: Reads the member, assigning adds or replaces it
+class JsonVariant {
+    public:
+        JsonVariant(JsonDocument *doc, const JsonDocument *cdoc, const char *key) 
+            : _doc(doc), _cdoc(cdoc), _key(key) { }
+
+        operator const char *() const;
+        explicit operator bool() const  { return !isNull(); }
+        bool isNull() const;
+
+        JsonVariant& operator=(const char *s);
+
+    private:
+        JsonDocument       *_doc;
+        const JsonDocument *_cdoc;
+        const char         *_key;
+};
+
+class JsonDocument {
+    public:
+        JsonDocument(size_t capacity) : _capacity(capacity) { }
+
+        JsonVariant operator[](const char *key)       { return JsonVariant(this, this, key); }
+        JsonVariant operator[](const char *key) const { return JsonVariant(NULL, this, key); }
+
+        // As ArduinoJson 6 on 32 bit: 16 bytes per member, plus
+        // copied strings
+        size_t memoryUsage() const
+        {
+            size_t s = 0;
+            for(const hostJsonMember& m : _m) {
+                s += 16 + m.key.length() + 1 + (m.isStr ? m.val.length() + 1 : 0);
+            }
+            return s;
+        }
+        size_t capacity() const     { return _capacity; }
+        bool   overflowed() const   { return memoryUsage() > _capacity; }
+        void   clear()              { _m.clear(); }
+
+        // Host side
+        const hostJsonMember *find(const char *key) const
+        {
+            for(const hostJsonMember& m : _m) {
+                if(m.key == key) return &m;
+            }
+            return NULL;
+        }
+        void set(const char *key, const char *val, bool isStr)
+        {
+            for(hostJsonMember& m : _m) {
+                if(m.key == key) {
+                    m.val = val;
+                    m.isStr = isStr;
+                    return;
+                }
+            }
+            _m.push_back({ key, val, isStr });
+        }
+        const std::vector<hostJsonMember>& members() const { return _m; }
+
+    private:
+        size_t _capacity;
+        std::vector<hostJsonMember> _m;
+};
+
+template<size_t N> class StaticJsonDocument : public JsonDocument {
+    public:
+        StaticJsonDocument() : JsonDocument(N) { }
+};
+
+class DynamicJsonDocument : public JsonDocument {
+    public:
+        DynamicJsonDocument(size_t capacity) : JsonDocument(capacity) { }
+};
+
+inline JsonVariant::operator const char *() const
+{
+    const hostJsonMember *m = _cdoc->find(_key);
+
+    return (m && m->isStr) ? m->val.c_str() : NULL;
+}
+
+inline bool JsonVariant::isNull() const
+{
+    const hostJsonMember *m = _cdoc->find(_key);
+
+    return !m || (!m->isStr && m->val == "null");
+}
+
+inline JsonVariant& JsonVariant::operator=(const char *s)
+{
+    if(_doc) {
+        if(s) _doc->set(_key, s, true);
+        else  _doc->set(_key, "null", false);
+    }
+
+    return *this;
+}
+
+/*
+ * Parser and serializer
+ */
+
+static inline const char *hostJsonSkip(const char *p)
+{
+    while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+// String at p (after the quote); NULL if unterminated
+static inline const char *hostJsonStr(const char *p, std::string& out)
+{
+    out.clear();
+    while(*p && *p != '"') {
+        if(*p == '\\') {
+            p++;
+            switch(*p) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case '"': case '\\': case '/': out += *p; break;
+            default: return NULL;
+            }
+            p++;
+        } else {
+            out += *p++;
+        }
+    }
+
+    return *p ? p + 1 : NULL;
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char *in)
+{
+    std::string key, val;
+    const char *p;
+    bool isStr;
+
+    doc.clear();
+    
+    if(!in || !*(p = hostJsonSkip(in)))
+        return DeserializationError::EmptyInput;
+
+    if(*p++ != '{')
+        return DeserializationError::InvalidInput;
+
+    p = hostJsonSkip(p);
+    if(*p == '}')
+        return DeserializationError::Ok;
+
+    for(;;) {
+        if(!*p)
+            return DeserializationError::IncompleteInput;
+        if(*p++ != '"')
+            return DeserializationError::InvalidInput;
+        if(!(p = hostJsonStr(p, key)))
+            return DeserializationError::IncompleteInput;
+        p = hostJsonSkip(p);
+        if(*p++ != ':')
+            return DeserializationError::InvalidInput;
+        p = hostJsonSkip(p);
+
+        if(*p == '"') {
+            if(!(p = hostJsonStr(p + 1, val)))
+                return DeserializationError::IncompleteInput;
+            isStr = true;
+        } else if(*p == '{' || *p == '[') {
+            return DeserializationError::InvalidInput;
+        } else {
+            const char *s = p;
+            while(*p && *p != ',' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+            val.assign(s, p - s);
+            if(val.empty())
+                return DeserializationError::InvalidInput;
+            isStr = false;
+        }
+        doc.set(key.c_str(), val.c_str(), isStr);
+        if(doc.overflowed())
+            return DeserializationError::NoMemory;
+
+        p = hostJsonSkip(p);
+        if(*p == '}')
+            return DeserializationError::Ok;
+        if(!*p)
+            return DeserializationError::IncompleteInput;
+        if(*p++ != ',')
+            return DeserializationError::InvalidInput;
+        p = hostJsonSkip(p);
+    }
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, char *in)
+{
+    return deserializeJson(doc, (const char *)in);
+}
+
+static inline void hostJsonQuote(std::string& out, const std::string& s)
+{
+    out += '"';
+    for(char c : s) {
+        switch(c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:   out += c;
+        }
+    }
+    out += '"';
+}
+
+static inline std::string hostJsonText(const JsonDocument& doc)
+{
+    std::string out = "{";
+    bool first = true;
+
+    for(const hostJsonMember& m : doc.members()) {
+        if(!first) out += ',';
+        first = false;
+        hostJsonQuote(out, m.key);
+        out += ':';
+        if(m.isStr) hostJsonQuote(out, m.val);
+        else        out += m.val;
+    }
+    out += '}';
+
+    return out;
+}
+
+inline size_t measureJson(const JsonDocument& doc)
+{
+    return hostJsonText(doc).length();
+}
+
+// As ArduinoJson: Writes at most size chars, and a terminator 
+// if there is room
+inline size_t serializeJson(const JsonDocument& doc, char *buf, size_t size)
+{
+    std::string t = hostJsonText(doc);
+    size_t n = min(t.length(), size);
+
+    memcpy(buf, t.data(), n);
+    if(n < size) buf[n] = 0;
+
+    return n;
+}
+
+#endif
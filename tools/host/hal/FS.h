@@ -0,0 +1,83 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: File systems, backed by host directories. 
+ * host_fsRoot() sets the base directory; flash FS and SD card
+ * are subdirectories "flash" and "sd". Without a base, neither
+ * mounts.
+ */
+
+#ifndef _HOST_FS_H
+#define _HOST_FS_H
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ       "r"
+#define FILE_WRITE      "w"
+#define FILE_APPEND     "a"
+
+namespace fs {
+
+struct FSImpl {
+    const char *dir;            // Below base
+    bool        mounted;
+};
+
+typedef FSImpl *FSImplPtr;
+
+class File {
+    public:
+        File() { }
+        File(FILE *fp, const char *name);
+
+        operator bool() const  { return !!_fp; }
+        
+        size_t read(uint8_t *buf, size_t len);
+        int    read();
+        int    available();
+        size_t write(const uint8_t *buf, size_t len);
+        size_t write(uint8_t val)   { return write(&val, 1); }
+        bool   seek(uint32_t pos);
+        size_t position();
+        size_t size();
+        void   flush();
+        void   close();
+        const char *name() const;
+
+    private:
+        // Shared by copies, as the ESP32 core's File
+        std::shared_ptr<FILE> _fp;
+        std::shared_ptr<char> _name;
+};
+
+class FS {
+    public:
+        FS(FSImplPtr impl) : _impl(impl) { }
+
+        File open(const char *path, const char *mode = FILE_READ, bool create = false);
+        bool exists(const char *path);
+        bool remove(const char *path);
+        bool rename(const char *from, const char *to);
+        bool mkdir(const char *path);
+        bool rmdir(const char *path);
+
+    protected:
+        FSImplPtr _impl;
+        
+        bool hostPath(const char *path, char *buf, int len);
+};
+
+}
+
+using fs::File;
+using fs::FS;
+
+void host_fsRoot(const char *dir);
+// SD card inserted (default: yes)
+void host_sdPresent(bool present);
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: IPv4 address
+ */
+
+#ifndef _HOST_IPADDRESS_H
+#define _HOST_IPADDRESS_H
+
+#include <Arduino.h>
+
+class IPAddress {
+    public:
+        IPAddress() { }
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { _a[0] = a; _a[1] = b; _a[2] = c; _a[3] = d; }
+
+        bool fromString(const char *s);
+        // No String class on the host: A static buffer
+        const char *toString() const;
+
+        uint8_t  operator[](int i) const  { return _a[i & 3]; }
+        uint8_t& operator[](int i)        { return _a[i & 3]; }
+        bool operator==(const IPAddress& o) const { return !memcmp(_a, o._a, 4); }
+        bool operator!=(const IPAddress& o) const { return !(*this == o); }
+
+    private:
+        uint8_t _a[4] = { 0, 0, 0, 0 };
+};
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Flash FS (see FS.h)
+ */
+
+#ifndef _HOST_LITTLEFS_H
+#define _HOST_LITTLEFS_H
+
+#include <FS.h>
+
+namespace fs {
+
+class LittleFSFS : public FS {
+    public:
+        LittleFSFS();
+        bool   begin(bool formatOnFail = false, const char *basePath = "/littlefs",
+                     uint8_t maxOpenFiles = 10, const char *partitionLabel = "spiffs");
+        void   end();
+        bool   format();
+        size_t totalBytes();
+        size_t usedBytes();
+};
+
+}
+
+extern fs::LittleFSFS LittleFS;
+
+#endif
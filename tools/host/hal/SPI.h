@@ -0,0 +1,25 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: SPI bus (only passed to SD.begin())
+ */
+
+#ifndef _HOST_SPI_H
+#define _HOST_SPI_H
+
+#include <Arduino.h>
+
+#define SS  5
+
+class SPIClass {
+    public:
+        void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) { }
+        void end() { }
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: OTA update. Takes the image and drops it.
+ */
+
+#ifndef _HOST_UPDATE_H
+#define _HOST_UPDATE_H
+
+#include <Arduino.h>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+class UpdateClass {
+    public:
+        bool    begin(size_t size)                  { return true; }
+        size_t  write(uint8_t *buf, size_t len)     { return len; }
+        bool    end(bool evenIfRemaining = false)   { return true; }
+        bool    hasError()                          { return false; }
+        uint8_t getError()                          { return 0; }
+};
+
+extern UpdateClass Update;
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Station on a simulated network. The host code 
+ * connects/disconnects it, receives what the firmware sends,
+ * and sends packets to it (see WiFiUdp.h).
+ */
+
+#ifndef _HOST_WIFI_H
+#define _HOST_WIFI_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <WiFiUdp.h>
+
+typedef enum {
+    WL_IDLE_STATUS    = 0,
+    WL_CONNECTED      = 3,
+    WL_DISCONNECTED   = 6
+} wl_status_t;
+
+class WiFiClass {
+    public:
+        wl_status_t status();
+        IPAddress   localIP();
+        int         hostByName(const char *name, IPAddress& ip);
+};
+
+extern WiFiClass WiFi;
+
+void host_wifiConnect(bool connected, IPAddress ip = IPAddress(192, 168, 1, 2));
+
+// Firmware sent a packet
+void host_udpOnSend(void (*tx)(IPAddress dst, uint16_t port, const uint8_t *buf, int len));
+// Send a packet to the firmware; false if no socket took it
+bool host_udpSend(IPAddress src, IPAddress dst, uint16_t port, const uint8_t *buf, int len);
+// Name for WiFi.hostByName()
+void host_dnsAdd(const char *name, IPAddress ip);
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: UDP sockets on a simulated network (see WiFi.h).
+ * Packets sent by the firmware go to the host's send hook;
+ * packets from the host are queued on the sockets bound to 
+ * their port (and group, for multicast).
+ */
+
+#ifndef _HOST_WIFIUDP_H
+#define _HOST_WIFIUDP_H
+
+#include <IPAddress.h>
+
+#define HOST_UDP_MAXPKT 1472
+#define HOST_UDP_QUEUE  8
+
+class UDP {
+    public:
+        virtual ~UDP() { }
+        virtual uint8_t   begin(uint16_t port) = 0;
+        virtual uint8_t   beginMulticast(IPAddress group, uint16_t port) = 0;
+        virtual int       beginPacket(IPAddress ip, uint16_t port) = 0;
+        virtual size_t    write(const uint8_t *buf, size_t len) = 0;
+        virtual int       endPacket() = 0;
+        virtual int       parsePacket() = 0;
+        virtual int       read(uint8_t *buf, size_t len) = 0;
+        virtual IPAddress remoteIP() = 0;
+        virtual void      stop() = 0;
+};
+
+typedef struct {
+    IPAddress src;
+    uint16_t  len;
+    uint8_t   data[HOST_UDP_MAXPKT];
+} hostUDPPkt;
+
+class WiFiUDP : public UDP {
+    public:
+        ~WiFiUDP();
+        uint8_t   begin(uint16_t port);
+        uint8_t   beginMulticast(IPAddress group, uint16_t port);
+        int       beginPacket(IPAddress ip, uint16_t port);
+        size_t    write(const uint8_t *buf, size_t len);
+        int       endPacket();
+        int       parsePacket();
+        int       read(uint8_t *buf, size_t len);
+        IPAddress remoteIP();
+        void      stop();
+
+        // Host side
+        bool      deliver(IPAddress src, IPAddress dst, uint16_t port, const uint8_t *buf, int len);
+
+    private:
+        uint16_t   _port = 0;
+        bool       _mc = false;
+        IPAddress  _group;
+
+        hostUDPPkt _q[HOST_UDP_QUEUE];
+        int        _qHead = 0, _qNum = 0;
+        hostUDPPkt _cur;            // parsePacket()ed
+        int        _curPos = 0;
+        bool       _haveCur = false;
+
+        IPAddress  _txIP;
+        uint16_t   _txPort = 0;
+        uint8_t    _txBuf[HOST_UDP_MAXPKT];
+        int        _txLen = -1;
+};
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: i2c master. Devices are models attached by the
+ * host code; each transmission is handed to the model at its
+ * address. Addresses without a model NACK. A transmission takes
+ * its time on the bus (9 clocks per byte, address included).
+ */
+
+#ifndef _HOST_WIRE_H
+#define _HOST_WIRE_H
+
+#include <Arduino.h>
+
+#define HOST_I2C_BUF    64
+
+class TwoWire {
+    public:
+        bool    begin(int sda = -1, int scl = -1, uint32_t freq = 0);
+        void    setClock(uint32_t freq);
+        void    beginTransmission(uint8_t addr);
+        size_t  write(uint8_t val);
+        uint8_t endTransmission(bool sendStop = true);
+
+    private:
+        uint32_t _freq = 100000;
+        uint8_t  _addr = 0;
+        uint8_t  _buf[HOST_I2C_BUF];
+        int      _len = 0;
+};
+
+extern TwoWire Wire;
+
+// Model for device at addr: rx() gets each transmission
+void host_i2cAttach(uint8_t addr, void (*rx)(uint8_t addr, const uint8_t *buf, int len));
+
+#endif
@@ -0,0 +1,13 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: ADC (nothing used; included by sid_sa)
+ */
+
+#ifndef _HOST_ADC_H
+#define _HOST_ADC_H
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: I2S receiver. i2s_read() returns what the host's
+ * source generates (silence if none), without waiting.
+ */
+
+#ifndef _HOST_I2S_H
+#define _HOST_I2S_H
+
+#include <Arduino.h>
+
+typedef enum { I2S_NUM_0 = 0, I2S_NUM_1 = 1 } i2s_port_t;
+
+typedef enum {
+    I2S_MODE_MASTER = 1,
+    I2S_MODE_SLAVE  = 2,
+    I2S_MODE_TX     = 4,
+    I2S_MODE_RX     = 8
+} i2s_mode_t;
+
+#define I2S_BITS_PER_SAMPLE_32BIT   32
+#define I2S_CHANNEL_FMT_ONLY_RIGHT  3
+#define I2S_COMM_FORMAT_STAND_MSB   2
+#define I2S_PIN_NO_CHANGE           -1
+
+typedef struct {
+    int bck_io_num;
+    int ws_io_num;
+    int data_out_num;
+    int data_in_num;
+} i2s_pin_config_t;
+
+typedef struct {
+    i2s_mode_t mode;
+    uint32_t   sample_rate;
+    int        bits_per_sample;
+    int        channel_format;
+    int        communication_format;
+    int        intr_alloc_flags;
+    int        dma_buf_count;
+    int        dma_buf_len;
+    bool       use_apll;
+    bool       tx_desc_auto_clear;
+    int        fixed_mclk;
+} i2s_config_t;
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t *cfg, int qsize, void *queue);
+esp_err_t i2s_driver_uninstall(i2s_port_t port);
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t *pins);
+esp_err_t i2s_start(i2s_port_t port);
+esp_err_t i2s_stop(i2s_port_t port);
+esp_err_t i2s_read(i2s_port_t port, void *buf, size_t size, size_t *bytesRead, uint32_t ticks);
+
+// Sample source: Fills n 32-bit samples (data MSB-aligned, as
+// the SPH0645 delivers it); sample rate as installed
+void host_i2sSource(void (*gen)(int32_t *buf, int n, uint32_t rate));
+
+#endif
@@ -0,0 +1,17 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: RTC IO
+ */
+
+#ifndef _HOST_RTC_IO_H
+#define _HOST_RTC_IO_H
+
+#include <esp_sleep.h>
+
+static inline esp_err_t rtc_gpio_deinit(gpio_num_t pin) { return ESP_OK; }
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Core version (as the one the firmware is built with)
+ */
+
+#ifndef _HOST_ESP_ARDUINO_VERSION_H
+#define _HOST_ESP_ARDUINO_VERSION_H
+
+#define ESP_ARDUINO_VERSION_MAJOR   2
+#define ESP_ARDUINO_VERSION_MINOR   0
+#define ESP_ARDUINO_VERSION_PATCH   17
+
+#define ESP_ARDUINO_VERSION_VAL(major, minor, patch) ((major << 16) | (minor << 8) | (patch))
+
+#define ESP_ARDUINO_VERSION \
+    ESP_ARDUINO_VERSION_VAL(ESP_ARDUINO_VERSION_MAJOR, ESP_ARDUINO_VERSION_MINOR, ESP_ARDUINO_VERSION_PATCH)
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Light sleep. The timer wakeup is the only source;
+ * light sleep advances the virtual clock by it.
+ */
+
+#ifndef _HOST_ESP_SLEEP_H
+#define _HOST_ESP_SLEEP_H
+
+#include <Arduino.h>
+
+typedef int gpio_num_t;
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_ALL   = 0,
+    ESP_SLEEP_WAKEUP_EXT0  = 2,
+    ESP_SLEEP_WAKEUP_TIMER = 4
+} esp_sleep_source_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us);
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level);
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t src);
+esp_err_t esp_light_sleep_start();
+
+#endif
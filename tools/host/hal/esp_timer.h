@@ -0,0 +1,20 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: esp_timer (on the virtual clock)
+ */
+
+#ifndef _HOST_ESP_TIMER_H
+#define _HOST_ESP_TIMER_H
+
+#include <Arduino.h>
+
+static inline int64_t esp_timer_get_time()
+{
+    return (int64_t)host_us();
+}
+
+#endif
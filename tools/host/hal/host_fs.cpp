@@ -0,0 +1,317 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Flash FS and SD card in host directories (see FS.h)
+ */
+
+#include <FS.h>
+#include <LittleFS.h>
+#include <SPI.h>
+#include <Update.h>
+#include "src/SD/SD.h"
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+
+static char base[256] = { 0 };
+static bool sdPresent = true;
+
+static fs::FSImpl flashImpl = { "flash", false };
+static fs::FSImpl sdImpl    = { "sd",    false };
+
+fs::LittleFSFS LittleFS;
+fs::SDFS       SD(&sdImpl);
+SPIClass       SPI;
+UpdateClass    Update;
+
+void host_fsRoot(const char *dir)
+{
+    snprintf(base, sizeof(base), "%s", dir);
+}
+
+void host_sdPresent(bool present)
+{
+    sdPresent = present;
+}
+
+static bool mountDir(fs::FSImpl *impl)
+{
+    char path[600];
+
+    if(!*base)
+        return false;
+
+    snprintf(path, sizeof(path), "%s/%s", base, impl->dir);
+    mkdir(base, 0755);
+    mkdir(path, 0755);
+
+    return (impl->mounted = !access(path, W_OK));
+}
+
+static size_t dirBytes(fs::FSImpl *impl)
+{
+    char path[600];
+    struct dirent *de;
+    struct stat st;
+    size_t sum = 0;
+    DIR *d;
+
+    snprintf(path, sizeof(path), "%s/%s", base, impl->dir);
+    if(!impl->mounted || !(d = opendir(path)))
+        return 0;
+
+    while((de = readdir(d))) {
+        snprintf(path, sizeof(path), "%s/%s/%s", base, impl->dir, de->d_name);
+        if(!stat(path, &st) && S_ISREG(st.st_mode))
+            sum += st.st_size;
+    }
+    closedir(d);
+
+    return sum;
+}
+
+/*
+ * File
+ */
+
+namespace fs {
+
+File::File(FILE *fp, const char *name) : _fp(fp, fclose), _name(strdup(name), free)
+{
+}
+
+size_t File::read(uint8_t *buf, size_t len)
+{
+    return _fp ? fread(buf, 1, len, _fp.get()) : 0;
+}
+
+int File::read()
+{
+    return _fp ? fgetc(_fp.get()) : -1;
+}
+
+int File::available()
+{
+    return _fp ? (int)(size() - position()) : 0;
+}
+
+size_t File::write(const uint8_t *buf, size_t len)
+{
+    return _fp ? fwrite(buf, 1, len, _fp.get()) : 0;
+}
+
+bool File::seek(uint32_t pos)
+{
+    return _fp && !fseek(_fp.get(), pos, SEEK_SET);
+}
+
+size_t File::position()
+{
+    return _fp ? ftell(_fp.get()) : 0;
+}
+
+size_t File::size()
+{
+    struct stat st;
+
+    if(!_fp)
+        return 0;
+
+    fflush(_fp.get());
+
+    return fstat(fileno(_fp.get()), &st) ? 0 : st.st_size;
+}
+
+void File::flush()
+{
+    if(_fp) fflush(_fp.get());
+}
+
+void File::close()
+{
+    _fp.reset();
+}
+
+const char *File::name() const
+{
+    return _name ? _name.get() : "";
+}
+
+/*
+ * FS
+ */
+
+bool FS::hostPath(const char *path, char *buf, int len)
+{
+    if(!_impl->mounted || !path || *path != '/' || strstr(path, ".."))
+        return false;
+
+    snprintf(buf, len, "%s/%s%s", base, _impl->dir, path);
+
+    return true;
+}
+
+File FS::open(const char *path, const char *mode, bool create)
+{
+    char hp[300];
+    FILE *fp;
+
+    if(!hostPath(path, hp, sizeof(hp)))
+        return File();
+
+    // Always binary; read as "r", not "r+" as the core
+    if(!(fp = fopen(hp, !strcmp(mode, "r") ? "rb" : !strcmp(mode, "a") ? "ab" : "wb")))
+        return File();
+
+    return File(fp, strrchr(path, '/') + 1);
+}
+
+bool FS::exists(const char *path)
+{
+    char hp[300];
+
+    return hostPath(path, hp, sizeof(hp)) && !access(hp, F_OK);
+}
+
+bool FS::remove(const char *path)
+{
+    char hp[300];
+
+    return hostPath(path, hp, sizeof(hp)) && !unlink(hp);
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+    char hf[300], ht[300];
+
+    return hostPath(from, hf, sizeof(hf)) && hostPath(to, ht, sizeof(ht)) && !::rename(hf, ht);
+}
+
+bool FS::mkdir(const char *path)
+{
+    char hp[300];
+
+    return hostPath(path, hp, sizeof(hp)) && !::mkdir(hp, 0755);
+}
+
+bool FS::rmdir(const char *path)
+{
+    char hp[300];
+
+    return hostPath(path, hp, sizeof(hp)) && !::rmdir(hp);
+}
+
+/*
+ * Flash FS
+ */
+
+LittleFSFS::LittleFSFS() : FS(&flashImpl)
+{
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel)
+{
+    return mountDir(_impl);
+}
+
+void LittleFSFS::end()
+{
+    _impl->mounted = false;
+}
+
+bool LittleFSFS::format()
+{
+    char path[600];
+    struct dirent *de;
+    DIR *d;
+
+    if(!*base)
+        return false;
+
+    snprintf(path, sizeof(path), "%s/%s", base, _impl->dir);
+    if((d = opendir(path))) {
+        while((de = readdir(d))) {
+            snprintf(path, sizeof(path), "%s/%s/%s", base, _impl->dir, de->d_name);
+            unlink(path);
+        }
+        closedir(d);
+    }
+    _impl->mounted = false;
+
+    return true;
+}
+
+size_t LittleFSFS::totalBytes()
+{
+    return 0x160000;
+}
+
+size_t LittleFSFS::usedBytes()
+{
+    return dirBytes(_impl);
+}
+
+/*
+ * SD card
+ */
+
+SDFS::SDFS(FSImplPtr impl) : FS(impl)
+{
+}
+
+bool SDFS::begin(uint8_t ssPin, SPIClass &spi, uint32_t frequency, const char *mountpoint, 
+                 uint8_t max_files, bool format_if_empty)
+{
+    return sdPresent && mountDir(_impl);
+}
+
+void SDFS::end()
+{
+    _impl->mounted = false;
+}
+
+sdcard_type_t SDFS::cardType()
+{
+    return _impl->mounted ? CARD_SDHC : CARD_NONE;
+}
+
+uint64_t SDFS::cardSize()
+{
+    return _impl->mounted ? 4ULL << 30 : 0;
+}
+
+size_t SDFS::numSectors()
+{
+    return cardSize() / 512;
+}
+
+size_t SDFS::sectorSize()
+{
+    return 512;
+}
+
+uint64_t SDFS::totalBytes()
+{
+    return cardSize();
+}
+
+uint64_t SDFS::usedBytes()
+{
+    return dirBytes(_impl);
+}
+
+bool SDFS::readRAW(uint8_t *buffer, uint32_t sector)
+{
+    return false;
+}
+
+bool SDFS::writeRAW(uint8_t *buffer, uint32_t sector)
+{
+    return false;
+}
+
+}
@@ -0,0 +1,376 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Virtual clock and HAL shims (see Arduino.h)
+ */
+
+#include <Arduino.h>
+#include <esp_sleep.h>
+
+#include <stdarg.h>
+#include <malloc.h>
+
+HostSerial Serial;
+
+/*
+ * Virtual clock. Atomic, since "ISR" threads read it.
+ */
+
+static uint64_t hostUs = 0;
+
+uint64_t host_us()
+{
+    return __atomic_load_n(&hostUs, __ATOMIC_ACQUIRE);
+}
+
+void host_setUs(uint64_t us)
+{
+    __atomic_store_n(&hostUs, us, __ATOMIC_RELEASE);
+}
+
+void host_advance(uint64_t us)
+{
+    __atomic_fetch_add(&hostUs, us, __ATOMIC_ACQ_REL);
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(host_us() / 1000);
+}
+
+static void (*microsHook)() = NULL;
+
+void host_onNextMicros(void (*hook)())
+{
+    microsHook = hook;
+}
+
+unsigned long micros()
+{
+    if(microsHook) {
+        void (*hook)() = microsHook;
+        microsHook = NULL;
+        hook();
+    }
+
+    return (unsigned long)host_us();
+}
+
+/*
+ * The other core: A task that runs every intervalUs while the
+ * virtual time passes in delay(), vTaskDelay() or light sleep,
+ * as the main side's waits give it time on the device
+ */
+
+static void     (*coreFunc)() = NULL;
+static uint32_t coreInt = 0;
+static uint64_t coreNext = 0;
+static bool     inCore = false;
+
+void host_coreTask(void (*func)(), uint32_t intervalUs)
+{
+    coreFunc = func;
+    coreInt = intervalUs ? intervalUs : 1;
+    coreNext = host_us();
+}
+
+static void waitUs(uint64_t us)
+{
+    uint64_t end = host_us() + us;
+
+    if(coreFunc && !inCore) {
+        inCore = true;
+        // Time moved on elsewhere (host_advance()): No catching up
+        if(coreNext < host_us()) coreNext = host_us();
+        while(coreNext <= end) {
+            if(host_us() < coreNext) host_setUs(coreNext);
+            coreFunc();
+            coreNext += coreInt;
+        }
+        inCore = false;
+    }
+    
+    if(host_us() < end) host_setUs(end);
+}
+
+void delay(unsigned long ms)
+{
+    waitUs((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    waitUs(us);
+}
+
+void yield()
+{
+}
+
+void vTaskDelay(uint32_t ticks)
+{
+    delay(ticks);       // 1 tick = 1ms
+}
+
+/*
+ * CPU clock and cycle counter
+ */
+
+HostESP ESP;
+
+static uint32_t cpuMHz = 240;
+static uint32_t cycBase = 0;
+static uint64_t cycBaseUs = 0;
+
+uint32_t HostESP::getCycleCount()
+{
+    return cycBase + (uint32_t)((host_us() - cycBaseUs) * cpuMHz);
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+    return cpuMHz;
+}
+
+bool setCpuFrequencyMhz(uint32_t mhz)
+{
+    // Cycles counted so far stay, the rate changes from now on
+    cycBase = ESP.getCycleCount();
+    cycBaseUs = host_us();
+    cpuMHz = mhz;
+
+    return true;
+}
+
+/*
+ * Heap: What the device has free after boot, less what has been
+ * allocated on the host
+ */
+
+#define HOST_HEAP_SIZE  (180 * 1024)
+
+uint32_t HostESP::getFreeHeap()
+{
+    size_t used = mallinfo2().uordblks;
+
+    return (used < HOST_HEAP_SIZE) ? HOST_HEAP_SIZE - used : 0;
+}
+
+void HostESP::restart()
+{
+    esp_restart();
+}
+
+void esp_restart()
+{
+    printf("esp_restart() at %lums\n", millis());
+    fflush(stdout);
+    exit(3);
+}
+
+/*
+ * GPIO and pin interrupts
+ */
+
+typedef struct {
+    int  level;
+    int  mode;
+    void (*isr)(void);
+    void (*isrArg)(void *);
+    void *arg;
+} hostPin;
+
+static hostPin pins[HOST_NUMPINS];
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if(pin >= HOST_NUMPINS) return;
+
+    // Idle level of pulled-up inputs is HIGH
+    if(mode == INPUT_PULLUP) pins[pin].level = HIGH;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return (pin < HOST_NUMPINS) ? __atomic_load_n(&pins[pin].level, __ATOMIC_ACQUIRE) : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if(pin < HOST_NUMPINS) __atomic_store_n(&pins[pin].level, val ? HIGH : LOW, __ATOMIC_RELEASE);
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode)
+{
+    if(pin >= HOST_NUMPINS) return;
+
+    pins[pin].isr = isr;
+    pins[pin].isrArg = NULL;
+    pins[pin].mode = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode)
+{
+    if(pin >= HOST_NUMPINS) return;
+
+    pins[pin].isr = NULL;
+    pins[pin].isrArg = isr;
+    pins[pin].arg = arg;
+    pins[pin].mode = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    if(pin >= HOST_NUMPINS) return;
+
+    pins[pin].isr = NULL;
+    pins[pin].isrArg = NULL;
+}
+
+void host_setPin(uint8_t pin, int level)
+{
+    hostPin *p;
+    int old;
+
+    if(pin >= HOST_NUMPINS) return;
+
+    p = &pins[pin];
+    level = level ? HIGH : LOW;
+    old = __atomic_exchange_n(&p->level, level, __ATOMIC_ACQ_REL);
+
+    if(old == level)
+        return;
+
+    if(p->mode == CHANGE || (p->mode == RISING && level) || (p->mode == FALLING && !level)) {
+        if(p->isr)    p->isr();
+        if(p->isrArg) p->isrArg(p->arg);
+    }
+}
+
+/*
+ * Light sleep: Until the timer wakes up
+ */
+
+static uint64_t sleepUs = 0;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us)
+{
+    sleepUs = us;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t pin, int level)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t src)
+{
+    if(src == ESP_SLEEP_WAKEUP_ALL || src == ESP_SLEEP_WAKEUP_TIMER)
+        sleepUs = 0;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start()
+{
+    waitUs(sleepUs);
+
+    return ESP_OK;
+}
+
+/*
+ * Hardware timers
+ */
+
+#define HOST_NUMTIMERS 4
+
+struct hw_timer_s {
+    void (*isr)(void);
+    bool enabled;
+};
+
+static hw_timer_t timers[HOST_NUMTIMERS];
+
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp)
+{
+    return (num < HOST_NUMTIMERS) ? &timers[num] : NULL;
+}
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*isr)(void), bool edge)
+{
+    if(timer) timer->isr = isr;
+}
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm, bool autoreload)
+{
+}
+
+void timerAlarmEnable(hw_timer_t *timer)
+{
+    if(timer) timer->enabled = true;
+}
+
+void timerAlarmDisable(hw_timer_t *timer)
+{
+    if(timer) timer->enabled = false;
+}
+
+void host_timerTick(uint8_t num)
+{
+    if(num < HOST_NUMTIMERS && timers[num].enabled && timers[num].isr) {
+        timers[num].isr();
+    }
+}
+
+/*
+ * Critical sections
+ */
+
+void portENTER_CRITICAL(portMUX_TYPE *mux)
+{
+    while(__atomic_exchange_n(&mux->lock, 1, __ATOMIC_ACQUIRE)) { }
+}
+
+void portEXIT_CRITICAL(portMUX_TYPE *mux)
+{
+    __atomic_store_n(&mux->lock, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Random: xorshift32, seedable for reproducible runs
+ */
+
+static uint32_t rndState = 0x12345678;
+
+void host_seed(uint32_t seed)
+{
+    rndState = seed ? seed : 0x12345678;
+}
+
+uint32_t esp_random()
+{
+    uint32_t x = rndState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return (rndState = x);
+}
+
+size_t HostSerial::printf(const char *fmt, ...)
+{
+    va_list ap;
+    int r;
+
+    va_start(ap, fmt);
+    r = vprintf(fmt, ap);
+    va_end(ap);
+
+    return (r > 0) ? r : 0;
+}
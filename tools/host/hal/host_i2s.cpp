@@ -0,0 +1,75 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: I2S receiver (see driver/i2s.h)
+ */
+
+#include <driver/i2s.h>
+
+static bool     installed = false;
+static bool     running = false;
+static uint32_t rate = 0;
+
+static void (*source)(int32_t *buf, int n, uint32_t rate) = NULL;
+
+void host_i2sSource(void (*gen)(int32_t *buf, int n, uint32_t rate))
+{
+    source = gen;
+}
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t *cfg, int qsize, void *queue)
+{
+    if(installed)
+        return ESP_FAIL;
+
+    installed = running = true;
+    rate = cfg->sample_rate;
+
+    return ESP_OK;
+}
+
+esp_err_t i2s_driver_uninstall(i2s_port_t port)
+{
+    installed = running = false;
+
+    return ESP_OK;
+}
+
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t *pins)
+{
+    return installed ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2s_start(i2s_port_t port)
+{
+    running = installed;
+
+    return installed ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2s_stop(i2s_port_t port)
+{
+    running = false;
+
+    return installed ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2s_read(i2s_port_t port, void *buf, size_t size, size_t *bytesRead, uint32_t ticks)
+{
+    *bytesRead = 0;
+
+    if(!running)
+        return ESP_FAIL;
+
+    if(source) {
+        source((int32_t *)buf, size / 4, rate);
+    } else {
+        memset(buf, 0, size);
+    }
+    *bytesRead = size & ~3;
+
+    return ESP_OK;
+}
@@ -0,0 +1,250 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Simulated network (see WiFi.h, WiFiUdp.h)
+ */
+
+#include <WiFi.h>
+
+WiFiClass WiFi;
+
+static bool      connected = false;
+static IPAddress myIP;
+
+#define MAX_SOCKS   8
+#define MAX_NAMES   4
+
+static WiFiUDP *socks[MAX_SOCKS];
+
+static void (*txHook)(IPAddress dst, uint16_t port, const uint8_t *buf, int len) = NULL;
+
+static struct {
+    char      name[64];
+    IPAddress ip;
+} names[MAX_NAMES];
+
+/*
+ * IPAddress
+ */
+
+bool IPAddress::fromString(const char *s)
+{
+    unsigned int a, b, c, d;
+    char x;
+
+    if(sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &x) != 4 ||
+       a > 255 || b > 255 || c > 255 || d > 255)
+        return false;
+
+    _a[0] = a; _a[1] = b; _a[2] = c; _a[3] = d;
+
+    return true;
+}
+
+const char *IPAddress::toString() const
+{
+    static char buf[16];
+
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _a[0], _a[1], _a[2], _a[3]);
+
+    return buf;
+}
+
+/*
+ * WiFi
+ */
+
+wl_status_t WiFiClass::status()
+{
+    return connected ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP()
+{
+    return connected ? myIP : IPAddress();
+}
+
+int WiFiClass::hostByName(const char *name, IPAddress& ip)
+{
+    for(int i = 0; i < MAX_NAMES; i++) {
+        if(!strcmp(names[i].name, name)) {
+            ip = names[i].ip;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void host_wifiConnect(bool conn, IPAddress ip)
+{
+    connected = conn;
+    myIP = ip;
+}
+
+void host_dnsAdd(const char *name, IPAddress ip)
+{
+    for(int i = 0; i < MAX_NAMES; i++) {
+        if(!*names[i].name) {
+            snprintf(names[i].name, sizeof(names[i].name), "%s", name);
+            names[i].ip = ip;
+            return;
+        }
+    }
+}
+
+void host_udpOnSend(void (*tx)(IPAddress dst, uint16_t port, const uint8_t *buf, int len))
+{
+    txHook = tx;
+}
+
+bool host_udpSend(IPAddress src, IPAddress dst, uint16_t port, const uint8_t *buf, int len)
+{
+    bool taken = false;
+
+    if(!connected)
+        return false;
+
+    for(int i = 0; i < MAX_SOCKS; i++) {
+        if(socks[i] && socks[i]->deliver(src, dst, port, buf, len))
+            taken = true;
+    }
+
+    return taken;
+}
+
+/*
+ * UDP sockets
+ */
+
+static void addSock(WiFiUDP *s)
+{
+    int fr = -1;
+
+    for(int i = 0; i < MAX_SOCKS; i++) {
+        if(socks[i] == s) return;
+        if(!socks[i] && fr < 0) fr = i;
+    }
+    if(fr >= 0) socks[fr] = s;
+}
+
+WiFiUDP::~WiFiUDP()
+{
+    stop();
+}
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+    _port = port;
+    _mc = false;
+    _qNum = 0;
+    addSock(this);
+
+    return 1;
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress group, uint16_t port)
+{
+    begin(port);
+    _mc = true;
+    _group = group;
+
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    for(int i = 0; i < MAX_SOCKS; i++) {
+        if(socks[i] == this) socks[i] = NULL;
+    }
+    _port = 0;
+    _qNum = 0;
+    _haveCur = false;
+}
+
+bool WiFiUDP::deliver(IPAddress src, IPAddress dst, uint16_t port, const uint8_t *buf, int len)
+{
+    if(!_port || port != _port || (_mc ? (dst != _group) : (dst != myIP)))
+        return false;
+
+    // Full queue drops, like the stack does
+    if(_qNum >= HOST_UDP_QUEUE || len > HOST_UDP_MAXPKT)
+        return true;
+
+    hostUDPPkt *p = &_q[(_qHead + _qNum++) % HOST_UDP_QUEUE];
+    p->src = src;
+    p->len = len;
+    memcpy(p->data, buf, len);
+
+    return true;
+}
+
+int WiFiUDP::parsePacket()
+{
+    _haveCur = false;
+    
+    if(!_qNum)
+        return 0;
+
+    _cur = _q[_qHead];
+    _qHead = (_qHead + 1) % HOST_UDP_QUEUE;
+    _qNum--;
+    _curPos = 0;
+    _haveCur = true;
+
+    return _cur.len;
+}
+
+int WiFiUDP::read(uint8_t *buf, size_t len)
+{
+    if(!_haveCur)
+        return 0;
+
+    int n = min((int)len, _cur.len - _curPos);
+    memcpy(buf, _cur.data + _curPos, n);
+    _curPos += n;
+
+    return n;
+}
+
+IPAddress WiFiUDP::remoteIP()
+{
+    return _haveCur ? _cur.src : IPAddress();
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    _txIP = ip;
+    _txPort = port;
+    _txLen = 0;
+
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t *buf, size_t len)
+{
+    if(_txLen < 0)
+        return 0;
+
+    len = min(len, (size_t)(HOST_UDP_MAXPKT - _txLen));
+    memcpy(_txBuf + _txLen, buf, len);
+    _txLen += len;
+
+    return len;
+}
+
+int WiFiUDP::endPacket()
+{
+    if(_txLen < 0)
+        return 0;
+
+    if(connected && txHook) {
+        txHook(_txIP, _txPort, _txBuf, _txLen);
+    }
+    _txLen = -1;
+
+    return connected ? 1 : 0;
+}
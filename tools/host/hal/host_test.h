@@ -0,0 +1,30 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Checks for the host tests
+ *
+ * CHECK(cond, fmt, ...) prints and counts a failure if cond is
+ * false; host_result() prints the verdict and returns the exit
+ * status for main().
+ */
+
+#ifndef _HOST_TEST_H
+#define _HOST_TEST_H
+
+#include <stdio.h>
+
+static int fails = 0;
+
+#define CHECK(c, ...) do { if(!(c)) { fails++; printf("FAIL: " __VA_ARGS__); printf("\n"); } } while(0)
+
+static inline int host_result()
+{
+    printf("%s\n", fails ? "FAILED" : "OK");
+
+    return fails ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: i2c master (see Wire.h)
+ */
+
+#include <Wire.h>
+
+TwoWire Wire;
+
+static void (*devs[128])(uint8_t addr, const uint8_t *buf, int len);
+
+void host_i2cAttach(uint8_t addr, void (*rx)(uint8_t addr, const uint8_t *buf, int len))
+{
+    devs[addr & 0x7f] = rx;
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t freq)
+{
+    if(freq) _freq = freq;
+
+    return true;
+}
+
+void TwoWire::setClock(uint32_t freq)
+{
+    if(freq) _freq = freq;
+}
+
+void TwoWire::beginTransmission(uint8_t addr)
+{
+    _addr = addr & 0x7f;
+    _len = 0;
+}
+
+size_t TwoWire::write(uint8_t val)
+{
+    if(_len >= HOST_I2C_BUF)
+        return 0;
+
+    _buf[_len++] = val;
+
+    return 1;
+}
+
+// 0: ACK, 2: NACK on address (as the ESP32 core)
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    host_advance((uint64_t)(1 + _len) * 9 * 1000000 / _freq);
+
+    if(!devs[_addr])
+        return 2;
+
+    devs[_addr](_addr, _buf, _len);
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: I2S registers (writes are dropped)
+ */
+
+#ifndef _HOST_I2S_REG_H
+#define _HOST_I2S_REG_H
+
+#define I2S_TIMING_REG(p)   (p)
+#define I2S_CONF_REG(p)     (p)
+#define I2S_RX_MSB_SHIFT    (1 << 9)
+
+#define REG_SET_BIT(r, b)   do { (void)(r); (void)(b); } while(0)
+
+#endif
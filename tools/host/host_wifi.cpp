@@ -0,0 +1,118 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Stand-in for sid_wifi.cpp (WiFiManager, Config
+ * Portal, MQTT are not built on the host). The station is 
+ * connected or not as the host sets it up (host_wifiConnect());
+ * WiFi is never switched off, so there is no power save, AP 
+ * mode or Config Portal. Config Portal values and car mode 
+ * changes are recorded for the host to check.
+ */
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "sid_settings.h"
+#include "sid_wifi.h"
+#include "host_wifi.h"
+
+Settings settings;
+
+IPSettings ipsettings;
+
+bool wifiSetupDone = false;
+bool wifiIsOff     = false;
+bool wifiAPIsOff   = false;
+bool wifiInAPMode  = false;
+bool carMode       = false;
+
+hostCPValues hostCP;
+
+void wifi_setup()
+{
+    wifiSetupDone = true;
+}
+
+void wifi_loop()
+{
+}
+
+void wifiOn(unsigned long newDelay, bool alsoInAPMode, bool deferConfigPortal)
+{
+    hostCP.wifiOnCnt++;
+}
+
+bool wifiOnWillBlock()
+{
+    return WiFi.status() != WL_CONNECTED;
+}
+
+void wifiStartCP()
+{
+}
+
+bool updateAvailable()
+{
+    return false;
+}
+
+void updateConfigPortalStrictValue(bool strict)
+{
+    hostCP.strict = strict;
+    hostCP.updates++;
+}
+
+void updateConfigPortalSAValues(int mode, bool peaks, bool mirror)
+{
+    hostCP.saMode = mode;
+    hostCP.saPeaks = peaks;
+    hostCP.saMirror = mirror;
+    hostCP.updates++;
+}
+
+void updateConfigPortalIRFBValues(bool posFB, bool cmdFB)
+{
+    hostCP.posFB = posFB;
+    hostCP.cmdFB = cmdFB;
+    hostCP.updates++;
+}
+
+// The firmware saves and reboots
+void wifiSetCarMode(bool enable)
+{
+    hostCP.carMode = enable;
+    hostCP.carModeSet++;
+}
+
+bool wifi_getIP(uint8_t& a, uint8_t& b, uint8_t& c, uint8_t& d)
+{
+    IPAddress ip = WiFi.localIP();
+
+    a = ip[0];
+    b = ip[1];
+    c = ip[2];
+    d = ip[3];
+
+    return true;
+}
+
+bool isIp(char *str)
+{
+    IPAddress ip;
+
+    return ip.fromString(str);
+}
+
+bool checkIPConfig()
+{
+    return (*ipsettings.ip            &&
+            isIp(ipsettings.ip)       &&
+            isIp(ipsettings.gateway)  &&
+            isIp(ipsettings.netmask)  &&
+            isIp(ipsettings.dns));
+}
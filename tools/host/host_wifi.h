@@ -0,0 +1,26 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: What the sid_wifi stand-in recorded
+ */
+
+#ifndef _HOST_WIFI_STANDIN_H
+#define _HOST_WIFI_STANDIN_H
+
+typedef struct {
+    int  updates;               // Config Portal value updates
+    bool strict;
+    int  saMode;
+    bool saPeaks, saMirror;
+    bool posFB, cmdFB;
+    int  carModeSet;            // wifiSetCarMode() calls
+    bool carMode;
+    int  wifiOnCnt;
+} hostCPValues;
+
+extern hostCPValues hostCP;
+
+#endif
@@ -0,0 +1,304 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: Synthetic IR signals and timing fixtures for the
+ * IR tests and irreplay
+ *
+ * Frames are lists of durations in us: mark, space, mark, ...,
+ * ending with a mark (the final space is part of the next gap),
+ * as recorded by input.cpp without the leading gap.
+ *
+ * irSend() plays a frame into input.cpp through the HAL: Pin
+ * edges at the exact times (edge capture), and, if a timer is
+ * given, that timer's ISR every 50us in between (timer capture).
+ *
+ * Fixture files (fixtures/ir/): One frame per line,
+ *   <gap> <code> <mark> <space> <mark> ... <mark>
+ * gap: us from the end of the previous frame; code: the code
+ * (hex) input.cpp must decode, with "r" appended if it must be
+ * recognized as a repeat, or "-" if it must not decode. Lines
+ * starting with # are comments.
+ */
+
+#ifndef _HOST_IRGEN_H
+#define _HOST_IRGEN_H
+
+#include <Arduino.h>
+#include <vector>
+
+#include "input.h"
+#include "sid_prng.h"
+
+typedef std::vector<uint32_t> irFrame;
+
+// Receiver output: LOW while light is seen
+#define IRGEN_LIGHT     LOW
+#define IRGEN_DARK      HIGH
+
+#define IRGEN_TICK      50      // Timer capture interval (us)
+
+/*
+ * Protocol encoders, and the codes input.cpp should make of them
+ */
+
+static inline void irPulse(irFrame& f, uint32_t mark, uint32_t space)
+{
+    f.push_back(mark);
+    f.push_back(space);
+}
+
+// NEC: 8 bits address, inverted, 8 bits command, inverted; LSB first
+static inline irFrame irNEC(uint8_t addr, uint8_t cmd)
+{
+    uint32_t data = addr | ((uint8_t)~addr << 8) | (cmd << 16) | ((uint32_t)(uint8_t)~cmd << 24);
+    irFrame f;
+
+    irPulse(f, 9000, 4500);
+    for(int b = 0; b < 32; b++) {
+        irPulse(f, 560, ((data >> b) & 1) ? 1690 : 560);
+    }
+    f.push_back(560);
+
+    return f;
+}
+
+static inline irFrame irNECRepeat()
+{
+    return irFrame { 9000, 2250, 560 };
+}
+
+// Sony SIRC: 7 bits command, then 5 (12 bit), 8 (15 bit) or
+// 13 (20 bit) bits address; LSB first
+static inline irFrame irSony(uint16_t addr, uint8_t cmd, int bits = 12)
+{
+    uint32_t data = (cmd & 0x7f) | ((uint32_t)addr << 7);
+    irFrame f;
+
+    irPulse(f, 2400, 600);
+    for(int b = 0; b < bits; b++) {
+        irPulse(f, ((data >> b) & 1) ? 1200 : 600, 600);
+    }
+    f.pop_back();
+
+    return f;
+}
+
+// Half-bit levels (1 = light) to durations; leading
+// and trailing dark half-bits are part of the gaps
+static inline irFrame irHalves(const std::vector<uint8_t>& h, uint32_t t)
+{
+    irFrame f;
+    size_t i = 0;
+    int cur = -1;
+
+    while(i < h.size() && !h[i]) i++;
+
+    for(; i < h.size(); i++) {
+        if(h[i] == cur) {
+            f.back() += t;
+        } else {
+            f.push_back(t);
+            cur = h[i];
+        }
+    }
+    if(cur == 0) f.pop_back();
+
+    return f;
+}
+
+// RC5: S1, S2 (inverted bit 6 of command), toggle, 5 bits
+// address, 6 bits command; MSB first, 1 = space-mark
+static inline irFrame irRC5(bool toggle, uint8_t addr, uint8_t cmd)
+{
+    uint32_t data = (1 << 13) | ((cmd & 0x40) ? 0 : (1 << 12)) | (toggle << 11) |
+                    ((addr & 0x1f) << 6) | (cmd & 0x3f);
+    std::vector<uint8_t> h;
+
+    for(int b = 13; b >= 0; b--) {
+        int bit = (data >> b) & 1;
+        h.push_back(!bit);
+        h.push_back(bit);
+    }
+
+    return irHalves(h, 889);
+}
+
+// RC6 mode 0: Header, start bit (1), 3 bits mode, toggle (double
+// length), 8 bits address, 8 bits command; MSB first, 1 = mark-space
+static inline irFrame irRC6(bool toggle, uint8_t addr, uint8_t cmd)
+{
+    uint32_t data = (1 << 20) | (toggle << 16) | (addr << 8) | cmd;
+    std::vector<uint8_t> h;
+    irFrame f { 2666, 889 }, r;
+
+    for(int b = 20; b >= 0; b--) {
+        int bit = (data >> b) & 1;
+        int w = (b == 16) ? 2 : 1;
+        for(int k = 0; k < w; k++) h.push_back(bit);
+        for(int k = 0; k < w; k++) h.push_back(!bit);
+    }
+
+    r = irHalves(h, 444);
+    f.insert(f.end(), r.begin(), r.end());
+
+    return f;
+}
+
+static inline uint32_t irCodeNEC(uint8_t addr, uint8_t cmd)    { return IRCODE(IRPROTO_NEC, addr, cmd); }
+static inline uint32_t irCodeSony(uint16_t addr, uint8_t cmd)  { return IRCODE(IRPROTO_SONY, addr, cmd & 0x7f); }
+static inline uint32_t irCodeRC5(uint8_t addr, uint8_t cmd)    { return IRCODE(IRPROTO_RC5, addr & 0x1f, cmd & 0x7f); }
+static inline uint32_t irCodeRC6(uint8_t addr, uint8_t cmd)    { return IRCODE(IRPROTO_RC6, addr, cmd); }
+
+/*
+ * Receiver-like distortion: Demodulating receivers stretch marks
+ * (and shorten the following space by as much), plus jitter of
+ * up to +/-jitter us per edge. Durations stay >= 50us.
+ */
+static inline irFrame irDistort(const irFrame& in, sidPRNG& rng, int32_t stretch, int32_t jitter)
+{
+    irFrame f(in);
+    int32_t prev = 0;
+
+    for(size_t i = 0; i < f.size(); i++) {
+        int32_t edge = jitter ? rng.range(-jitter, jitter) : 0;
+        int32_t d = (int32_t)f[i] + edge - prev + ((i & 1) ? -stretch : stretch);
+        f[i] = (d < 50) ? 50 : d;
+        prev = edge;
+    }
+
+    return f;
+}
+
+/*
+ * Fixtures
+ */
+
+typedef struct {
+    uint32_t gap;
+    uint32_t code;              // 0: must not decode
+    bool     repeat;
+    irFrame  f;
+} irFixture;
+
+static inline bool irReadFixtures(const char *fn, std::vector<irFixture>& fx)
+{
+    FILE *fp = fopen(fn, "r");
+    char line[2048];
+
+    if(!fp) return false;
+
+    while(fgets(line, sizeof(line), fp)) {
+        irFixture x = { 0, 0, false };
+        char *p = line, *e;
+
+        if(*p == '#' || *p == '\n' || !*p) continue;
+
+        x.gap = strtoul(p, &e, 10);
+        p = e + strspn(e, " \t");
+        if(*p == '-') {
+            p++;
+        } else {
+            x.code = strtoul(p, &e, 16);
+            p = e;
+            if(*p == 'r') {
+                x.repeat = true;
+                p++;
+            }
+        }
+        for(;;) {
+            uint32_t d = strtoul(p, &e, 10);
+            if(e == p) break;
+            x.f.push_back(d);
+            p = e;
+        }
+        fx.push_back(x);
+    }
+
+    fclose(fp);
+
+    return true;
+}
+
+static inline void irWriteFixture(FILE *fp, const irFixture& x)
+{
+    if(x.code) {
+        fprintf(fp, "%u %08x%s", x.gap, x.code, x.repeat ? "r" : "");
+    } else {
+        fprintf(fp, "%u -", x.gap);
+    }
+    for(uint32_t d : x.f) {
+        fprintf(fp, " %u", d);
+    }
+    fprintf(fp, "\n");
+}
+
+/*
+ * Playback through the HAL
+ */
+
+typedef struct {
+    uint8_t  pin;
+    int      timer;             // Timer to tick, -1 if none
+    uint64_t nextTick;
+} irPlayer;
+
+static inline void irPlayerInit(irPlayer& p, uint8_t pin, int timer)
+{
+    p.pin = pin;
+    p.timer = timer;
+    p.nextTick = host_us();
+    host_setPin(pin, IRGEN_DARK);
+}
+
+// Move virtual time to t, ticking the timer on the way
+static inline void irAdvanceTo(irPlayer& p, uint64_t t)
+{
+    if(p.timer >= 0) {
+        while(p.nextTick <= t) {
+            host_setUs(p.nextTick);
+            host_timerTick(p.timer);
+            p.nextTick += IRGEN_TICK;
+        }
+    }
+    host_setUs(t);
+}
+
+// Play a frame, starting now, ending dark
+static inline void irSend(irPlayer& p, const irFrame& f)
+{
+    uint64_t t = host_us();
+
+    for(size_t i = 0; i < f.size(); i++) {
+        irAdvanceTo(p, t);
+        host_setPin(p.pin, (i & 1) ? IRGEN_DARK : IRGEN_LIGHT);
+        t += f[i];
+    }
+    irAdvanceTo(p, t);
+    host_setPin(p.pin, IRGEN_DARK);
+}
+
+static inline void irIdle(irPlayer& p, uint32_t us)
+{
+    irAdvanceTo(p, host_us() + us);
+}
+
+// Play a frame gap us after the previous one into an (edge
+// capture, tracing) IRRemote; fetch its trace record
+static inline bool irPlay(IRRemote& ir, irPlayer& p, uint32_t gap, const irFrame& f, IRTraceRec& rec)
+{
+    uint32_t lost;
+
+    irIdle(p, (gap > 6000) ? gap - 6000 : 0);
+    irSend(p, f);
+    irIdle(p, 6000);
+    for(int i = 0; i < 3; i++) {
+        ir.loop();
+    }
+
+    return ir.readTrace(rec, lost);
+}
+
+#endif
@@ -0,0 +1,348 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * irreplay: Replay IR timing traces through the firmware's IR code
+ * (input.cpp: edge capture, decoders, hash) and fuzz them
+ *
+ * Usage: irreplay [options] file...
+ *
+ *   file       IR timing trace as written to SD by *993
+ *              (sidirtrace.bin), or a fixture file (fixtures/ir)
+ *   -n runs    Fuzz runs per frame (default 100)
+ *   -j us      Max jitter per edge (default 40)
+ *   -s us      Max mark stretch (default 100)
+ *   -g pct     Glitches: Percentage of fuzzed frames in which a
+ *              mark or space is split by a 50-150us spike (default 0)
+ *   -r seed    Random seed
+ *   -H         Hash only: Judge frames by their hash, as for remotes
+ *              the decoders don't know
+ *   -o file    Write the clean replay as trace file
+ *   -v         Results per key
+ *
+ * Every frame is first replayed as recorded ("clean"), on its own
+ * (250ms apart, so repeat detection doesn't come into play). Frames
+ * giving the same code (or, without a code, the same hash) form a
+ * key. For traces, the clean result is compared to the one recorded
+ * on the device (except for repeats, which depend on the preceding
+ * frame), for fixtures to the expected code.
+ *
+ * Then each frame is replayed with random jitter, mark stretch and
+ * glitches; the result is
+ *   ok         the same code/hash as its clean replay,
+ *   miss       no code/hash, or one no key has: Press is ignored,
+ *   wrong      the code/hash of another key: A collision, the wrong
+ *              key is triggered.
+ *
+ * Trace files are read as little endian, as the ESP32 writes them.
+ * Exit status is 2 if a clean replay differs from the recorded or
+ * expected result, 1 on errors.
+ */
+
+#include <Arduino.h>
+#include <map>
+#include <unistd.h>
+
+#include "irgen.h"
+
+#define IR_PIN      13
+#define IR_TIMER    0
+
+#define RP_GAP      250000
+
+typedef struct {
+    irFrame  f;
+    const char *file;
+    bool     haveRef;           // Reference result to compare clean replay to
+    bool     refByCode;
+    uint32_t ref;
+    bool     result;            // Clean replay gave a code/hash
+    bool     byCode;
+    uint32_t key;
+    uint32_t runs, ok, miss, wrong;
+} rpFrame;
+
+static IRRemote ir(IR_TIMER, IR_PIN);
+static irPlayer pl;
+static sidPRNG  rng;
+
+static bool hashOnly = false;
+
+// Code, or hash, of a replayed frame
+static bool result(const IRTraceRec& rec, bool& byCode, uint32_t& val)
+{
+    if(!hashOnly && (rec.flags & IRTR_CODE)) {
+        byCode = true;
+        val = rec.code;
+        return true;
+    }
+    if(rec.flags & IRTR_HASH) {
+        byCode = false;
+        val = rec.hash;
+        return true;
+    }
+
+    return false;
+}
+
+static bool readBin(const char *fn, std::vector<rpFrame>& v)
+{
+    FILE *fp = fopen(fn, "rb");
+    const size_t hdr = sizeof(IRTraceRec) - sizeof(((IRTraceRec *)0)->dur);
+    char magic[8];
+    int skipped = 0;
+
+    if(!fp) return false;
+
+    if(fread(magic, 1, 8, fp) != 8 || memcmp(magic, "SIDIRTR1", 8)) {
+        fclose(fp);
+        return false;
+    }
+
+    for(;;) {
+        IRTraceRec rec;
+        rpFrame x = { };
+
+        if(fread(&rec, 1, hdr, fp) != hdr)
+            break;
+        if(rec.len > IRBUFSIZE || fread(rec.dur, sizeof(rec.dur[0]), rec.len, fp) != rec.len) {
+            printf("%s: truncated record\n", fn);
+            break;
+        }
+
+        // dur[0] is the gap before the frame
+        if(rec.len < 2) {
+            skipped++;
+            continue;
+        }
+        for(int i = 1; i < rec.len; i++) {
+            x.f.push_back(rec.dur[i]);
+        }
+
+        x.file = fn;
+        if(!(rec.flags & IRTR_REPEAT)) {
+            x.haveRef = result(rec, x.refByCode, x.ref);
+        }
+        v.push_back(x);
+    }
+
+    if(skipped) printf("%s: %d empty records skipped\n", fn, skipped);
+
+    fclose(fp);
+
+    return true;
+}
+
+static bool readTxt(const char *fn, std::vector<rpFrame>& v)
+{
+    std::vector<irFixture> fx;
+
+    if(!irReadFixtures(fn, fx))
+        return false;
+
+    for(auto& i : fx) {
+        rpFrame x = { };
+        x.f = i.f;
+        x.file = fn;
+        // Expected code; hashes aren't given in fixtures
+        x.haveRef = !hashOnly && i.code && !i.repeat;
+        x.refByCode = true;
+        x.ref = i.code;
+        v.push_back(x);
+    }
+
+    return true;
+}
+
+static uint64_t keyId(bool byCode, uint32_t val)
+{
+    return ((uint64_t)byCode << 32) | val;
+}
+
+// Split a mark or space by a short spike of the other level
+static void glitch(irFrame& f)
+{
+    for(int t = 0; t < 5; t++) {
+        int i = rng.below(f.size());
+        uint32_t g = 50 + rng.below(101);
+        if(f[i] < g + 100)
+            continue;
+        uint32_t a = 50 + rng.below(f[i] - g - 99);
+        uint32_t b = f[i] - g - a;
+        f[i] = a;
+        f.insert(f.begin() + i + 1, { g, b });
+        return;
+    }
+}
+
+static void usage()
+{
+    printf("Usage: irreplay [-n runs] [-j jitter] [-s stretch] [-g glitch%%] [-r seed] [-H] [-o out.bin] [-v] file...\n");
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<rpFrame> frames;
+    std::map<uint64_t, int> keys;
+    int runs = 100, jitter = 40, stretch = 100, glitches = 0;
+    const char *outFn = NULL;
+    bool verbose = false;
+    int opt;
+
+    rng.seed(0x19551112);
+
+    while((opt = getopt(argc, argv, "n:j:s:g:r:Ho:v")) != -1) {
+        switch(opt) {
+        case 'n': runs = atoi(optarg);      break;
+        case 'j': jitter = atoi(optarg);    break;
+        case 's': stretch = atoi(optarg);   break;
+        case 'g': glitches = atoi(optarg);  break;
+        case 'r': rng.seed(strtoul(optarg, NULL, 0)); break;
+        case 'H': hashOnly = true;          break;
+        case 'o': outFn = optarg;           break;
+        case 'v': verbose = true;           break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if(optind >= argc) {
+        usage();
+        return 1;
+    }
+
+    for(int i = optind; i < argc; i++) {
+        const char *ext = strrchr(argv[i], '.');
+        bool ok = (ext && !strcmp(ext, ".txt")) ? readTxt(argv[i], frames) : readBin(argv[i], frames);
+        if(!ok) {
+            printf("Can't read %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    host_setUs(1000000);
+    irPlayerInit(pl, IR_PIN, -1);
+    ir.begin();
+    ir.setTrace(true);
+
+    // Clean replay
+    FILE *out = NULL;
+    int differ = 0, refs = 0, none = 0;
+
+    if(outFn) {
+        if(!(out = fopen(outFn, "wb")) || fwrite("SIDIRTR1", 1, 8, out) != 8) {
+            printf("Can't write %s\n", outFn);
+            return 1;
+        }
+    }
+
+    for(auto& x : frames) {
+        IRTraceRec rec;
+
+        if(!irPlay(ir, pl, RP_GAP, x.f, rec)) {
+            none++;
+            continue;
+        }
+
+        if(out) {
+            // As flushIRTrace() in sid_main.cpp
+            fwrite(&rec, 1, sizeof(rec) - sizeof(rec.dur) + rec.len * sizeof(rec.dur[0]), out);
+        }
+
+        x.result = result(rec, x.byCode, x.key);
+        if(!x.result) {
+            none++;
+            continue;
+        }
+
+        if(x.haveRef) {
+            refs++;
+            if(x.byCode != x.refByCode || x.key != x.ref) {
+                differ++;
+                if(verbose) {
+                    printf("%s: replay gives %s %08x, recorded %s %08x\n", x.file,
+                        x.byCode ? "code" : "hash", x.key, x.refByCode ? "code" : "hash", x.ref);
+                }
+            }
+        }
+
+        keys.emplace(keyId(x.byCode, x.key), keys.size());
+    }
+
+    if(out) fclose(out);
+
+    int byCode = 0;
+    for(auto& k : keys) {
+        if(k.first >> 32) byCode++;
+    }
+
+    printf("%zu frames, %zu keys (%d by code, %zu by hash), %d frames without result\n",
+        frames.size(), keys.size(), byCode, keys.size() - byCode, none);
+    printf("clean replay: %d of %d differ from recorded/expected result\n", differ, refs);
+
+    // Fuzz
+    uint32_t tot[2][4] = { };       // [byCode][runs, ok, miss, wrong]
+
+    for(auto& x : frames) {
+        if(!x.result) continue;
+
+        for(int r = 0; r < runs; r++) {
+            irFrame f = irDistort(x.f, rng, rng.below(stretch + 1), jitter);
+            IRTraceRec rec;
+            bool bc;
+            uint32_t val;
+
+            if(glitches && (int)rng.below(100) < glitches) {
+                glitch(f);
+            }
+
+            x.runs++;
+            if(!irPlay(ir, pl, RP_GAP, f, rec) || !result(rec, bc, val)) {
+                x.miss++;
+            } else if(bc == x.byCode && val == x.key) {
+                x.ok++;
+            } else if(keys.count(keyId(bc, val))) {
+                x.wrong++;
+            } else {
+                x.miss++;
+            }
+        }
+
+        uint32_t *t = tot[x.byCode];
+        t[0] += x.runs;
+        t[1] += x.ok;
+        t[2] += x.miss;
+        t[3] += x.wrong;
+    }
+
+    printf("fuzz: %d runs per frame, jitter +/-%dus, stretch 0..%dus, glitches in %d%%\n",
+        runs, jitter, stretch, glitches);
+    printf("             runs      ok%%    miss%%   wrong%%\n");
+    for(int c = 1; c >= 0; c--) {
+        uint32_t *t = tot[c];
+        if(!t[0]) continue;
+        printf("%-8s %8u %8.2f %8.2f %8.3f\n", c ? "by code" : "by hash", t[0],
+            t[1] * 100.0 / t[0], t[2] * 100.0 / t[0], t[3] * 100.0 / t[0]);
+    }
+
+    if(verbose) {
+        for(auto& k : keys) {
+            uint32_t n = 0, ok = 0, miss = 0, wrong = 0;
+            for(auto& x : frames) {
+                if(x.result && keyId(x.byCode, x.key) == k.first) {
+                    n += x.runs;
+                    ok += x.ok;
+                    miss += x.miss;
+                    wrong += x.wrong;
+                }
+            }
+            printf("%s %08x: %u runs, ok %u, miss %u, wrong %u\n", (k.first >> 32) ? "code" : "hash",
+                (uint32_t)k.first, n, ok, miss, wrong);
+        }
+    }
+
+    return differ ? 2 : 0;
+}
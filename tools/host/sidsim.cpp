@@ -0,0 +1,549 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host build: The firmware on the virtual clock
+ *
+ * Boots the firmware as setup() in the sketch does and runs the
+ * scheduler as loop() does. The network side (wifi_loop(),
+ * bttfn_loop()) is the task on the other core, run every 1ms of
+ * virtual time spent waiting. Around it:
+ * - A TCD on the network (BTTFN, port 1338): Answers polls, sends
+ *   time travel notifications and remote commands, and takes
+ *   time travels triggered by the SID
+ * - The two HT16K33 of the display on i2c, which record what is
+ *   shown
+ * - A 1kHz tone on the microphone (I2S)
+ * - Flash and SD card in build/simfs, with a sidconfig.json
+ *   pointing at the TCD
+ *
+ * Default scenario: 6 minutes idle (screen saver after 5), then
+ * 20 synced time travels with random lead times, one triggered
+ * by the TT button, then remote commands from the TCD (spectrum
+ * analyzer, peaks, strict mode, the games, back to idle).
+ *
+ * Usage: sidsim [-i idle_s] [-n num_tt] [-s seed] [-v]
+ * Exit status is non-zero if a check failed.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include <LittleFS.h>
+#include <driver/i2s.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "host_test.h"
+#include "host_wifi.h"
+#include "sid_global.h"
+#include "sid_main.h"
+#include "sid_settings.h"
+#include "sid_wifi.h"
+#include "sid_msg.h"
+#include "sid_sched.h"
+#include "sid_ttseq.h"
+#include "sid_power.h"
+#include "sid_prng.h"
+
+#define SIM_DIR         "build/simfs"
+#define SS_DELAY        300000  // ssTimer 5 (minutes)
+#define TT_GAP          20000   // Time between TTs (ms)
+#define TT_P1           4000    // P1 duration announced by "TCD"
+#define TT_MAX_LATE     25      // ms a TT may start late
+#define P2_SLACK        100     // ms a TT may end after P2_DUR
+#define CMD_STEP        6000    // Time per remote command (ms)
+
+static bool verbose = false;
+static sidPRNG simRNG;
+
+/*
+ * The display: Two HT16K33 at 0x74 (left) and 0x72 (right)
+ */
+
+enum {
+    PH_BOOT = 0, PH_IDLE, PH_TT, PH_BTN, PH_SA, PH_SIDDLY, PH_SNAKE, PH_BACK, PH_NUM
+};
+
+static const char *phName[PH_NUM] = {
+    "boot", "idle", "tt", "button", "sa", "siddly", "snake", "idle"
+};
+
+typedef struct {
+    bool    osc, on;
+    uint8_t dim;
+    uint8_t ram[16];
+} ht16k33;
+
+typedef struct {
+    uint32_t frames;            // While on
+    int      maxLit;
+} phaseStats;
+
+static ht16k33       disp[2];
+static int           phase = PH_BOOT;
+static phaseStats    ph[PH_NUM];
+static unsigned long ssOffAt = 0, dispOnAfterSS = 0;
+
+static int litLEDs()
+{
+    int n = 0;
+
+    for(int j = 0; j < 2; j++) {
+        for(int i = 0; i < 16; i++) {
+            n += __builtin_popcount(disp[j].ram[i]);
+        }
+    }
+
+    return n;
+}
+
+static void dispRx(uint8_t addr, const uint8_t *buf, int len)
+{
+    ht16k33 *d = &disp[(addr == 0x74) ? 0 : 1];
+
+    if(len == 1) {
+        switch(buf[0] & 0xf0) {
+        case 0x20:
+            d->osc = buf[0] & 1;
+            break;
+        case 0x80:
+            if(d == &disp[0] && d->on != (buf[0] & 1)) {
+                if(!(buf[0] & 1) && phase == PH_IDLE && !ssOffAt) {
+                    ssOffAt = millis();
+                } else if((buf[0] & 1) && ssOffAt && !dispOnAfterSS) {
+                    dispOnAfterSS = millis();
+                }
+            }
+            d->on = buf[0] & 1;
+            break;
+        case 0xe0:
+            d->dim = buf[0] & 0x0f;
+            break;
+        }
+        return;
+    }
+
+    for(int i = 1, a = buf[0] & 0x0f; i < len && a < 16; i++, a++) {
+        d->ram[a] = buf[i];
+    }
+
+    // Right half comes last
+    if(d == &disp[1] && d->on && d->osc) {
+        int lit = litLEDs();
+        ph[phase].frames++;
+        if(lit > ph[phase].maxLit) ph[phase].maxLit = lit;
+    }
+}
+
+/*
+ * Microphone: 1kHz tone
+ */
+
+static void micTone(int32_t *buf, int n, uint32_t rate)
+{
+    static uint32_t t = 0;
+
+    for(int i = 0; i < n; i++, t++) {
+        buf[i] = (int32_t)(sin(2 * PI * 1000.0 * t / (rate ? rate : 1)) * 0x3fffffff);
+    }
+}
+
+/*
+ * The TCD
+ */
+
+#define TCD_PORT        1338
+
+static IPAddress tcdIP(192, 168, 1, 10);
+static IPAddress sidIP(192, 168, 1, 2);
+
+typedef struct {
+    unsigned long tt;           // When NOT_TT is sent
+    uint16_t      lead;
+    unsigned long reentry;      // When NOT_REENTRY is sent
+    bool          ttSent, reSent;
+    // Observed
+    unsigned long start, end;
+} ttScript;
+
+typedef struct {
+    unsigned long at;
+    uint32_t      cmd;
+    int           phase;        // From then on
+    bool          sent;
+} cmdScript;
+
+static ttScript *script;
+static int      numTT = 20;     // Plus one by button
+static int      curTT = -1;
+
+static cmdScript cmds[] = {
+    { 0,            21, PH_SA },        // Spectrum analyzer
+    { CMD_STEP,     61, PH_SA },        // Peaks on/off
+    { CMD_STEP + 1, 60, PH_SA },        // Strict mode on/off
+    { 2 * CMD_STEP, 22, PH_SIDDLY },
+    { 3 * CMD_STEP, 23, PH_SNAKE },
+    { 4 * CMD_STEP, 20, PH_BACK }
+};
+#define NUM_CMDS  (int)(sizeof(cmds) / sizeof(cmds[0]))
+
+static unsigned long cmdStart;
+static uint32_t polls = 0, triggers = 0, remCmds = 0, badPackets = 0;
+static unsigned long firstPoll = 0, lastPoll = 0;
+
+static void tcdSend(uint8_t *buf)
+{
+    uint8_t a = 0;
+
+    memcpy(buf, "BTTF", 4);
+    for(int i = 4; i < 47; i++) {
+        a += buf[i] ^ 0x55;
+    }
+    buf[47] = a;
+
+    host_udpSend(tcdIP, sidIP, TCD_PORT, buf, 48);
+}
+
+static void tcdNotify(uint8_t type, uint16_t v1 = 0, uint16_t v2 = 0, uint32_t v32 = 0)
+{
+    uint8_t buf[48] = { 0 };
+
+    buf[4] = 1 | 0x40;
+    buf[5] = type;
+    if(v32) {
+        memcpy(&buf[6], &v32, 4);
+    } else {
+        buf[6] = v1 & 0xff;
+        buf[7] = v1 >> 8;
+        buf[8] = v2 & 0xff;
+        buf[9] = v2 >> 8;
+    }
+    tcdSend(buf);
+}
+
+static void tcdTT(ttScript *s)
+{
+    tcdNotify(2, s->lead, TT_P1);
+    s->ttSent = true;
+    if(verbose) {
+        printf("%9.3fs tcd: tt %d, lead %u\n", millis() / 1000.0, (int)(s - script), s->lead);
+    }
+}
+
+// Packets from the SID
+static void tcdRx(IPAddress dst, uint16_t port, const uint8_t *rx, int len)
+{
+    uint8_t buf[48];
+    uint8_t a = 0;
+
+    if(dst != tcdIP || port != TCD_PORT || len != 48 || memcmp(rx, "BTTF", 4)) {
+        badPackets++;
+        return;
+    }
+    for(int i = 4; i < 47; i++) {
+        a += rx[i] ^ 0x55;
+    }
+    if(rx[47] != a || rx[10 + 13] != 2) {
+        badPackets++;
+        return;
+    }
+
+    if(rx[5] == 0x80) {
+        // TT trigger: As the TCD, with ETTO lead
+        ttScript *s = &script[numTT];
+        triggers++;
+        if(!s->ttSent) {
+            s->tt = millis();
+            s->reentry = s->tt + s->lead + TT_P1;
+            tcdTT(s);
+        }
+    } else if(!rx[5]) {
+        remCmds++;
+    } else {
+        // Poll: Status, capabilities; no date, no speed
+        memset(buf, 0, sizeof(buf));
+        buf[4] = 1 | 0x80;
+        memcpy(&buf[6], &rx[6], 4);
+        buf[5] = rx[5] & 0x52;
+        buf[18] = buf[19] = 0xff;
+        tcdSend(buf);
+        if(!firstPoll) firstPoll = millis();
+        lastPoll = millis();
+        polls++;
+    }
+}
+
+static void tcd_step()
+{
+    unsigned long now = millis();
+
+    for(int i = 0; i <= numTT; i++) {
+        ttScript *s = &script[i];
+        if(i < numTT && !s->ttSent && (long)(now - s->tt) >= 0) {
+            tcdTT(s);
+        }
+        if(s->ttSent && !s->reSent && (long)(now - s->reentry) >= 0) {
+            tcdNotify(3);
+            s->reSent = true;
+        }
+    }
+
+    for(int i = 0; i < NUM_CMDS && cmdStart; i++) {
+        if(!cmds[i].sent && (long)(now - (cmdStart + cmds[i].at)) >= 0) {
+            tcdNotify(8, 0, 0, cmds[i].cmd);
+            cmds[i].sent = true;
+            phase = cmds[i].phase;
+            if(verbose) {
+                printf("%9.3fs tcd: command %u\n", now / 1000.0, cmds[i].cmd);
+            }
+        }
+    }
+}
+
+/*
+ * What the main side does, sampled every 1ms and after each
+ * scheduler pass
+ */
+
+static bool          wasTT = false;
+static uint32_t      minMHzSS = 240, maxMHzTT = 0;
+
+static void observe()
+{
+    unsigned long now = millis();
+
+    if(TTrunning != wasTT) {
+        wasTT = TTrunning;
+        if(TTrunning) {
+            curTT++;
+            if(curTT <= numTT) script[curTT].start = now;
+        } else if(curTT <= numTT) {
+            script[curTT].end = now;
+        }
+        if(verbose) {
+            printf("%9.3fs sid: tt %s\n", now / 1000.0, TTrunning ? "start" : "end");
+        }
+    }
+
+    if(TTrunning) {
+        if(getCpuFrequencyMhz() > maxMHzTT) maxMHzTT = getCpuFrequencyMhz();
+    } else if(ssOffAt && !dispOnAfterSS) {
+        if(getCpuFrequencyMhz() < minMHzSS) minMHzSS = getCpuFrequencyMhz();
+    }
+}
+
+// As netTask() in the sketch
+static void netCore()
+{
+    tcd_step();
+    wifi_loop();
+    bttfn_loop();
+    observe();
+}
+
+/*
+ * Setup
+ */
+
+static void writeFile(const char *name, const char *text)
+{
+    FILE *f = fopen(name, "w");
+
+    if(f) {
+        fputs(text, f);
+        fclose(f);
+    }
+}
+
+static bool fileExists(const char *name)
+{
+    struct stat st;
+
+    return !stat(name, &st);
+}
+
+static void simSetup()
+{
+    CHECK(!system("rm -rf " SIM_DIR " && mkdir -p " SIM_DIR "/flash " SIM_DIR "/sd"),
+          "can't create " SIM_DIR);
+    writeFile(SIM_DIR "/flash/sidconfig.json",
+              "{\"tcdIP\":\"192.168.1.10\",\"ssTimer\":\"5\",\"ssClock\":\"0\",\"bttfnTT\":\"1\"}");
+    host_fsRoot(SIM_DIR);
+    host_sdPresent(true);
+
+    host_wifiConnect(true, sidIP);
+    host_udpOnSend(tcdRx);
+    host_i2cAttach(0x74, dispRx);
+    host_i2cAttach(0x72, dispRx);
+    host_i2sSource(micTone);
+}
+
+static double wallSecs()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long idleSecs = 360;
+    uint32_t seed = 0x19551105;
+    int opt;
+
+    while((opt = getopt(argc, argv, "i:n:s:v")) != -1) {
+        switch(opt) {
+        case 'i': idleSecs = strtoul(optarg, NULL, 0); break;
+        case 'n': numTT = atoi(optarg); break;
+        case 's': seed = strtoul(optarg, NULL, 0); break;
+        case 'v': verbose = true; break;
+        default:
+            fprintf(stderr, "Usage: %s [-i idle_s] [-n num_tt] [-s seed] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    host_seed(seed);
+    simRNG.seed(seed);
+    simSetup();
+
+    double wall = wallSecs();
+
+    // As setup() in the sketch
+    powerupMillis = millis();
+    Wire.begin(-1, -1, 400000);
+    main_boot();
+    settings_setup();
+    wifi_setup();
+    main_setup();
+    bttfn_loop();
+    main_sched_setup();
+    host_coreTask(netCore, 1000);
+
+    unsigned long bootEnd = millis();
+    unsigned long ttStart = bootEnd + idleSecs * 1000;
+    unsigned long btnAt = ttStart + numTT * TT_GAP;
+
+    phase = PH_IDLE;
+
+    script = (ttScript *)calloc(numTT + 1, sizeof(ttScript));
+    for(int i = 0; i < numTT; i++) {
+        script[i].tt = ttStart + i * TT_GAP;
+        script[i].lead = simRNG.below(6000);
+        script[i].reentry = script[i].tt + script[i].lead + TT_P1;
+    }
+    script[numTT].lead = ETTO_LEAD;
+
+    cmdStart = 0;
+    unsigned long endMs = btnAt + TT_GAP + NUM_CMDS * CMD_STEP;
+    uint64_t passes = 0;
+    unsigned long blocked = 0, longest = 0;
+    bool pressed = false, released = false;
+
+    // As loop() in the sketch
+    while(millis() < endMs) {
+        unsigned long before = millis();
+        sched_run();
+        observe();
+        passes++;
+
+        // Tasks blocking (game intros, ...): Others can't run
+        unsigned long now = millis();
+        if(now - before > longest) longest = now - before;
+        if(now - before > 250) blocked += now - before;
+        if(phase == PH_IDLE && numTT && (long)(now - ttStart) >= 0) {
+            phase = PH_TT;
+        }
+        if(!pressed && (long)(now - btnAt) >= 0) {
+            phase = PH_BTN;
+            host_setPin(TT_IN_PIN, HIGH);
+            pressed = true;
+        } else if(pressed && !released && (long)(now - btnAt) >= 300) {
+            host_setPin(TT_IN_PIN, LOW);
+            released = true;
+        }
+        if(!cmdStart && (long)(now - (btnAt + TT_GAP)) >= 0) {
+            cmdStart = now;
+        }
+    }
+
+    wall = wallSecs() - wall;
+
+    /*
+     * Report and checks
+     */
+
+    printf("virtual %.1fs in %.2fs real (x%.0f), %llu passes, boot %.1fs\n",
+        millis() / 1000.0, wall, millis() / 1000.0 / (wall > 0 ? wall : 1e-6),
+        (unsigned long long)passes, bootEnd / 1000.0);
+    printf("longest pass %lums, %.1fs in passes >250ms\n", longest, blocked / 1000.0);
+    for(int i = 0; i < PH_NUM; i++) {
+        printf("%-7s frames %6u, max %3d LEDs lit\n", phName[i], ph[i].frames, ph[i].maxLit);
+    }
+
+    CHECK(disp[0].osc && disp[1].osc, "display oscillator not on");
+    CHECK(ph[PH_BOOT].frames > 0, "no boot sequence shown");
+    CHECK(ph[PH_IDLE].frames > idleSecs / 2 && ph[PH_IDLE].maxLit > 0, "idle: %u frames", ph[PH_IDLE].frames);
+
+    if(idleSecs * 1000 > SS_DELAY + 10000) {
+        long ss = (long)(ssOffAt - bootEnd);
+        printf("screen saver after %.1fs, %uMHz, display on again at %.1fs\n",
+            ss / 1000.0, minMHzSS, dispOnAfterSS / 1000.0);
+        CHECK(ssOffAt && ss >= SS_DELAY && ss <= SS_DELAY + 10000, "screen saver after %ldms", ss);
+        CHECK(minMHzSS < pwrTable[PWR_ACTIVE].cpuMHz, "CPU at %uMHz in screen saver", minMHzSS);
+        CHECK(!numTT || (dispOnAfterSS >= ttStart && dispOnAfterSS <= ttStart + TT_MAX_LATE + 100),
+              "display not back on at first time travel");
+    }
+
+    int late = 0;
+    for(int i = 0; i <= numTT; i++) {
+        ttScript *s = &script[i];
+        long sl = (long)(s->start - s->tt), el = (long)(s->end - s->reentry);
+        if(verbose || i == numTT) {
+            printf("tt %2d: lead %4u start +%ldms, end %+ldms from reentry\n", i, s->lead, sl, el);
+        }
+        CHECK(s->ttSent, "tt %d never sent", i);
+        CHECK(i <= curTT, "tt %d never started", i);
+        if(i > curTT || !s->ttSent) continue;
+        CHECK(s->end, "tt %d did not finish", i);
+        // From quiet state, Main runs every loopInt ms
+        CHECK(sl >= 0 && sl <= TT_MAX_LATE + 2 * pwrTable[PWR_QUIET].loopInt, "tt %d started %ldms late", i, sl);
+        CHECK(el >= 0 && el <= P2_DUR + P2_SLACK, "tt %d ended %ldms after reentry", i, el);
+        if(sl > 5) late++;
+    }
+    printf("tt %d/%d done, %d late >5ms, %uMHz\n", curTT + 1, numTT + 1, late, maxMHzTT);
+    CHECK(curTT == numTT, "%d of %d TTs started", curTT + 1, numTT + 1);
+    CHECK(triggers == 1, "tcd: %u TT triggers", triggers);
+    CHECK(!numTT || ph[PH_TT].frames > 0, "no frames in time travels");
+    CHECK(!numTT || maxMHzTT == pwrTable[PWR_ACTIVE].cpuMHz, "CPU at %uMHz in time travel", maxMHzTT);
+
+    // Polls every BTTFN_POLL_INT (1000ms), more often if timed out
+    float pollSecs = (lastPoll - firstPoll) / 1000.0;
+    printf("tcd: %u polls in %.1fs, %u commands, %u bad packets\n", polls, pollSecs, remCmds, badPackets);
+    CHECK(polls >= pollSecs * 0.95 && polls <= pollSecs + 2, "%u polls in %.1fs", polls, pollSecs);
+    CHECK(!badPackets, "%u bad packets", badPackets);
+
+    CHECK(ph[PH_SA].frames > 5 * 1000 / 50 && ph[PH_SA].maxLit > 0, "sa: %u frames", ph[PH_SA].frames);
+    CHECK(hostCP.updates >= 2, "%d Config Portal updates", hostCP.updates);
+    CHECK(hostCP.saPeaks == !DEF_SA_PEAKS, "peaks not toggled");
+    CHECK(hostCP.strict == !DEF_STRICT, "strict mode not toggled");
+    CHECK(fileExists(SIM_DIR "/sd/sid2cfg") || fileExists(SIM_DIR "/flash/sid2cfg"), "sid2cfg not saved");
+    CHECK(ph[PH_SIDDLY].frames > 0, "siddly: no frames");
+    CHECK(ph[PH_SNAKE].frames > 0, "snake: no frames");
+    CHECK(ph[PH_BACK].frames > 0 && ph[PH_BACK].maxLit > 0, "no idle after commands");
+    CHECK(!cmdQueueDropped(CMDSRC_BTTFN), "%u BTTFN commands dropped", cmdQueueDropped(CMDSRC_BTTFN));
+
+    const char *name;
+    uint32_t runs, avgUs, maxUs, housekeeping = 0;
+    for(int i = 0; (i = sched_getStats(i, name, runs, avgUs, maxUs)) > 0; ) {
+        printf("task %-8s runs %9u avg %5uus max %5uus\n", name, runs, avgUs, maxUs);
+        if(!strcmp(name, "Housekp")) housekeeping = runs;
+    }
+    CHECK(housekeeping >= (millis() - bootEnd - blocked) / 250 - 1, "housekeeping ran %u times", housekeeping);
+
+    return host_result();
+}
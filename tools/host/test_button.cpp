@@ -0,0 +1,310 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: SIDButton (input.cpp) on recorded edge sequences
+ *
+ * Edge sequences (time, level) are played into the pin; the edge
+ * ISR records them, scan() runs every 10ms as in the main loop.
+ * Both configurations of the TT button are tested, as set up in
+ * sid_main.cpp: Physical button (debounce 50ms, press 200ms, long
+ * press 5s, press reported on release) and TCD trigger (5ms, 50ms,
+ * no long press, press reported while held).
+ *
+ * - Clean and bouncing presses: Exactly one press, timed from the
+ *   edge that starts the stable press (the last one of the bounce).
+ * - Long press: One long press start after 5s, one stop on release,
+ *   no press.
+ * - Ring overflow: Bursts of more edges than the ring holds between
+ *   two scans; the result must still be exactly one press, or none
+ *   for a burst that ends released.
+ * - Race: An edge coming in during scan(), just before it takes the
+ *   time, must neither make a press long at once, nor let a release
+ *   bounce through as a second press.
+ */
+
+#include <Arduino.h>
+
+#include "host_test.h"
+#include "input.h"
+
+#define BTN_PIN     27
+#define SCAN_US     10000
+
+typedef struct {
+    uint32_t us;                // Offset from start of sequence
+    uint8_t  active;
+} btnEdge;
+
+#define NUM_EDGES(s) (sizeof(s) / sizeof(s[0]))
+
+typedef struct {
+    int           ev;
+    unsigned long t;            // eventTime()
+    unsigned long at;           // When reported
+} btnEvent;
+
+// Active HIGH, pull-down, as the TT button
+static SIDButton btn(BTN_PIN, false, false, true);
+
+static btnEvent events[16];
+static int      numEvents = 0;
+static uint64_t nextScan;
+
+static void addEvent(int ev)
+{
+    if(numEvents < 16) {
+        events[numEvents].ev = ev;
+        events[numEvents].t = btn.eventTime();
+        events[numEvents].at = micros();
+    }
+    numEvents++;
+}
+
+static void onPress()      { addEvent(SIDB_EV_PRESS); }
+static void onLongStart()  { addEvent(SIDB_EV_LONGSTART); }
+static void onLongStop()   { addEvent(SIDB_EV_LONGSTOP); }
+
+static void setLevel(bool active)
+{
+    host_setPin(BTN_PIN, active ? HIGH : LOW);
+}
+
+// Move time to t, scanning on the way. Never backwards, as 
+// raceHook() moves time during a scan.
+static void runTo(uint64_t t)
+{
+    while(nextScan <= t) {
+        if(host_us() < nextScan) host_setUs(nextScan);
+        btn.scan();
+        nextScan += SCAN_US;
+    }
+    if(host_us() < t) host_setUs(t);
+}
+
+static void play(const btnEdge *e, int n)
+{
+    uint64_t t0 = host_us();
+
+    for(int i = 0; i < n; i++) {
+        runTo(t0 + e[i].us);
+        setLevel(e[i].active);
+    }
+}
+
+// Start a scenario just after a scan, with the button idle
+static uint64_t start(bool longPress)
+{
+    setLevel(false);
+    runTo(host_us() + 1000000);
+    btn.reset();
+    if(longPress) {
+        btn.setTiming(50, 200, 5000);
+        btn.attachLongPressStart(onLongStart);
+        btn.attachLongPressStop(onLongStop);
+    } else {
+        btn.setTiming(5, 50, 100000);
+        btn.attachLongPressStart(NULL);
+        btn.attachLongPressStop(NULL);
+    }
+    numEvents = 0;
+    runTo(nextScan);
+    host_advance(100);
+
+    return host_us();
+}
+
+// One press, starting at t0 + start (or within the burst, if
+// start is negative), reported no later than t0 + maxLate
+static void expectPress(const char *name, uint64_t t0, int32_t start, uint32_t maxLate)
+{
+    CHECK(numEvents == 1, "%s: %d events, expected one press", name, numEvents);
+    if(numEvents >= 1) {
+        unsigned long d = events[0].t - (unsigned long)t0;
+        CHECK(events[0].ev == SIDB_EV_PRESS, "%s: event %d, expected press", name, events[0].ev);
+        CHECK((start >= 0) ? (d == (unsigned long)start) : (d <= (unsigned long)-start), "%s: press started at +%luus, expected %s%dus",
+              name, d, (start >= 0) ? "+" : "up to +", abs(start));
+        CHECK(events[0].at - (unsigned long)t0 <= maxLate, "%s: press reported %luus after start",
+              name, events[0].at - (unsigned long)t0);
+    }
+}
+
+/*
+ * Edge sequences
+ */
+
+// Clean short press
+static const btnEdge seqClean[] = {
+    { 0, 1 }, { 120000, 0 }
+};
+
+// Bouncing contacts on press and release
+static const btnEdge seqBounce[] = {
+    { 0, 1 },      { 300, 0 },    { 800, 1 },    { 1500, 0 },   { 2100, 1 },
+    { 150000, 0 }, { 150400, 1 }, { 151000, 0 }, { 151900, 1 }, { 153000, 0 }
+};
+
+// Held for 6 seconds, bouncing
+static const btnEdge seqLong[] = {
+    { 0, 1 },       { 500, 0 },     { 1200, 1 },
+    { 6000000, 0 }, { 6000700, 1 }, { 6001500, 0 }
+};
+
+// Glitch while idle, shorter than the debounce time
+static const btnEdge seqGlitch[] = {
+    { 0, 1 }, { 2000, 0 }
+};
+
+static void testSequences()
+{
+    uint64_t t0;
+
+    // Physical button: Press reported after release + press time
+    t0 = start(true);
+    play(seqClean, NUM_EDGES(seqClean));
+    runTo(t0 + 1000000);
+    expectPress("button clean", t0, 0, 120000 + 200000 + SCAN_US);
+
+    t0 = start(true);
+    play(seqBounce, NUM_EDGES(seqBounce));
+    runTo(t0 + 1000000);
+    expectPress("button bounce", t0, 2100, 153000 + 200000 + SCAN_US);
+
+    t0 = start(true);
+    play(seqLong, NUM_EDGES(seqLong));
+    runTo(t0 + 7000000);
+    CHECK(numEvents == 2, "button long: %d events, expected 2", numEvents);
+    if(numEvents == 2) {
+        CHECK(events[0].ev == SIDB_EV_LONGSTART, "button long: first event %d", events[0].ev);
+        CHECK(events[0].at - t0 > 5000000 && events[0].at - t0 <= 5000000 + SCAN_US,
+              "button long: start reported after %luus", events[0].at - (unsigned long)t0);
+        CHECK(events[1].ev == SIDB_EV_LONGSTOP, "button long: second event %d", events[1].ev);
+        CHECK(events[1].at - t0 >= 6000000 + 50000, "button long: stop reported after %luus",
+              events[1].at - (unsigned long)t0);
+    }
+
+    t0 = start(true);
+    play(seqGlitch, NUM_EDGES(seqGlitch));
+    runTo(t0 + 1000000);
+    CHECK(!numEvents, "button glitch: %d events", numEvents);
+
+    // TCD trigger: Press reported while held, after 50ms
+    t0 = start(false);
+    play(seqBounce, NUM_EDGES(seqBounce));
+    runTo(t0 + 1000000);
+    expectPress("tcd bounce", t0, 2100, 2100 + 50000 + SCAN_US);
+
+    t0 = start(false);
+    play(seqLong, NUM_EDGES(seqLong));
+    runTo(t0 + 7000000);
+    expectPress("tcd long", t0, 1200, 1200 + 50000 + SCAN_US);
+}
+
+/*
+ * More edges between two scans than the ring holds
+ */
+
+static void burst(uint64_t t, int edges, bool endActive)
+{
+    for(int i = 0; i < edges; i++) {
+        runTo(t + i * 100);
+        setLevel(((edges - i) & 1) ? endActive : !endActive);
+    }
+}
+
+static void testOverflow()
+{
+    uint64_t t0;
+
+    // Bouncing press and release, 3 times the ring size each
+    t0 = start(true);
+    burst(t0, 3 * SIDB_EDGES + 1, true);
+    burst(t0 + 150000, 3 * SIDB_EDGES + 1, false);
+    runTo(t0 + 1000000);
+    expectPress("overflow press", t0, -(3 * SIDB_EDGES * 100), 150000 + 200000 + 2 * SCAN_US);
+
+    // Burst ending released: Nothing
+    t0 = start(true);
+    burst(t0, 3 * SIDB_EDGES, false);
+    runTo(t0 + 1000000);
+    CHECK(!numEvents, "overflow glitch: %d events", numEvents);
+
+    t0 = start(false);
+    burst(t0, 3 * SIDB_EDGES + 1, true);
+    runTo(t0 + 200000);
+    setLevel(false);
+    runTo(t0 + 1000000);
+    expectPress("overflow tcd", t0, -(3 * SIDB_EDGES * 100), 3 * SIDB_EDGES * 100 + 50000 + SCAN_US);
+}
+
+/*
+ * Edge during scan(): The hook runs when scan() takes the time,
+ * and changes the level in between, as an interrupt would
+ */
+
+static int raceLevel;
+
+static void raceHook()
+{
+    host_advance(10);
+    setLevel(raceLevel);
+    host_advance(10);
+}
+
+static void raceScan(bool active)
+{
+    raceLevel = active;
+    runTo(nextScan - 1);
+    host_onNextMicros(raceHook);
+    runTo(nextScan);
+}
+
+static void testRace()
+{
+    uint64_t t0;
+
+    // Press comes in during scan: Must not become a long press
+    t0 = start(true);
+    raceScan(true);
+    t0 = host_us() - 10;
+    runTo(t0 + 300000);
+    setLevel(false);
+    runTo(t0 + 1000000);
+    CHECK(numEvents == 1 && events[0].ev == SIDB_EV_PRESS, "race press: %d events, first %d",
+          numEvents, numEvents ? events[0].ev : 0);
+
+    // Release comes in during scan, then contacts chatter for 
+    // a while: One press, reported 200ms after the release
+    t0 = start(true);
+    setLevel(true);
+    runTo(t0 + 300000);
+    raceScan(false);
+    uint64_t rel = host_us();
+    runTo(rel + 5000);
+    setLevel(true);
+    runTo(rel + 65000);
+    setLevel(false);
+    runTo(t0 + 2000000);
+    expectPress("race release", t0, 0, 2000000);
+    if(numEvents) {
+        CHECK(events[0].at >= rel + 200000, "race release: press reported %luus after release",
+              events[0].at - (unsigned long)rel);
+    }
+}
+
+int main()
+{
+    host_setUs(1000000);
+    nextScan = host_us();
+
+    btn.begin();
+    btn.attachPress(onPress);
+
+    testSequences();
+    testOverflow();
+    testRace();
+
+    return host_result();
+}
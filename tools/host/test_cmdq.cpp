@@ -0,0 +1,91 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: mpscQueue (sid_msg.h), the remote command queue
+ *
+ * Three producer threads (standing in for BTTFN, MQTT and the
+ * serial injector) put 200.000 commands each into a 16-entry
+ * queue (as cmdQueue in sid_main.cpp), while one consumer thread
+ * takes them out. Every command must arrive exactly once, and
+ * each producer's commands in the order they were put.
+ */
+
+#include <Arduino.h>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "sid_msg.h"
+
+#define NUM_PROD    CMDSRC_NUM
+#define NUM_CMDS    200000      // per producer
+
+static mpscQueue<sidCmd, 16> cmdQueue;
+
+int main()
+{
+    std::vector<std::thread> prods;
+    uint32_t full[NUM_PROD] = { 0 };
+    uint32_t nextCode[NUM_PROD] = { 0 };
+    uint32_t recv = 0, bad = 0, maxCount = 0;
+
+    for(int s = 0; s < NUM_PROD; s++) {
+        prods.emplace_back([s, &full] {
+            for(uint32_t i = 0; i < NUM_CMDS; ) {
+                sidCmd c;
+                c.code = i;
+                c.stamp = ~i;
+                c.src = s;
+                c.flags = i & 0xff;
+                if(cmdQueue.put(c)) {
+                    i++;
+                } else {
+                    full[s]++;
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::thread cons([&] {
+        sidCmd c;
+        while(recv < NUM_PROD * NUM_CMDS) {
+            uint32_t n = cmdQueue.count();
+            if(n > maxCount) maxCount = n;
+            if(!cmdQueue.get(c)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if(c.src >= NUM_PROD || c.code != nextCode[c.src] ||
+               c.stamp != ~c.code || c.flags != (c.code & 0xff)) {
+                bad++;
+            } else {
+                nextCode[c.src]++;
+            }
+            recv++;
+        }
+    });
+
+    for(auto& t : prods) t.join();
+    cons.join();
+
+    sidCmd c;
+    uint32_t totalFull = 0;
+    for(int s = 0; s < NUM_PROD; s++) {
+        printf("producer %d: %u delivered, queue full %u times\n", s, nextCode[s], full[s]);
+        CHECK(nextCode[s] == NUM_CMDS, "producer %d: %u of %u in order", s, nextCode[s], NUM_CMDS);
+        totalFull += full[s];
+    }
+    printf("received %u, bad %u, lost() %u, max count %u\n", recv, bad, cmdQueue.lost(), maxCount);
+
+    CHECK(recv == NUM_PROD * NUM_CMDS, "received %u", recv);
+    CHECK(!bad, "%u commands duplicated, out of order or corrupt", bad);
+    CHECK(cmdQueue.lost() == totalFull, "lost() %u, failed puts %u", cmdQueue.lost(), totalFull);
+    CHECK(!cmdQueue.get(c) && !cmdQueue.count(), "queue not empty at end");
+    CHECK(maxCount <= 16, "count() %u exceeds size", maxCount);
+
+    return host_result();
+}
@@ -0,0 +1,279 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: IR protocol decoders (input.cpp)
+ *
+ * - Fixtures: The frames in fixtures/ir/{nec,sony,rc5,rc6}.txt are
+ *   played into IRRemote (edge capture) and must decode to the
+ *   code given there, including repeat detection (NEC repeat
+ *   frames, Sony resends, RC5/RC6 toggle bit).
+ * - Sweep: Random codes of each protocol with increasing timing
+ *   jitter, on top of up to 120us of mark stretch; reports the
+ *   rates of correct and missing codes, and the number of wrong
+ *   ones. Up to 40us jitter, every frame must decode correctly;
+ *   up to 60us, none may decode to a wrong code. (Beyond that,
+ *   RC5/RC6, having no checksum, do show the odd wrong code.)
+ *
+ * The fixtures are synthetic, made by irgen.h with receiver-like
+ * distortion; "test_irdec -w [dir]" rewrites them.
+ */
+
+#include <Arduino.h>
+
+#include "host_test.h"
+#include "irgen.h"
+
+#define IR_PIN      13
+#define IR_TIMER    0
+
+#define FIX_DIR     "fixtures/ir"
+
+enum { P_NEC, P_SONY, P_RC5, P_RC6, P_NUM };
+static const char *pNames[P_NUM] = { "nec", "sony", "rc5", "rc6" };
+
+static IRRemote ir(IR_TIMER, IR_PIN);
+static irPlayer pl;
+static sidPRNG  rng;
+
+static bool play(uint32_t gap, const irFrame& f, IRTraceRec& rec)
+{
+    return irPlay(ir, pl, gap, f, rec);
+}
+
+/*
+ * Fixtures
+ */
+
+// Receiver models used for the fixtures
+static const struct {
+    const char *name;
+    int32_t    stretch;
+    int32_t    jitter;
+} levels[] = {
+    { "clean",   0,   0 },
+    { "typical", 60,  20 },
+    { "heavy",   100, 40 }
+};
+
+#define NUM_LEVELS (int)(sizeof(levels) / sizeof(levels[0]))
+
+static uint32_t frameLen(const irFrame& f)
+{
+    uint32_t l = 0;
+    for(uint32_t d : f) l += d;
+    return l;
+}
+
+static void fixAdd(FILE *fp, int lvl, uint32_t gap, const irFrame& f, uint32_t code, bool rep)
+{
+    irFixture x;
+
+    x.gap = gap;
+    x.code = code;
+    x.repeat = rep;
+    x.f = irDistort(f, rng, levels[lvl].stretch, levels[lvl].jitter);
+    irWriteFixture(fp, x);
+}
+
+static bool writeFixtures(const char *dir)
+{
+    for(int p = 0; p < P_NUM; p++) {
+        char fn[256];
+        FILE *fp;
+
+        snprintf(fn, sizeof(fn), "%s/%s.txt", dir, pNames[p]);
+        if(!(fp = fopen(fn, "w"))) {
+            printf("Can't write %s\n", fn);
+            return false;
+        }
+
+        fprintf(fp, "# %s: SYNTHETIC timings, made by test_irdec -w (irgen.h), not\n"
+                    "# captured from a real remote. Receiver models: clean; typical\n"
+                    "# (marks stretched by 60us, +/-20us jitter per edge); heavy\n"
+                    "# (100us, +/-40us).\n"
+                    "# <gap> <code>[r]|- <mark> <space> ... <mark>; see irgen.h\n", pNames[p]);
+
+        rng.seed(0x1955 + p);
+
+        for(int l = 0; l < NUM_LEVELS; l++) {
+
+            fprintf(fp, "# %s\n", levels[l].name);
+
+            for(int k = 0; k < 8; k++) {
+                uint8_t addr = rng.below(256), cmd = rng.below(256);
+                int reps = rng.below(3);
+                bool tog = k & 1;
+                irFrame f;
+                uint32_t code;
+
+                switch(p) {
+                case P_NEC:
+                    // Key held: Repeat frames every 108ms
+                    f = irNEC(addr, cmd);
+                    code = irCodeNEC(addr, cmd);
+                    fixAdd(fp, l, 250000, f, code, false);
+                    for(int r = 0; r < reps; r++) {
+                        fixAdd(fp, l, 108000 - frameLen(f), irNECRepeat(), code, true);
+                        f = irNECRepeat();
+                    }
+                    break;
+                case P_SONY:
+                    // 12, 15 and 20 bits; key held: Frame resent every 45ms
+                    {
+                        static const int bits[3] = { 12, 15, 20 };
+                        int b = bits[k % 3];
+                        uint16_t a = addr & ((1 << (b - 7)) - 1);
+                        if(b == 20) a |= (rng.below(32) << 8);
+                        f = irSony(a, cmd, b);
+                        code = irCodeSony(a, cmd);
+                    }
+                    fixAdd(fp, l, 250000, f, code, false);
+                    for(int r = 0; r < reps; r++) {
+                        fixAdd(fp, l, 45000 - frameLen(f), f, code, true);
+                    }
+                    break;
+                case P_RC5:
+                case P_RC6:
+                    // Key held: Same toggle every ~110ms; pressed
+                    // again quickly: Toggle flips, a new press
+                    f = (p == P_RC5) ? irRC5(tog, addr, cmd) : irRC6(tog, addr, cmd);
+                    code = (p == P_RC5) ? irCodeRC5(addr, cmd) : irCodeRC6(addr, cmd);
+                    fixAdd(fp, l, 250000, f, code, false);
+                    for(int r = 0; r < reps; r++) {
+                        fixAdd(fp, l, 110000 - frameLen(f), f, code, true);
+                    }
+                    if(k == 7) {
+                        f = (p == P_RC5) ? irRC5(!tog, addr, cmd) : irRC6(!tog, addr, cmd);
+                        fixAdd(fp, l, 110000 - frameLen(f), f, code, false);
+                    }
+                    break;
+                }
+            }
+        }
+
+        // Repeat without a frame to repeat
+        if(p == P_NEC) {
+            fprintf(fp, "# orphaned repeat frame\n");
+            fixAdd(fp, 0, 250000, irNECRepeat(), 0, false);
+        }
+
+        fclose(fp);
+        printf("Wrote %s\n", fn);
+    }
+
+    return true;
+}
+
+static void testFixtures(const char *dir)
+{
+    for(int p = 0; p < P_NUM; p++) {
+        std::vector<irFixture> fx;
+        char fn[256];
+        int ok = 0;
+
+        snprintf(fn, sizeof(fn), "%s/%s.txt", dir, pNames[p]);
+        CHECK(irReadFixtures(fn, fx) && fx.size(), "can't read %s", fn);
+
+        for(size_t i = 0; i < fx.size(); i++) {
+            IRTraceRec rec;
+            bool got = play(fx[i].gap, fx[i].f, rec);
+            uint32_t code = (got && (rec.flags & IRTR_CODE)) ? rec.code : 0;
+            bool rep = got && (rec.flags & IRTR_REPEAT);
+
+            CHECK(got, "%s %zu: no frame", pNames[p], i);
+            CHECK(code == fx[i].code && rep == fx[i].repeat, "%s %zu: code %08x%s, expected %08x%s",
+                  pNames[p], i, code, rep ? "r" : "", fx[i].code, fx[i].repeat ? "r" : "");
+            if(got && code == fx[i].code && rep == fx[i].repeat) ok++;
+        }
+
+        printf("fixtures %-4s: %d of %zu ok\n", pNames[p], ok, fx.size());
+    }
+}
+
+/*
+ * Jitter sweep
+ */
+
+#define SWEEP_FRAMES 400
+#define NUM_JITTERS  6
+
+static void testSweep()
+{
+    static const int32_t jitters[NUM_JITTERS] = { 0, 20, 40, 60, 80, 100 };
+
+    rng.seed(0x20151021);
+
+    printf("sweep: %d frames each, marks stretched 0..120us; ok%%/miss%%/wrong codes\n", SWEEP_FRAMES);
+    printf("jitter(us) ");
+    for(int32_t j : jitters) printf("%15d", j);
+    printf("\n");
+
+    for(int p = 0; p < P_NUM; p++) {
+        int oks[NUM_JITTERS], wrongs[NUM_JITTERS];
+
+        printf("%-10s ", pNames[p]);
+        for(int l = 0; l < NUM_JITTERS; l++) {
+            int32_t j = jitters[l];
+            int ok = 0, miss = 0, wrong = 0;
+
+            for(int n = 0; n < SWEEP_FRAMES; n++) {
+                uint8_t addr = rng.below(256), cmd = rng.below(256);
+                irFrame f;
+                uint32_t code;
+                IRTraceRec rec;
+
+                switch(p) {
+                case P_NEC:  f = irNEC(addr, cmd);              code = irCodeNEC(addr, cmd);         break;
+                case P_SONY: f = irSony(addr & 0x1f, cmd);      code = irCodeSony(addr & 0x1f, cmd); break;
+                case P_RC5:  f = irRC5(n & 1, addr, cmd);       code = irCodeRC5(addr, cmd);         break;
+                default:     f = irRC6(n & 1, addr, cmd);       code = irCodeRC6(addr, cmd);         break;
+                }
+
+                f = irDistort(f, rng, rng.below(121), j);
+
+                if(!play(250000, f, rec) || !(rec.flags & IRTR_CODE)) {
+                    miss++;
+                } else if(rec.code == code) {
+                    ok++;
+                } else {
+                    wrong++;
+                }
+            }
+
+            printf("   %3d/%3d/%3d", ok * 100 / SWEEP_FRAMES, miss * 100 / SWEEP_FRAMES, wrong);
+            oks[l] = ok;
+            wrongs[l] = wrong;
+        }
+        printf("\n");
+
+        for(int l = 0; l < NUM_JITTERS; l++) {
+            if(jitters[l] <= 40) {
+                CHECK(oks[l] == SWEEP_FRAMES, "%s, jitter %d: %d of %d ok", 
+                      pNames[p], jitters[l], oks[l], SWEEP_FRAMES);
+            }
+            if(jitters[l] <= 60) {
+                CHECK(!wrongs[l], "%s, jitter %d: %d wrong codes", pNames[p], jitters[l], wrongs[l]);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    host_setUs(1000000);
+    irPlayerInit(pl, IR_PIN, -1);
+    ir.begin();
+    ir.setTrace(true);
+
+    if(argc > 1 && !strcmp(argv[1], "-w")) {
+        return writeFixtures(argc > 2 ? argv[2] : FIX_DIR) ? 0 : 1;
+    }
+
+    testFixtures(argc > 1 ? argv[1] : FIX_DIR);
+    testSweep();
+
+    return host_result();
+}
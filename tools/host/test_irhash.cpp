@@ -0,0 +1,195 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: IR edge capture vs. timer capture (input.cpp)
+ *
+ * input.cpp is built twice, once with edge capture (the default)
+ * and once with the old 50us timer capture (IR_CAPTURE_TIMER).
+ * Both instances watch the same pin while a synthetic stream of
+ * NEC, Sony, RC5, RC6 and unknown-protocol frames with receiver-
+ * like distortion is played into it; the timer instance's ISR
+ * runs every 50us on the virtual clock.
+ *
+ * Every frame must show up in both instances' traces, with
+ * durations within one timer tick of each other, the same decoded
+ * code, and the same hash: Edge capture hashes the durations as
+ * the timer would have counted them (ticks at multiples of 50us,
+ * as the host timer runs here), so that hashes of default codes
+ * and learned keys, recorded with timer capture, stay valid. The
+ * frames whose hash depends on quantization, ie have a pair of
+ * durations so close to calcHash()'s 80% threshold that one tick
+ * can flip the comparison, are counted and reported; they must
+ * hash the same, too.
+ */
+
+#include <Arduino.h>
+#include "host_test.h"
+#include "sid_global.h"
+
+#include "irgen.h"
+
+#undef _SIDINPUT_H
+namespace irEdge {
+#include "input.cpp"
+}
+
+#undef _SIDINPUT_H
+#undef IR_CAPTURE_EDGE
+#define IR_CAPTURE_TIMER
+namespace irTimer {
+#include "input.cpp"
+}
+
+#define IR_PIN      13
+#define IR_TIMER    0
+#define NUM_FRAMES  5000
+
+enum { F_NEC, F_NECREP, F_SONY, F_RC5, F_RC6, F_UNKNOWN, F_NUM };
+static const char *fNames[F_NUM] = { "nec", "nec-rep", "sony", "rc5", "rc6", "unknown" };
+
+static sidPRNG rng;
+
+// As IRRemote::compare()
+static uint32_t hcomp(uint32_t a, uint32_t b)
+{
+    if(b < a * 80 / 100) return 0;
+    if(a < b * 80 / 100) return 2;
+    return 1;
+}
+
+// Could one tick of quantization on each duration change the hash?
+static bool nearThreshold(const irFrame& f)
+{
+    const int32_t q = IRGEN_TICK;
+
+    for(size_t i = 0; i + 2 < f.size(); i++) {
+        uint32_t a = f[i], b = f[i + 2];
+        uint32_t r = hcomp(a, b);
+        if(hcomp(a - q, b + q) != r || hcomp(a + q, b - q) != r)
+            return true;
+    }
+
+    return false;
+}
+
+static irFrame makeFrame(int type, uint32_t& code)
+{
+    uint8_t addr = rng.below(256), cmd = rng.below(256);
+    irFrame f;
+
+    code = 0;
+
+    switch(type) {
+    case F_NEC:
+        f = irNEC(addr, cmd);
+        code = irCodeNEC(addr, cmd);
+        break;
+    case F_NECREP:
+        f = irNECRepeat();
+        break;
+    case F_SONY:
+        f = irSony(addr & 0x1f, cmd);
+        code = irCodeSony(addr & 0x1f, cmd);
+        break;
+    case F_RC5:
+        f = irRC5(rng.below(2), addr, cmd);
+        code = irCodeRC5(addr, cmd);
+        break;
+    case F_RC6:
+        f = irRC6(rng.below(2), addr, cmd);
+        code = irCodeRC6(addr, cmd);
+        break;
+    default:
+        // Mark/space pairs plus final mark
+        for(int i = 4 + rng.below(30); i > 0; i--) {
+            irPulse(f, 250 + rng.below(2750), 250 + rng.below(2750));
+        }
+        f.push_back(250 + rng.below(2750));
+    }
+
+    return irDistort(f, rng, rng.below(101), rng.below(41));
+}
+
+int main()
+{
+    irEdge::IRRemote  edge(IR_TIMER, IR_PIN);
+    irTimer::IRRemote timer(IR_TIMER, IR_PIN);
+    irPlayer pl;
+    uint32_t sent[F_NUM] = { 0 }, near[F_NUM] = { 0 }, diff[F_NUM] = { 0 };
+    uint32_t hashes = 0;
+
+    rng.seed(0x19851026);
+    host_setUs(1000000);
+
+    irPlayerInit(pl, IR_PIN, IR_TIMER);
+    edge.begin();
+    timer.begin();
+    edge.setTrace(true);
+    timer.setTrace(true);
+
+    irIdle(pl, 100000);
+
+    for(int n = 0; n < NUM_FRAMES; n++) {
+        int type = rng.below(F_NUM);
+        uint32_t code;
+        irFrame f = makeFrame(type, code);
+
+        sent[type]++;
+        if(nearThreshold(f)) near[type]++;
+
+        irSend(pl, f);
+        irIdle(pl, 6000);       // Edge capture: End of frame is seen in loop()
+        for(int i = 0; i < 3; i++) {
+            edge.loop();
+            timer.loop();
+        }
+
+        irEdge::IRTraceRec re = { }, xe;
+        irTimer::IRTraceRec rt = { }, xt;
+        uint32_t lost;
+        bool ge = edge.readTrace(re, lost);
+        bool gt = timer.readTrace(rt, lost);
+
+        CHECK(ge && gt, "frame %d (%s): edge %d timer %d", n, fNames[type], ge, gt);
+        CHECK(!edge.readTrace(xe, lost) && !timer.readTrace(xt, lost), "frame %d: extra trace", n);
+        if(!ge || !gt) continue;
+
+        CHECK(re.len == f.size() + 1, "frame %d (%s): edge len %u of %zu",
+              n, fNames[type], re.len, f.size() + 1);
+        CHECK(re.len == rt.len, "frame %d (%s): len %u vs %u", n, fNames[type], re.len, rt.len);
+        if(re.len == rt.len) {
+            for(int i = 1; i < re.len; i++) {
+                int d = (int)re.dur[i] - (int)rt.dur[i];
+                CHECK(d >= -IRGEN_TICK && d <= IRGEN_TICK, "frame %d (%s): dur[%d] %u vs %u",
+                      n, fNames[type], i, re.dur[i], rt.dur[i]);
+            }
+        }
+
+        CHECK(re.code == rt.code, "frame %d (%s): code %08x vs %08x", n, fNames[type], re.code, rt.code);
+        CHECK(!code || re.code == code, "frame %d (%s): code %08x, sent %08x", n, fNames[type], re.code, code);
+
+        bool same = ((re.flags ^ rt.flags) & IRTR_HASH) == 0 && re.hash == rt.hash;
+        CHECK(same, "frame %d (%s): hash %08x vs %08x", n, fNames[type], re.hash, rt.hash);
+        if(!same) diff[type]++;
+        if(re.flags & IRTR_HASH) hashes++;
+
+        irIdle(pl, 14000 + rng.below(60000));
+    }
+
+    uint32_t ovf, trunc;
+    edge.getStats(ovf, trunc);
+    CHECK(!ovf && !trunc, "edge: %u overflows, %u truncated", ovf, trunc);
+    timer.getStats(ovf, trunc);
+    CHECK(!ovf && !trunc, "timer: %u overflows, %u truncated", ovf, trunc);
+
+    for(int t = 0; t < F_NUM; t++) {
+        printf("%-8s %4u frames, %3u near a threshold, %3u hash differently\n",
+            fNames[t], sent[t], near[t], diff[t]);
+    }
+    printf("%u hashes compared\n", hashes);
+
+    return host_result();
+}
@@ -0,0 +1,148 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: IR frame ring (input.cpp) with the edge ISR running
+ * in a thread of its own
+ *
+ * An "ISR" thread plays NEC frames carrying a sequence number into
+ * the pin (the edge ISR runs in that thread, and closes a frame
+ * when the next one starts), while the main thread calls loop()
+ * (which also closes frames, lazily, after the gap) and reads the
+ * decoded codes from the trace.
+ *
+ * - Paced: The ISR thread waits while the ring is nearly full;
+ *   no frame may be lost.
+ * - Flood: Hardly any pacing, the ring overflows. Frames received
+ *   plus overflows counted by getStats() must equal frames sent.
+ *
+ * In both, every received frame must decode to its sequence
+ * number (data intact), in order, each once.
+ */
+
+#include <Arduino.h>
+#include <thread>
+#include <chrono>
+
+#include "host_test.h"
+#include "irgen.h"
+
+#define IR_PIN      13
+#define IR_TIMER    0
+#define NUM_FRAMES  20000       // per phase
+
+static IRRemote ir(IR_TIMER, IR_PIN);
+static irPlayer pl;
+
+static volatile uint32_t sent = 0;
+static volatile uint32_t accounted = 0;     // Received + overflows
+static volatile bool     isrDone = false;
+
+static uint32_t nextSeq = 0;
+
+static uint32_t overflows()
+{
+    uint32_t ovf, trunc;
+
+    ir.getStats(ovf, trunc);
+
+    return ovf;
+}
+
+static void isrThread(uint32_t first, bool paced)
+{
+    for(uint32_t i = first; i < first + NUM_FRAMES; i++) {
+        // Ring holds 3 frames, plus the one being recorded
+        while(paced && __atomic_load_n(&sent, __ATOMIC_ACQUIRE) -
+                       __atomic_load_n(&accounted, __ATOMIC_ACQUIRE) >= 2) {
+            std::this_thread::yield();
+        }
+        // Flood: Give the consumer a chance now and then
+        if(!paced && !(i & 7)) {
+            std::this_thread::yield();
+        }
+        irIdle(pl, 20000);
+        irSend(pl, irNEC(i & 0xff, i >> 8));
+        __atomic_add_fetch(&sent, 1, __ATOMIC_ACQ_REL);
+    }
+
+    // Let loop() see the end of the last frame
+    irIdle(pl, 20000);
+    __atomic_store_n(&isrDone, true, __ATOMIC_RELEASE);
+}
+
+static void runPhase(const char *name, bool paced)
+{
+    uint32_t first = nextSeq;
+    uint32_t ovf0 = overflows();
+    uint32_t recv = 0, bad = 0, order = 0;
+    auto t0 = std::chrono::steady_clock::now();
+
+    sent = accounted = 0;
+    isrDone = false;
+
+    std::thread isr(isrThread, first, paced);
+
+    for(;;) {
+        IRTraceRec rec;
+        uint32_t lost;
+
+        ir.loop();
+
+        while(ir.readTrace(rec, lost)) {
+            uint32_t seq = ((rec.code >> 8) & 0xff) | ((rec.code & 0xff) << 8);
+            if(!(rec.flags & IRTR_CODE) || rec.code != irCodeNEC(seq & 0xff, seq >> 8)) {
+                bad++;
+            } else if(seq < nextSeq || seq >= first + NUM_FRAMES) {
+                order++;
+            } else {
+                nextSeq = seq + 1;
+            }
+            recv++;
+            CHECK(!lost, "%s: %u trace records lost", name, lost);
+        }
+
+        __atomic_store_n(&accounted, recv + overflows() - ovf0, __ATOMIC_RELEASE);
+
+        if(__atomic_load_n(&isrDone, __ATOMIC_ACQUIRE) && accounted == NUM_FRAMES)
+            break;
+
+        if(std::chrono::steady_clock::now() - t0 > std::chrono::seconds(60)) {
+            CHECK(false, "%s: timeout, %u sent, %u accounted for", name, sent, accounted);
+            break;
+        }
+
+        std::this_thread::yield();
+    }
+
+    isr.join();
+    nextSeq = first + NUM_FRAMES;
+
+    uint32_t ovf, trunc;
+    ir.getStats(ovf, trunc);
+    ovf -= ovf0;
+
+    printf("%-6s: %u sent, %u received, %u overflows\n", name, sent, recv, ovf);
+    CHECK(recv + ovf == NUM_FRAMES, "%s: %u received + %u overflows != %u sent", name, recv, ovf, NUM_FRAMES);
+    CHECK(!bad, "%s: %u frames corrupt", name, bad);
+    CHECK(!order, "%s: %u frames out of order or duplicated", name, order);
+    CHECK(!trunc, "%s: %u frames truncated", name, trunc);
+    if(paced) {
+        CHECK(!ovf, "%s: %u frames lost", name, ovf);
+    }
+}
+
+int main()
+{
+    host_setUs(1000000);
+    irPlayerInit(pl, IR_PIN, -1);
+    ir.begin();
+    ir.setTrace(true);
+
+    runPhase("paced", true);
+    runPhase("flood", false);
+
+    return host_result();
+}
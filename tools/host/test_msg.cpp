@@ -0,0 +1,103 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: msgQueue (sid_msg.h), the SPSC queue between
+ * network task and main side
+ *
+ * - Contention: A producer and a consumer thread (standing in
+ *   for core 0 and core 1) pass 1M messages through a small
+ *   queue; every message must arrive once, in order, intact.
+ * - Reserve: Puts with a reserve leave room for puts without.
+ */
+
+#include <Arduino.h>
+#include <thread>
+
+#include "host_test.h"
+#include "sid_msg.h"
+
+#define NUM_MSGS 1000000
+
+typedef struct {
+    uint32_t seq;
+    uint32_t inv;
+    uint8_t  pad[8];
+} testMsg;
+
+static void testContention()
+{
+    static msgQueue<testMsg, 32> q;
+    uint32_t full = 0, empty = 0, bad = 0, recv = 0;
+
+    std::thread prod([&] {
+        for(uint32_t i = 0; i < NUM_MSGS; ) {
+            testMsg m;
+            m.seq = i;
+            m.inv = ~i;
+            memset(m.pad, i & 0xff, sizeof(m.pad));
+            if(q.put(m)) {
+                i++;
+            } else {
+                full++;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::thread cons([&] {
+        testMsg m;
+        while(recv < NUM_MSGS) {
+            if(!q.get(m)) {
+                empty++;
+                std::this_thread::yield();
+                continue;
+            }
+            if(m.seq != recv || m.inv != ~recv || m.pad[0] != (recv & 0xff) || m.pad[7] != (recv & 0xff)) {
+                bad++;
+            }
+            recv++;
+        }
+    });
+
+    prod.join();
+    cons.join();
+
+    testMsg m;
+    printf("contention: %u received, %u bad, producer saw full %u times, consumer empty %u times\n",
+        recv, bad, full, empty);
+    CHECK(recv == NUM_MSGS, "received %u of %u", recv, NUM_MSGS);
+    CHECK(!bad, "%u messages out of order or corrupt", bad);
+    CHECK(!q.get(m), "queue not empty at end");
+    CHECK(q.lost() == full, "lost() %u, failed puts %u", q.lost(), full);
+}
+
+static void testReserve()
+{
+    msgQueue<testMsg, 32> q;
+    testMsg m = { 0 };
+    int n = 0;
+
+    while(q.put(m, 4)) n++;
+    CHECK(n == 28, "reserve 4: %d puts", n);
+    while(q.put(m)) n++;
+    CHECK(n == 32, "without reserve: %d puts total", n);
+    CHECK(q.lost() == 2, "lost %u", q.lost());
+
+    // One get makes room for an unreserved put only
+    CHECK(q.get(m), "get");
+    CHECK(!q.put(m, 4), "reserved put into reserve");
+    CHECK(q.put(m), "unreserved put");
+
+    printf("reserve: ok\n");
+}
+
+int main()
+{
+    testReserve();
+    testContention();
+
+    return host_result();
+}
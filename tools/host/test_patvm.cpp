@@ -0,0 +1,208 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: Idle pattern programs (sid_patprog.h, run by
+ * sid_patvm) against the previous native code (sid_patref)
+ *
+ * For every built-in pattern, strict and non-strict, with frozen
+ * and moving baseline, with and without coming from speed (GPS):
+ * Random start states, then steps as showIdle() takes them, with
+ * the same seed for both sides. After each step, baselines,
+ * direction, variation, flags, delays, hold time, frame index,
+ * the speed flag, the bars drawn and the PRNG state must be the
+ * same.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "sid_global.h"
+#include "sid_patvm.h"
+#include "sid_patprog.h"
+#include "sid_patref.h"
+
+#define NUM_RUNS    500         // Per configuration
+#define RUN_STEPS   100
+#define TT_SQF_LN   51          // as sid_main.cpp
+
+static const uint8_t *progs[SID_IDLE_IDC + 1] = {
+    pat_idle0, pat_idle1, pat_idle2, pat_idle3, pat_idle4, pat_idle5
+};
+static const int progLen[SID_IDLE_IDC + 1] = {
+    sizeof(pat_idle0), sizeof(pat_idle1), sizeof(pat_idle2),
+    sizeof(pat_idle3), sizeof(pat_idle4), sizeof(pat_idle5)
+};
+
+static sidPRNG rng;             // Scenarios
+
+typedef struct {
+    uint8_t h[10];
+    int     cnt;
+} barsSeen;
+
+static barsSeen refBars, vmBars;
+
+static void refBarsCb(const uint8_t *heights)
+{
+    memcpy(refBars.h, heights, 10);
+    refBars.cnt++;
+}
+
+static void vmBarsCb(const uint8_t *heights)
+{
+    memcpy(vmBars.h, heights, 10);
+    vmBars.cnt++;
+}
+
+// As patStep() in sid_main.cpp
+static void vmStep(int mode, bool strict, bool freeze, int speed, unsigned long now,
+                   patRefState& s, sidPRNG& prng)
+{
+    patCtx c = { };
+    int32_t *r = c.r;
+
+    c.rng = &prng;
+    c.bars = vmBarsCb;
+
+    r[PVR_BL] = s.bl;
+    r[PVR_SBL] = s.sbl;
+    r[PVR_WAY] = s.wayUp;
+    r[PVR_VAR] = s.variation;
+    r[PVR_FLG] = s.flags;
+    r[PVR_DLY] = s.delay;
+    r[PVR_IDX] = s.idx;
+    r[PVR_GPS] = s.gps;
+    r[PVR_STRICT] = strict;
+    r[PVR_FRZ] = freeze;
+    r[PVR_SPD] = speed;
+    c.now = now;
+    c.mark = s.mark;
+    c.hold = s.hold;
+
+    CHECK(patRun(progs[mode], c), "idle%d: step limit hit", mode);
+
+    s.bl = r[PVR_BL];
+    s.sbl = r[PVR_SBL];
+    s.wayUp = !!r[PVR_WAY];
+    s.variation = r[PVR_VAR];
+    s.flags = r[PVR_FLG];
+    s.delay = (r[PVR_DLY] > 0) ? r[PVR_DLY] : 0;
+    s.idx = r[PVR_IDX];
+    s.gps = !!r[PVR_GPS];
+    s.mark = c.mark;
+    s.hold = c.hold;
+}
+
+// Clamp after the step, shared by both (showIdle())
+static void clampBL(patRefState& s)
+{
+    if(s.bl < 0) s.bl = 0;
+    else if(s.bl > 19) s.bl = 19;
+    if(s.sbl < 0) s.sbl = 0;
+    else if(s.sbl > TT_SQF_LN-1) s.sbl = TT_SQF_LN-1;
+}
+
+static bool same(const patRefState& a, const patRefState& b)
+{
+    return a.bl == b.bl && a.sbl == b.sbl && a.wayUp == b.wayUp &&
+           a.variation == b.variation && a.flags == b.flags &&
+           a.delay == b.delay && a.mark == b.mark && a.hold == b.hold &&
+           a.idx == b.idx && a.gps == b.gps;
+}
+
+static void dump(const char *side, const patRefState& s, const barsSeen& b)
+{
+    printf("  %-4s bl %d sbl %d way %d var %d flg 0x%02x dly %lu mark %lu hold %lu idx %d gps %d bars %d\n",
+        side, s.bl, s.sbl, s.wayUp, s.variation, s.flags, s.delay, s.mark, s.hold,
+        s.idx, s.gps, b.cnt);
+}
+
+// Returns number of steps compared
+static uint32_t runConfig(int mode, bool strict, bool freeze, bool gps)
+{
+    uint32_t steps = 0;
+
+    for(int run = 0; run < NUM_RUNS; run++) {
+        sidPRNG refRNG, vmRNG;
+        patRefState ref, vm;
+        unsigned long now = rng.next();
+        uint32_t seed = rng.next();
+
+        refRNG.seed(seed);
+        vmRNG.seed(seed);
+
+        ref.bl = rng.below(20);
+        ref.sbl = rng.below(TT_SQF_LN);
+        ref.wayUp = rng.below(2);
+        ref.delay = 800;
+        ref.mark = now - rng.below(1000);
+        ref.hold = 800;
+        ref.idx = rng.below(14);
+        ref.gps = gps;
+        vm = ref;
+
+        for(int i = 0; i < RUN_STEPS; i++, steps++) {
+            int speed = (int)rng.below(90) - 1;
+
+            // As showIdle(): Hold time re-rolled, then the step
+            // (after the delay), flags and variation fresh
+            ref.hold = refRNG.range(700, 899);
+            vm.hold = vmRNG.range(700, 899);
+            ref.flags = vm.flags = 0;
+            ref.variation = vm.variation = 20;
+            refBars.cnt = vmBars.cnt = 0;
+
+            patRefStep(mode, strict, freeze, now, ref, refRNG, refBarsCb);
+            vmStep(mode, strict, freeze, speed, now, vm, vmRNG);
+
+            clampBL(ref);
+            clampBL(vm);
+
+            if(!same(ref, vm) || refBars.cnt != vmBars.cnt ||
+               (refBars.cnt && memcmp(refBars.h, vmBars.h, 10)) ||
+               memcmp(&refRNG, &vmRNG, sizeof(sidPRNG))) {
+                CHECK(0, "idle%d strict %d frozen %d gps %d: run %d differs at step %d%s",
+                    mode, strict, freeze, gps, run, i,
+                    memcmp(&refRNG, &vmRNG, sizeof(sidPRNG)) ? " (PRNG out of step)" : "");
+                dump("ref", ref, refBars);
+                dump("vm", vm, vmBars);
+                return steps;
+            }
+
+            // Back from speed now and then
+            if(gps && !rng.below(8)) {
+                ref.gps = vm.gps = true;
+            }
+
+            now += ref.delay + rng.below(30);
+        }
+    }
+
+    return steps;
+}
+
+int main()
+{
+    uint32_t steps = 0;
+
+    rng.seed(0x19851026);
+
+    for(int m = 0; m <= SID_IDLE_IDC; m++) {
+        CHECK(patVerify(progs[m], progLen[m]), "idle%d: patVerify failed", m);
+    }
+
+    for(int m = 0; m <= SID_IDLE_IDC; m++) {
+        for(int c = 0; c < 8; c++) {
+            steps += runConfig(m, c & 1, c & 2, c & 4);
+        }
+    }
+
+    printf("%u steps compared (%d patterns, strict/frozen/gps)\n", steps, SID_IDLE_IDC + 1);
+
+    return host_result();
+}
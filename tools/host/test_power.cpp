@@ -0,0 +1,178 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: Power state (sid_power) and the profiler (sid_prof)
+ * across CPU clock changes
+ *
+ * - Screen saver/fake power off enter QUIET/OFF only after the
+ *   conditions held for PWR_ENTER_DELAY; flickering conditions
+ *   don't switch; busy and waking up switch to ACTIVE at once.
+ * - Loop rates are measured per state.
+ * - Applying a state the way pwrApply() does (CPU clock, then
+ *   prof_setCpuMHz()): Profiled times are right at 240 and 80MHz,
+ *   also for a scope spanning a clock change, and for one longer
+ *   than the 17.9s it takes CCOUNT to wrap at 240MHz.
+ */
+
+#include <Arduino.h>
+
+#include "host_test.h"
+#include "sid_power.h"
+#include "sid_prof.h"
+
+static pwrState pwr;
+static int      changes = 0;
+static unsigned long lastChange = 0;
+
+static void pwrApply()
+{
+    setCpuFrequencyMhz(pwr.params().cpuMHz);
+    prof_setCpuMHz(pwr.params().cpuMHz);
+}
+
+// Run "loop passes" of loopMs each for dur ms
+static void step(unsigned long dur, bool fpoOff, bool ssActive, bool busy, int loopMs)
+{
+    for(unsigned long e = 0; e < dur; e += loopMs) {
+        host_advance(loopMs * 1000);
+        unsigned long now = millis();
+        pwr.countLoop(now);
+        if(pwr.update(now, fpoOff, ssActive, busy)) {
+            pwrApply();
+            changes++;
+            lastChange = now;
+        }
+    }
+}
+
+static void testStates()
+{
+    unsigned long t0;
+
+    // Active: 1ms loop passes
+    step(5000, false, false, false, 1);
+    CHECK(pwr.state() == PWR_ACTIVE && !changes, "not active at start");
+    CHECK(pwr.loopRate(PWR_ACTIVE) == 1000, "active loop rate %u", pwr.loopRate(PWR_ACTIVE));
+
+    // Screen saver: QUIET after PWR_ENTER_DELAY, not before
+    t0 = millis();
+    step(PWR_ENTER_DELAY - 1, false, true, false, 1);
+    CHECK(pwr.state() == PWR_ACTIVE, "quiet before enter delay");
+    step(5, false, true, false, 1);
+    CHECK(pwr.state() == PWR_QUIET && lastChange - t0 == PWR_ENTER_DELAY + 1,
+          "quiet after %lums", lastChange - t0);
+    CHECK(getCpuFrequencyMhz() == pwrTable[PWR_QUIET].cpuMHz, "CPU at %uMHz", getCpuFrequencyMhz());
+
+    // Quiet: Loop runs at the min interval
+    step(5000, false, true, false, pwrTable[PWR_QUIET].loopInt);
+    CHECK(pwr.loopRate(PWR_QUIET) == 1000 / pwrTable[PWR_QUIET].loopInt,
+          "quiet loop rate %u", pwr.loopRate(PWR_QUIET));
+
+    // Busy (TT, IR learning...): ACTIVE on the next pass
+    t0 = millis();
+    step(20, false, true, true, 20);
+    CHECK(pwr.state() == PWR_ACTIVE && lastChange == t0 + 20, "busy: not active at once");
+
+    // Flickering screen saver never reaches the enter delay
+    for(int i = 0; i < 10; i++) {
+        step(PWR_ENTER_DELAY / 2, false, true, false, 1);
+        step(10, false, false, false, 1);
+    }
+    CHECK(pwr.state() == PWR_ACTIVE, "flickering screen saver switched state");
+
+    // Fake power off
+    t0 = millis();
+    step(PWR_ENTER_DELAY + 10, true, false, false, 1);
+    CHECK(pwr.state() == PWR_OFF && lastChange - t0 == PWR_ENTER_DELAY + 1,
+          "off after %lums", lastChange - t0);
+    step(5000, true, false, false, pwrTable[PWR_OFF].loopInt);
+    CHECK(pwr.loopRate(PWR_OFF) == 1000 / pwrTable[PWR_OFF].loopInt,
+          "off loop rate %u", pwr.loopRate(PWR_OFF));
+
+    // Screen saver while off: OFF wins
+    step(PWR_ENTER_DELAY * 2, true, true, false, pwrTable[PWR_OFF].loopInt);
+    CHECK(pwr.state() == PWR_OFF, "ss while off: %s", pwr.params().name);
+
+    // Fake power on: ACTIVE at once
+    t0 = millis();
+    step(1, false, false, false, 1);
+    CHECK(pwr.state() == PWR_ACTIVE && lastChange == t0 + 1, "power on: not active at once");
+    CHECK(getCpuFrequencyMhz() == pwrTable[PWR_ACTIVE].cpuMHz, "CPU at %uMHz", getCpuFrequencyMhz());
+
+    printf("states: %d changes, loop rates active %u quiet %u off %u\n", changes,
+        pwr.loopRate(PWR_ACTIVE), pwr.loopRate(PWR_QUIET), pwr.loopRate(PWR_OFF));
+}
+
+static void profRun(int n, uint32_t us)
+{
+    for(int i = 0; i < n; i++) {
+        PROF_SCOPE(PROF_MAIN);
+        host_advance(us);
+    }
+}
+
+static bool profGet(uint32_t& n, uint32_t& avg, uint32_t& mx)
+{
+    char buf[192];
+
+    prof_report(PROF_MAIN, buf, sizeof(buf));
+
+    return sscanf(buf, "Main n=%u avg=%uus max=%uus", &n, &avg, &mx) == 3;
+}
+
+static void testProfiler()
+{
+    uint32_t n, avg, mx;
+
+    prof_begin();
+
+    // Active, 240MHz
+    profRun(100, 1500);
+    CHECK(profGet(n, avg, mx) && n == 100 && avg == 1500 && mx == 1500,
+          "240MHz: n=%u avg=%u max=%u", n, avg, mx);
+
+    // Screen saver: QUIET, 80MHz
+    prof_reset();
+    step(PWR_ENTER_DELAY + 20, false, true, false, 20);
+    CHECK(pwr.state() == PWR_QUIET, "not quiet");
+    profRun(100, 1500);
+    CHECK(profGet(n, avg, mx) && n == 100 && avg == 1500 && mx == 1500,
+          "80MHz: n=%u avg=%u max=%u", n, avg, mx);
+
+    // Clock changes inside a scope (pwrApply() is called from
+    // within the profiled main loop)
+    prof_reset();
+    {
+        PROF_SCOPE(PROF_MAIN);
+        host_advance(1000);
+        step(20, false, true, true, 20);        // busy: back to 240MHz
+        host_advance(1000);
+    }
+    CHECK(profGet(n, avg, mx) && n == 1 && mx == 22000,
+          "clock change in scope: n=%u max=%u", n, mx);
+
+    // Longer than a CCOUNT wrap
+    prof_reset();
+    profRun(1, 20000000);
+    CHECK(profGet(n, avg, mx) && n == 1 && mx == 20000000,
+          "20s scope: n=%u max=%u", n, mx);
+
+    // Overhead is measured in cycles; on the host, the cycle
+    // counter only moves with virtual time, so this is 0 here.
+    printf("profiler: overhead %uns per measurement\n", prof_overhead());
+
+    printf("profiler: ok\n");
+}
+
+int main()
+{
+    host_setUs(1000000);
+
+    testStates();
+    testProfiler();
+
+    return host_result();
+}
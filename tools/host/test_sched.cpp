@@ -0,0 +1,327 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: Task scheduler (sid_sched) on the virtual clock
+ *
+ * - Handles stay valid when tasks of higher priority are added
+ *   later; sched_runAt() hits the task it was given.
+ * - Run order: By priority.
+ * - Intervals are kept on the virtual clock without catching up
+ *   when late; tasks can set their own next deadline.
+ * - Min interval (power saving) throttles all tasks.
+ * - With no every-pass task, the scheduler sleeps until the
+ *   earliest deadline: A task set like the sketch's (IR, Main,
+ *   Idle at 5ms, a TT task following keyframe deadlines, an SA
+ *   task following frame deadlines) leaves the CPU idle most of
+ *   the time.
+ */
+
+#include <Arduino.h>
+
+#include "host_test.h"
+#include "sid_sched.h"
+
+/*
+ * Since the scheduler has no way to remove tasks, each test uses
+ * the task slots it registers, in registration order; the tests
+ * below fill them up gradually (SCHED_MAX_TASKS in total).
+ */
+
+static char     runLog[64];
+static int      runLogLen;
+static uint32_t runs[SCHED_MAX_TASKS];
+static unsigned long lastRun[SCHED_MAX_TASKS];
+static uint32_t maxGap[SCHED_MAX_TASKS];
+
+static void logRun(int id)
+{
+    unsigned long now = millis();
+
+    if(runLogLen < (int)sizeof(runLog) - 1) runLog[runLogLen++] = 'a' + id;
+    if(runs[id] && now - lastRun[id] > maxGap[id]) maxGap[id] = now - lastRun[id];
+    lastRun[id] = now;
+    runs[id]++;
+}
+
+static void clearLog()
+{
+    memset(runLog, 0, sizeof(runLog));
+    runLogLen = 0;
+    memset(runs, 0, sizeof(runs));
+    memset(maxGap, 0, sizeof(maxGap));
+}
+
+static uint64_t sleptUs = 0;
+static uint32_t sleeps = 0;
+
+static void hostSleep(unsigned long ms)
+{
+    sleptUs += (uint64_t)ms * 1000;
+    sleeps++;
+    host_advance((uint64_t)ms * 1000);
+}
+
+// Tasks a..c: Handles and run order
+
+static int hA, hB, hC;
+static void taskA() { logRun(0); }
+static void taskB() { logRun(1); }
+static void taskC() { logRun(2); }
+
+static void noSleep(unsigned long ms)
+{
+}
+
+static void testHandles()
+{
+    // Time only moves when we say so
+    sched_setSleep(noSleep);
+
+    hA = sched_add("A", taskA, 100, SCHED_PRIO_LOW);
+    hB = sched_add("B", taskB, 100, SCHED_PRIO_NORMAL);
+    hC = sched_add("C", taskC, 100, SCHED_PRIO_HIGH);
+
+    CHECK(hA == 0 && hB == 1 && hC == 2, "handles %d %d %d", hA, hB, hC);
+
+    // All due at start: Priority order
+    clearLog();
+    sched_run();
+    CHECK(!strcmp(runLog, "cba"), "run order %s", runLog);
+
+    // runAt on the LOW task (registered first, now last in
+    // run order) must move that task and no other
+    host_advance(10000);
+    clearLog();
+    sched_runAt(hA, millis());
+    sched_run();
+    CHECK(!strcmp(runLog, "a"), "runAt(A) ran %s", runLog);
+
+    // Interval is kept from A's new deadline
+    host_advance(95000);
+    clearLog();
+    sched_run();
+    CHECK(!strcmp(runLog, "cb"), "after 105ms ran %s", runLog);
+    host_advance(15000);
+    clearLog();
+    sched_run();
+    CHECK(!strcmp(runLog, "a"), "after 120ms ran %s", runLog);
+
+    // Stats are by handle
+    const char *name;
+    uint32_t r, avg, mx;
+    int n = 0;
+    for(int i = 0; (i = sched_getStats(i, name, r, avg, mx)) > 0; n++) { }
+    CHECK(n == 3, "%d tasks in stats", n);
+    CHECK(sched_getStats(hA, name, r, avg, mx) == hA + 1 && !strcmp(name, "A") && r == 3,
+          "stats of A: %s runs %u", name, r);
+
+    printf("handles: ok\n");
+
+    // Park these three
+    sched_setInterval(hA, 1000000);
+    sched_setInterval(hB, 1000000);
+    sched_setInterval(hC, 1000000);
+}
+
+// Task d: Late runs don't catch up; self deadline; min interval
+
+static int  hD;
+static long dLate = 0;
+static long dSelf = -1;
+
+static void taskD()
+{
+    logRun(3);
+    if(dLate) {
+        host_advance(dLate * 1000);
+        dLate = 0;
+    }
+    if(dSelf >= 0) {
+        sched_runAt(hD, millis() + dSelf);
+    }
+}
+
+static void runFor(unsigned long ms)
+{
+    unsigned long end = millis() + ms;
+    while((long)(millis() - end) < 0) {
+        sched_run();
+    }
+}
+
+static void testIntervals()
+{
+    hD = sched_add("D", taskD, 10, SCHED_PRIO_NORMAL);
+    CHECK(hD == 3, "handle D %d", hD);
+
+    sched_setSleep(hostSleep);
+
+    clearLog();
+    runFor(1000);
+    CHECK(runs[3] >= 99 && runs[3] <= 101, "10ms task ran %u times in 1s", runs[3]);
+    CHECK(maxGap[3] == 10, "10ms task max gap %u", maxGap[3]);
+
+    // A 55ms overrun: Next run 10ms after the late one, no burst
+    dLate = 55;
+    clearLog();
+    runFor(200);
+    CHECK(runs[3] >= 14 && runs[3] <= 16, "after overrun %u runs in 200ms", runs[3]);
+
+    // Task sets its own deadline (3ms), overriding its interval
+    dSelf = 3;
+    clearLog();
+    runFor(300);
+    CHECK(runs[3] >= 99 && runs[3] <= 101, "self-scheduled at 3ms: %u runs in 300ms", runs[3]);
+
+    // ... but not below the min interval
+    sched_setMinInterval(20);
+    clearLog();
+    runFor(1000);
+    CHECK(runs[3] >= 49 && runs[3] <= 51, "min interval 20: %u runs in 1s", runs[3]);
+    sched_setMinInterval(0);
+    dSelf = -1;
+
+    printf("intervals: ok\n");
+
+    sched_setInterval(hD, 1000000);
+}
+
+// Tasks e..i: Sketch-like task set, sleep path
+
+#define SIM_TT_KEYS 16
+
+static int  hTT, hSA;
+static bool ttRun = false, saOn = true;
+static unsigned long ttStart, ttKey[SIM_TT_KEYS], ttKeySeen[SIM_TT_KEYS];
+static int  ttNext;
+static unsigned long saNext = 0;
+static uint32_t saFrames = 0;
+
+static void taskIR()   { logRun(4); host_advance(30); }
+static void taskMain() { logRun(5); host_advance(80); }
+static void taskIdle() { logRun(6); host_advance(50); }
+
+static void taskTT()
+{
+    unsigned long now = millis();
+
+    logRun(7);
+
+    if(!ttRun) {
+        sched_runAt(hTT, now + 500);
+        return;
+    }
+
+    while(ttNext < SIM_TT_KEYS && now >= ttKey[ttNext]) {
+        ttKeySeen[ttNext++] = now;
+        host_advance(400);      // Draw
+    }
+
+    if(ttNext >= SIM_TT_KEYS) {
+        ttRun = false;
+        sched_runAt(hTT, now + 500);
+    } else {
+        sched_runAt(hTT, now + min(ttKey[ttNext] - now, 5UL));
+    }
+}
+
+static void taskSA()
+{
+    unsigned long now = millis();
+
+    logRun(8);
+
+    if(!saOn) {
+        sched_runAt(hSA, now + 5);
+        return;
+    }
+
+    // 256 samples at 32kHz: A frame every 8ms
+    if(!saNext) saNext = now;
+    if((long)(now - saNext) >= 0) {
+        saNext += 8;
+        saFrames++;
+        host_advance(2500);     // FFT and drawing
+    }
+    sched_runAt(hSA, saNext);
+}
+
+static void testSleep()
+{
+    sched_add("IR", taskIR, 5, SCHED_PRIO_HIGH);
+    hTT = sched_add("TT", taskTT, 5, SCHED_PRIO_HIGH);
+    sched_add("Main", taskMain, 5, SCHED_PRIO_NORMAL);
+    hSA = sched_add("SA", taskSA, 5, SCHED_PRIO_NORMAL);
+    sched_add("Idle", taskIdle, 5, SCHED_PRIO_NORMAL);
+
+    CHECK(hTT == 5 && hSA == 7, "handles TT %d SA %d", hTT, hSA);
+    CHECK(sched_add("X", taskIdle, 5, SCHED_PRIO_LOW) == 9, "10th slot");
+    CHECK(sched_add("Y", taskIdle, 5, SCHED_PRIO_LOW) == -1, "11th task accepted");
+
+    // SA running for 10s
+    clearLog();
+    sleptUs = 0;
+    uint64_t t0 = host_us();
+    runFor(10000);
+    uint64_t el = host_us() - t0;
+    printf("sa:   %u frames in 10s, slept %.1f%% of the time in %u sleeps\n",
+        saFrames, sleptUs * 100.0 / el, sleeps);
+    CHECK(saFrames >= 1249 && saFrames <= 1251, "%u SA frames in 10s", saFrames);
+    CHECK(sleptUs > el / 2, "slept only %.1f%%", sleptUs * 100.0 / el);
+    // 5ms, plus an SA frame's work in the same pass
+    CHECK(maxGap[4] <= 8, "IR max gap %ums", maxGap[4]);
+
+    // Time travel: Keyframes at uneven times must be hit on time
+    saOn = false;
+    ttStart = millis() + 10;
+    for(int i = 0; i < SIM_TT_KEYS; i++) {
+        ttKey[i] = ttStart + 2500 + i * 2500 / (SIM_TT_KEYS + 1) + (i & 1);
+    }
+    ttNext = 0;
+    ttRun = true;
+    host_advance(10000);
+    sched_runAt(hTT, millis());
+
+    clearLog();
+    sleptUs = 0;
+    t0 = host_us();
+    runFor(6000);
+    el = host_us() - t0;
+    long maxLate = 0;
+    for(int i = 0; i < SIM_TT_KEYS; i++) {
+        long late = ttKeySeen[i] - ttKey[i];
+        if(late > maxLate) maxLate = late;
+        CHECK(late >= 0, "keyframe %d early", i);
+    }
+    printf("tt:   %d keyframes, max %ldms late, slept %.1f%%\n", ttNext, maxLate, sleptUs * 100.0 / el);
+    CHECK(ttNext == SIM_TT_KEYS, "%d keyframes", ttNext);
+    CHECK(maxLate <= 1, "keyframe %ldms late", maxLate);
+    CHECK(sleptUs > el / 2, "slept only %.1f%%", sleptUs * 100.0 / el);
+
+    // Quiet (screen saver): Min interval 20ms
+    sched_setMinInterval(20);
+    clearLog();
+    sleptUs = 0;
+    t0 = host_us();
+    runFor(10000);
+    el = host_us() - t0;
+    printf("quiet: IR ran %u times in 10s, slept %.1f%%\n", runs[4], sleptUs * 100.0 / el);
+    CHECK(runs[4] >= 495 && runs[4] <= 501, "IR %u runs at min interval 20", runs[4]);
+    CHECK(sleptUs > el * 9 / 10, "slept only %.1f%%", sleptUs * 100.0 / el);
+
+    printf("sleep: ok\n");
+}
+
+int main()
+{
+    host_setUs(1000000);
+
+    testHandles();
+    testIntervals();
+    testSleep();
+
+    return host_result();
+}
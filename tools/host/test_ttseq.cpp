@@ -0,0 +1,208 @@
+/*
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * License: Modified MIT NON-AI, see LICENSE
+ *
+ * Host test: TT sequencer (sid_ttseq)
+ *
+ * Simulates 1000 random time travels in 1ms steps: Stand-alone
+ * and TCD-triggered, random lead times, keyframe counts, reentry
+ * and abort times, and three kinds of caller behavior in P2 (SA
+ * stepping back to normal, idle mode ending at once, a caller that
+ * never ends it). Checks phase durations against P0_DUR, P1_DUR,
+ * P2_DUR and the TCD's times, keyframe counts and spacing.
+ * Plus fixed cases for early reentry and millis() wrap-around.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "sid_ttseq.h"
+#include "sid_prng.h"
+#include "sid_global.h"
+
+#define NUM_RUNS     1000
+#define TT_AMP_STEPS 16         // as sid_main.cpp
+
+// P2 caller behavior
+#define P2_SA        0          // Finish when SA amp is back to normal
+#define P2_IDLE      1          // Finish right away
+#define P2_NEVER     2          // Don't finish; phase must time out
+#define P2_NUM       3
+
+static sidPRNG rng;
+
+static uint32_t rnd(uint32_t n)
+{
+    return rng.below(n);
+}
+
+typedef struct {
+    unsigned long end[TTPH_NUM];    // Phase ends, relative to start
+    int           keys;             // P0 keyframes
+    uint32_t      minGap;           // Min time between P0 keyframes
+    unsigned long lastKey;
+    int           ticks[TTPH_NUM];
+    int           p2Cnt;            // count() at P2 start
+} ttResult;
+
+static ttResult sim(const ttPhase *tl, uint32_t p0, uint32_t p1, int cnt, bool alt,
+                    long reentryAt, long abortAt, int p2mode, unsigned long start = 1000)
+{
+    ttSequencer s(rnd);
+    ttResult r = { };
+    unsigned long lk = 0;
+
+    r.minGap = 0xffffffff;
+
+    s.begin(tl, start, p0, p1, cnt, alt);
+
+    for(unsigned long now = start; now - start < 60000; now++) {
+
+        if(reentryAt >= 0 && now - start >= (unsigned long)reentryAt) s.event(TTE_REENTRY);
+        if(abortAt >= 0 && now - start >= (unsigned long)abortAt) s.event(TTE_ABORT);
+
+        uint8_t ev;
+        bool again;
+
+        do {
+            ev = s.run(now);
+            again = false;
+
+            if(ev & TTEV_STEP) {
+                r.ticks[s.phase()]++;
+                if(s.phase() == TTPH_ACCEL) {
+                    if(r.keys && now - lk < r.minGap) r.minGap = now - lk;
+                    lk = now;
+                    r.keys++;
+                    r.lastKey = now - start;
+                }
+            }
+
+            if(s.phase() == TTPH_REENTRY && !(ev & TTEV_END)) {
+                if(p2mode == P2_IDLE || (p2mode == P2_SA && s.count() >= TT_AMP_STEPS - 1)) {
+                    s.finish();
+                    again = true;
+                }
+            }
+
+            if(ev & TTEV_END) {
+                r.end[s.phase()] = now - start;
+                s.next(now);
+                if(s.phase() == TTPH_REENTRY) r.p2Cnt = s.count();
+            }
+
+        } while((ev & TTEV_END) || again);
+
+        if(!s.running()) break;
+    }
+
+    CHECK(!s.running(), "sequence did not end");
+
+    return r;
+}
+
+static void checkRun(int i, const ttResult& r, unsigned long p0, unsigned long p1, int cnt, int p2mode)
+{
+    unsigned long p2 = r.end[2] - r.end[1];
+
+    CHECK(r.end[0] == p0, "run %d: P0 ended at %lu, expected %lu", i, r.end[0], p0);
+    CHECK(r.end[1] == p1, "run %d: P1 ended at %lu, expected %lu", i, r.end[1], p1);
+    CHECK(!r.keys || r.lastKey < r.end[0], "run %d: keyframe at %lu after P0 end", i, r.lastKey);
+
+    switch(p2mode) {
+    case P2_SA:
+        // From the count left after P0, ticks step up to 15; all fit in P2_DUR
+        CHECK(p2 < P2_DUR, "run %d: SA P2 took %lu", i, p2);
+        CHECK(r.p2Cnt >= TT_AMP_STEPS - 1 || r.ticks[2] == TT_AMP_STEPS - 1 - r.p2Cnt,
+              "run %d: SA P2 %d ticks from count %d", i, r.ticks[2], r.p2Cnt);
+        break;
+    case P2_IDLE:
+        CHECK(p2 == 0, "run %d: idle P2 took %lu", i, p2);
+        break;
+    case P2_NEVER:
+        CHECK(p2 == P2_DUR, "run %d: P2 timed out after %lu", i, p2);
+        break;
+    }
+}
+
+int main()
+{
+    static const char *p2names[P2_NUM] = { "sa", "idle", "never" };
+    int runs[2][P2_NUM] = { };
+    unsigned long p2max = 0;
+
+    rng.seed(0x19551105);
+
+    for(int i = 0; i < NUM_RUNS; i++) {
+        bool tcd = rng.below(2);
+        bool alt = rng.below(2);
+        int  cnt = rng.below(TT_AMP_STEPS + 45);
+        int  p2mode = rng.below(P2_NUM);
+        ttResult r;
+
+        if(p2mode == P2_SA) cnt = TT_AMP_STEPS;
+
+        if(!tcd) {
+
+            r = sim(ttTimelineInt, 0, 0, cnt, alt, -1, -1, p2mode);
+            checkRun(i, r, P0_DUR, P0_DUR + P1_DUR, cnt, p2mode);
+            CHECK(r.keys == cnt, "run %d: %d keyframes of %d", i, r.keys, cnt);
+            CHECK(cnt < 2 || (cnt + 1) * 65 > 2500 || r.minGap >= 65,
+                  "run %d: keyframes %ums apart", i, r.minGap);
+
+        } else {
+
+            uint32_t lead = rng.below(ETTO_LEAD + 3000);
+            uint32_t p1 = P1_DUR_TCD + P1_GRACE;
+            long reentry = -1, abort = -1;
+            unsigned long e0 = lead, e1;
+
+            switch(rng.below(4)) {
+            case 0:     // Reentry in P1
+                reentry = lead + 1 + rng.below(p1 - 1);
+                e1 = reentry;
+                break;
+            case 1:     // Reentry during P0 ends P1 at once
+                reentry = rng.below(lead + 1);
+                e1 = lead;
+                break;
+            case 2:     // Abort during P0 (or at its end)
+                abort = rng.below(lead + 1);
+                e0 = e1 = abort;
+                break;
+            default:    // No reentry: P1 times out
+                e1 = lead + p1;
+            }
+
+            r = sim(ttTimelineTCD, lead, p1, cnt, alt, reentry, abort, p2mode);
+            checkRun(i, r, e0, e1, cnt, p2mode);
+            if(abort < 0) {
+                CHECK(lead < 200 || r.keys == cnt, "run %d: lead %u, %d keyframes of %d",
+                      i, lead, r.keys, cnt);
+            }
+
+        }
+
+        runs[tcd][p2mode]++;
+        if(r.end[2] - r.end[1] > p2max) p2max = r.end[2] - r.end[1];
+    }
+
+    for(int m = 0; m < P2_NUM; m++) {
+        printf("P2 %-5s: %3d stand-alone, %3d TCD-triggered\n", p2names[m], runs[0][m], runs[1][m]);
+    }
+    printf("longest P2: %lums (P2_DUR %d)\n", p2max, P2_DUR);
+
+    // Reentry during P0 ends P1 right away
+    ttResult r = sim(ttTimelineTCD, ETTO_LEAD, P1_DUR_TCD + P1_GRACE, 20, false, 100, -1, P2_IDLE);
+    CHECK(r.end[0] == ETTO_LEAD && r.end[1] == ETTO_LEAD, "early reentry: %lu %lu", r.end[0], r.end[1]);
+
+    // millis() wrap during sequence
+    r = sim(ttTimelineInt, 0, 0, 20, false, -1, -1, P2_NEVER, 0xffffffffUL - 3000);
+    CHECK(r.end[0] == P0_DUR && r.end[1] == P0_DUR + P1_DUR && r.end[2] == P0_DUR + P1_DUR + P2_DUR,
+          "wrap: %lu %lu %lu", r.end[0], r.end[1], r.end[2]);
+
+    return host_result();
+}
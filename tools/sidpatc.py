@@ -0,0 +1,224 @@
+#!/usr/bin/env python3
+#
+# CircuitSetup.us Status Indicator Display
+# (C) 2023-2026 Thomas Winischhofer (A10001986)
+# https://github.com/realA10001986/SID
+# License: Modified MIT NON-AI, see LICENSE
+#
+# Idle pattern compiler: Text DSL -> SID pattern bytecode
+#
+# Usage:
+#   sidpatc.py pattern.sidp -o sidpat.bin       Binary for SD (put as /sidpat.bin)
+#   sidpatc.py --header out.h a.sidp b.sidp     C arrays (built-in patterns)
+#
+# Opcodes and registers must match sid_patvm.h.
+#
+# Syntax, one statement per line, '#' starts a comment:
+#
+#   label:
+#   set   reg imm           reg = imm
+#   add   reg imm           reg += imm
+#   xor   reg imm           reg ^= imm
+#   or    reg imm           reg |= imm
+#   radd  reg n k           reg += rnd(n) + k       (0 <= rnd(n) < n)
+#   rsub  reg n k           reg -= rnd(n) + k
+#   rset  reg lo hi         reg = rnd(lo..hi)
+#   clamp reg lo hi         lo <= reg <= hi
+#   smooth reg t            reg = (reg + reg_at_start) / 2 if change > t
+#   speed reg mul div       reg = speed * mul / div (if speed available)
+#   mark  lo hi             start hold time rnd(lo..hi) ms
+#   frames {                frame table (10 bar heights per row, 0-20);
+#     h0 h1 ... h9          draws row idx, then advances idx
+#   }
+#   jmp   label
+#   jgt   reg imm label     jump if reg > imm
+#   jlt   reg imm label     jump if reg < imm
+#   jrnd  n m label         jump if rnd(n) < m
+#   jhold label             jump if hold time not expired
+#   end
+#
+# Registers: bl sbl way var flg dly idx gps t (read/write),
+#            strict frz spd (read-only)
+# Flag names for flg: REPEAT LM SKIPSHOW NOBL STRICT, combined with |
+
+import argparse
+import os
+import struct
+import sys
+
+REGS = { 'bl': 0, 'sbl': 1, 'way': 2, 'var': 3, 'flg': 4, 'dly': 5, 'idx': 6,
+         'gps': 7, 't': 8, 'strict': 9, 'frz': 10, 'spd': 11 }
+NUM_RW = 9
+
+FLAGS = { 'REPEAT': 1, 'LM': 4, 'SKIPSHOW': 8, 'NOBL': 32, 'STRICT': 128 }
+
+# name: (opcode, operand kinds)
+#   r: writable register, R: any register, i: int16, b: uint8, k: int8, a: label
+OPS = {
+    'end':    (0x00, ''),
+    'set':    (0x01, 'ri'),
+    'add':    (0x02, 'ri'),
+    'xor':    (0x03, 'ri'),
+    'or':     (0x04, 'ri'),
+    'radd':   (0x05, 'rbk'),
+    'rsub':   (0x06, 'rbk'),
+    'rset':   (0x07, 'rii'),
+    'clamp':  (0x08, 'rii'),
+    'smooth': (0x09, 'rb'),
+    'speed':  (0x0a, 'rbb'),
+    'mark':   (0x0b, 'ii'),
+    'frames': (0x0c, ''),
+    'jmp':    (0x10, 'a'),
+    'jgt':    (0x11, 'Ria'),
+    'jlt':    (0x12, 'Ria'),
+    'jrnd':   (0x13, 'bba'),
+    'jhold':  (0x14, 'a'),
+}
+
+MAGIC = b'SIDP'
+VERSION = 1
+MAX_SIZE = 2048
+
+class PatError(Exception):
+    pass
+
+def value(tok):
+    v = 0
+    for part in tok.split('|'):
+        if part in FLAGS:
+            v |= FLAGS[part]
+        else:
+            try:
+                v |= int(part, 0)
+            except ValueError:
+                raise PatError("bad value '%s'" % tok)
+    return v
+
+def operand(kind, tok, labels, fixups, pos):
+    if kind in 'rR':
+        if tok not in REGS:
+            raise PatError("unknown register '%s'" % tok)
+        if kind == 'r' and REGS[tok] >= NUM_RW:
+            raise PatError("register '%s' is read-only" % tok)
+        return bytes([REGS[tok]])
+    if kind == 'a':
+        fixups.append((pos, tok))
+        return b'\0\0'
+    v = value(tok)
+    if kind == 'i':
+        if not -32768 <= v <= 32767:
+            raise PatError("value %d out of range" % v)
+        return struct.pack('<h', v)
+    if kind == 'k':
+        if not -128 <= v <= 127:
+            raise PatError("value %d out of range" % v)
+        return struct.pack('<b', v)
+    if not 0 <= v <= 255:
+        raise PatError("value %d out of range" % v)
+    return bytes([v])
+
+def compile_src(text):
+    code = bytearray()
+    labels = {}
+    fixups = []
+    rows = None
+    for lineno, line in enumerate(text.splitlines(), 1):
+        try:
+            line = line.split('#')[0].strip()
+            if not line:
+                continue
+            if rows is not None:
+                if line == '}':
+                    if not rows:
+                        raise PatError("empty frame table")
+                    if len(rows) > 255:
+                        raise PatError("too many frames")
+                    code += bytes([OPS['frames'][0], len(rows)])
+                    for r in rows:
+                        code += bytes(r)
+                    rows = None
+                    continue
+                r = [value(t) for t in line.split()]
+                if len(r) != 10 or any(h < 0 or h > 20 for h in r):
+                    raise PatError("frame needs 10 heights 0-20")
+                rows.append(r)
+                continue
+            if line.endswith(':'):
+                name = line[:-1]
+                if name in labels:
+                    raise PatError("duplicate label '%s'" % name)
+                labels[name] = len(code)
+                continue
+            toks = line.split()
+            op = toks[0].lower()
+            if op not in OPS:
+                raise PatError("unknown operation '%s'" % op)
+            opc, kinds = OPS[op]
+            if op == 'frames':
+                if toks[1:] != ['{']:
+                    raise PatError("expected 'frames {'")
+                rows = []
+                continue
+            if len(toks) - 1 != len(kinds):
+                raise PatError("'%s' takes %d operands" % (op, len(kinds)))
+            ins = bytearray([opc])
+            for k, t in zip(kinds, toks[1:]):
+                ins += operand(k, t, labels, fixups, len(code) + len(ins))
+            code += ins
+        except PatError as e:
+            raise PatError("line %d: %s" % (lineno, e))
+    if rows is not None:
+        raise PatError("unterminated frame table")
+    for pos, name in fixups:
+        if name not in labels:
+            raise PatError("undefined label '%s'" % name)
+        code[pos:pos+2] = struct.pack('<h', labels[name])
+    if len(code) > MAX_SIZE:
+        raise PatError("program too large (%d bytes)" % len(code))
+    return bytes(code)
+
+def c_array(name, code):
+    out = "static const uint8_t %s[%d] = {\n" % (name, len(code))
+    for i in range(0, len(code), 12):
+        out += "    " + ", ".join("0x%02x" % b for b in code[i:i+12]) + ",\n"
+    return out + "};\n"
+
+def main():
+    ap = argparse.ArgumentParser(description='SID idle pattern compiler')
+    ap.add_argument('src', nargs='+')
+    ap.add_argument('-o', '--output', help='binary output (single source)')
+    ap.add_argument('--header', help='C header output')
+    args = ap.parse_args()
+
+    progs = []
+    for fn in args.src:
+        try:
+            with open(fn) as f:
+                progs.append((fn, compile_src(f.read())))
+        except PatError as e:
+            sys.exit("%s: %s" % (fn, e))
+
+    if args.output:
+        if len(progs) != 1:
+            sys.exit("-o takes exactly one source")
+        code = progs[0][1]
+        with open(args.output, 'wb') as f:
+            f.write(MAGIC + bytes([VERSION, 0]) + struct.pack('<H', len(code)) + code)
+
+    if args.header:
+        with open(args.header, 'w') as f:
+            f.write("/*\n * Built-in idle patterns\n"
+                    " * Generated by tools/sidpatc.py from tools/patterns - do not edit\n */\n"
+                    "#ifndef _SID_PATPROG_H\n#define _SID_PATPROG_H\n\n")
+            for fn, code in progs:
+                name = os.path.splitext(os.path.basename(fn))[0]
+                f.write("// %s\n" % os.path.basename(fn))
+                f.write(c_array("pat_" + name, code) + "\n")
+            f.write("#endif\n")
+
+    if not args.output and not args.header:
+        for fn, code in progs:
+            print("%s: %d bytes" % (fn, len(code)))
+
+if __name__ == '__main__':
+    main()